@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_LAMBDA_COLUMNAR_TRANSPORT_HPP
+#define GRAPHLAB_LAMBDA_COLUMNAR_TRANSPORT_HPP
+#include <cstring>
+#include <vector>
+#include <flexible_type/flexible_type.hpp>
+#include <serialization/serialization_includes.hpp>
+#include <sframe/sframe_rows.hpp>
+#include <sframe/sarray_v2_block_types.hpp>
+#include <sframe/sarray_v2_type_encoding.hpp>
+
+namespace graphlab {
+namespace lambda {
+
+/**
+ * \ingroup lambda
+ *
+ * The columnar format used to ship batches of values to the lambda workers
+ * (and results back) over shared memory.
+ *
+ * Each column is written as a typed block, exactly as the columns of an
+ * SFrame are written to disk (see sarray_v2_type_encoding.hpp): integers,
+ * floats and strings are stored as packed buffers with the positions of
+ * missing values in a bitmap, instead of one tagged flexible_type at a time.
+ * The block is preceded by its block_info and its length, so that the
+ * receiver decodes it straight from the receive buffer.
+ *
+ * \code
+ * num_columns
+ * for each column: block_info, length, typed block
+ * \endcode
+ *
+ * This function writes a single column (block_info, length, typed block).
+ */
+inline void write_columnar_block(oarchive& oarc, const std::vector<flexible_type>& values) {
+  // the info and length are only known after encoding, so placeholders
+  // are written first and filled in afterwards
+  size_t info_offset = oarc.off;
+  v2_block_impl::block_info info;
+  oarc << info << (uint64_t)0;
+  size_t block_start = oarc.off;
+  v2_block_impl::typed_encode(values, info, oarc);
+  uint64_t length = oarc.off - block_start;
+  memcpy(oarc.buf + info_offset, &info, sizeof(v2_block_impl::block_info));
+  memcpy(oarc.buf + info_offset + sizeof(v2_block_impl::block_info), &length, sizeof(uint64_t));
+}
+
+/// Writes one column in the columnar format
+inline void write_columnar(oarchive& oarc, const std::vector<flexible_type>& values) {
+  oarc << (size_t)1;
+  write_columnar_block(oarc, values);
+}
+
+/// Writes the columns of rows in the columnar format
+inline void write_columnar(oarchive& oarc, const sframe_rows& rows) {
+  const auto& columns = rows.cget_columns();
+  oarc << columns.size();
+  for (const auto& column: columns) write_columnar_block(oarc, *column);
+}
+
+/**
+ * Reads the columns written by write_columnar. The blocks are decoded from
+ * the buffer of the archive in place.
+ */
+inline void read_columnar(iarchive& iarc,
+                          std::vector<sframe_rows::ptr_to_decoded_column_type>& columns) {
+  size_t num_columns;
+  iarc >> num_columns;
+  columns.resize(num_columns);
+  for (auto& column: columns) {
+    v2_block_impl::block_info info;
+    uint64_t length;
+    iarc >> info >> length;
+    if (iarc.off + length > iarc.len) {
+      log_and_throw("Truncated columnar lambda batch");
+    }
+    column = std::make_shared<sframe_rows::decoded_column_type>();
+    if (!v2_block_impl::typed_decode(info, iarc.buf + iarc.off, length, *column)) {
+      log_and_throw("Invalid columnar lambda batch");
+    }
+    iarc.off += length;
+  }
+}
+
+/// Reads a single column written by write_columnar
+inline void read_columnar(iarchive& iarc, std::vector<flexible_type>& values) {
+  std::vector<sframe_rows::ptr_to_decoded_column_type> columns;
+  read_columnar(iarc, columns);
+  if (columns.size() != 1) log_and_throw("Expected a single column");
+  values = std::move(*columns[0]);
+}
+
+} // namespace lambda
+} // namespace graphlab
+
+#endif
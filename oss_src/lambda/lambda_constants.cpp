@@ -15,6 +15,8 @@ size_t DEFAULT_NUM_PYLAMBDA_WORKERS = 16;
 
 size_t DEFAULT_NUM_GRAPH_LAMBDA_WORKERS = 16;
 
+size_t PYLAMBDA_BATCH_TARGET_MILLISECONDS = 50;
+
 REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             DEFAULT_NUM_PYLAMBDA_WORKERS,
                             true, 
@@ -24,4 +26,9 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             DEFAULT_NUM_GRAPH_LAMBDA_WORKERS,
                             true, 
                             +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            PYLAMBDA_BATCH_TARGET_MILLISECONDS,
+                            true, 
+                            +[](int64_t val){ return val >= 1; });
 }
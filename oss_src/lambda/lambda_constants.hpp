@@ -21,6 +21,14 @@ extern size_t DEFAULT_NUM_PYLAMBDA_WORKERS;
  */
 extern size_t DEFAULT_NUM_GRAPH_LAMBDA_WORKERS;
 
+/**
+ * The time, in milliseconds, a batch of rows sent to a pylambda worker
+ * should take to evaluate. Blocks of rows are split into batches of about
+ * this duration, as measured on the previous batches of the same lambda,
+ * which are spread over the idle workers.
+ */
+extern size_t PYLAMBDA_BATCH_TARGET_MILLISECONDS;
+
 }
 
 #endif
@@ -16,9 +16,16 @@ namespace graphlab {
 
 namespace lambda {
 
+/**
+ * The calls which can be made over shared memory. The COLUMNS variants
+ * carry their arguments (and the results) in the columnar format of
+ * columnar_transport.hpp.
+ */
 enum class bulk_eval_serialized_tag:char {
   BULK_EVAL_ROWS = 0,
   BULK_EVAL_DICT_ROWS = 1,
+  BULK_EVAL_COLUMNS = 2,
+  BULK_EVAL_DICT_COLUMNS = 3,
 };
 
 GENERATE_INTERFACE_AND_PROXY(lambda_evaluator_interface, lambda_evaluator_proxy,
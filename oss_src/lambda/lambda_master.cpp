@@ -12,6 +12,8 @@
 #include <algorithm>
 #include <lambda/lambda_constants.hpp>
 #include <shmipc/shmipc.hpp>
+#include <timer/timer.hpp>
+#include <lambda/columnar_transport.hpp>
 
 namespace graphlab { namespace lambda {
 
@@ -66,7 +68,9 @@ static lambda_master* instance_ptr = nullptr;
         if (!shared_memory_address.second.empty()) {
           std::shared_ptr<shmipc::client> client = std::make_shared<shmipc::client>();
           if (client->connect(shared_memory_address.second)) {
-            m_shared_memory_worker_connections[shared_memory_address.first] = client;
+            auto connection = std::make_shared<shared_memory_connection>();
+            connection->client = client;
+            m_shared_memory_worker_connections[shared_memory_address.first] = connection;
           }
         }
       }
@@ -122,6 +126,10 @@ static lambda_master* instance_ptr = nullptr;
       return 0;
     };
     m_worker_pool->call_all_workers<size_t>(release_lambda_fn);
+    {
+      std::lock_guard<graphlab::mutex> batch_lock(m_batch_mtx);
+      m_seconds_per_row.erase(lambda_hash);
+    }
   }
 
 
@@ -143,30 +151,26 @@ static lambda_master* instance_ptr = nullptr;
 
   /**
    * Performs a remote call to an interprocess shared memory server
-   * deserializing the response to RetType.
+   * deserializing the response to ret.
    *
    * Note that this is not a general purpose function and only works 
    * with pylambda_master and pylambda_evaluator.
    *
-   * Performs a remote call for bulk_eval_rows and bulk_eval_dict_rows.
-   *
-   * Arguments must be serialized into the "arguments" archive. This function
-   * will also take over management of the buffer inside of "arguments" and
-   * free it when done.
+   * Performs a remote call for bulk_eval_rows and bulk_eval_dict_rows, with
+   * the arguments and the response in the columnar format.
    *
-   * Results will be deserialized into the ret.
+   * Arguments must be serialized into the "arguments" archive, which must
+   * use the buffer of the connection. The buffer (which may be reallocated)
+   * is given back to the connection when done.
    *
    * This function may throw exceptions if remote exceptions were raised.
    */
-  template <typename RetType>
-  static bool shm_call(const std::shared_ptr<shmipc::client>& shmclient,
+  template <typename Connection>
+  static bool shm_call(Connection& connection,
                        oarchive& arguments,
-                       RetType& ret) {
+                       std::vector<flexible_type>& ret) {
     // send the message
-    bool shmok = shmipc::large_send(*shmclient, arguments.buf, arguments.off);
-    if (shmok == false) {
-      free(arguments.buf); arguments.buf = nullptr;
-    }
+    bool shmok = shmipc::large_send(*connection.client, arguments.buf, arguments.off);
 
     // reuse the arguments buffer so we dont alloc again
     // receive the reply
@@ -174,12 +178,13 @@ static lambda_master* instance_ptr = nullptr;
     size_t buflen = arguments.len;
     size_t receivelen = 0;
     arguments.buf = nullptr;
-    shmok = shmipc::large_receive(*shmclient, &buf, &buflen, 
-                                  receivelen, (size_t)(-1));
-    if (shmok == false) {
-      free(buf);
-      return false;
+    if (shmok) {
+      shmok = shmipc::large_receive(*connection.client, &buf, &buflen,
+                                    receivelen, (size_t)(-1));
     }
+    connection.buffer = buf;
+    connection.buffer_length = buflen;
+    if (shmok == false) return false;
 
     // deserialize
     // first byte is whether it is an error message or not
@@ -187,18 +192,55 @@ static lambda_master* instance_ptr = nullptr;
     char good_call;
     iarc >> good_call;
     if (good_call) {
-      iarc >> ret;
+      read_columnar(iarc, ret);
     } else {
       std::string message;
       iarc >> message;
       throw message;
     }
-    free(buf);
-
     return true;
   }
 
 
+  bool lambda_master::shared_memory_bulk_eval(void* worker_proxy,
+                                              size_t lambda_hash,
+                                              const std::vector<std::string>* keys,
+                                              const sframe_rows& args,
+                                              std::vector<flexible_type>& out,
+                                              bool skip_undefined, int seed) {
+    auto iter = m_shared_memory_worker_connections.find(worker_proxy);
+    if (iter == m_shared_memory_worker_connections.end() ||
+        iter->second->client.get() == nullptr) {
+      return false;
+    }
+    auto& connection = *(iter->second);
+    oarchive oarc;
+    oarc.buf = connection.buffer;
+    oarc.len = connection.buffer_length;
+    connection.buffer = nullptr;
+    connection.buffer_length = 0;
+    if (keys == nullptr) {
+      oarc << (char)(bulk_eval_serialized_tag::BULK_EVAL_COLUMNS) << lambda_hash;
+    } else {
+      oarc << (char)(bulk_eval_serialized_tag::BULK_EVAL_DICT_COLUMNS) << lambda_hash << *keys;
+    }
+    write_columnar(oarc, args);
+    oarc << skip_undefined << seed;
+    // if shmcall was good, return. 
+    if (shm_call(connection, oarc, out)) return true;
+
+    // otherwise shmcall was bad. reset the client so we don't ever use
+    // it again and fall back to regular IPC.
+    // (note. we cannot delete it from the
+    // m_shared_memory_worker_connections map because of concurency 
+    // issues. There may be parallel access to it and locking seems 
+    // overkill.
+    connection.client.reset();
+    logstream(LOG_WARNING) << "Unexpected SHMIPC failure. Falling back to CPPIPC" << std::endl;
+    return false;
+  }
+
+
   /**
    * \overload with sframe rows
    */
@@ -207,39 +249,7 @@ static lambda_master* instance_ptr = nullptr;
                                   std::vector<flexible_type>& out,
                                   bool skip_undefined,
                                   int seed) {
-
-    auto worker = m_worker_pool->get_worker();
-    auto worker_guard = m_worker_pool->get_worker_guard(worker);
-
-    // catch and reinterpret comm failure
-    try {
-      auto shmclient_iter = m_shared_memory_worker_connections.find(worker->proxy.get());
-      if (shmclient_iter != m_shared_memory_worker_connections.end() &&
-          shmclient_iter->second.get() != nullptr) {
-        auto& shmclient = shmclient_iter->second;
-        oarchive oarc;
-        oarc << (char)(bulk_eval_serialized_tag::BULK_EVAL_ROWS)
-             << lambda_hash
-             << args
-             << skip_undefined
-             << seed;
-        bool good = shm_call(shmclient, oarc, out);
-        // if shmcall was good, return. 
-        if (good) return;
-
-        // otherwise shmcall was bad. reset the client so we don't ever use
-        // it again and fall back to regular IPC.
-        // (note. we cannot delete it from the
-        // m_shared_memory_worker_connections map because of concurency 
-        // issues. There may be parallel access to it and locking seems 
-        // overkill.
-        shmclient.reset();
-        logstream(LOG_WARNING) << "Unexpected SHMIPC failure. Falling back to CPPIPC" << std::endl;
-      } 
-      out = worker->proxy->bulk_eval_rows(lambda_hash, args, skip_undefined, seed);
-    } catch (cppipc::ipcexception e) {
-      throw reinterpret_comm_failure(e);
-    }
+    eval_in_batches(lambda_hash, nullptr, args, out, skip_undefined, seed);
   }
 
 
@@ -264,38 +274,217 @@ static lambda_master* instance_ptr = nullptr;
                                   const sframe_rows& rows,
                                   std::vector<flexible_type>& out,
                                   bool skip_undefined, int seed) {
-    auto worker = m_worker_pool->get_worker();
-    auto worker_guard = m_worker_pool->get_worker_guard(worker);
+    eval_in_batches(lambda_hash, &keys, rows, out, skip_undefined, seed);
+  }
+
+
+  struct lambda_master::batched_eval {
+    size_t lambda_hash;
+    const std::vector<std::string>* keys;
+    const sframe_rows* rows;
+    std::vector<flexible_type>* out;
+    bool skip_undefined;
+    int seed;
+    /// The [begin, end) rows of each batch
+    std::vector<std::pair<size_t, size_t>> batches;
+
+    // The following are protected by m_batch_mtx
+    /// The next batch to start
+    size_t next_batch = 0;
+    /// The number of batches completed (or skipped after an error)
+    size_t num_completed = 0;
+    /// The first error
+    std::exception_ptr error;
+  };
+
+
+  void lambda_master::eval_on_worker(
+      std::unique_ptr<worker_process<lambda_evaluator_proxy>>& worker,
+      size_t lambda_hash,
+      const std::vector<std::string>* keys,
+      const sframe_rows& rows,
+      std::vector<flexible_type>& out,
+      bool skip_undefined, int seed) {
     // catch and reinterpret comm failure
     try {
-      auto shmclient_iter = m_shared_memory_worker_connections.find(worker->proxy.get());
-      if (shmclient_iter != m_shared_memory_worker_connections.end() &&
-          shmclient_iter->second.get() != nullptr) {
-        auto& shmclient = shmclient_iter->second;
-        oarchive oarc;
-        oarc << (char)(bulk_eval_serialized_tag::BULK_EVAL_DICT_ROWS)
-             << lambda_hash
-             << keys 
-             << rows
-             << skip_undefined
-             << seed;
-        bool good = shm_call(shmclient, oarc, out);
-        // everything good. return
-        if (good) return;
-
-
-        // shmcall was bad... reset the client so we don't ever use it again
-        // and fall back to regular IPC
-        shmclient.reset();
-        logstream(LOG_WARNING) << "Unexpected SHMIPC failure. Falling back to CPPIPC" << std::endl;
-      } 
-      out = worker->proxy->bulk_eval_dict_rows(lambda_hash, keys, rows, skip_undefined, seed);
+      if (shared_memory_bulk_eval(worker->proxy.get(), lambda_hash, keys,
+                                  rows, out, skip_undefined, seed)) {
+        return;
+      }
+      if (keys == nullptr) {
+        out = worker->proxy->bulk_eval_rows(lambda_hash, rows, skip_undefined, seed);
+      } else {
+        out = worker->proxy->bulk_eval_dict_rows(lambda_hash, *keys, rows,
+                                                 skip_undefined, seed);
+      }
     } catch (cppipc::ipcexception e) {
       throw reinterpret_comm_failure(e);
     }
   }
 
 
+  size_t lambda_master::batch_size(size_t lambda_hash, size_t num_rows) {
+    std::lock_guard<graphlab::mutex> lock(m_batch_mtx);
+    auto iter = m_seconds_per_row.find(lambda_hash);
+    if (iter == m_seconds_per_row.end()) {
+      // nothing measured yet: one batch per worker
+      return std::max<size_t>(1, (num_rows + num_workers() - 1) / num_workers());
+    }
+    double target_seconds = PYLAMBDA_BATCH_TARGET_MILLISECONDS / 1000.0;
+    double batch_rows = target_seconds / std::max(iter->second, 1e-9);
+    return std::max<size_t>(1, std::min<double>(batch_rows, num_rows));
+  }
+
+
+  void lambda_master::record_batch_time(size_t lambda_hash, size_t num_rows,
+                                        double seconds) {
+    if (num_rows == 0) return;
+    double seconds_per_row = seconds / num_rows;
+    std::lock_guard<graphlab::mutex> lock(m_batch_mtx);
+    auto iter = m_seconds_per_row.find(lambda_hash);
+    if (iter == m_seconds_per_row.end()) {
+      m_seconds_per_row[lambda_hash] = seconds_per_row;
+    } else {
+      iter->second = 0.7 * iter->second + 0.3 * seconds_per_row;
+    }
+  }
+
+
+  bool lambda_master::run_next_batch(const std::shared_ptr<batched_eval>& eval,
+                                     bool wait_for_worker) {
+    // Stops the evaluation: the batches not started are counted as completed
+    auto fail = [&](std::exception_ptr error) {
+      std::lock_guard<graphlab::mutex> lock(m_batch_mtx);
+      if (!eval->error) eval->error = error;
+      if (eval->next_batch < eval->batches.size()) {
+        eval->num_completed += eval->batches.size() - eval->next_batch;
+        eval->next_batch = eval->batches.size();
+        m_pending_evals.remove(eval);
+      }
+    };
+
+    {
+      std::lock_guard<graphlab::mutex> lock(m_batch_mtx);
+      if (eval->next_batch >= eval->batches.size()) return false;
+    }
+    std::unique_ptr<worker_process<lambda_evaluator_proxy>> worker;
+    try {
+      if (wait_for_worker) worker = m_worker_pool->get_worker();
+      else worker = m_worker_pool->try_get_worker();
+    } catch (...) {
+      fail(std::current_exception());
+      m_batch_cv.notify_all();
+      return false;
+    }
+    if (worker == nullptr) return false;
+
+    {
+      auto worker_guard = m_worker_pool->get_worker_guard(worker);
+      std::pair<size_t, size_t> batch;
+      {
+        std::lock_guard<graphlab::mutex> lock(m_batch_mtx);
+        if (eval->next_batch >= eval->batches.size()) return false;
+        batch = eval->batches[eval->next_batch++];
+        if (eval->next_batch == eval->batches.size()) m_pending_evals.remove(eval);
+      }
+
+      try {
+        sframe_rows batch_rows;
+        for (const auto& column: eval->rows->cget_columns()) {
+          batch_rows.add_decoded_column(std::make_shared<std::vector<flexible_type>>(
+              column->begin() + batch.first, column->begin() + batch.second));
+        }
+        std::vector<flexible_type> batch_out;
+        timer ti;
+        eval_on_worker(worker, eval->lambda_hash, eval->keys, batch_rows, batch_out,
+                       eval->skip_undefined, eval->seed);
+        record_batch_time(eval->lambda_hash, batch.second - batch.first, ti.current_time());
+        ASSERT_EQ(batch_out.size(), batch.second - batch.first);
+        std::move(batch_out.begin(), batch_out.end(), eval->out->begin() + batch.first);
+      } catch (...) {
+        fail(std::current_exception());
+      }
+    }
+
+    {
+      std::lock_guard<graphlab::mutex> lock(m_batch_mtx);
+      ++eval->num_completed;
+    }
+    m_batch_cv.notify_all();
+    return true;
+  }
+
+
+  void lambda_master::eval_in_batches(size_t lambda_hash,
+                                      const std::vector<std::string>* keys,
+                                      const sframe_rows& rows,
+                                      std::vector<flexible_type>& out,
+                                      bool skip_undefined, int seed) {
+    size_t num_rows = rows.num_rows();
+    size_t rows_per_batch = batch_size(lambda_hash, num_rows);
+    if (num_rows <= rows_per_batch) {
+      auto worker = m_worker_pool->get_worker();
+      auto worker_guard = m_worker_pool->get_worker_guard(worker);
+      timer ti;
+      eval_on_worker(worker, lambda_hash, keys, rows, out, skip_undefined, seed);
+      record_batch_time(lambda_hash, num_rows, ti.current_time());
+      return;
+    }
+
+    auto eval = std::make_shared<batched_eval>();
+    eval->lambda_hash = lambda_hash;
+    eval->keys = keys;
+    eval->rows = &rows;
+    eval->out = &out;
+    eval->skip_undefined = skip_undefined;
+    eval->seed = seed;
+    for (size_t begin = 0; begin < num_rows; begin += rows_per_batch) {
+      eval->batches.emplace_back(begin, std::min(begin + rows_per_batch, num_rows));
+    }
+    out.clear();
+    out.resize(num_rows);
+
+    {
+      std::lock_guard<graphlab::mutex> lock(m_batch_mtx);
+      m_pending_evals.push_back(eval);
+      if (m_batch_helpers == nullptr) {
+        m_batch_helpers.reset(new thread_pool(num_workers()));
+      }
+    }
+    // threads waiting on their last batches may now take some of ours
+    m_batch_cv.notify_all();
+
+    // and so may the workers which are idle
+    size_t num_helpers = std::min(eval->batches.size() - 1,
+                                  m_worker_pool->num_available_workers());
+    for (size_t i = 0; i < num_helpers; ++i) {
+      m_batch_helpers->launch([this, eval]() {
+        while (run_next_batch(eval, false)) { }
+      });
+    }
+
+    while (run_next_batch(eval, true)) { }
+
+    // All our batches are started. Until they complete, run the batches of
+    // the other evaluations.
+    std::unique_lock<graphlab::mutex> lock(m_batch_mtx);
+    while (eval->num_completed < eval->batches.size()) {
+      std::shared_ptr<batched_eval> other;
+      if (!m_pending_evals.empty()) other = m_pending_evals.front();
+      bool ran = false;
+      if (other != nullptr) {
+        lock.unlock();
+        ran = run_next_batch(other, false);
+        lock.lock();
+      }
+      if (!ran && eval->num_completed < eval->batches.size()) m_batch_cv.wait(lock);
+    }
+    lock.unlock();
+
+    if (eval->error) std::rethrow_exception(eval->error);
+  }
+
+
 /**
  * Set the path to the pylambda_worker binary from environment variables:
  *   "__GL_PYTHON_EXECUTABLE__" points to the python executable
@@ -9,7 +9,10 @@
 #define GRAPHLAB_LAMBDA_LAMBDA_MASTER_HPP
 
 #include <map>
+#include <list>
+#include <exception>
 #include <globals/globals.hpp>
+#include <parallel/thread_pool.hpp>
 #include <lambda/lambda_interface.hpp>
 #include <lambda/worker_pool.hpp>
 
@@ -39,6 +42,14 @@ namespace lambda {
    * The evaluation functions can be called in parallel. When this happens,
    * the master evenly allocates the jobs to workers who has the shortest job queue.
    *
+   * Evaluations on sframe_rows are split into batches sized after the
+   * measured evaluation time of the lambda (see
+   * PYLAMBDA_BATCH_TARGET_MILLISECONDS). The batches of an evaluation are
+   * run by the calling thread, by helper threads while there are idle
+   * workers, and by the threads of other evaluations waiting on their own
+   * last batches, so that one slow block of rows does not leave the other
+   * workers idle.
+   *
    * \code
    *
    * std::vector<flexible_type> args{0,1,2,3,4};
@@ -157,12 +168,83 @@ namespace lambda {
     lambda_master& operator=(lambda_master const&) = delete;
 
    private:
+    /**
+     * A shared memory connection to a worker. The buffer holds the
+     * arguments, then the reply, of the calls to the worker, and is reused
+     * by all the calls (a worker only runs one call at a time).
+     */
+    struct shared_memory_connection {
+      std::shared_ptr<shmipc::client> client;
+      char* buffer = nullptr;
+      size_t buffer_length = 0;
+      ~shared_memory_connection() { if (buffer) free(buffer); }
+    };
+
     std::shared_ptr<worker_pool<lambda_evaluator_proxy>> m_worker_pool;
-    std::map<void*, std::shared_ptr<shmipc::client>> m_shared_memory_worker_connections;
+    std::map<void*, std::shared_ptr<shared_memory_connection>> m_shared_memory_worker_connections;
+
+    /// An evaluation on sframe_rows, split into batches
+    struct batched_eval;
+
+    /**
+     * Evaluates the lambda on rows, in batches, and waits for all the
+     * batches to complete. keys is nullptr unless the lambda takes a
+     * dictionary argument.
+     */
+    void eval_in_batches(size_t lambda_hash,
+                         const std::vector<std::string>* keys,
+                         const sframe_rows& rows,
+                         std::vector<flexible_type>& out,
+                         bool skip_undefined, int seed);
+
+    /**
+     * Runs the next batch of the evaluation on an available worker. If
+     * wait_for_worker is false and no worker is available, returns false
+     * immediately. Also returns false if there is no batch left to start.
+     * Errors are stored in the evaluation.
+     */
+    bool run_next_batch(const std::shared_ptr<batched_eval>& eval, bool wait_for_worker);
+
+    /// Evaluates the lambda on all the rows using the given worker
+    void eval_on_worker(std::unique_ptr<worker_process<lambda_evaluator_proxy>>& worker,
+                        size_t lambda_hash,
+                        const std::vector<std::string>* keys,
+                        const sframe_rows& rows,
+                        std::vector<flexible_type>& out,
+                        bool skip_undefined, int seed);
+
+    /// The number of rows of a batch of the lambda
+    size_t batch_size(size_t lambda_hash, size_t num_rows);
+
+    /// Updates the average evaluation time of a row of the lambda
+    void record_batch_time(size_t lambda_hash, size_t num_rows, double seconds);
+
+    /**
+     * Evaluates the lambda on the columns of args through the shared memory
+     * connection of the worker, if there is one. Returns false if the call
+     * could not be made, in which case the regular IPC must be used.
+     */
+    bool shared_memory_bulk_eval(void* worker_proxy,
+                                 size_t lambda_hash,
+                                 const std::vector<std::string>* keys,
+                                 const sframe_rows& args,
+                                 std::vector<flexible_type>& out,
+                                 bool skip_undefined, int seed);
 
     std::unordered_map<size_t, size_t> m_lambda_object_counter;
     graphlab::mutex m_mtx;
 
+    /// Protects the members below
+    graphlab::mutex m_batch_mtx;
+    /// Signaled when a batch completes, or batches are added
+    graphlab::condition_variable m_batch_cv;
+    /// The evaluations which have batches not started yet
+    std::list<std::shared_ptr<batched_eval>> m_pending_evals;
+    /// Running average of the evaluation time of a row, per lambda
+    std::unordered_map<size_t, double> m_seconds_per_row;
+    /// Runs batches on idle workers. Destroyed before the workers.
+    std::unique_ptr<thread_pool> m_batch_helpers;
+
     /** The binary for executing the lambda_workers.
      */
     static std::vector<std::string> lambda_worker_binary_and_args;    
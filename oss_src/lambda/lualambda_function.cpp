@@ -0,0 +1,198 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <lambda/lualambda_function.hpp>
+#include <sframe/sframe_rows.hpp>
+#include <logger/logger.hpp>
+#include <logger/assertions.hpp>
+#include <boost/algorithm/string.hpp>
+#ifdef HAS_LUAJIT
+#include <luastate/LuaState.h>
+extern "C" {
+#include <lua/luajit.h>
+}
+#endif
+
+namespace graphlab {
+namespace lambda {
+
+bool is_lua_lambda(const std::string& lambda_str) {
+  return boost::starts_with(lambda_str, "LUA");
+}
+
+#ifdef HAS_LUAJIT
+
+bool lua_lambda_supported() { return true; }
+
+/**
+ * Converts the value returned by a Lua function to a flexible_type.
+ */
+static flexible_type from_lua_value(lua::Value& valret) {
+  if (valret.is<lua::Integer>()) {
+    lua::Integer val = 0;
+    valret.get<lua::Integer>(val);
+    return flex_int(val);
+  } else if (valret.is<lua::Number>()) {
+    lua::Number val = 0;
+    valret.get<lua::Number>(val);
+    return flex_float(val);
+  } else if (valret.is<lua::String>()) {
+    std::string val;
+    valret.get<std::string>(val);
+    return flex_string(std::move(val));
+  } else {
+    return FLEX_UNDEFINED;
+  }
+}
+
+/**
+ * Calls the function on a single value, dispatching on its type.
+ */
+static flexible_type call_lua_function(lua::Value& function, const flexible_type& arg) {
+  lua::Value valret;
+  switch(arg.get_type()) {
+   case flex_type_enum::INTEGER:
+     valret = function(arg.get<flex_int>());
+     break;
+   case flex_type_enum::FLOAT:
+     valret = function(arg.get<flex_float>());
+     break;
+   case flex_type_enum::STRING:
+     valret = function(arg.get<flex_string>().c_str());
+     break;
+   case flex_type_enum::UNDEFINED:
+     valret = function(lua::Nil());
+     break;
+   default:
+     log_and_throw(std::string("Lua lambdas do not support values of type ") +
+                   flex_type_enum_to_name(arg.get_type()));
+  };
+
+  return from_lua_value(valret);
+}
+
+/**
+ * Sets table[key] = value, dispatching on the type of the value.
+ */
+static void set_lua_field(lua::Value& table, const std::string& key,
+                          const flexible_type& value) {
+  switch(value.get_type()) {
+   case flex_type_enum::INTEGER:
+     table.set(key.c_str(), value.get<flex_int>());
+     break;
+   case flex_type_enum::FLOAT:
+     table.set(key.c_str(), value.get<flex_float>());
+     break;
+   case flex_type_enum::STRING:
+     table.set(key.c_str(), value.get<flex_string>().c_str());
+     break;
+   case flex_type_enum::UNDEFINED:
+     table.set(key.c_str(), lua::Nil());
+     break;
+   default:
+     log_and_throw(std::string("Lua lambdas do not support values of type ") +
+                   flex_type_enum_to_name(value.get_type()));
+  }
+}
+
+void lualambda_function::compile() {
+  std::string source = m_lambda_str.substr(3);
+  try {
+    m_state.reset(new lua::State(true));
+    luaJIT_setmode(m_state->getState().get(), 0, LUAJIT_MODE_ENGINE|LUAJIT_MODE_ON);
+    m_state->doString(source);
+    // the many to one version passes the row as a table, which is reused
+    // for every row of the batch
+    m_state->doString("__row__ = {}\n"
+                      "__lambda__row__ = function() return __lambda__transfer__(__row__) end");
+  } catch (const std::exception& e) {
+    m_state.reset();
+    log_and_throw(std::string("Cannot compile Lua lambda: ") + e.what());
+  }
+}
+
+/* One to one */
+void lualambda_function::eval(const sframe_rows& rows,
+                              std::vector<flexible_type>& out) {
+  if (m_state == nullptr) compile();
+  ASSERT_EQ(rows.num_columns(), 1);
+  // read the values straight from the decoded column of the batch
+  const auto& column = *(rows.cget_columns()[0]);
+  out.resize(column.size());
+  try {
+    auto function = (*m_state)["__lambda__transfer__"];
+    for (size_t i = 0; i < column.size(); ++i) {
+      if (m_skip_undefined && column[i].get_type() == flex_type_enum::UNDEFINED) {
+        out[i] = FLEX_UNDEFINED;
+      } else {
+        out[i] = call_lua_function(function, column[i]);
+      }
+    }
+  } catch (const std::exception& e) {
+    log_and_throw(std::string("Error evaluating Lua lambda: ") + e.what());
+  }
+}
+
+/* Many to one */
+void lualambda_function::eval(const std::vector<std::string>& keys,
+                              const sframe_rows& rows,
+                              std::vector<flexible_type>& out) {
+  if (m_state == nullptr) compile();
+  const auto& columns = rows.cget_columns();
+  ASSERT_EQ(columns.size(), keys.size());
+  out.resize(rows.num_rows());
+  try {
+    auto row = (*m_state)["__row__"];
+    auto function = (*m_state)["__lambda__row__"];
+    for (size_t i = 0; i < out.size(); ++i) {
+      for (size_t j = 0; j < keys.size(); ++j) {
+        set_lua_field(row, keys[j], (*columns[j])[i]);
+      }
+      lua::Value valret = function();
+      out[i] = from_lua_value(valret);
+    }
+  } catch (const std::exception& e) {
+    log_and_throw(std::string("Error evaluating Lua lambda: ") + e.what());
+  }
+}
+
+#else
+
+bool lua_lambda_supported() { return false; }
+
+void lualambda_function::compile() {
+  log_and_throw("Lua lambdas are not supported: this build does not include LuaJIT");
+}
+
+void lualambda_function::eval(const sframe_rows& rows,
+                              std::vector<flexible_type>& out) {
+  compile();
+}
+
+void lualambda_function::eval(const std::vector<std::string>& keys,
+                              const sframe_rows& rows,
+                              std::vector<flexible_type>& out) {
+  compile();
+}
+
+#endif
+
+lualambda_function::lualambda_function(const std::string& lambda_str)
+    : m_lambda_str(lambda_str) {
+  if (!is_lua_lambda(lambda_str)) {
+    log_and_throw("Lua lambdas must start with \"LUA\"");
+  }
+}
+
+lualambda_function::~lualambda_function() { }
+
+void lualambda_function::set_skip_undefined(bool value) {
+  m_skip_undefined = value;
+}
+
+} // end of lambda
+} // end of graphlab
@@ -0,0 +1,99 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_LAMBDA_LUALAMBDA_FUNCTION_HPP
+#define GRAPHLAB_LAMBDA_LUALAMBDA_FUNCTION_HPP
+
+#include<vector>
+#include<string>
+#include<memory>
+#include<flexible_type/flexible_type.hpp>
+
+namespace lua {
+class State;
+};
+
+namespace graphlab {
+
+class sframe_rows;
+
+namespace lambda {
+
+/**
+ * Returns true if the lambda string is a Lua lambda, i.e. Lua source
+ * prefixed with "LUA" which assigns the function to __lambda__transfer__.
+ *
+ * \code
+ * LUA __lambda__transfer__ = function(x) return x + 1 end
+ * \endcode
+ */
+bool is_lua_lambda(const std::string& lambda_str);
+
+/**
+ * Returns true if this build can evaluate Lua lambdas in process.
+ */
+bool lua_lambda_supported();
+
+/**
+ * Represents a Lua lambda function which is evaluated in process.
+ *
+ * Unlike the pylambda_function, which ships every batch to a pool of
+ * pylambda workers, the lualambda_function owns its own Lua (LuaJIT)
+ * state: the lambda is compiled on the first call to eval() and the
+ * following batches call it directly on the values of the sframe_rows,
+ * without any copy or IPC.
+ *
+ * A lualambda_function is not thread safe. Each thread evaluating the
+ * lambda must use its own instance (the query operators are instantiated
+ * once per executing thread, so each operator simply owns one).
+ *
+ * \code
+ * lualambda_function f("LUA __lambda__transfer__ = function(x) return x + 1 end");
+ * f.set_skip_undefined(true);
+ * std::vector<flexible_type> out;
+ * f.eval(rows, out);
+ * \endcode
+ *
+ * Values of type INTEGER, FLOAT, STRING and UNDEFINED (as nil) can be
+ * passed to and returned from the lambda.
+ */
+class lualambda_function {
+ public:
+  lualambda_function(const std::string& lambda_str);
+
+  lualambda_function(const lualambda_function& other) = delete;
+  lualambda_function& operator=(const lualambda_function& other) = delete;
+
+  ~lualambda_function();
+
+  //// Options
+  void set_skip_undefined(bool value);
+
+  //// Evaluating Interface
+
+  /* One to one */
+  void eval(const sframe_rows& rows,
+            std::vector<flexible_type>& out);
+
+  /* Many to one. The lambda is called with a table keyed by column name. */
+  void eval(const std::vector<std::string>& keys,
+            const sframe_rows& rows,
+            std::vector<flexible_type>& out);
+
+ private:
+  /// Creates the Lua state and compiles the lambda into it.
+  void compile();
+
+  std::string m_lambda_str;
+  bool m_skip_undefined = false;
+  std::shared_ptr<lua::State> m_state;
+};
+
+} // end of lambda namespace
+} // end of graphlab namespace
+
+#endif
@@ -6,6 +6,7 @@
  * of the BSD license. See the LICENSE file for details.
  */
 #include <lambda/pylambda.hpp>
+#include <lambda/columnar_transport.hpp>
 #include <sframe/sarray.hpp>
 #include <sframe/sframe.hpp>
 #include <sframe/sframe_rows.hpp>
@@ -114,20 +115,9 @@ std::vector<flexible_type> pylambda_evaluator::bulk_eval_rows(
     const sframe_rows& rows,
     bool skip_undefined,
     int seed) {
-
-  evaluation_functions.set_random_seed(seed);
-
-  std::vector<flexible_type> ret(rows.num_rows());
-  
-  size_t i = 0;
-  for (const auto& x : rows) {
-    if (skip_undefined && x[0] == FLEX_UNDEFINED) {
-      ret[i++] = FLEX_UNDEFINED;
-    } else {
-      ret[i++] = eval(lambda_id, x[0]);
-    }
-  }
-  return ret;
+  // The rows have a single column, which is evaluated in one call.
+  DASSERT_EQ(rows.num_columns(), 1);
+  return bulk_eval(lambda_id, *rows.cget_columns()[0], skip_undefined, seed);
 }
 
 
@@ -183,10 +173,12 @@ std::vector<flexible_type> pylambda_evaluator::bulk_eval_dict_rows(
 }
 
 std::vector<flexible_type>
-pylambda_evaluator::bulk_eval_rows_serialized(const char* ptr, size_t len) {
+pylambda_evaluator::bulk_eval_rows_serialized(const char* ptr, size_t len,
+                                              bool& columnar_reply) {
   iarchive iarc(ptr, len);
   char c;
   iarc >> c;
+  columnar_reply = false;
   if (c == (char)bulk_eval_serialized_tag::BULK_EVAL_ROWS) {
     size_t lambda_id;
     sframe_rows rows;
@@ -202,6 +194,30 @@ pylambda_evaluator::bulk_eval_rows_serialized(const char* ptr, size_t len) {
     int seed;
     iarc >> lambda_id >> keys >> values >> skip_undefined >> seed;
     return bulk_eval_dict_rows(lambda_id, keys, values, skip_undefined, seed);
+  } else if (c == (char)bulk_eval_serialized_tag::BULK_EVAL_COLUMNS) {
+    size_t lambda_id;
+    std::vector<sframe_rows::ptr_to_decoded_column_type> columns;
+    bool skip_undefined;
+    int seed;
+    iarc >> lambda_id;
+    read_columnar(iarc, columns);
+    iarc >> skip_undefined >> seed;
+    ASSERT_EQ(columns.size(), 1);
+    columnar_reply = true;
+    return bulk_eval(lambda_id, *columns[0], skip_undefined, seed);
+  } else if (c == (char)bulk_eval_serialized_tag::BULK_EVAL_DICT_COLUMNS) {
+    size_t lambda_id;
+    std::vector<std::string> keys;
+    std::vector<sframe_rows::ptr_to_decoded_column_type> columns;
+    bool skip_undefined;
+    int seed;
+    iarc >> lambda_id >> keys;
+    read_columnar(iarc, columns);
+    iarc >> skip_undefined >> seed;
+    sframe_rows values;
+    for (const auto& column: columns) values.add_decoded_column(column);
+    columnar_reply = true;
+    return bulk_eval_dict_rows(lambda_id, keys, values, skip_undefined, seed);
   } else {
     logstream(LOG_FATAL) << "Invalid serialized result" << std::endl;
     return std::vector<flexible_type>();
@@ -236,8 +252,12 @@ std::string pylambda_evaluator::initialize_shared_memory_comm() {
                 oarc.buf = send_buffer;
                 oarc.len = send_buffer_length;
                 try {
-                  auto ret = bulk_eval_rows_serialized(receive_buffer, message_length);
-                  oarc << (char)(1) << ret;
+                  bool columnar_reply = false;
+                  auto ret = bulk_eval_rows_serialized(receive_buffer, message_length,
+                                                       columnar_reply);
+                  oarc << (char)(1);
+                  if (columnar_reply) write_columnar(oarc, ret);
+                  else oarc << ret;
                 } catch (std::string& s) {
                   oarc << (char)(0) << s;
                 } catch (const char* s) {
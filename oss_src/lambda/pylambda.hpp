@@ -211,12 +211,15 @@ class pylambda_evaluator : public lambda_evaluator_interface {
   /**
    * Redirects to either bulk_eval_rows or bulk_eval_dict_rows.
    * First byte in the string is a bulk_eval_serialized_tag byte to denote
-   * whether this call is going to bulk_eval_rows or bulk_eval_dict_rows.
+   * whether this call is going to bulk_eval_rows or bulk_eval_dict_rows,
+   * and whether the arguments are in the columnar format.
    *
    * Deserializes the remaining parameters from the string 
-   * and calls the function accordingly.
+   * and calls the function accordingly. columnar_reply is set if the
+   * result must be sent back in the columnar format.
    */
-  std::vector<flexible_type> bulk_eval_rows_serialized(const char* ptr, size_t len);
+  std::vector<flexible_type> bulk_eval_rows_serialized(const char* ptr, size_t len,
+                                                       bool& columnar_reply);
 
   graphlab::shmipc::server* m_shared_memory_server;
   graphlab::thread m_shared_memory_listener;
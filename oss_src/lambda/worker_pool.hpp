@@ -238,6 +238,20 @@ public:
     return worker;
   }
 
+  /**
+   * Return the next available worker, or nullptr if no worker is
+   * available right now. Never blocks.
+   *
+   * \note: As with get_worker(), a returned worker must be released.
+   */
+  std::unique_ptr<worker_process<ProxyType>> try_get_worker() {
+    std::unique_lock<graphlab::mutex> lck(m_mutex);
+    if (m_available_workers.empty()) return nullptr;
+    auto worker = std::move(m_available_workers.front());
+    m_available_workers.pop_front();
+    return worker;
+  }
+
   /**
    * Returns a worker_guard for the given worker.
    * When the worker_guard goes out of the scope, the guarded
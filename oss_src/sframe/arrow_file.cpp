@@ -0,0 +1,897 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <logger/logger.hpp>
+#include <logger/assertions.hpp>
+#include <parallel/lambda_omp.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sarray.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/arrow_file.hpp>
+#include <fileio/general_fstream.hpp>
+
+namespace graphlab {
+
+namespace {
+
+/*
+ * The Arrow IPC file format: the magic string, the encapsulated schema and
+ * record batch messages, and a footer locating the record batches. Each
+ * message is a FlatBuffers table (Message.fbs), followed by its body: the
+ * buffers of all the columns, each aligned to 8 bytes. See
+ * https://arrow.apache.org/docs/format/Columnar.html
+ */
+
+// Type union (Schema.fbs)
+const uint8_t TYPE_INT = 2;
+const uint8_t TYPE_FLOATING_POINT = 3;
+const uint8_t TYPE_BINARY = 4;
+const uint8_t TYPE_UTF8 = 5;
+const uint8_t TYPE_BOOL = 6;
+const uint8_t TYPE_LARGE_BINARY = 19;
+const uint8_t TYPE_LARGE_UTF8 = 20;
+
+// MessageHeader union (Message.fbs)
+const uint8_t HEADER_SCHEMA = 1;
+const uint8_t HEADER_RECORD_BATCH = 3;
+
+const int16_t METADATA_V5 = 4;
+const int16_t PRECISION_SINGLE = 1;
+const int16_t PRECISION_DOUBLE = 2;
+
+const std::string ARROW_MAGIC = "ARROW1";
+const uint32_t CONTINUATION_MARKER = 0xFFFFFFFF;
+
+// Sizes of the structs of the metadata
+const size_t BLOCK_SIZE = 24;
+const size_t FIELD_NODE_SIZE = 16;
+const size_t BUFFER_SIZE = 16;
+
+template <typename T>
+std::string to_bytes(T value) {
+  return std::string(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void pad_to(std::string& buf, size_t alignment) {
+  buf.resize((buf.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+size_t padding(size_t length) {
+  return (8 - length % 8) % 8;
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                         FlatBuffers Encoding                           */
+/*                                                                        */
+/**************************************************************************/
+
+struct fb_object;
+typedef std::shared_ptr<fb_object> fb_ptr;
+
+/**
+ * A table, a vector or a string of the metadata, to be serialized into a
+ * flatbuffer. Unlike the FlatBuffers library, which builds the buffer back
+ * to front, objects are serialized after the objects referring to them, so
+ * that every offset points forward.
+ */
+struct fb_object {
+  enum kind_type { TABLE, TABLE_VECTOR, STRUCT_VECTOR, STRING };
+  kind_type kind = TABLE;
+
+  /// The scalar fields of a table, by field id
+  std::map<size_t, std::string> scalars;
+  /// The table, vector and string fields of a table, by field id
+  std::map<size_t, fb_ptr> children;
+  /// The tables of a table vector
+  std::vector<fb_ptr> elements;
+  /// The bytes of a string or of a struct vector
+  std::string bytes;
+  size_t struct_size = 0;
+
+  template <typename T>
+  fb_object& add(size_t id, T value) {
+    scalars[id] = to_bytes(value);
+    return *this;
+  }
+
+  fb_object& add(size_t id, fb_ptr child) {
+    children[id] = child;
+    return *this;
+  }
+};
+
+fb_ptr fb_table() {
+  return std::make_shared<fb_object>();
+}
+
+fb_ptr fb_string(const std::string& value) {
+  auto ret = std::make_shared<fb_object>();
+  ret->kind = fb_object::STRING;
+  ret->bytes = value;
+  return ret;
+}
+
+fb_ptr fb_tables(const std::vector<fb_ptr>& elements) {
+  auto ret = std::make_shared<fb_object>();
+  ret->kind = fb_object::TABLE_VECTOR;
+  ret->elements = elements;
+  return ret;
+}
+
+fb_ptr fb_structs(const std::string& bytes, size_t struct_size) {
+  auto ret = std::make_shared<fb_object>();
+  ret->kind = fb_object::STRUCT_VECTOR;
+  ret->bytes = bytes;
+  ret->struct_size = struct_size;
+  return ret;
+}
+
+/**
+ * Appends the object, and then the objects it refers to, to buf. Returns
+ * the position of the object, which offsets to it point to.
+ */
+size_t fb_write(std::string& buf, const fb_object& obj) {
+  size_t pos = 0;
+  // (position of the offset, object it points to)
+  std::vector<std::pair<size_t, const fb_object*> > children;
+  switch(obj.kind) {
+   case fb_object::STRING:
+     pad_to(buf, 4);
+     pos = buf.size();
+     buf += to_bytes<uint32_t>(obj.bytes.size());
+     buf += obj.bytes;
+     buf.push_back('\0');
+     return pos;
+   case fb_object::STRUCT_VECTOR:
+     // the structs have 8 byte members, and follow the 4 byte length
+     pad_to(buf, 8);
+     buf.append(4, '\0');
+     pos = buf.size();
+     buf += to_bytes<uint32_t>(obj.bytes.size() / obj.struct_size);
+     buf += obj.bytes;
+     return pos;
+   case fb_object::TABLE_VECTOR:
+     pad_to(buf, 4);
+     pos = buf.size();
+     buf += to_bytes<uint32_t>(obj.elements.size());
+     for (const auto& element: obj.elements) {
+       children.push_back({buf.size(), element.get()});
+       buf.append(4, '\0');
+     }
+     break;
+   case fb_object::TABLE: {
+     size_t num_fields = 0;
+     if (!obj.scalars.empty()) num_fields = obj.scalars.rbegin()->first + 1;
+     if (!obj.children.empty()) {
+       num_fields = std::max(num_fields, obj.children.rbegin()->first + 1);
+     }
+     // the vtable comes first, then the table: its offset to the vtable,
+     // and the fields, largest first, each aligned to its size.
+     pad_to(buf, 2);
+     size_t vtable_pos = buf.size();
+     size_t vtable_size = 4 + 2 * num_fields;
+     size_t table_pos = (vtable_pos + vtable_size + 3) / 4 * 4;
+     std::vector<std::pair<size_t, size_t> > layout; // (size, field id)
+     for (const auto& field: obj.scalars) layout.push_back({field.second.size(), field.first});
+     for (const auto& field: obj.children) layout.push_back({4, field.first});
+     std::stable_sort(layout.begin(), layout.end(),
+                      [](const std::pair<size_t, size_t>& a,
+                         const std::pair<size_t, size_t>& b) {
+                        return a.first > b.first;
+                      });
+     std::vector<uint16_t> field_offsets(num_fields, 0);
+     size_t table_end = table_pos + 4;
+     for (const auto& field: layout) {
+       table_end = (table_end + field.first - 1) / field.first * field.first;
+       field_offsets[field.second] = table_end - table_pos;
+       table_end += field.first;
+     }
+     buf += to_bytes<uint16_t>(vtable_size);
+     buf += to_bytes<uint16_t>(table_end - table_pos);
+     for (uint16_t offset: field_offsets) buf += to_bytes<uint16_t>(offset);
+     buf.resize(table_end, '\0');
+     int32_t vtable_offset = table_pos - vtable_pos;
+     memcpy(&buf[table_pos], &vtable_offset, 4);
+     for (const auto& field: obj.scalars) {
+       buf.replace(table_pos + field_offsets[field.first],
+                   field.second.size(), field.second);
+     }
+     for (const auto& field: obj.children) {
+       children.push_back({table_pos + field_offsets[field.first],
+                           field.second.get()});
+     }
+     pos = table_pos;
+     break;
+   }
+  }
+  for (const auto& child: children) {
+    uint32_t offset = fb_write(buf, *child.second) - child.first;
+    memcpy(&buf[child.first], &offset, 4);
+  }
+  return pos;
+}
+
+/**
+ * Serializes a flatbuffer with the given root table, padded to 8 bytes.
+ */
+std::string fb_finish(const fb_object& root) {
+  std::string buf(4, '\0');
+  uint32_t root_offset = fb_write(buf, root);
+  memcpy(&buf[0], &root_offset, 4);
+  pad_to(buf, 8);
+  return buf;
+}
+
+/**
+ * A table of a flatbuffer being read. Every access is bounds checked, and
+ * throws if the buffer is corrupted.
+ */
+class fb_table_reader {
+ public:
+  /// The root table of the flatbuffer, which must outlive the reader.
+  explicit fb_table_reader(const std::string& buf)
+      : buf(&buf), pos(deref(0)) { }
+
+  bool has(size_t id) const {
+    return field(id) != 0;
+  }
+
+  template <typename T>
+  T scalar(size_t id, T default_value = T()) const {
+    size_t at = field(id);
+    return at ? read<T>(at) : default_value;
+  }
+
+  fb_table_reader table(size_t id) const {
+    size_t at = field(id);
+    if (at == 0) corrupted();
+    return fb_table_reader(*buf, deref(at));
+  }
+
+  std::string string(size_t id) const {
+    size_t at = field(id);
+    if (at == 0) return "";
+    size_t begin = deref(at);
+    size_t length = read<uint32_t>(begin);
+    if (begin + 4 + length > buf->size()) corrupted();
+    return buf->substr(begin + 4, length);
+  }
+
+  /// The length of a vector field, 0 if absent.
+  size_t length(size_t id) const {
+    size_t at = field(id);
+    return at ? read<uint32_t>(deref(at)) : 0;
+  }
+
+  /// The i-th table of a table vector field.
+  fb_table_reader element(size_t id, size_t i) const {
+    if (i >= length(id)) corrupted();
+    return fb_table_reader(*buf, deref(deref(field(id)) + 4 + 4 * i));
+  }
+
+  /// A member of the i-th struct of a struct vector field.
+  template <typename T>
+  T struct_member(size_t id, size_t i, size_t struct_size, size_t offset) const {
+    if (i >= length(id)) corrupted();
+    return read<T>(deref(field(id)) + 4 + i * struct_size + offset);
+  }
+
+ private:
+  fb_table_reader(const std::string& buf, size_t pos): buf(&buf), pos(pos) { }
+
+  static void corrupted() {
+    log_and_throw("Corrupted Arrow file metadata");
+  }
+
+  template <typename T>
+  T read(size_t at) const {
+    if (at + sizeof(T) > buf->size()) corrupted();
+    T ret;
+    memcpy(&ret, buf->data() + at, sizeof(T));
+    return ret;
+  }
+
+  size_t deref(size_t at) const {
+    return at + read<uint32_t>(at);
+  }
+
+  /// The position of a field of the table, 0 if absent.
+  size_t field(size_t id) const {
+    int64_t vtable = int64_t(pos) - read<int32_t>(pos);
+    if (vtable < 0) corrupted();
+    size_t vtable_size = read<uint16_t>(vtable);
+    if (4 + 2 * id + 2 > vtable_size) return 0;
+    size_t offset = read<uint16_t>(vtable + 4 + 2 * id);
+    return offset ? pos + offset : 0;
+  }
+
+  const std::string* buf;
+  size_t pos;
+};
+
+/**************************************************************************/
+/*                                                                        */
+/*                               Metadata                                 */
+/*                                                                        */
+/**************************************************************************/
+
+/**
+ * A column of an Arrow file, and how its values are stored.
+ */
+struct arrow_column {
+  std::string name;
+  uint8_t type = 0;
+  /// Of the integers, floats, or string offsets
+  size_t bit_width = 0;
+  bool is_signed = true;
+  /// Validity bitmap, then values, or offsets and data
+  size_t num_buffers = 0;
+};
+
+struct arrow_buffer {
+  size_t offset = 0;
+  size_t length = 0;
+};
+
+struct arrow_record_batch {
+  /// The position of the body in the file
+  size_t body_offset = 0;
+  size_t length = 0;
+  /// One per column
+  std::vector<size_t> null_counts;
+  /// The buffers of all the columns, in column order
+  std::vector<arrow_buffer> buffers;
+};
+
+struct arrow_file {
+  std::vector<arrow_column> columns;
+  std::vector<arrow_record_batch> record_batches;
+};
+
+flex_type_enum sframe_type(const arrow_column& column) {
+  switch(column.type) {
+   case TYPE_INT:
+   case TYPE_BOOL:
+     return flex_type_enum::INTEGER;
+   case TYPE_FLOATING_POINT:
+     return flex_type_enum::FLOAT;
+   default:
+     return flex_type_enum::STRING;
+  }
+}
+
+/**
+ * Reads length bytes at offset of the file.
+ */
+std::string read_range(general_ifstream& fin, size_t offset, size_t length) {
+  std::string ret(length, '\0');
+  fin.seekg(offset);
+  fin.read(&ret[0], length);
+  if (!fin.good() || size_t(fin.gcount()) != length) {
+    log_and_throw("Unable to read " + fin.filename() + ": unexpected end of file");
+  }
+  return ret;
+}
+
+arrow_column read_field(const fb_table_reader& field) {
+  arrow_column ret;
+  ret.name = field.string(0);
+  if (field.has(4)) {
+    log_and_throw("Column " + ret.name + " is dictionary encoded, which is not supported");
+  }
+  ret.type = field.scalar<uint8_t>(2);
+  switch(ret.type) {
+   case TYPE_INT: {
+     fb_table_reader type = field.table(3);
+     ret.bit_width = type.scalar<int32_t>(0);
+     ret.is_signed = type.scalar<uint8_t>(1) != 0;
+     if (ret.bit_width != 8 && ret.bit_width != 16 &&
+         ret.bit_width != 32 && ret.bit_width != 64) {
+       log_and_throw("Column " + ret.name + " has an invalid integer width");
+     }
+     ret.num_buffers = 2;
+     break;
+   }
+   case TYPE_FLOATING_POINT: {
+     int16_t precision = field.table(3).scalar<int16_t>(0);
+     if (precision == PRECISION_SINGLE) ret.bit_width = 32;
+     else if (precision == PRECISION_DOUBLE) ret.bit_width = 64;
+     else log_and_throw("Column " + ret.name + " has half precision floats, which are not supported");
+     ret.num_buffers = 2;
+     break;
+   }
+   case TYPE_BOOL:
+     ret.bit_width = 1;
+     ret.num_buffers = 2;
+     break;
+   case TYPE_UTF8:
+   case TYPE_BINARY:
+     ret.bit_width = 32;
+     ret.num_buffers = 3;
+     break;
+   case TYPE_LARGE_UTF8:
+   case TYPE_LARGE_BINARY:
+     ret.bit_width = 64;
+     ret.num_buffers = 3;
+     break;
+   default:
+     log_and_throw("Column " + ret.name + " has an Arrow type which is not supported");
+  }
+  return ret;
+}
+
+/**
+ * Reads the schema from the footer, and the metadata of all the record
+ * batches, which locates the buffers of every column.
+ */
+arrow_file read_arrow_metadata(const std::string& url) {
+  general_ifstream fin(url, false);
+  size_t file_size = fin.file_size();
+  const size_t trailer_size = 4 + ARROW_MAGIC.size();
+  if (file_size == (size_t)(-1) || file_size < 8 + trailer_size ||
+      read_range(fin, 0, ARROW_MAGIC.size()) != ARROW_MAGIC ||
+      read_range(fin, file_size - ARROW_MAGIC.size(), ARROW_MAGIC.size()) != ARROW_MAGIC) {
+    log_and_throw(url + " is not an Arrow file");
+  }
+  int32_t footer_length;
+  std::string trailer = read_range(fin, file_size - trailer_size, 4);
+  memcpy(&footer_length, trailer.data(), 4);
+  if (footer_length <= 0 || size_t(footer_length) > file_size - 8 - trailer_size) {
+    log_and_throw("Corrupted Arrow file footer");
+  }
+  std::string footer_buf = read_range(fin, file_size - trailer_size - footer_length,
+                                      footer_length);
+  fb_table_reader footer(footer_buf);
+
+  arrow_file ret;
+  fb_table_reader schema = footer.table(1);
+  size_t num_buffers = 0;
+  for (size_t i = 0; i < schema.length(1); ++i) {
+    ret.columns.push_back(read_field(schema.element(1, i)));
+    num_buffers += ret.columns.back().num_buffers;
+  }
+
+  for (size_t i = 0; i < footer.length(3); ++i) {
+    size_t offset = footer.struct_member<int64_t>(3, i, BLOCK_SIZE, 0);
+    size_t metadata_length = footer.struct_member<int32_t>(3, i, BLOCK_SIZE, 8);
+    size_t body_length = footer.struct_member<int64_t>(3, i, BLOCK_SIZE, 16);
+    if (metadata_length < 8 || offset > file_size ||
+        metadata_length > file_size - offset ||
+        body_length > file_size - offset - metadata_length) {
+      log_and_throw("Corrupted Arrow file footer");
+    }
+    // the message is prefixed by the continuation marker and its length,
+    // or only by its length in files written before Arrow 0.15.
+    std::string message_buf = read_range(fin, offset, metadata_length);
+    uint32_t marker;
+    memcpy(&marker, message_buf.data(), 4);
+    message_buf.erase(0, marker == CONTINUATION_MARKER ? 8 : 4);
+    fb_table_reader message(message_buf);
+    if (message.scalar<uint8_t>(1) != HEADER_RECORD_BATCH) {
+      log_and_throw("Corrupted Arrow file: expected a record batch");
+    }
+    fb_table_reader record_batch = message.table(2);
+    if (record_batch.has(3)) {
+      log_and_throw("Compressed Arrow files are not supported");
+    }
+
+    arrow_record_batch batch;
+    batch.body_offset = offset + metadata_length;
+    // every row takes at least a bit in the buffers of each column, which
+    // bounds the sizes computed from the length
+    int64_t length = record_batch.scalar<int64_t>(0);
+    if (length < 0 ||
+        (!ret.columns.empty() && size_t(length) / 8 > body_length)) {
+      log_and_throw("Corrupted Arrow file: invalid record batch length");
+    }
+    batch.length = length;
+    if (record_batch.length(1) != ret.columns.size() ||
+        record_batch.length(2) != num_buffers) {
+      log_and_throw("Corrupted Arrow file: the record batch does not match the schema");
+    }
+    for (size_t j = 0; j < ret.columns.size(); ++j) {
+      batch.null_counts.push_back(
+          record_batch.struct_member<int64_t>(1, j, FIELD_NODE_SIZE, 8));
+    }
+    for (size_t j = 0; j < num_buffers; ++j) {
+      arrow_buffer buffer;
+      buffer.offset = record_batch.struct_member<int64_t>(2, j, BUFFER_SIZE, 0);
+      buffer.length = record_batch.struct_member<int64_t>(2, j, BUFFER_SIZE, 8);
+      if (buffer.offset > body_length || buffer.length > body_length - buffer.offset) {
+        log_and_throw("Corrupted Arrow file: buffer out of the record batch");
+      }
+      batch.buffers.push_back(buffer);
+    }
+    ret.record_batches.push_back(std::move(batch));
+  }
+  return ret;
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                                Reading                                 */
+/*                                                                        */
+/**************************************************************************/
+
+template <typename T>
+T value_at(const std::string& values, size_t i) {
+  T ret;
+  memcpy(&ret, values.data() + i * sizeof(T), sizeof(T));
+  return ret;
+}
+
+flexible_type integer_at(const std::string& values, size_t i,
+                         const arrow_column& column) {
+  bool is_signed = column.is_signed;
+  switch(column.bit_width) {
+   case 8:
+     return is_signed ? flex_int(value_at<int8_t>(values, i))
+                      : flex_int(value_at<uint8_t>(values, i));
+   case 16:
+     return is_signed ? flex_int(value_at<int16_t>(values, i))
+                      : flex_int(value_at<uint16_t>(values, i));
+   case 32:
+     return is_signed ? flex_int(value_at<int32_t>(values, i))
+                      : flex_int(value_at<uint32_t>(values, i));
+   default:
+     if (!is_signed && value_at<uint64_t>(values, i) >
+         uint64_t(std::numeric_limits<flex_int>::max())) {
+       log_and_throw("Column " + column.name + " has unsigned 64 bit values " +
+                     "above the integer range, which are not supported");
+     }
+     return flex_int(value_at<int64_t>(values, i));
+  }
+}
+
+/**
+ * Decodes a column of a record batch, appending it to a segment of the
+ * output array. first_buffer is the index of the first buffer of the column
+ * in the batch.
+ */
+void read_column(general_ifstream& fin,
+                 const arrow_column& column,
+                 const arrow_record_batch& batch,
+                 size_t first_buffer,
+                 size_t null_count,
+                 sarray<flexible_type>::iterator& out) {
+  auto read_buffer = [&](size_t i, size_t min_length) {
+    const arrow_buffer& buffer = batch.buffers[first_buffer + i];
+    if (buffer.length < min_length) {
+      log_and_throw("Corrupted Arrow file: buffer of column " + column.name + " is too short");
+    }
+    return read_range(fin, batch.body_offset + buffer.offset, buffer.length);
+  };
+  size_t num_rows = batch.length;
+  size_t bitmap_length = (num_rows + 7) / 8;
+  // the validity bitmap may be omitted when there are no nulls
+  std::string validity = null_count ? read_buffer(0, bitmap_length) : "";
+  auto is_valid = [&](size_t i) {
+    return validity.empty() || ((validity[i / 8] >> (i % 8)) & 1);
+  };
+
+  if (column.num_buffers == 2) {
+    std::string values = read_buffer(1, column.bit_width == 1 ?
+                                        bitmap_length :
+                                        num_rows * column.bit_width / 8);
+    for (size_t i = 0; i < num_rows; ++i, ++out) {
+      if (!is_valid(i)) {
+        (*out) = FLEX_UNDEFINED;
+      } else if (column.type == TYPE_BOOL) {
+        (*out) = flex_int((values[i / 8] >> (i % 8)) & 1);
+      } else if (column.type == TYPE_INT) {
+        (*out) = integer_at(values, i, column);
+      } else if (column.bit_width == 32) {
+        (*out) = flex_float(value_at<float>(values, i));
+      } else {
+        (*out) = flex_float(value_at<double>(values, i));
+      }
+    }
+  } else {
+    std::string offsets = read_buffer(1, (num_rows + 1) * column.bit_width / 8);
+    auto offset_at = [&](size_t i) {
+      return column.bit_width == 32 ? int64_t(value_at<int32_t>(offsets, i))
+                                    : value_at<int64_t>(offsets, i);
+    };
+    std::string data = read_buffer(2, offset_at(num_rows) > 0 ? offset_at(num_rows) : 0);
+    for (size_t i = 0; i < num_rows; ++i, ++out) {
+      if (!is_valid(i)) {
+        (*out) = FLEX_UNDEFINED;
+        continue;
+      }
+      int64_t begin = offset_at(i), end = offset_at(i + 1);
+      if (begin < 0 || end < begin || size_t(end) > data.size()) {
+        log_and_throw("Corrupted Arrow file: invalid offsets in column " + column.name);
+      }
+      (*out) = flex_string(data.data() + begin, end - begin);
+    }
+  }
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                                Writing                                 */
+/*                                                                        */
+/**************************************************************************/
+
+/**
+ * The buffers of a column of a record batch being written.
+ */
+struct column_buffers {
+  std::vector<std::string> buffers;
+  size_t null_count = 0;
+  /// Whether the strings are too long for 32 bit offsets
+  bool overflow = false;
+};
+
+column_buffers encode_column(sarray_reader<flexible_type>& reader,
+                             flex_type_enum type,
+                             size_t begin, size_t end) {
+  std::vector<flexible_type> values;
+  reader.read_rows(begin, end, values);
+  size_t num_rows = values.size();
+  column_buffers ret;
+  std::string validity((num_rows + 7) / 8, '\0');
+  for (size_t i = 0; i < num_rows; ++i) {
+    if (values[i].get_type() == flex_type_enum::UNDEFINED) ++ret.null_count;
+    else validity[i / 8] |= (1 << (i % 8));
+  }
+  // the validity bitmap is omitted when there are no nulls
+  if (ret.null_count == 0) validity.clear();
+  ret.buffers.push_back(std::move(validity));
+
+  if (type == flex_type_enum::INTEGER || type == flex_type_enum::FLOAT) {
+    std::string data(num_rows * 8, '\0');
+    for (size_t i = 0; i < num_rows; ++i) {
+      if (values[i].get_type() == flex_type_enum::UNDEFINED) continue;
+      if (type == flex_type_enum::INTEGER) {
+        flex_int value = values[i].get<flex_int>();
+        memcpy(&data[i * 8], &value, 8);
+      } else {
+        flex_float value = values[i].get<flex_float>();
+        memcpy(&data[i * 8], &value, 8);
+      }
+    }
+    ret.buffers.push_back(std::move(data));
+  } else {
+    std::string offsets((num_rows + 1) * 4, '\0');
+    std::string data;
+    for (size_t i = 0; i < num_rows; ++i) {
+      if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+        data += values[i].get<flex_string>();
+        if (data.size() > size_t(std::numeric_limits<int32_t>::max())) {
+          ret.overflow = true;
+          return ret;
+        }
+      }
+      int32_t offset = data.size();
+      memcpy(&offsets[(i + 1) * 4], &offset, 4);
+    }
+    ret.buffers.push_back(std::move(offsets));
+    ret.buffers.push_back(std::move(data));
+  }
+  return ret;
+}
+
+fb_ptr make_schema(const sframe& frame) {
+  std::vector<fb_ptr> fields;
+  for (size_t i = 0; i < frame.num_columns(); ++i) {
+    fb_ptr type = fb_table();
+    uint8_t type_id = 0;
+    switch(frame.column_type(i)) {
+     case flex_type_enum::INTEGER:
+       type_id = TYPE_INT;
+       type->add(0, int32_t(64)).add(1, uint8_t(1));
+       break;
+     case flex_type_enum::FLOAT:
+       type_id = TYPE_FLOATING_POINT;
+       type->add(0, PRECISION_DOUBLE);
+       break;
+     case flex_type_enum::STRING:
+       type_id = TYPE_UTF8;
+       break;
+     default:
+       log_and_throw("Column " + frame.column_name(i) + " of type " +
+                     flex_type_enum_to_name(frame.column_type(i)) +
+                     " cannot be written to an Arrow file");
+    }
+    fb_ptr field = fb_table();
+    field->add(0, fb_string(frame.column_name(i)))
+        .add(1, uint8_t(1))
+        .add(2, type_id)
+        .add(3, type)
+        .add(5, fb_tables({}));
+    fields.push_back(field);
+  }
+  fb_ptr schema = fb_table();
+  schema->add(0, int16_t(0)).add(1, fb_tables(fields));
+  return schema;
+}
+
+/**
+ * Serializes an encapsulated message: the continuation marker, the length
+ * of the metadata, and the metadata, padded to 8 bytes.
+ */
+std::string make_message(uint8_t header_type, fb_ptr header, size_t body_length) {
+  fb_ptr message = fb_table();
+  message->add(0, METADATA_V5)
+      .add(1, header_type)
+      .add(2, header)
+      .add(3, int64_t(body_length));
+  std::string metadata = fb_finish(*message);
+  return to_bytes(CONTINUATION_MARKER) + to_bytes<int32_t>(metadata.size()) + metadata;
+}
+
+} // anonymous namespace
+
+arrow_file_info read_arrow_file_info(const std::string& url) {
+  arrow_file file = read_arrow_metadata(url);
+  arrow_file_info ret;
+  for (const auto& column: file.columns) {
+    ret.column_names.push_back(column.name);
+    ret.column_types.push_back(sframe_type(column));
+  }
+  for (const auto& batch: file.record_batches) {
+    ret.record_batch_lengths.push_back(batch.length);
+  }
+  return ret;
+}
+
+sframe read_arrow_file(const std::string& url, const arrow_read_options& options) {
+  arrow_file file = read_arrow_metadata(url);
+
+  std::vector<size_t> column_ids;
+  if (options.columns.empty()) {
+    for (size_t i = 0; i < file.columns.size(); ++i) column_ids.push_back(i);
+  }
+  for (const auto& name: options.columns) {
+    auto iter = std::find_if(file.columns.begin(), file.columns.end(),
+                             [&](const arrow_column& column) {
+                               return column.name == name;
+                             });
+    if (iter == file.columns.end()) {
+      log_and_throw("Column " + name + " not found in " + url);
+    }
+    column_ids.push_back(iter - file.columns.begin());
+  }
+  std::vector<size_t> batch_ids = options.record_batches;
+  if (options.record_batches.empty()) {
+    for (size_t i = 0; i < file.record_batches.size(); ++i) batch_ids.push_back(i);
+  }
+  for (size_t batch_id: batch_ids) {
+    if (batch_id >= file.record_batches.size()) {
+      log_and_throw("Record batch " + std::to_string(batch_id) + " not found in " + url);
+    }
+  }
+  std::vector<size_t> first_buffers;
+  size_t num_buffers = 0;
+  for (const auto& column: file.columns) {
+    first_buffers.push_back(num_buffers);
+    num_buffers += column.num_buffers;
+  }
+
+  // each segment gets a contiguous run of record batches
+  size_t num_segments = std::max<size_t>(
+      1, std::min<size_t>(batch_ids.size(), thread::cpu_count()));
+  std::vector<std::shared_ptr<sarray<flexible_type> > > columns;
+  std::vector<std::string> column_names;
+  for (size_t column_id: column_ids) {
+    auto column = std::make_shared<sarray<flexible_type> >();
+    column->open_for_write(num_segments);
+    column->set_type(sframe_type(file.columns[column_id]));
+    columns.push_back(column);
+    column_names.push_back(file.columns[column_id].name);
+  }
+  parallel_for(0, column_ids.size() * num_segments, [&](size_t i) {
+    size_t column = i % column_ids.size();
+    size_t segment = i / column_ids.size();
+    size_t column_id = column_ids[column];
+    general_ifstream fin(url, false);
+    auto out = columns[column]->get_output_iterator(segment);
+    for (size_t batch = batch_ids.size() * segment / num_segments;
+         batch < batch_ids.size() * (segment + 1) / num_segments; ++batch) {
+      const arrow_record_batch& record_batch = file.record_batches[batch_ids[batch]];
+      read_column(fin, file.columns[column_id], record_batch,
+                  first_buffers[column_id], record_batch.null_counts[column_id],
+                  out);
+    }
+  });
+  for (auto& column: columns) column->close();
+  return sframe(columns, column_names);
+}
+
+void write_arrow_file(const sframe& frame,
+                      const std::string& url,
+                      size_t rows_per_batch) {
+  ASSERT_GT(rows_per_batch, 0);
+  fb_ptr schema = make_schema(frame);
+  std::vector<std::unique_ptr<sarray_reader<flexible_type> > > readers;
+  for (size_t i = 0; i < frame.num_columns(); ++i) {
+    readers.push_back(frame.select_column(i)->get_reader());
+  }
+
+  general_ofstream fout(url, false);
+  size_t file_position = 0;
+  auto write = [&](const std::string& bytes) {
+    fout.write(bytes.data(), bytes.size());
+    if (!fout.good()) log_and_throw("Fail to write to " + url);
+    file_position += bytes.size();
+  };
+  write(ARROW_MAGIC + std::string(2, '\0'));
+  write(make_message(HEADER_SCHEMA, schema, 0));
+
+  std::string blocks;
+  std::function<void(size_t, size_t)> write_record_batch = [&](size_t begin, size_t end) {
+    std::vector<column_buffers> encoded(frame.num_columns());
+    parallel_for(0, frame.num_columns(), [&](size_t i) {
+      encoded[i] = encode_column(*readers[i], frame.column_type(i), begin, end);
+    });
+    // the string offsets are 32 bit: split batches with too many characters
+    for (const auto& column: encoded) {
+      if (!column.overflow) continue;
+      if (end - begin == 1) {
+        log_and_throw("String of more than 2GB cannot be written to an Arrow file");
+      }
+      size_t middle = begin + (end - begin) / 2;
+      write_record_batch(begin, middle);
+      write_record_batch(middle, end);
+      return;
+    }
+
+    std::string nodes, buffers;
+    size_t body_length = 0;
+    for (const auto& column: encoded) {
+      nodes += to_bytes<int64_t>(end - begin) + to_bytes<int64_t>(column.null_count);
+      for (const auto& buffer: column.buffers) {
+        buffers += to_bytes<int64_t>(body_length) + to_bytes<int64_t>(buffer.size());
+        body_length += buffer.size() + padding(buffer.size());
+      }
+    }
+    fb_ptr record_batch = fb_table();
+    record_batch->add(0, int64_t(end - begin))
+        .add(1, fb_structs(nodes, FIELD_NODE_SIZE))
+        .add(2, fb_structs(buffers, BUFFER_SIZE));
+    std::string message = make_message(HEADER_RECORD_BATCH, record_batch, body_length);
+    blocks += to_bytes<int64_t>(file_position) + to_bytes<int32_t>(message.size()) +
+              std::string(4, '\0') + to_bytes<int64_t>(body_length);
+    write(message);
+    for (const auto& column: encoded) {
+      for (const auto& buffer: column.buffers) {
+        write(buffer);
+        write(std::string(padding(buffer.size()), '\0'));
+      }
+    }
+  };
+  for (size_t begin = 0; begin < frame.num_rows(); begin += rows_per_batch) {
+    write_record_batch(begin, std::min(begin + rows_per_batch, frame.num_rows()));
+  }
+  // end of stream
+  write(to_bytes(CONTINUATION_MARKER) + to_bytes<int32_t>(0));
+
+  fb_ptr footer = fb_table();
+  footer->add(0, METADATA_V5)
+      .add(1, schema)
+      .add(2, fb_structs("", BLOCK_SIZE))
+      .add(3, fb_structs(blocks, BLOCK_SIZE));
+  std::string footer_buf = fb_finish(*footer);
+  write(footer_buf);
+  write(to_bytes<int32_t>(footer_buf.size()));
+  write(ARROW_MAGIC);
+  fout.close();
+}
+
+}
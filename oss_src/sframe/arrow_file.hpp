@@ -0,0 +1,80 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_ARROW_FILE_HPP
+#define GRAPHLAB_SFRAME_ARROW_FILE_HPP
+#include <string>
+#include <vector>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sframe.hpp>
+namespace graphlab {
+
+/**
+ * The contents of an Arrow file, as returned by \ref read_arrow_file_info.
+ */
+struct arrow_file_info {
+  /// The names of the columns
+  std::vector<std::string> column_names;
+
+  /// The SFrame type each column is read as
+  std::vector<flex_type_enum> column_types;
+
+  /// The number of rows in each record batch
+  std::vector<size_t> record_batch_lengths;
+};
+
+/**
+ * All the options pertaining to reading Arrow files.
+ */
+struct arrow_read_options {
+  /// The columns to read, in column order. If empty, all the columns.
+  std::vector<std::string> columns;
+
+  /// The indices of the record batches to read, in order. If empty, all of them.
+  std::vector<size_t> record_batches;
+};
+
+/**
+ * Reads the schema and the record batch lengths of an Arrow IPC file
+ * (the "Feather V2" format) without reading any column data.
+ */
+arrow_file_info read_arrow_file_info(const std::string& url);
+
+/**
+ * Reads an Arrow IPC file into a new SFrame.
+ *
+ * The record batches read are split into contiguous runs, one per segment
+ * (at most one per cpu), and the (column, segment) pairs are decoded in
+ * parallel, directly from the Arrow buffers into the column arrays: only
+ * the buffers of the selected columns and record batches are read from the
+ * file.
+ *
+ * Integer and boolean columns are read as integers, floating point columns
+ * as floats, and utf8 and binary columns (including the large variants) as
+ * strings. Nulls are missing values. Throws if a selected column has any
+ * other type, or unsigned 64 bit values above the integer range, or if the
+ * file uses dictionary encoding or compression.
+ */
+sframe read_arrow_file(const std::string& url,
+                       const arrow_read_options& options = arrow_read_options());
+
+/**
+ * Writes an SFrame into an Arrow IPC file, in record batches of at most
+ * rows_per_batch rows. Integer columns are written as 64 bit integers,
+ * float columns as doubles and string columns as utf8, with missing values
+ * as nulls. Throws if the frame has a column of any other type.
+ *
+ * The record batches are read column by column, and the columns of each
+ * batch are encoded in parallel.
+ */
+void write_arrow_file(const sframe& frame,
+                      const std::string& url,
+                      size_t rows_per_batch = 65536);
+
+}
+
+#endif // GRAPHLAB_SFRAME_ARROW_FILE_HPP
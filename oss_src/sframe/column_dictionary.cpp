@@ -0,0 +1,51 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <sframe/column_dictionary.hpp>
+
+namespace graphlab {
+
+bool column_dictionary::find(const flex_string& value, size_t& code) const {
+  auto iter = m_codes.find(value);
+  if (iter == m_codes.end()) return false;
+  code = iter->second;
+  return true;
+}
+
+bool column_dictionary::insert(const flex_string& value,
+                               size_t max_size,
+                               size_t& code) {
+  if (find(value, code)) return true;
+  if (m_values.size() >= max_size) return false;
+  code = m_values.size();
+  m_values.push_back(value);
+  m_codes[value] = code;
+  return true;
+}
+
+void column_dictionary::save(oarchive& oarc) const {
+  oarc << (uint64_t)m_values.size();
+  for (const auto& value: m_values) {
+    oarc << value.get<flex_string>();
+  }
+}
+
+void column_dictionary::load(iarchive& iarc) {
+  uint64_t num_values = 0;
+  iarc >> num_values;
+  m_values.clear();
+  m_codes.clear();
+  m_values.reserve(num_values);
+  flex_string value;
+  for (size_t i = 0;i < num_values; ++i) {
+    iarc >> value;
+    m_codes[value] = i;
+    m_values.push_back(value);
+  }
+}
+
+} // namespace graphlab
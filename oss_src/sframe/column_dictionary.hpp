@@ -0,0 +1,77 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_COLUMN_DICTIONARY_HPP
+#define GRAPHLAB_SFRAME_COLUMN_DICTIONARY_HPP
+#include <vector>
+#include <unordered_map>
+#include <flexible_type/flexible_type.hpp>
+#include <serialization/serialization_includes.hpp>
+namespace graphlab {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_main Main SFrame Objects
+ * \{
+ */
+
+/**
+ * The dictionary of the strings of a column, shared by all the blocks of
+ * the column.
+ *
+ * The string blocks of a column with few distinct values are stored as
+ * codes into the dictionary (see the v2 block encoder,
+ * sarray_v2_type_encoding.hpp), and can be read as codes (see
+ * \ref typed_column), so that operators can compare strings by comparing
+ * their codes.
+ *
+ * Codes are assigned in insertion order and never change: a dictionary is
+ * only ever appended to, so the dictionary of a column at some point in
+ * time is a prefix of the dictionary at any later point.
+ */
+class column_dictionary {
+ public:
+  /// The number of strings in the dictionary
+  inline size_t size() const {
+    return m_values.size();
+  }
+
+  /// Returns the string of the given code, as a STRING flexible_type
+  inline const flexible_type& value(size_t code) const {
+    return m_values[code];
+  }
+
+  /// Returns all the strings, in the order of their codes
+  inline const std::vector<flexible_type>& values() const {
+    return m_values;
+  }
+
+  /**
+   * Looks up the code of a string. Returns false if the string is not in
+   * the dictionary.
+   */
+  bool find(const flex_string& value, size_t& code) const;
+
+  /**
+   * Looks up the code of a string, adding the string to the dictionary if
+   * it is not there yet. Returns false if the string is not in the
+   * dictionary and the dictionary already holds max_size strings.
+   */
+  bool insert(const flex_string& value, size_t max_size, size_t& code);
+
+  void save(oarchive& oarc) const;
+
+  void load(iarchive& iarc);
+
+ private:
+  std::vector<flexible_type> m_values;
+  std::unordered_map<flex_string, size_t> m_codes;
+};
+
+/// \}
+} // namespace graphlab
+#endif
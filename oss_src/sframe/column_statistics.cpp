@@ -0,0 +1,220 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+#include <logger/assertions.hpp>
+#include <sframe/column_statistics.hpp>
+
+namespace graphlab {
+
+/**
+ * The number of buckets of the hyperloglog sketch is 2^HLL_BITS.
+ * 2^12 buckets take 4KB per column, for a standard error of about 1.6%.
+ */
+static constexpr size_t HLL_BITS = 12;
+
+/// The accuracy of the quantile sketch
+static constexpr double QUANTILE_EPSILON = 0.01;
+
+/// The selectivity of range comparisons which cannot be estimated
+static constexpr double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3;
+
+/**************************************************************************/
+/*                                                                        */
+/*                           column_statistics                            */
+/*                                                                        */
+/**************************************************************************/
+
+double column_statistics::defined_fraction() const {
+  if (num_rows == 0) return 0;
+  return double(num_rows - num_undefined) / num_rows;
+}
+
+/**
+ * Estimates the fraction of the values of a distribution, described by
+ * equally spaced quantiles, which are below value. If strict is true, the
+ * values equal to value are excluded.
+ */
+static double fraction_below(const std::vector<double>& quantiles,
+                             double value, bool strict) {
+  size_t k = quantiles.size();
+  double step = 1.0 / (k - 1);
+  if (strict) {
+    // the first quantile >= value
+    size_t i = std::lower_bound(quantiles.begin(), quantiles.end(), value) - quantiles.begin();
+    if (i == 0) return 0;
+    if (i == k) return 1;
+    double lo = quantiles[i - 1], hi = quantiles[i];
+    return (i - 1) * step + (value - lo) / (hi - lo) * step;
+  } else {
+    // the last quantile <= value
+    size_t i = std::upper_bound(quantiles.begin(), quantiles.end(), value) - quantiles.begin();
+    if (i == 0) return 0;
+    if (i == k) return 1;
+    double lo = quantiles[i - 1], hi = quantiles[i];
+    return (i - 1) * step + (value - lo) / (hi - lo) * step;
+  }
+}
+
+double column_statistics::selectivity(const std::string& op,
+                                      const flexible_type& value) const {
+  if (num_rows == 0) return 0;
+  double defined = defined_fraction();
+  bool numeric_value = value.get_type() == flex_type_enum::INTEGER ||
+                       value.get_type() == flex_type_enum::FLOAT;
+
+  // the fraction of the defined values equal to value
+  double equal = num_distinct >= 1 ? 1.0 / num_distinct : 1.0;
+  if (numeric_value && quantiles.size() >= 2) {
+    double v = value;
+    if (v < quantiles.front() || v > quantiles.back()) {
+      equal = 0;
+    } else {
+      // a frequent value spans several quantiles
+      equal = std::max(equal, fraction_below(quantiles, v, false) -
+                              fraction_below(quantiles, v, true));
+    }
+  }
+
+  double ret;
+  if (op == "==") {
+    ret = defined * equal;
+  } else if (op == "!=") {
+    ret = 1.0 - defined * equal;
+  } else if (numeric_value && quantiles.size() >= 2) {
+    double v = value;
+    if (op == "<") ret = defined * fraction_below(quantiles, v, true);
+    else if (op == "<=") ret = defined * fraction_below(quantiles, v, false);
+    else if (op == ">") ret = defined * (1.0 - fraction_below(quantiles, v, false));
+    else if (op == ">=") ret = defined * (1.0 - fraction_below(quantiles, v, true));
+    else ret = defined * DEFAULT_RANGE_SELECTIVITY;
+  } else {
+    ret = defined * DEFAULT_RANGE_SELECTIVITY;
+  }
+  return std::min(1.0, std::max(0.0, ret));
+}
+
+std::map<std::string, std::string> column_statistics::to_map() const {
+  std::map<std::string, std::string> ret;
+  ret["num_rows"] = std::to_string(num_rows);
+  ret["num_undefined"] = std::to_string(num_undefined);
+  ret["num_distinct"] = std::to_string(num_distinct);
+  if (!quantiles.empty()) {
+    std::stringstream strm;
+    strm.precision(17);
+    for (size_t i = 0; i < quantiles.size(); ++i) {
+      if (i > 0) strm << " ";
+      strm << quantiles[i];
+    }
+    ret["quantiles"] = strm.str();
+  }
+  return ret;
+}
+
+bool column_statistics::from_map(const std::map<std::string, std::string>& map) {
+  if (!map.count("num_rows") || !map.count("num_undefined") ||
+      !map.count("num_distinct")) {
+    return false;
+  }
+  num_rows = std::strtoull(map.at("num_rows").c_str(), NULL, 10);
+  num_undefined = std::strtoull(map.at("num_undefined").c_str(), NULL, 10);
+  num_distinct = std::strtod(map.at("num_distinct").c_str(), NULL);
+  quantiles.clear();
+  if (map.count("quantiles")) {
+    std::stringstream strm(map.at("quantiles"));
+    double val;
+    while (strm >> val) quantiles.push_back(val);
+  }
+  return num_undefined <= num_rows;
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                       column_statistics_builder                        */
+/*                                                                        */
+/**************************************************************************/
+
+column_statistics_builder::column_statistics_builder(): m_distinct(HLL_BITS) { }
+
+void column_statistics_builder::add(const std::vector<flexible_type>& values) {
+  ASSERT_TRUE(m_result == nullptr);
+  ASSERT_FALSE(m_combining);
+  m_num_rows += values.size();
+  for (const auto& val: values) {
+    switch(val.get_type()) {
+     case flex_type_enum::UNDEFINED:
+       ++m_num_undefined;
+       break;
+     case flex_type_enum::INTEGER:
+     case flex_type_enum::FLOAT:
+       m_distinct.add(val);
+       if (m_numeric) {
+         if (!m_quantiles) m_quantiles.reset(new quantile_sketch_type(QUANTILE_EPSILON));
+         m_quantiles->add((double)val);
+       }
+       break;
+     default:
+       m_distinct.add(val);
+       if (m_numeric) {
+         m_numeric = false;
+         m_quantiles.reset();
+       }
+    }
+  }
+}
+
+void column_statistics_builder::combine(column_statistics_builder& other) {
+  ASSERT_TRUE(m_result == nullptr);
+  ASSERT_TRUE(other.m_result == nullptr);
+  m_num_rows += other.m_num_rows;
+  m_num_undefined += other.m_num_undefined;
+  m_distinct.combine(other.m_distinct);
+  m_numeric = m_numeric && other.m_numeric;
+  if (!m_numeric) {
+    m_quantiles.reset();
+    other.m_quantiles.reset();
+    return;
+  }
+  // the quantile sketches are combined after a partial finalization
+  if (!m_combining) {
+    if (!m_quantiles) m_quantiles.reset(new quantile_sketch_type(QUANTILE_EPSILON));
+    m_quantiles->substream_finalize();
+    m_combining = true;
+  }
+  if (other.m_quantiles) {
+    if (!other.m_combining) other.m_quantiles->substream_finalize();
+    m_quantiles->combine(std::move(*other.m_quantiles));
+    other.m_quantiles.reset();
+  }
+  other.m_combining = true;
+}
+
+size_t column_statistics_builder::num_rows() const {
+  return m_num_rows;
+}
+
+column_statistics column_statistics_builder::finalize() {
+  if (m_result) return *m_result;
+  column_statistics ret;
+  ret.num_rows = m_num_rows;
+  ret.num_undefined = m_num_undefined;
+  ret.num_distinct = std::min<double>(m_distinct.estimate(), m_num_rows - m_num_undefined);
+  if (m_numeric && m_quantiles && m_quantiles->size() > 0) {
+    if (m_combining) m_quantiles->combine_finalize();
+    else m_quantiles->finalize();
+    for (size_t i = 0; i < NUM_QUANTILES; ++i) {
+      ret.quantiles.push_back(m_quantiles->query_quantile(double(i) / (NUM_QUANTILES - 1)));
+    }
+    m_quantiles.reset();
+  }
+  m_result.reset(new column_statistics(ret));
+  return ret;
+}
+
+} // namespace graphlab
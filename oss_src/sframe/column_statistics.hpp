@@ -0,0 +1,134 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_COLUMN_STATISTICS_HPP
+#define GRAPHLAB_SFRAME_COLUMN_STATISTICS_HPP
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <flexible_type/flexible_type.hpp>
+#include <sketches/hyperloglog.hpp>
+#include <sketches/streaming_quantile_sketch.hpp>
+namespace graphlab {
+
+/**
+ * \ingroup sframe_physical
+ * \addtogroup sframe_main Main SFrame Objects
+ * \{
+ */
+
+/**
+ * Summary statistics of a whole column, used by the query optimizer to
+ * estimate the number of rows flowing through a query plan.
+ *
+ * The statistics are computed from sketches while the column is written
+ * (see \ref column_statistics_builder), and are stored in the array index
+ * file (the "statistics" field of \ref index_file_information).
+ * They are approximate: the number of distinct values comes from a
+ * hyperloglog sketch, and the quantiles from a quantile sketch.
+ */
+struct column_statistics {
+  /// The number of rows of the column
+  size_t num_rows = 0;
+  /// The number of UNDEFINED values
+  size_t num_undefined = 0;
+  /// An estimate of the number of distinct defined values
+  double num_distinct = 0;
+  /**
+   * Equally spaced quantiles of the values: quantiles[i] is the
+   * (i / (quantiles.size() - 1)) quantile. Empty if the defined values are
+   * not all numeric.
+   */
+  std::vector<double> quantiles;
+
+  /// Returns the fraction of the values which are not UNDEFINED.
+  double defined_fraction() const;
+
+  /**
+   * Estimates the fraction of the rows for which (x op value) is true,
+   * where op is one of "<", ">", "<=", ">=", "==", "!=". UNDEFINED values
+   * only satisfy "!=" (the SArray comparisons of a missing value with a
+   * constant).
+   */
+  double selectivity(const std::string& op, const flexible_type& value) const;
+
+  /**
+   * Stores the statistics as a dictionary of strings, in the format of
+   * index_file_information::statistics.
+   */
+  std::map<std::string, std::string> to_map() const;
+
+  /**
+   * Reads the statistics stored by to_map(). Returns false if the
+   * dictionary does not contain statistics (for instance, the column was
+   * written by an older version).
+   */
+  bool from_map(const std::map<std::string, std::string>& map);
+};
+
+/**
+ * Accumulates the \ref column_statistics of a column while it is written.
+ *
+ * A builder is not safe for concurrent use: the values written in
+ * parallel (for instance, to different segments) go to different builders,
+ * which are merged once done.
+ *
+ * \code
+ * std::vector<column_statistics_builder> builders(num_segments);
+ * // for each block of segment i
+ * builders[i].add(values);
+ * // once done
+ * column_statistics_builder total;
+ * for (auto& builder: builders) total.combine(builder);
+ * column_statistics stats = total.finalize();
+ * \endcode
+ */
+class column_statistics_builder {
+ public:
+  /// The number of quantiles stored in the column statistics
+  static constexpr size_t NUM_QUANTILES = 33;
+
+  column_statistics_builder();
+
+  /// Adds a block of values.
+  void add(const std::vector<flexible_type>& values);
+
+  /**
+   * Merges the values added to another builder into this one. No values
+   * may be added to either builder afterwards.
+   */
+  void combine(column_statistics_builder& other);
+
+  /// The number of values added so far
+  size_t num_rows() const;
+
+  /**
+   * Computes the statistics of all the values added. No values may be
+   * added once finalize() is called; further calls return the same result.
+   */
+  column_statistics finalize();
+
+ private:
+  typedef sketches::streaming_quantile_sketch<double> quantile_sketch_type;
+
+  size_t m_num_rows = 0;
+  size_t m_num_undefined = 0;
+  /// True while all the defined values seen are numeric
+  bool m_numeric = true;
+  sketches::hyperloglog m_distinct;
+  std::unique_ptr<quantile_sketch_type> m_quantiles;
+  /// True once m_quantiles is substream finalized, ready to be combined
+  bool m_combining = false;
+  /// The result of finalize(), once called
+  std::unique_ptr<column_statistics> m_result;
+};
+
+/// \}
+} // namespace graphlab
+#endif
@@ -14,6 +14,12 @@
 #include <cstdlib>
 #include <algorithm>
 #include <boost/config/warning_disable.hpp>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 #include <sframe/csv_line_tokenizer.hpp>
 #include <flexible_type/string_escape.hpp>
 #include <flexible_type/flexible_type_spirit_parser.hpp>
@@ -206,6 +212,98 @@ size_t csv_line_tokenizer::tokenize_line(char* str, size_t len,
 };
 
 
+/**
+ * Parses an integer made of an optional sign and at most 18 digits,
+ * surrounded by white space: the common case, which does not need the
+ * spirit parser. Returns false if the buffer is anything else, in which case
+ * the spirit parser decides.
+ */
+static inline bool fast_int_parse(const char* c, size_t len, flex_int& out) {
+  const char* end = c + len;
+  while (c != end && (*c == ' ' || *c == '\t')) ++c;
+  bool negative = false;
+  if (c != end && (*c == '-' || *c == '+')) {
+    negative = (*c == '-');
+    ++c;
+  }
+  const char* digits_begin = c;
+  uint64_t value = 0;
+  while (c != end && *c >= '0' && *c <= '9') {
+    value = value * 10 + (*c - '0');
+    ++c;
+  }
+  size_t num_digits = c - digits_begin;
+  if (num_digits == 0 || num_digits > 18) return false;
+  while (c != end && std::isspace(*c)) ++c;
+  if (c != end) return false;
+  out = negative ? -(flex_int)value : (flex_int)value;
+  return true;
+}
+
+/**
+ * Parses a decimal number of at most 15 digits with an optional exponent,
+ * whose value is a product or quotient of two exactly representable doubles
+ * (the mantissa and a power of 10 up to 1e22), and hence is correctly
+ * rounded by a single operation. Returns false for anything else (more
+ * digits, larger exponents, inf, nan, ...), in which case the spirit parser
+ * decides.
+ */
+static inline bool fast_double_parse(const char* c, size_t len, double& out) {
+  static const double powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  const char* end = c + len;
+  while (c != end && (*c == ' ' || *c == '\t')) ++c;
+  bool negative = false;
+  if (c != end && (*c == '-' || *c == '+')) {
+    negative = (*c == '-');
+    ++c;
+  }
+  uint64_t mantissa = 0;
+  size_t num_digits = 0;
+  int exponent = 0;
+  while (c != end && *c >= '0' && *c <= '9') {
+    mantissa = mantissa * 10 + (*c - '0');
+    ++num_digits;
+    ++c;
+  }
+  if (c != end && *c == '.') {
+    ++c;
+    while (c != end && *c >= '0' && *c <= '9') {
+      mantissa = mantissa * 10 + (*c - '0');
+      ++num_digits;
+      --exponent;
+      ++c;
+    }
+  }
+  if (num_digits == 0 || num_digits > 15) return false;
+  if (c != end && (*c == 'e' || *c == 'E')) {
+    ++c;
+    bool negative_exponent = false;
+    if (c != end && (*c == '-' || *c == '+')) {
+      negative_exponent = (*c == '-');
+      ++c;
+    }
+    const char* exponent_begin = c;
+    int explicit_exponent = 0;
+    while (c != end && *c >= '0' && *c <= '9' && c - exponent_begin < 3) {
+      explicit_exponent = explicit_exponent * 10 + (*c - '0');
+      ++c;
+    }
+    if (c == exponent_begin) return false;
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+  while (c != end && std::isspace(*c)) ++c;
+  if (c != end) return false;
+  if (exponent < -22 || exponent > 22) return false;
+
+  double value = (double)mantissa;
+  if (exponent < 0) value /= powers_of_ten[-exponent];
+  else value *= powers_of_ten[exponent];
+  out = negative ? -value : value;
+  return true;
+}
+
 bool csv_line_tokenizer::parse_as(char** buf, size_t len, 
                                   flexible_type& out, bool recursive_parse) {
 
@@ -246,10 +344,20 @@ bool csv_line_tokenizer::parse_as(char** buf, size_t len,
    */
   switch(out.get_type()) {
    case flex_type_enum::INTEGER:
-     std::tie(out, parse_success) = parser->int_parse((const char**)buf, len);
+     if (fast_int_parse(*buf, len, out.mutable_get<flex_int>())) {
+       (*buf) += len;
+       parse_success = true;
+     } else {
+       std::tie(out, parse_success) = parser->int_parse((const char**)buf, len);
+     }
      break;
    case flex_type_enum::FLOAT:
-     std::tie(out, parse_success) = parser->double_parse((const char**)buf, len);
+     if (fast_double_parse(*buf, len, out.mutable_get<flex_float>())) {
+       (*buf) += len;
+       parse_success = true;
+     } else {
+       std::tie(out, parse_success) = parser->double_parse((const char**)buf, len);
+     }
      break;
    case flex_type_enum::VECTOR:
      std::tie(out, parse_success) = parser->vector_parse((const char**)buf, len);
@@ -372,6 +480,69 @@ static inline bool is_space_but_not_tab(char c) {
   return c != '\t' && std::isspace(c);
 }
 
+bool csv_line_tokenizer::find_delimiters(const char* str, size_t len) {
+  delimiter_positions.clear();
+  const char delim = delimiter_first_character;
+  // without a comment character, the quote character is looked for twice
+  const char comment = has_comment_char ? comment_char : quote_char;
+  size_t i = 0;
+  // Compare blocks of the line against the delimiter, quote and comment
+  // characters at once. Each block yields a bit mask of the positions of
+  // the delimiters, and one of the special characters.
+#if defined(__AVX2__)
+  const __m256i delim_v = _mm256_set1_epi8(delim);
+  const __m256i quote_v = _mm256_set1_epi8(quote_char);
+  const __m256i comment_v = _mm256_set1_epi8(comment);
+  for (; i + 32 <= len; i += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i*)(str + i));
+    uint32_t special = _mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, quote_v),
+                        _mm256_cmpeq_epi8(block, comment_v)));
+    if (special) return false;
+    uint32_t delims = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, delim_v));
+    while (delims) {
+      delimiter_positions.push_back(i + __builtin_ctz(delims));
+      delims &= delims - 1;
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i delim_v16 = _mm_set1_epi8(delim);
+  const __m128i quote_v16 = _mm_set1_epi8(quote_char);
+  const __m128i comment_v16 = _mm_set1_epi8(comment);
+  for (; i + 16 <= len; i += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i*)(str + i));
+    uint32_t special = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(block, quote_v16),
+                     _mm_cmpeq_epi8(block, comment_v16)));
+    if (special) return false;
+    uint32_t delims = _mm_movemask_epi8(_mm_cmpeq_epi8(block, delim_v16));
+    while (delims) {
+      delimiter_positions.push_back(i + __builtin_ctz(delims));
+      delims &= delims - 1;
+    }
+  }
+#endif
+  for (; i < len; ++i) {
+    if (str[i] == quote_char || str[i] == comment) return false;
+    if (str[i] == delim) delimiter_positions.push_back(i);
+  }
+
+  // A field beginning with a bracket may hold delimiters
+  // (see tokenize_line_impl)
+  size_t field_begin = 0;
+  for (size_t f = 0; f <= delimiter_positions.size(); ++f) {
+    size_t field_end = f < delimiter_positions.size() ? delimiter_positions[f] : len;
+    size_t c = field_begin;
+    if (skip_initial_space) {
+      while (c < field_end && is_space_but_not_tab(str[c])) ++c;
+    }
+    if (c < field_end && (str[c] == '[' || str[c] == '{')) return false;
+    field_begin = field_end + 1;
+  }
+  return true;
+}
+
 template <typename Fn, typename Fn2, typename Fn3>
 bool csv_line_tokenizer::tokenize_line_impl(char* str, 
                                             size_t len,
@@ -397,6 +568,28 @@ bool csv_line_tokenizer::tokenize_line_impl(char* str,
     return true;
   }
 
+  // Fast path: the fields are exactly the text between the delimiters,
+  // less the initial spaces. This emits the same tokens as the state
+  // machine below.
+  if (use_structural_index && structural_index_applicable &&
+      find_delimiters(str, len)) {
+    size_t field_begin = 0;
+    for (size_t f = 0; f <= delimiter_positions.size(); ++f) {
+      size_t field_end = f < delimiter_positions.size() ? delimiter_positions[f] : len;
+      size_t c = field_begin;
+      if (skip_initial_space) {
+        while (c < field_end && is_space_but_not_tab(str[c])) ++c;
+      }
+      // The state machine emits an empty last field only after a delimiter
+      bool is_last = (f == delimiter_positions.size());
+      if (c < field_end || !is_last || !delimiter_positions.empty()) {
+        if (!add_token(str + c, field_end - c)) return false;
+      }
+      field_begin = field_end + 1;
+    }
+    return true;
+  }
+
   // this is adaptive. It can be either " or ' as we encounter it
 
   while(keep_parsing && buf != bufend) {
@@ -564,6 +757,14 @@ void csv_line_tokenizer::init() {
                                    });
   delimiter_first_character = delimiter[0];
   delimiter_is_singlechar = delimiter.length() == 1;
+  structural_index_applicable = delimiter_is_singlechar &&
+                                !delimiter_is_new_line &&
+                                !delimiter_is_space_but_not_tab &&
+                                delimiter_first_character != quote_char &&
+                                delimiter_first_character != '[' &&
+                                delimiter_first_character != '{' &&
+                                !(has_comment_char &&
+                                  delimiter_first_character == comment_char);
   empty_string_in_na_values = false;
   for (auto& na_val: na_values) {
     empty_string_in_na_values |= na_val.length() == 0;
@@ -119,6 +119,16 @@ struct csv_line_tokenizer {
    */
   std::vector<std::string> na_values;
 
+  /**
+   * If set to true (Default), the lines which can be split on the delimiter
+   * alone are tokenized by a vectorized scan for the delimiters instead of
+   * the character by character state machine. This applies when the
+   * delimiter is a single character which is not a space, and the line has
+   * no quote or comment characters and no field beginning with a bracket.
+   * The result is the same either way.
+   */
+  bool use_structural_index = true;
+
   /**
    * Constructor. Does nothing but set up internal buffers.
    */
@@ -309,6 +319,17 @@ struct csv_line_tokenizer {
                           Fn2 lookahead,
                           Fn3 undotoken);
 
+  /**
+   * Fills delimiter_positions with the positions of the delimiters in the
+   * line. Returns false if the line cannot be split on the delimiters alone
+   * (it has quote or comment characters, or a field beginning with a
+   * bracket), in which case it must go through the state machine.
+   */
+  bool find_delimiters(const char* str, size_t len);
+
+  // the positions of the delimiters found by find_delimiters
+  std::vector<size_t> delimiter_positions;
+
   std::shared_ptr<flexible_type_parser> parser;
 
   // some precomputed information about the delimiter so we avoid excess
@@ -320,6 +341,8 @@ struct csv_line_tokenizer {
   bool delimiter_is_not_empty = true;
   bool empty_string_in_na_values = false;
   bool is_regular_line_terminator = true;
+  // whether the delimiter permits use_structural_index
+  bool structural_index_applicable = false;
 };
 } // namespace graphlab
 
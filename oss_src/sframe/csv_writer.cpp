@@ -6,10 +6,36 @@
  * of the BSD license. See the LICENSE file for details.
  */
 #include <sframe/csv_writer.hpp>
+#include <cstdio>
 #include <flexible_type/string_escape.hpp>
 #include <logger/logger.hpp>
 namespace graphlab {
 
+namespace {
+
+/// Appends an integer, as printed by an output stream
+void append_integer(std::string& out, flex_int value) {
+  char buf[24];
+  char* end = buf + sizeof(buf);
+  char* p = end;
+  uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+  do {
+    *--p = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+  if (value < 0) *--p = '-';
+  out.append(p, end);
+}
+
+/// Appends a float, as printed by an output stream with the default precision
+void append_float(std::string& out, flex_float value) {
+  char buf[32];
+  int len = snprintf(buf, sizeof(buf), "%g", value);
+  out.append(buf, len);
+}
+
+} // anonymous namespace
+
 void csv_writer::write_verbatim(std::ostream& out,
                                 const std::vector<std::string>& row) {
   for (size_t i = 0;i < row.size(); ++i) {
@@ -23,8 +49,10 @@ void csv_writer::write_verbatim(std::ostream& out,
 void csv_writer::csv_print_internal(std::string& out, const flexible_type& val) {
   switch(val.get_type()) {
     case flex_type_enum::INTEGER:
+      append_integer(out, val.get<flex_int>());
+      break;
     case flex_type_enum::FLOAT:
-      out += std::string(val);
+      append_float(out, val.get<flex_float>());
       break;
     case flex_type_enum::DATETIME:
     case flex_type_enum::VECTOR:
@@ -66,24 +94,37 @@ void csv_writer::csv_print_internal(std::string& out, const flexible_type& val)
 void csv_writer::csv_print(std::ostream& out,
                            const flexible_type& val,
                            bool allow_empty_output) {
+  m_row_buffer.clear();
+  csv_print(m_row_buffer, val, allow_empty_output);
+  out.write(m_row_buffer.c_str(), m_row_buffer.length());
+}
+
+void csv_writer::csv_print(std::string& out,
+                           const flexible_type& val,
+                           bool allow_empty_output) {
   bool str_needs_delimiter = false;
   bool str_has_quote_char = false;
   switch(val.get_type()) {
     case flex_type_enum::INTEGER:
     case flex_type_enum::FLOAT:
-      if (quote_level == csv_quote_level::QUOTE_ALL) {
-        out << quote_char << std::string(val) << quote_char; // quote numbers only at QUOTE_ALL
+      // quote numbers only at QUOTE_ALL
+      if (quote_level == csv_quote_level::QUOTE_ALL) out += quote_char;
+      if (val.get_type() == flex_type_enum::INTEGER) {
+        append_integer(out, val.get<flex_int>());
       } else {
-        out << std::string(val);
+        append_float(out, val.get<flex_float>());
       }
+      if (quote_level == csv_quote_level::QUOTE_ALL) out += quote_char;
       break;
     case flex_type_enum::DATETIME:
     case flex_type_enum::VECTOR:
       if (quote_level == csv_quote_level::QUOTE_NONE) {
-        out << std::string(val);
+        out += std::string(val);
       } else {
         // quote this field at any level higher than QUOTE_NONE
-        out << quote_char << std::string(val) << quote_char;
+        out += quote_char;
+        out += std::string(val);
+        out += quote_char;
       }
       break;
     case flex_type_enum::STRING:
@@ -100,7 +141,7 @@ void csv_writer::csv_print(std::ostream& out,
                       quote_char, true,
                       double_quote,
                       m_string_escape_buffer, m_string_escape_buffer_len);
-        out.write(m_string_escape_buffer.c_str(), m_string_escape_buffer_len);
+        out.append(m_string_escape_buffer.c_str(), m_string_escape_buffer_len);
       } else {
         // not quote all. we can pick from a bunch of heuristics
         // to get minimal quoting
@@ -124,10 +165,11 @@ void csv_writer::csv_print(std::ostream& out,
         }
 
         if (allow_empty_output == false && valstr.length() == 0) {
-          out << quote_char << quote_char;
+          out += quote_char;
+          out += quote_char;
         } else if (str_needs_delimiter == false && str_has_quote_char == false) {
           // - no delimiterization needed.
-          out.write(valstr.c_str(), valstr.length());
+          out.append(valstr.c_str(), valstr.length());
         } else if (str_needs_delimiter == false &&
                    str_has_quote_char == true &&
                    double_quote == true) {
@@ -137,21 +179,21 @@ void csv_writer::csv_print(std::ostream& out,
                         quote_char, false,
                         double_quote,
                         m_string_escape_buffer, m_string_escape_buffer_len);
-          out.write(m_string_escape_buffer.c_str(), m_string_escape_buffer_len);
+          out.append(m_string_escape_buffer.c_str(), m_string_escape_buffer_len);
         }  else if (quote_level == csv_quote_level::QUOTE_NONE) {
           // do not quote at all, just escape
           escape_string(valstr, escape_char, use_escape_char,
                         quote_char, false,
                         double_quote,
                         m_string_escape_buffer, m_string_escape_buffer_len);
-          out.write(m_string_escape_buffer.c_str(), m_string_escape_buffer_len);
+          out.append(m_string_escape_buffer.c_str(), m_string_escape_buffer_len);
         } else {
           // the regular case
           escape_string(val.get<flex_string>(), escape_char, use_escape_char,
                         quote_char, true,
                         double_quote,
                         m_string_escape_buffer, m_string_escape_buffer_len);
-          out.write(m_string_escape_buffer.c_str(), m_string_escape_buffer_len);
+          out.append(m_string_escape_buffer.c_str(), m_string_escape_buffer_len);
         }
       }
       break;
@@ -160,7 +202,7 @@ void csv_writer::csv_print(std::ostream& out,
       if (quote_level == csv_quote_level::QUOTE_NONE) {
         m_complex_type_temporary.clear();
         csv_print_internal(m_complex_type_temporary, val);
-        out.write(m_complex_type_temporary.c_str(), m_complex_type_temporary.length());
+        out.append(m_complex_type_temporary.c_str(), m_complex_type_temporary.length());
       } else {
         m_complex_type_temporary.clear();
         csv_print_internal(m_complex_type_temporary, val);
@@ -169,22 +211,26 @@ void csv_writer::csv_print(std::ostream& out,
                       double_quote,
                       m_complex_type_escape_buffer,
                       m_complex_type_escape_buffer_len);
-        out.write(m_complex_type_escape_buffer.c_str(), m_complex_type_escape_buffer_len);
+        out.append(m_complex_type_escape_buffer.c_str(), m_complex_type_escape_buffer_len);
       }
       break;
     case flex_type_enum::UNDEFINED:
       if (quote_level == csv_quote_level::QUOTE_ALL) {
-        out << quote_char << na_value << quote_char;
+        out += quote_char;
+        out += na_value;
+        out += quote_char;
       } else {
-        out.write(na_value.c_str(), na_value.length());
+        out.append(na_value.c_str(), na_value.length());
       }
       break;
     default:
       if (quote_level == csv_quote_level::QUOTE_NONE) {
-        out << std::string(val);
+        out += std::string(val);
       } else {
         // quote this field at any level higher than QUOTE_NONE
-        out << quote_char << std::string(val) << quote_char;
+        out += quote_char;
+        out += std::string(val);
+        out += quote_char;
       }
       break;
   }
@@ -192,14 +238,21 @@ void csv_writer::csv_print(std::ostream& out,
 
 void csv_writer::write(std::ostream& out,
                        const std::vector<flexible_type>& row) {
+  m_row_buffer.clear();
+  write(m_row_buffer, row);
+  out.write(m_row_buffer.c_str(), m_row_buffer.length());
+}
+
+void csv_writer::write(std::string& out,
+                       const std::vector<flexible_type>& row) {
   // if row size is 1, we cannot allow empty output
   bool allow_empty_output = row.size() > 1;
   for (size_t i = 0;i < row.size(); ++i) {
-    csv_print(out, row[i], row.size() > 1);
+    csv_print(out, row[i], allow_empty_output);
     // put a delimiter after every element except for the last element.
-    if (i + 1 < row.size()) out << delimiter;
+    if (i + 1 < row.size()) out += delimiter;
   }
-  out << line_terminator;
+  out += line_terminator;
 }
 
 
@@ -95,6 +95,13 @@ class csv_writer {
    */
   void write(std::ostream& out, const std::vector<flexible_type>& row);
 
+  /**
+   * Appends an array of values as a row to a string, making the appropriate
+   * formatting changes. Not safe to use in parallel: use one writer per
+   * thread.
+   */
+  void write(std::string& out, const std::vector<flexible_type>& row);
+
   /**
    * Converts one value to a string.
    * \param out The stream to write to
@@ -113,6 +120,14 @@ class csv_writer {
                  const flexible_type& val,
                  bool allow_empty_output=true);
 
+  /**
+   * \overload
+   * Appends one value to a string.
+   */
+  void csv_print(std::string& out,
+                 const flexible_type& val,
+                 bool allow_empty_output=true);
+
  private:
 
   /**
@@ -144,6 +159,12 @@ class csv_writer {
    */
   std::string m_string_escape_buffer;
   size_t m_string_escape_buffer_len = 0;
+
+  /**
+   * The row formatted by the stream versions of write and csv_print, which
+   * is written to the stream at once.
+   */
+  std::string m_row_buffer;
 };
 
 
@@ -10,6 +10,7 @@
 #define GRAPHLAB_SFRAME_GROUP_AGGREGATE_VALUE_HPP
 
 #include <flexible_type/flexible_type.hpp>
+#include <sframe/typed_column.hpp>
 
 namespace graphlab {
 
@@ -63,6 +64,16 @@ class group_aggregate_value {
    */
   virtual void add_element_simple(const flexible_type& flex) = 0;
 
+  /**
+   * Adds all the values of a column in the typed representation (see
+   * \ref typed_column) to the aggregate. Returns false if the aggregator
+   * does not support the column, in which case add_element_simple() must 
+   * be called on each value instead.
+   */
+  virtual bool add_typed_column(const typed_column& column) { 
+    return false; 
+  }
+
   /**
    * No more elements will be added to this value. However, this value
    * may still be combined with other values.
@@ -133,6 +144,42 @@ class group_aggregate_value {
   virtual flex_type_enum set_input_type(flex_type_enum type) {
     return type;
   }
+
+  /**
+   * \name Flat state
+   *
+   * An aggregator can optionally describe its state as a fixed-size block
+   * of memory. The groupby then keeps the states of all groups in a single
+   * arena instead of creating an instance of the aggregator per group, and
+   * uses this (prototype) instance to operate on them.
+   *
+   * The flat state must be equivalent to the state of an instance: after
+   * flat_init() and any sequence of flat_add_element_simple() and
+   * flat_combine(), flat_save() must write exactly what save() would write
+   * on an instance which received the same elements and combines.
+   * partial_finalize() must be a no-op.
+   * \{
+   */
+
+  /**
+   * The size in bytes of the flat state, or 0 if the aggregator (with its
+   * current input type) does not have one. Defaults to 0.
+   */
+  virtual size_t flat_state_size() const { return 0; }
+
+  /// Initializes an empty flat state, as returned by new_instance().
+  virtual void flat_init(char* state) const { }
+
+  /// Equivalent of add_element_simple() on a flat state.
+  virtual void flat_add_element_simple(char* state, const flexible_type& flex) const { }
+
+  /// Equivalent of combine() on flat states: merges other into state.
+  virtual void flat_combine(char* state, const char* other) const { }
+
+  /// Equivalent of save() on a flat state.
+  virtual void flat_save(const char* state, oarchive& oarc) const { }
+
+  /// \}
 };
   
 inline std::ostream& operator<<(std::ostream& os, const group_aggregate_value& dt) {
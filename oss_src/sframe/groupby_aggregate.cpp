@@ -10,6 +10,7 @@
 #include <logger/logger.hpp>
 #include <timer/timer.hpp>
 #include <sframe/sframe.hpp>
+#include <sframe/sframe_config.hpp>
 #include <sframe/group_aggregate_value.hpp>
 #include <sframe/groupby_aggregate_impl.hpp>
 #include <sframe/groupby_aggregate.hpp>
@@ -188,11 +189,16 @@ sframe groupby_aggregate(const sframe& source,
                 [&](size_t i) {
                   auto iter = input_reader->begin(i);
                   auto enditer = input_reader->end(i);
+                  std::vector<std::vector<flexible_type> > rows;
                   while(iter != enditer) {
-                    auto& row = *iter;
-                    container.add(row, num_keys);
+                    rows.push_back(*iter);
+                    if (rows.size() == sframe_config::SFRAME_READ_BATCH_SIZE) {
+                      container.add(rows, num_keys);
+                      rows.clear();
+                    }
                     ++iter;
                   }
+                  container.add(rows, num_keys);
                 });
 
   logstream(LOG_INFO) << "Group container filled in " << ti.current_time() << std::endl;
@@ -214,6 +214,87 @@ size_t groupby_element::hash() const {
   return hash_val;
 }
 
+/****************************************************************************/
+/*                                                                          */
+/*                             flat_group_table                             */
+/*                                                                          */
+/****************************************************************************/
+static const size_t FLAT_GROUP_TABLE_INITIAL_SHIFT = 64 - 4;
+
+flat_group_table::flat_group_table(size_t num_keys, size_t state_size):
+    m_num_keys(num_keys),
+    m_state_words((state_size + sizeof(uint64_t) - 1) / sizeof(uint64_t)),
+    m_shift(FLAT_GROUP_TABLE_INITIAL_SHIFT),
+    m_slots(size_t(1) << (64 - FLAT_GROUP_TABLE_INITIAL_SHIFT), 0) { }
+
+size_t flat_group_table::find_or_insert(const std::vector<flexible_type>& val,
+                                        size_t hash, bool& inserted) {
+  return find_or_insert_impl(val, hash, inserted);
+}
+
+size_t flat_group_table::find_or_insert(const sframe_rows::row& val,
+                                        size_t hash, bool& inserted) {
+  return find_or_insert_impl(val, hash, inserted);
+}
+
+size_t flat_group_table::find_or_insert(const flexible_type* val,
+                                        size_t hash, bool& inserted) {
+  return find_or_insert_impl(val, hash, inserted);
+}
+
+template <typename T>
+size_t flat_group_table::find_or_insert_impl(const T& val, size_t hash, bool& inserted) {
+  // keep the load factor below 0.7
+  if ((size() + 1) * 10 > m_slots.size() * 7) grow();
+  size_t mask = m_slots.size() - 1;
+  // fibonacci hashing: the hash itself also picks the segment, so use its
+  // high bits (mixed) to pick the slot.
+  size_t slot = (uint64_t(hash) * 0x9E3779B97F4A7C15ULL) >> m_shift;
+  while(true) {
+    size_t group = m_slots[slot];
+    if (group == 0) break;
+    --group;
+    if (m_hashes[group] == hash &&
+        flexible_type_vector_equality(key(group), m_num_keys, val, m_num_keys)) {
+      inserted = false;
+      return group;
+    }
+    slot = (slot + 1) & mask;
+  }
+  size_t group = size();
+  m_slots[slot] = group + 1;
+  m_hashes.push_back(hash);
+  for (size_t i = 0; i < m_num_keys; ++i) m_keys.push_back(val[i]);
+  m_states.resize(m_states.size() + m_state_words);
+  inserted = true;
+  return group;
+}
+
+void flat_group_table::grow() {
+  --m_shift;
+  m_slots.assign(size_t(1) << (64 - m_shift), 0);
+  size_t mask = m_slots.size() - 1;
+  for (size_t group = 0; group < size(); ++group) {
+    size_t slot = (uint64_t(m_hashes[group]) * 0x9E3779B97F4A7C15ULL) >> m_shift;
+    while(m_slots[slot] != 0) slot = (slot + 1) & mask;
+    m_slots[slot] = group + 1;
+  }
+}
+
+std::vector<size_t> flat_group_table::sorted_groups() const {
+  std::vector<size_t> ret(size());
+  for (size_t i = 0; i < ret.size(); ++i) ret[i] = i;
+  std::sort(ret.begin(), ret.end(),
+            [&](size_t a, size_t b) {
+              if (m_hashes[a] != m_hashes[b]) return m_hashes[a] < m_hashes[b];
+              // if hash collision, use the full compare
+              return flexible_type_vector_lt(
+                  std::vector<flexible_type>(key(a), key(a) + m_num_keys),
+                  std::vector<flexible_type>(key(b), key(b) + m_num_keys));
+            });
+  return ret;
+}
+
 /****************************************************************************/
 /*                                                                          */
 /*                         group_aggregate_container                        */
@@ -234,12 +315,113 @@ void group_aggregate_container::define_group(std::vector<size_t> column_numbers,
   desc.column_numbers = column_numbers;
   desc.aggregator = aggregator;
   group_descriptors.push_back(desc);
+
+  size_t state_size = aggregator->flat_state_size();
+  if (state_size == 0 || column_numbers.size() > 1) use_flat_groups = false;
+  // keep every state 8 byte aligned
+  flat_state_offsets.push_back(flat_state_size);
+  flat_state_size += (state_size + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+}
+
+template <typename T>
+void group_aggregate_container::aggregate_flat(flat_group_table& table,
+                                               const T& val,
+                                               size_t hash) {
+  bool inserted = false;
+  size_t group = table.find_or_insert(val, hash, inserted);
+  char* state = table.state(group);
+  for (size_t i = 0; i < group_descriptors.size(); ++i) {
+    const auto& desc = group_descriptors[i];
+    char* aggregator_state = state + flat_state_offsets[i];
+    if (inserted) desc.aggregator->flat_init(aggregator_state);
+    if (desc.column_numbers.empty()) {
+      desc.aggregator->flat_add_element_simple(aggregator_state, 0);
+    } else if (desc.column_numbers[0] < val.size()) {
+      desc.aggregator->flat_add_element_simple(aggregator_state,
+                                               val[desc.column_numbers[0]]);
+    } else {
+      desc.aggregator->flat_add_element_simple(aggregator_state, FLEX_UNDEFINED);
+    }
+  }
+}
+
+template <typename T>
+void group_aggregate_container::add_flat(const T& val,
+                                         size_t num_keys,
+                                         size_t hash,
+                                         size_t segmentid) {
+  auto& segment = segments[segmentid];
+  std::unique_lock<graphlab::simple_spinlock> lock(segment.in_memory_group_lock);
+  if (!segment.flat_elements) {
+    segment.flat_elements.reset(new flat_group_table(num_keys, flat_state_size));
+  }
+  aggregate_flat(*segment.flat_elements, val, hash);
+  bool full = segment.flat_elements->size() >= max_buffer_size;
+  lock.unlock();
+  if (full) flush_segment(segmentid);
+}
+
+void group_aggregate_container::merge_flat(std::unique_ptr<flat_group_table> local,
+                                           size_t segmentid) {
+  auto& segment = segments[segmentid];
+  std::unique_lock<graphlab::simple_spinlock> lock(segment.in_memory_group_lock);
+  if (!segment.flat_elements || segment.flat_elements->size() == 0) {
+    segment.flat_elements = std::move(local);
+  } else {
+    flat_group_table& table = *segment.flat_elements;
+    for (size_t group = 0; group < local->size(); ++group) {
+      bool inserted = false;
+      size_t target = table.find_or_insert(local->key(group), local->hash(group), inserted);
+      char* state = table.state(target);
+      const char* other = local->state(group);
+      for (size_t i = 0; i < group_descriptors.size(); ++i) {
+        const auto& desc = group_descriptors[i];
+        char* aggregator_state = state + flat_state_offsets[i];
+        if (inserted) desc.aggregator->flat_init(aggregator_state);
+        desc.aggregator->flat_combine(aggregator_state, other + flat_state_offsets[i]);
+      }
+    }
+  }
+  bool full = segment.flat_elements->size() >= max_buffer_size;
+  lock.unlock();
+  if (full) flush_segment(segmentid);
+}
+
+template <typename Rows>
+void group_aggregate_container::add_rows(const Rows& rows, size_t num_keys) {
+  if (!use_flat_groups) {
+    for (const auto& row: rows) add(row, num_keys);
+    return;
+  }
+  std::vector<std::unique_ptr<flat_group_table> > local(segments.size());
+  for (const auto& row: rows) {
+    size_t hash = groupby_element::hash_key(row, num_keys);
+    auto& table = local[hash % segments.size()];
+    if (!table) table.reset(new flat_group_table(num_keys, flat_state_size));
+    aggregate_flat(*table, row, hash);
+  }
+  for (size_t i = 0; i < local.size(); ++i) {
+    if (local[i]) merge_flat(std::move(local[i]), i);
+  }
+}
+
+void group_aggregate_container::add(const sframe_rows& rows, size_t num_keys) {
+  add_rows(rows, num_keys);
+}
+
+void group_aggregate_container::add(const std::vector<std::vector<flexible_type> >& rows,
+                                    size_t num_keys) {
+  add_rows(rows, num_keys);
 }
 
 void group_aggregate_container::add(const std::vector<flexible_type>& val,
                                     size_t num_keys) {
   size_t hash = groupby_element::hash_key(val, num_keys);
   size_t target_segment = hash % segments.size();
+  if (use_flat_groups) {
+    add_flat(val, num_keys, hash, target_segment);
+    return;
+  }
   // acquire lock on the segment
   std::unique_lock<graphlab::simple_spinlock> lock(segments[target_segment].in_memory_group_lock);
   // look for the id in the group_keys structure
@@ -282,6 +464,10 @@ void group_aggregate_container::add(const sframe_rows::row& val,
                                     size_t num_keys) {
   size_t hash = groupby_element::hash_key(val, num_keys);
   size_t target_segment = hash % segments.size();
+  if (use_flat_groups) {
+    add_flat(val, num_keys, hash, target_segment);
+    return;
+  }
   // acquire lock on the segment
   std::unique_lock<graphlab::simple_spinlock> lock(segments[target_segment].in_memory_group_lock);
   // look for the id in the group_keys structure
@@ -323,6 +509,10 @@ void group_aggregate_container::add(const sframe_rows::row& val,
 }
 
 void group_aggregate_container::flush_segment(size_t segmentid) {
+  if (use_flat_groups) {
+    flush_flat_segment(segmentid);
+    return;
+  }
   // unlock and swap out the segment.
   std::unique_lock<graphlab::simple_spinlock> lock(segments[segmentid].in_memory_group_lock);
   if (segments[segmentid].elements.size() == 0) return;
@@ -368,6 +558,36 @@ void group_aggregate_container::flush_segment(size_t segmentid) {
   segments[segmentid].chunk_size.push_back(local_sorted.size());
 }
 
+void group_aggregate_container::flush_flat_segment(size_t segmentid) {
+  // unlock and swap out the segment.
+  std::unique_lock<graphlab::simple_spinlock> lock(segments[segmentid].in_memory_group_lock);
+  std::unique_ptr<flat_group_table> local = std::move(segments[segmentid].flat_elements);
+  lock.unlock();
+  if (!local || local->size() == 0) return;
+
+  std::vector<size_t> sorted = local->sorted_groups();
+  // write exactly what the equivalent groupby_element would write, so
+  // the chunks can be merged by group_and_write_segment.
+  std::unique_lock<graphlab::mutex> filelock(segments[segmentid].file_lock);
+  oarchive oarc;
+  std::vector<flexible_type> key;
+  for (size_t group: sorted) {
+    const flexible_type* group_key = local->key(group);
+    key.assign(group_key, group_key + local->num_keys());
+    oarc << key;
+    const char* state = local->state(group);
+    for (size_t i = 0; i < group_descriptors.size(); ++i) {
+      group_descriptors[i].aggregator->flat_save(state + flat_state_offsets[i], oarc);
+    }
+    // write into the iterator
+    *(segments[segmentid].outiter) = std::string(oarc.buf, oarc.off);
+    ++(segments[segmentid].outiter);
+    oarc.off = 0;
+  }
+  free(oarc.buf);
+  segments[segmentid].chunk_size.push_back(sorted.size());
+}
+
 void group_aggregate_container::group_and_write(sframe& out) {
   for (size_t i = 0 ;i < segments.size(); ++i) flush_segment(i);
 
@@ -151,6 +151,80 @@ struct hash<graphlab::groupby_aggregate_impl::groupby_element> {
 namespace graphlab {
 namespace groupby_aggregate_impl {
 
+/**
+ * An open addressing hash table of groups used when every aggregator has a
+ * flat state (see group_aggregate_value::flat_state_size()).
+ *
+ * The keys of all groups are stored contiguously in one array, and the
+ * aggregation states of all groups are stored contiguously in one arena,
+ * so inserting a group does not allocate any per-group object. Groups are
+ * identified by their index, in insertion order.
+ */
+class flat_group_table {
+ public:
+  /**
+   * Constructs an empty table of groups of num_keys keys, each group
+   * having state_size bytes of aggregation state.
+   */
+  flat_group_table(size_t num_keys, size_t state_size);
+
+  /// The number of groups
+  inline size_t size() const { return m_hashes.size(); }
+
+  /// The number of keys of every group
+  inline size_t num_keys() const { return m_num_keys; }
+
+  /**
+   * Returns the index of the group of the first num_keys values of val,
+   * inserting a new group if there is none. inserted is set to true if the
+   * group was inserted. The state of a new group is uninitialized.
+   */
+  size_t find_or_insert(const std::vector<flexible_type>& val, size_t hash, bool& inserted);
+
+  /// \overload
+  size_t find_or_insert(const sframe_rows::row& val, size_t hash, bool& inserted);
+
+  /// \overload
+  size_t find_or_insert(const flexible_type* val, size_t hash, bool& inserted);
+
+  /// The keys of a group
+  inline const flexible_type* key(size_t group) const {
+    return m_keys.data() + group * m_num_keys;
+  }
+
+  /// The aggregation state of a group. Invalidated by insertions.
+  inline char* state(size_t group) {
+    return reinterpret_cast<char*>(m_states.data() + group * m_state_words);
+  }
+
+  /// The hash of the keys of a group
+  inline size_t hash(size_t group) const { return m_hashes[group]; }
+
+  /**
+   * Returns the indices of all groups in the order of the equivalent
+   * groupby_element objects.
+   */
+  std::vector<size_t> sorted_groups() const;
+
+ private:
+  template <typename T>
+  size_t find_or_insert_impl(const T& val, size_t hash, bool& inserted);
+
+  void grow();
+
+  size_t m_num_keys;
+  /// The size of a state in 8 byte words
+  size_t m_state_words;
+  /// log2 of the number of slots subtracted from 64
+  size_t m_shift;
+  /// group index + 1 for every slot. 0 for empty slots.
+  std::vector<size_t> m_slots;
+  std::vector<flexible_type> m_keys;
+  std::vector<uint64_t> m_states;
+  std::vector<size_t> m_hashes;
+};
+
+
 /**
  * This
  */
@@ -182,6 +256,16 @@ class group_aggregate_container {
   void add(const sframe_rows::row& val,
             size_t num_keys);
 
+   /**
+    * Adds a batch of elements to the container. With flat groups, the batch
+    * is first aggregated into tables local to the call, one per segment,
+    * and the segment locks are only taken to merge those in.
+    */
+   void add(const sframe_rows& rows, size_t num_keys);
+
+   /// \overload
+   void add(const std::vector<std::vector<flexible_type> >& rows, size_t num_keys);
+
    /// Sort all elements in the container and writes to the output.
    void group_and_write(sframe& out);
   private:
@@ -189,6 +273,16 @@ class group_aggregate_container {
    /// collection of all the group operations
    std::vector<group_descriptor> group_descriptors;
 
+   /**
+    * True if every group operation has a flat state and at most one input
+    * column, in which case groups are kept in a flat_group_table.
+    */
+   bool use_flat_groups = true;
+   /// The offset of the flat state of each group operation
+   std::vector<size_t> flat_state_offsets;
+   /// The total size of the flat states of a group
+   size_t flat_state_size = 0;
+
    struct segment_information {
      /// Locks on the elements structure
      graphlab::simple_spinlock in_memory_group_lock;
@@ -196,6 +290,8 @@ class group_aggregate_container {
      atomic<size_t> refctr;
      /// Intermediate group values
      hopscotch_map<size_t, std::vector<groupby_element>* > elements;
+     /// Intermediate group values when use_flat_groups is set
+     std::unique_ptr<flat_group_table> flat_elements;
 
      /// Locks on the below structures
      graphlab::mutex file_lock;
@@ -205,9 +301,27 @@ class group_aggregate_container {
      std::vector<size_t> chunk_size;
    };
 
+   /// Adds a new element to the flat group table of a segment.
+   template <typename T>
+   void add_flat(const T& val, size_t num_keys, size_t hash, size_t segmentid);
+
+   /// Adds a new element to a flat group table. No locking.
+   template <typename T>
+   void aggregate_flat(flat_group_table& table, const T& val, size_t hash);
+
+   /// Implements the batch add()
+   template <typename Rows>
+   void add_rows(const Rows& rows, size_t num_keys);
+
+   /// Merges a flat group table into the flat group table of a segment.
+   void merge_flat(std::unique_ptr<flat_group_table> local, size_t segmentid);
+
    /// Writes the content into the sarray segment backend.
    void flush_segment(size_t segmentid);
 
+   /// Writes the content of a flat group table into the sarray segment backend.
+   void flush_flat_segment(size_t segmentid);
+
    size_t max_buffer_size;
    std::vector<segment_information> segments;
    sarray<std::string> intermediate_buffer;
@@ -161,7 +161,43 @@ class sum : public group_aggregate_value {
     iarc >> value;
   }
 
+  /// The flat state is the sum as a flex_int or a flex_float
+  size_t flat_state_size() const {
+    return support_type(value.get_type()) ? sizeof(flat_value) : 0;
+  }
+
+  void flat_init(char* state) const {
+    *reinterpret_cast<flat_value*>(state) = flat_value();
+  }
+
+  void flat_add_element_simple(char* state, const flexible_type& flex) const {
+    if (flex.get_type() != flex_type_enum::UNDEFINED){
+      DASSERT_EQ((int)flex.get_type(), (int)value.get_type());
+      flat_value& s = *reinterpret_cast<flat_value*>(state);
+      if (value.get_type() == flex_type_enum::INTEGER) s.i += flex.get<flex_int>();
+      else s.f += flex.get<flex_float>();
+    }
+  }
+
+  void flat_combine(char* state, const char* other) const {
+    flat_value& s = *reinterpret_cast<flat_value*>(state);
+    const flat_value& o = *reinterpret_cast<const flat_value*>(other);
+    if (value.get_type() == flex_type_enum::INTEGER) s.i += o.i;
+    else s.f += o.f;
+  }
+
+  void flat_save(const char* state, oarchive& oarc) const {
+    const flat_value& s = *reinterpret_cast<const flat_value*>(state);
+    if (value.get_type() == flex_type_enum::INTEGER) oarc << flexible_type(s.i);
+    else oarc << flexible_type(s.f);
+  }
+
  private:
+  union flat_value {
+    flex_int i;
+    flex_float f;
+  };
+
   flexible_type value;
 };
 
@@ -241,7 +277,58 @@ class min: public group_aggregate_value {
     iarc >> value >> init;
   }
 
+  /// The flat state is the value as a flex_int or a flex_float and the init flag
+  size_t flat_state_size() const {
+    return (value.get_type() == flex_type_enum::INTEGER ||
+            value.get_type() == flex_type_enum::FLOAT) ? sizeof(flat_value) : 0;
+  }
+
+  void flat_init(char* state) const {
+    *reinterpret_cast<flat_value*>(state) = flat_value();
+  }
+
+  void flat_add_element_simple(char* state, const flexible_type& flex) const {
+    if (flex.get_type() != flex_type_enum::UNDEFINED) {
+      DASSERT_EQ((int)flex.get_type(), (int)value.get_type());
+      flat_value& s = *reinterpret_cast<flat_value*>(state);
+      if (value.get_type() == flex_type_enum::INTEGER) {
+        flex_int v = flex.get<flex_int>();
+        if (!s.init || s.i > v) s.i = v;
+      } else {
+        flex_float v = flex.get<flex_float>();
+        if (!s.init || s.f > v) s.f = v;
+      }
+      s.init = true;
+    }
+  }
+
+  void flat_combine(char* state, const char* other) const {
+    flat_value& s = *reinterpret_cast<flat_value*>(state);
+    const flat_value& o = *reinterpret_cast<const flat_value*>(other);
+    if (!o.init) return;
+    if (value.get_type() == flex_type_enum::INTEGER) {
+      if (!s.init || s.i > o.i) s.i = o.i;
+    } else {
+      if (!s.init || s.f > o.f) s.f = o.f;
+    }
+    s.init = true;
+  }
+
+  void flat_save(const char* state, oarchive& oarc) const {
+    const flat_value& s = *reinterpret_cast<const flat_value*>(state);
+    if (value.get_type() == flex_type_enum::INTEGER) oarc << flexible_type(s.i) << s.init;
+    else oarc << flexible_type(s.f) << s.init;
+  }
+
  private:
+  struct flat_value {
+    union {
+      flex_int i;
+      flex_float f;
+    };
+    bool init;
+  };
+
   flexible_type value;
   bool init = false;
 };
@@ -502,7 +589,58 @@ class max: public group_aggregate_value {
     iarc >> value >> init;
   }
 
+  /// The flat state is the value as a flex_int or a flex_float and the init flag
+  size_t flat_state_size() const {
+    return (value.get_type() == flex_type_enum::INTEGER ||
+            value.get_type() == flex_type_enum::FLOAT) ? sizeof(flat_value) : 0;
+  }
+
+  void flat_init(char* state) const {
+    *reinterpret_cast<flat_value*>(state) = flat_value();
+  }
+
+  void flat_add_element_simple(char* state, const flexible_type& flex) const {
+    if (flex.get_type() != flex_type_enum::UNDEFINED) {
+      DASSERT_EQ((int)flex.get_type(), (int)value.get_type());
+      flat_value& s = *reinterpret_cast<flat_value*>(state);
+      if (value.get_type() == flex_type_enum::INTEGER) {
+        flex_int v = flex.get<flex_int>();
+        if (!s.init || s.i < v) s.i = v;
+      } else {
+        flex_float v = flex.get<flex_float>();
+        if (!s.init || s.f < v) s.f = v;
+      }
+      s.init = true;
+    }
+  }
+
+  void flat_combine(char* state, const char* other) const {
+    flat_value& s = *reinterpret_cast<flat_value*>(state);
+    const flat_value& o = *reinterpret_cast<const flat_value*>(other);
+    if (!o.init) return;
+    if (value.get_type() == flex_type_enum::INTEGER) {
+      if (!s.init || s.i < o.i) s.i = o.i;
+    } else {
+      if (!s.init || s.f < o.f) s.f = o.f;
+    }
+    s.init = true;
+  }
+
+  void flat_save(const char* state, oarchive& oarc) const {
+    const flat_value& s = *reinterpret_cast<const flat_value*>(state);
+    if (value.get_type() == flex_type_enum::INTEGER) oarc << flexible_type(s.i) << s.init;
+    else oarc << flexible_type(s.f) << s.init;
+  }
+
  private:
+  struct flat_value {
+    union {
+      flex_int i;
+      flex_float f;
+    };
+    bool init;
+  };
+
   flexible_type value;
   bool init = false;
 };
@@ -562,6 +700,27 @@ class count: public group_aggregate_value {
     iarc >> value;
   }
 
+  /// The flat state is the count
+  size_t flat_state_size() const {
+    return sizeof(size_t);
+  }
+
+  void flat_init(char* state) const {
+    *reinterpret_cast<size_t*>(state) = 0;
+  }
+
+  void flat_add_element_simple(char* state, const flexible_type& flex) const {
+    ++(*reinterpret_cast<size_t*>(state));
+  }
+
+  void flat_combine(char* state, const char* other) const {
+    *reinterpret_cast<size_t*>(state) += *reinterpret_cast<const size_t*>(other);
+  }
+
+  void flat_save(const char* state, oarchive& oarc) const {
+    oarc << *reinterpret_cast<const size_t*>(state);
+  }
+
  private:
   size_t value = 0;
 };
@@ -622,6 +781,28 @@ class non_null_count: public group_aggregate_value {
     iarc >> value;
   }
 
+  /// The flat state is the count
+  size_t flat_state_size() const {
+    return sizeof(size_t);
+  }
+
+  void flat_init(char* state) const {
+    *reinterpret_cast<size_t*>(state) = 0;
+  }
+
+  void flat_add_element_simple(char* state, const flexible_type& flex) const {
+    if(flex.get_type() != flex_type_enum::UNDEFINED)
+      ++(*reinterpret_cast<size_t*>(state));
+  }
+
+  void flat_combine(char* state, const char* other) const {
+    *reinterpret_cast<size_t*>(state) += *reinterpret_cast<const size_t*>(other);
+  }
+
+  void flat_save(const char* state, oarchive& oarc) const {
+    oarc << *reinterpret_cast<const size_t*>(state);
+  }
+
  private:
   size_t value = 0;
 };
@@ -783,7 +964,44 @@ class average: public group_aggregate_value {
     iarc >> value >> count;
   }
 
+  /// The flat state is the running mean and the count
+  size_t flat_state_size() const {
+    return sizeof(flat_value);
+  }
+
+  void flat_init(char* state) const {
+    *reinterpret_cast<flat_value*>(state) = flat_value();
+  }
+
+  void flat_add_element_simple(char* state, const flexible_type& flex) const {
+    if (flex != FLEX_UNDEFINED) {
+      flat_value& s = *reinterpret_cast<flat_value*>(state);
+      ++s.count;
+      s.value += ((double)flex - s.value)/double(s.count);
+    }
+  }
+
+  void flat_combine(char* state, const char* other) const {
+    flat_value& s = *reinterpret_cast<flat_value*>(state);
+    const flat_value& o = *reinterpret_cast<const flat_value*>(other);
+    //weighted mean
+    if (s.count + o.count > 0) {
+      s.value = ((s.value * s.count) + (o.value * o.count)) / (s.count + o.count);
+      s.count += o.count;
+    }
+  }
+
+  void flat_save(const char* state, oarchive& oarc) const {
+    const flat_value& s = *reinterpret_cast<const flat_value*>(state);
+    oarc << s.value << s.count;
+  }
+
  private:
+  struct flat_value {
+    double value;
+    size_t count;
+  };
+
   double value = 0;
   size_t count = 0;
 };
@@ -868,7 +1086,52 @@ class variance : public group_aggregate_value {
        << ")";
   }
 
+  /// The flat state is the count, the mean and M2
+  size_t flat_state_size() const {
+    return sizeof(flat_value);
+  }
+
+  void flat_init(char* state) const {
+    *reinterpret_cast<flat_value*>(state) = flat_value();
+  }
+
+  void flat_add_element_simple(char* state, const flexible_type& flex) const {
+    if (flex != FLEX_UNDEFINED) {
+      flat_value& s = *reinterpret_cast<flat_value*>(state);
+      ++s.count;
+      double delta = (double)flex - s.mean;
+      s.mean += delta / s.count;
+      s.M2 += delta * ((double)flex - s.mean);
+    }
+  }
+
+  void flat_combine(char* state, const char* other) const {
+    flat_value& s = *reinterpret_cast<flat_value*>(state);
+    const flat_value& o = *reinterpret_cast<const flat_value*>(other);
+    if (o.count == 0) {
+      return;
+    } else if (s.count == 0) {
+      s = o;
+    } else {
+      double delta = o.mean - s.mean;
+      s.mean = ((s.mean * s.count) + (o.mean * o.count)) / (s.count + o.count);
+      s.M2 += o.M2 + delta * delta * o.count * s.count / (s.count + o.count);
+      s.count += o.count;
+    }
+  }
+
+  void flat_save(const char* state, oarchive& oarc) const {
+    const flat_value& s = *reinterpret_cast<const flat_value*>(state);
+    oarc << s.count << s.mean << s.M2;
+  }
+
  protected:
+  struct flat_value {
+    size_t count;
+    double mean;
+    double M2;
+  };
+
   size_t count = 0;
   double mean = 0;
   double M2 = 0;
@@ -5,10 +5,71 @@
  * This software may be modified and distributed under the terms
  * of the BSD license. See the LICENSE file for details.
  */
+#include <set>
+#include <algorithm>
 #include <sframe/join.hpp>
 
 namespace graphlab {
 
+void join_output_schema(const std::vector<std::string>& left_column_names,
+                        const std::vector<flex_type_enum>& left_column_types,
+                        const std::vector<std::string>& right_column_names,
+                        const std::vector<flex_type_enum>& right_column_types,
+                        std::string join_type,
+                        const std::map<std::string,std::string>& join_columns,
+                        std::vector<std::string>& column_names,
+                        std::vector<flex_type_enum>& column_types,
+                        int64_t left_num_rows,
+                        int64_t right_num_rows) {
+  ASSERT_EQ(left_column_names.size(), left_column_types.size());
+  ASSERT_EQ(right_column_names.size(), right_column_types.size());
+
+  boost::algorithm::to_lower(join_type);
+  if (join_type != "outer" && join_type != "left" &&
+      join_type != "right" && join_type != "inner") {
+    log_and_throw("Invalid join type given!");
+  }
+
+  std::set<std::string> right_join_columns;
+  for(const auto &col_pair : join_columns) {
+    auto left_iter = std::find(left_column_names.begin(), left_column_names.end(),
+                               col_pair.first);
+    if (left_iter == left_column_names.end()) {
+      log_and_throw(std::string("Column ") + col_pair.first + " does not exist.");
+    }
+    auto right_iter = std::find(right_column_names.begin(), right_column_names.end(),
+                                col_pair.second);
+    if (right_iter == right_column_names.end()) {
+      log_and_throw(std::string("Column ") + col_pair.second + " does not exist.");
+    }
+    // Each column must have matching types to compare effectively
+    if (left_column_types[left_iter - left_column_names.begin()] !=
+        right_column_types[right_iter - right_column_names.begin()] &&
+        left_num_rows != 0 && right_num_rows != 0) {
+      log_and_throw("Columns " + col_pair.first + " and " + col_pair.second +
+          " do not have the same type in both SFrames.");
+    }
+    right_join_columns.insert(col_pair.second);
+  }
+
+  column_names = left_column_names;
+  column_types = left_column_types;
+  std::set<std::string> used_names(column_names.begin(), column_names.end());
+  for (size_t i = 0; i < right_column_names.size(); ++i) {
+    if (right_join_columns.count(right_column_names[i])) continue;
+    // same renaming as sframe::generate_valid_column_name
+    std::string name = right_column_names[i];
+    if (used_names.count(name)) {
+      size_t number = 1;
+      while (used_names.count(name + "." + std::to_string(number))) ++number;
+      name = name + "." + std::to_string(number);
+    }
+    used_names.insert(name);
+    column_names.push_back(name);
+    column_types.push_back(right_column_types[i]);
+  }
+}
+
 sframe join(sframe& sf_left, 
             sframe& sf_right,
             std::string join_type,
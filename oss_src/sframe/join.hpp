@@ -5,6 +5,8 @@
  * This software may be modified and distributed under the terms
  * of the BSD license. See the LICENSE file for details.
  */
+#ifndef GRAPHLAB_SFRAME_JOIN_HPP
+#define GRAPHLAB_SFRAME_JOIN_HPP
 #include <string>
 #include <vector>
 #include <cstdio>
@@ -15,6 +17,31 @@
 
 namespace graphlab {
 
+/**
+ * Validates the arguments of \ref join and computes the names and types of
+ * the columns of its output, without performing the join. Throws on
+ * invalid arguments.
+ *
+ * The key columns must have the same types in both inputs, unless one of
+ * the inputs is empty. The numbers of rows of the inputs are only used for
+ * this exemption: -1 means that the number is unknown, in which case the
+ * input is not assumed to be empty.
+ *
+ * The output has all the columns of the left frame, followed by the columns
+ * of the right frame which are not join keys. Conflicting names of right
+ * columns are renamed "name.1", "name.2", ... as in the actual join.
+ */
+void join_output_schema(const std::vector<std::string>& left_column_names,
+                        const std::vector<flex_type_enum>& left_column_types,
+                        const std::vector<std::string>& right_column_names,
+                        const std::vector<flex_type_enum>& right_column_types,
+                        std::string join_type,
+                        const std::map<std::string,std::string>& join_columns,
+                        std::vector<std::string>& column_names,
+                        std::vector<flex_type_enum>& column_types,
+                        int64_t left_num_rows = -1,
+                        int64_t right_num_rows = -1);
+
 sframe join(sframe& sf_left,
             sframe& sf_right,
             std::string join_type,
@@ -22,3 +49,4 @@ sframe join(sframe& sf_left,
             size_t max_buffer_size = SFRAME_JOIN_BUFFER_NUM_CELLS);
 
 } // end of graphlab
+#endif
@@ -14,93 +14,161 @@ namespace graphlab {
 namespace join_impl {
 
 /****************** join_hash_table **********************/
-bool join_hash_table::add_row(const std::vector<flexible_type> &row) {
-
-  size_t the_hash_key = compute_hash_from_row(row, _hash_positions);
-  bool first_entry;
-
-  auto find_ret = _hash_table.find(the_hash_key);
-  if(find_ret == _hash_table.end()) {
-    // Not found, add
-    hash_join_row_t tmp;
-    tmp.rows = {row};
-    tmp.matched = false;
-    std::list<value_type> tmp_list;
-    tmp_list.push_back(std::move(tmp));
-    _hash_table.insert(std::make_pair(the_hash_key, tmp_list));
-    first_entry = true;
-  } else {
-    // Get an iterator to the list, loop to find join-key match
-    ASSERT_GT(find_ret->second.size(), 0);
-    bool matched = false;
-    auto it = find_ret->second.begin();
-    while(it != find_ret->second.end()) {
-      ASSERT_GT(it->rows.size(), 0);
-      if(join_values_equal(it->rows[0], row, _hash_positions)) {
-        it->rows.push_back(row);
-        matched = true;
-        first_entry = false;
+// The build side is radix partitioned into partitions of about this many rows
+static const size_t JOIN_ROWS_PER_PARTITION = 4096;
+static const size_t JOIN_MAX_RADIX_BITS = 12;
+
+join_hash_table::join_hash_table(std::vector<size_t> hp, size_t num_columns) :
+    _hash_positions(hp), _num_columns(num_columns) {}
+
+void join_hash_table::add_row(const std::vector<flexible_type> &row) {
+  DASSERT_FALSE(_built);
+  DASSERT_EQ(row.size(), _num_columns);
+  _hashes.push_back(compute_hash_from_row(row, _hash_positions));
+  _cells.insert(_cells.end(), row.begin(), row.end());
+}
+
+void join_hash_table::build() {
+  ASSERT_FALSE(_built);
+  size_t num_rows = _hashes.size();
+  _radix_bits = 0;
+  while(_radix_bits < JOIN_MAX_RADIX_BITS &&
+        (num_rows >> _radix_bits) > JOIN_ROWS_PER_PARTITION) {
+    ++_radix_bits;
+  }
+  size_t num_partitions = size_t(1) << _radix_bits;
+
+  // Counting sort of the rows by partition
+  _partition_begin.assign(num_partitions + 1, 0);
+  for(size_t hash : _hashes) {
+    ++_partition_begin[partition_of(hash) + 1];
+  }
+  for(size_t p = 0; p < num_partitions; ++p) {
+    _partition_begin[p + 1] += _partition_begin[p];
+  }
+  _order.resize(num_rows);
+  std::vector<size_t> next(_partition_begin.begin(), _partition_begin.end() - 1);
+  for(size_t i = 0; i < num_rows; ++i) {
+    _order[next[partition_of(_hashes[i])]++] = i;
+  }
+
+  // Every partition table is at most half full
+  _slot_begin.assign(num_partitions + 1, 0);
+  for(size_t p = 0; p < num_partitions; ++p) {
+    size_t partition_size = _partition_begin[p + 1] - _partition_begin[p];
+    size_t num_slots = 1;
+    while(num_slots < 2 * partition_size) num_slots *= 2;
+    _slot_begin[p + 1] = _slot_begin[p] + num_slots;
+  }
+  _slots.assign(_slot_begin[num_partitions], 0);
+  _group_end.assign(num_rows, 0);
+  _matched.assign(num_rows, 0);
+
+  parallel_for(0, num_partitions, [&](size_t p) {
+    build_partition(p);
+  });
+  _built = true;
+}
+
+void join_hash_table::build_partition(size_t partition) {
+  size_t begin = _partition_begin[partition];
+  size_t end = _partition_begin[partition + 1];
+  if(begin == end) return;
+  size_t* slots = _slots.data() + _slot_begin[partition];
+  size_t mask = _slot_begin[partition + 1] - _slot_begin[partition] - 1;
+
+  // Find the group of every row. While building, the table refers to the
+  // groups by their index in the partition.
+  std::vector<size_t> row_group(end - begin);
+  std::vector<size_t> group_first_row;
+  std::vector<size_t> group_size;
+  for(size_t i = begin; i < end; ++i) {
+    size_t row = _order[i];
+    size_t slot = _hashes[row] & mask;
+    while(true) {
+      if(slots[slot] == 0) {
+        slots[slot] = group_first_row.size() + 1;
+        group_first_row.push_back(row);
+        group_size.push_back(0);
+        break;
+      }
+      size_t first_row = group_first_row[slots[slot] - 1];
+      if(_hashes[first_row] == _hashes[row] &&
+         stored_join_values_equal(first_row, row)) {
         break;
       }
-      ++it;
+      slot = (slot + 1) & mask;
     }
+    row_group[i - begin] = slots[slot] - 1;
+    ++group_size[slots[slot] - 1];
+  }
 
-    // If we get here, this means the join key hashed to the same value as a
-    // different join key
-    if(!matched) {
-      hash_join_row_t tmp;
-      tmp.rows = {row};
-      tmp.matched = false;
-      find_ret->second.push_back(std::move(tmp));
-      first_entry = true;
-    }
+  // Lay out the rows of every group contiguously
+  std::vector<size_t> group_begin(group_size.size());
+  size_t pos = begin;
+  for(size_t g = 0; g < group_size.size(); ++g) {
+    group_begin[g] = pos;
+    _group_end[pos] = pos + group_size[g];
+    pos += group_size[g];
+  }
+  std::vector<size_t> rows(_order.begin() + begin, _order.begin() + end);
+  std::vector<size_t> next(group_begin);
+  for(size_t i = 0; i < rows.size(); ++i) {
+    _order[next[row_group[i]]++] = rows[i];
   }
 
-  return first_entry;
+  // From now on the table refers to the groups by their starting position
+  for(size_t slot = 0; slot <= mask; ++slot) {
+    if(slots[slot] != 0) slots[slot] = group_begin[slots[slot] - 1] + 1;
+  }
 }
 
-const join_hash_table::value_type& join_hash_table::get_matching_rows(
-    const std::vector<flexible_type> &row,
-    const std::vector<size_t> &hash_positions,
-    bool mark_match) {
-
+size_t join_hash_table::find(const std::vector<flexible_type> &row,
+                             const std::vector<size_t> &hash_positions,
+                             bool mark_match) {
+  DASSERT_TRUE(_built);
   size_t the_hash_key = compute_hash_from_row(row, hash_positions);
-  auto ret = _hash_table.find(the_hash_key);
+  size_t partition = partition_of(the_hash_key);
+  const size_t* slots = _slots.data() + _slot_begin[partition];
+  size_t mask = _slot_begin[partition + 1] - _slot_begin[partition] - 1;
 
-  if(ret == _hash_table.end()) {
-    // Return empty hash_join_key_t if nothing is found
-    return empty_vt;
-  } else {
+  for(size_t slot = the_hash_key & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+    size_t group = slots[slot] - 1;
+    size_t first_row = _order[group];
     // There's a hit on the hash! See if it is an actual match.
-    auto it = ret->second.begin();
-    while(it != ret->second.end()) {
-      if(join_values_equal(it->rows[0], row, hash_positions)) {
-        if(mark_match) {
-          it->matched = true;
-        }
-        return *it;
+    if(_hashes[first_row] == the_hash_key &&
+       join_values_equal(first_row, row, hash_positions)) {
+      if(mark_match) {
+        _matched[group] = 1;
       }
-      ++it;
+      return group;
     }
+  }
+  return NOT_FOUND;
+}
 
-    // If we're here, we didn't find an actual match
-    return empty_vt;
+void join_hash_table::get_group_rows(size_t group,
+                                     std::vector<std::vector<flexible_type>> &rows) const {
+  rows.resize(_group_end[group] - group);
+  for(size_t i = 0; i < rows.size(); ++i) {
+    const flexible_type* row = stored_row(_order[group + i]);
+    rows[i].assign(row, row + _num_columns);
   }
 }
 
-bool join_hash_table::join_values_equal(const std::vector<flexible_type> &row,
-                                        const std::vector<flexible_type> &other,
-                                        const std::vector<size_t> &hash_positions) {
-  if(hash_positions.size() == 0) {
-    if(row.size() == 0 && other.size() == 0) {
-      return true;
-    } else {
-      return false;
-    }
+void join_hash_table::for_each_unmatched_group(std::function<void(size_t)> fn) const {
+  DASSERT_TRUE(_built);
+  for(size_t group = 0; group < _order.size(); group = _group_end[group]) {
+    if(!_matched[group]) fn(group);
   }
+}
 
+bool join_hash_table::join_values_equal(size_t stored_row_id,
+                                        const std::vector<flexible_type> &other,
+                                        const std::vector<size_t> &hash_positions) const {
   ASSERT_EQ(_hash_positions.size(), hash_positions.size());
 
+  const flexible_type* row = stored_row(stored_row_id);
   for(size_t i = 0; i < hash_positions.size(); ++i) {
     if(row[_hash_positions[i]] != other[hash_positions[i]]) {
       return false;
@@ -110,28 +178,28 @@ bool join_hash_table::join_values_equal(const std::vector<flexible_type> &row,
   return true;
 }
 
-size_t join_hash_table::num_stored_rows() {
-  size_t num_rows = 0;
-  size_t num_unique_join_values = 0;
-  logstream(LOG_INFO) << "Number of hash values: " << _hash_table.size() << std::endl;
-  for(auto it = _hash_table.begin(); it != _hash_table.end(); ++it) {
-    for(auto it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
-      num_unique_join_values++;
-      num_rows += it2->rows.size();
+bool join_hash_table::stored_join_values_equal(size_t stored_row_id,
+                                               size_t other_stored_row_id) const {
+  const flexible_type* row = stored_row(stored_row_id);
+  const flexible_type* other = stored_row(other_stored_row_id);
+  for(size_t pos : _hash_positions) {
+    if(row[pos] != other[pos]) {
+      return false;
     }
   }
-  logstream(LOG_INFO) << "Number of unique join values: " << num_unique_join_values << std::endl;
-  logstream(LOG_INFO) << "Number of stored rows: " << num_rows << std::endl;
-
-  return num_rows;
+  return true;
 }
 
-std::unordered_map<size_t, std::list<join_hash_table::value_type>>::const_iterator join_hash_table::cbegin() {
-  return _hash_table.cbegin();
-}
+size_t join_hash_table::num_stored_rows() {
+  size_t num_unique_join_values = 0;
+  for(size_t group = 0; group < _order.size(); group = _group_end[group]) {
+    num_unique_join_values++;
+  }
+  logstream(LOG_INFO) << "Number of partitions: " << (size_t(1) << _radix_bits) << std::endl;
+  logstream(LOG_INFO) << "Number of unique join values: " << num_unique_join_values << std::endl;
+  logstream(LOG_INFO) << "Number of stored rows: " << _hashes.size() << std::endl;
 
-std::unordered_map<size_t, std::list<join_hash_table::value_type>>::const_iterator join_hash_table::cend() {
-  return _hash_table.cend();
+  return _hashes.size();
 }
 
 hash_join_executor::hash_join_executor(const sframe &left,
@@ -315,22 +383,22 @@ sframe hash_join_executor::grace_hash_join() {
   ti.start();
   for(size_t i = 0; i < num_segments; ++i) {
     // Load the entire left partition into a hash table
-    join_hash_table cur_ht(_left_join_positions);
+    join_hash_table cur_ht(_left_join_positions, _left_frame.num_columns());
     for(auto iter = l_rdr->begin(i); iter != l_rdr->end(i); ++iter) {
       // Must unpack the row data from the serialized string it is stored as
-      std::vector<flexible_type> row;
       if(_frames_partitioned) {
-        row = unpack_row(std::string(iter->at(0)), _left_frame.num_columns());
+        cur_ht.add_row(unpack_row(std::string(iter->at(0)), _left_frame.num_columns()));
       } else {
-        row = *iter;
+        cur_ht.add_row(*iter);
       }
-      cur_ht.add_row(row);
     }
+    cur_ht.build();
 
     parallel_for(0, result_frame.num_segments(),
         [&](size_t seg_num) {
           size_t cur_logical_segment = i*result_frame.num_segments()+seg_num;
           auto writer = result_output_iterators[seg_num];
+          std::vector<std::vector<flexible_type>> left_rows;
 
           // Iterate through the logical segment of the current segment
           for(auto iter = r_rdr->begin(cur_logical_segment);
@@ -346,15 +414,18 @@ sframe hash_join_executor::grace_hash_join() {
             }
 
             // Merge any matching rows to the corresponding left row and write
-            auto query_result = cur_ht.get_matching_rows(row, _right_join_positions);
+            size_t group = cur_ht.find(row, _right_join_positions);
 
-            // If our matching rows query returned something, then this result
-            // should be in the inner join.  If it didn't, this row should only
-            // be in a right join
-            if((query_result.rows.size() > 0) ||
-              ((query_result.rows.size() == 0) && _right_join)) {
+            // If our lookup found something, then this result should be in
+            // the inner join.  If it didn't, this row should only be in a
+            // right join
+            if(group != join_hash_table::NOT_FOUND) {
               // Match found! Add to the result set
-              merge_rows_for_output(result_frame, writer, query_result.rows, {row});
+              cur_ht.get_group_rows(group, left_rows);
+              merge_rows_for_output(result_frame, writer, left_rows, {row});
+            } else if(_right_join) {
+              merge_rows_for_output(result_frame, writer,
+                                    std::vector<std::vector<flexible_type>>(), {row});
             }
           }
         });
@@ -362,18 +433,17 @@ sframe hash_join_executor::grace_hash_join() {
     // Get an output iterator for a segment...try not to overload one segment
     size_t seg_cntr = 0;
     if(_left_join) {
-      for(auto iter = cur_ht.cbegin(); iter != cur_ht.cend(); ++iter) {
-        for(auto iter2 = iter->second.begin(); iter2 != iter->second.end(); ++iter2) {
-          if(!iter2->matched) {
-            auto result_writer =
-              result_output_iterators[seg_cntr % result_frame.num_segments()];
-            merge_rows_for_output(result_frame,
-                result_writer,
-                {iter2->rows},
-                std::vector<std::vector<flexible_type>>());
-          }
-        }
-      }
+      std::vector<std::vector<flexible_type>> left_rows;
+      cur_ht.for_each_unmatched_group([&](size_t group) {
+        auto result_writer =
+          result_output_iterators[seg_cntr % result_frame.num_segments()];
+        ++seg_cntr;
+        cur_ht.get_group_rows(group, left_rows);
+        merge_rows_for_output(result_frame,
+            result_writer,
+            left_rows,
+            std::vector<std::vector<flexible_type>>());
+      });
     }
   }
   logstream(LOG_INFO) << "Hash join time: " << ti.current_time() << std::endl;
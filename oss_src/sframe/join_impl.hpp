@@ -5,9 +5,12 @@
  * This software may be modified and distributed under the terms
  * of the BSD license. See the LICENSE file for details.
  */
+#ifndef GRAPHLAB_SFRAME_JOIN_IMPL_HPP
+#define GRAPHLAB_SFRAME_JOIN_IMPL_HPP
 #include <cstdio>
 #include <unordered_set>
 #include <unordered_map>
+#include <functional>
 
 #include <sframe/sframe.hpp>
 
@@ -21,72 +24,120 @@ size_t hash_key(const std::vector<flexible_type>& key);
 size_t compute_hash_from_row(const std::vector<flexible_type> &row,
                              const std::vector<size_t> &positions);
 
-typedef struct {
-  std::vector<std::vector<flexible_type>> rows;
-  bool matched;
-} hash_join_row_t;
-
 /**
  * This class is the keeper of an in-memory hash table for use in a join
  * algorithm. Its methods facilatate hashing by given join keys by taking
  * a vector of positions these keys are in a row.
  *
- * NOTE:Could be templated for hash_type, row_type, but I don't see a need now.
+ * The table is built in two phases. Rows are first appended with add_row()
+ * into one contiguous array of cells, together with the hash of their join
+ * keys. build() then radix partitions the rows on the high bits of the hash
+ * and, in parallel for every partition, groups the rows with identical join
+ * keys next to each other and indexes the groups in a small open addressing
+ * table. A lookup hence only touches one partition, and the rows of a join
+ * key are contiguous in memory.
  */
 class join_hash_table {
  public:
-  typedef hash_join_row_t value_type;
+  /// Returned by find() when no stored row matches.
+  static const size_t NOT_FOUND = (size_t)(-1);
 
   /** 
    * Constructor.  Takes a vector of hash positions, which are the column
    * numbers in each row that represent the values the join is on (or the join
    * keys).  These hash positions are for the frame that each row is added from.
+   * All rows added must have num_columns values.
    */
-  join_hash_table(std::vector<size_t> hp) : _hash_positions(hp) {}
+  join_hash_table(std::vector<size_t> hp, size_t num_columns);
 
   /**
    * Add a row to the hash table.  Each row must be from the same frame, or
-   * else join results will not make sense.
+   * else join results will not make sense. Must be called before build().
+   */
+  void add_row(const std::vector<flexible_type> &row);
+
+  /**
+   * Partitions and indexes all the added rows. Must be called once, after
+   * all rows are added and before any lookup.
    */
-  bool add_row(const std::vector<flexible_type> &row);
+  void build();
 
   /**
-   * Returns all rows whose join keys match the given row's join keys.
+   * Returns the group of stored rows whose join keys match the given row's
+   * join keys (at hash_positions in that row), or NOT_FOUND.
    *
-   * The return object is a hash_join_row_t, a structure containing a list of
-   * rows and whether this join key was "matched" or not.  An optional argument
-   * marks all of the matching rows as "matched", which is usually used for
-   * completing a left join, in deciding which rows need to be joined with NULL
-   * values and emitted into the result set.
+   * An optional argument marks the group as "matched", which is usually used
+   * for completing a left join, in deciding which rows need to be joined
+   * with NULL values and emitted into the result set.
+   */
+  size_t find(const std::vector<flexible_type> &row,
+              const std::vector<size_t> &hash_positions,
+              bool mark_match=true);
+
+  /**
+   * Copies the rows of a group into rows, reusing its storage.
+   */
+  void get_group_rows(size_t group,
+                      std::vector<std::vector<flexible_type>> &rows) const;
+
+  /**
+   * Calls fn(group) on every group which was never marked as matched.
    */
-  const value_type &get_matching_rows(const std::vector<flexible_type> &row,
-                                      const std::vector<size_t> &hash_positions,
-                                      bool mark_match=true);
+  void for_each_unmatched_group(std::function<void(size_t)> fn) const;
 
   /**
    * Prints stats about the hash table to the log.
    */
   size_t num_stored_rows();
-  std::unordered_map<size_t, std::list<value_type>>::const_iterator cbegin();
-  std::unordered_map<size_t, std::list<value_type>>::const_iterator cend();
-
 
  private:
   /**
-   * Does an itemwise check to see if two rows have matching join keys.
+   * Does an itemwise check to see if the join keys of a stored row match
+   * the join keys of a row.
    */
-  bool join_values_equal(const std::vector<flexible_type> &row,
-      const std::vector<flexible_type> &other,
-      const std::vector<size_t> &hash_positions);
-
-  // Holds a list of each row with an identical hash key.  If we are joining on
-  // a key that holds a unique primary key within it, all entries will have a vector
-  // with 1 element.  We can't guarantee this though, so the value type is a vector
-  // of vectors.
-  std::unordered_map<size_t, std::list<value_type>> _hash_table;
+  bool join_values_equal(size_t stored_row,
+                         const std::vector<flexible_type> &other,
+                         const std::vector<size_t> &hash_positions) const;
+
+  /// Groups and indexes the rows of one partition.
+  void build_partition(size_t partition);
+
+  /// Does an itemwise check to see if two stored rows have matching join keys.
+  bool stored_join_values_equal(size_t stored_row, size_t other_stored_row) const;
+
+  inline const flexible_type* stored_row(size_t row) const {
+    return _cells.data() + row * _num_columns;
+  }
+
+  inline size_t partition_of(size_t hash) const {
+    return _radix_bits == 0 ? 0 : (uint64_t(hash) >> (64 - _radix_bits));
+  }
+
   // The positions in the rows that we store taht make up the hash key
   std::vector<size_t> _hash_positions;
-  value_type empty_vt;
+  size_t _num_columns;
+  // The cells of all stored rows, row after row
+  std::vector<flexible_type> _cells;
+  // The hash of the join key of every stored row
+  std::vector<size_t> _hashes;
+  // Number of high bits of the hash used to pick the partition
+  size_t _radix_bits = 0;
+  // The stored rows, ordered by partition and then by join key. The rows of
+  // partition p are in _order[_partition_begin[p] .. _partition_begin[p+1])
+  std::vector<size_t> _order;
+  std::vector<size_t> _partition_begin;
+  // For every position in _order where a group starts, where it ends.
+  // A group is identified by the position where it starts.
+  std::vector<size_t> _group_end;
+  // Per partition open addressing tables of (group + 1), 0 for empty slots.
+  // The table of partition p is _slots[_slot_begin[p] .. _slot_begin[p+1])
+  // and has a power of two size.
+  std::vector<size_t> _slots;
+  std::vector<size_t> _slot_begin;
+  // Whether each group (by starting position) was matched. Concurrent
+  // lookups only ever set it to 1.
+  std::vector<unsigned char> _matched;
+  bool _built = false;
 };
 
 /**
@@ -174,3 +225,4 @@ class hash_join_executor {
 
 } // end of join_impl
 } // end of graphlab
+#endif
@@ -15,6 +15,7 @@
 #include <logger/logger.hpp>
 #include <timer/timer.hpp>
 #include <parallel/thread_pool.hpp>
+#include <parallel/pthread_tools.hpp>
 #include <parallel/atomic.hpp>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sframe.hpp>
@@ -184,14 +185,29 @@ class parallel_csv_parser {
   void set_total_input_size(size_t input_size) {
     total_input_file_sizes = input_size;
   }
+
   /**
-   * Parses an input file into an output frame
+   * Writes all outputs to the given segment. Used instead of
+   * set_total_input_size when several parsers write to the same frame.
+   */
+  void set_output_segment(size_t output_segment) {
+    total_input_file_sizes = 0;
+    current_output_segment = output_segment;
+  }
+
+  /**
+   * Parses an input file into an output frame. If num_bytes is given, only
+   * that many bytes are read from the current position of the file, which
+   * must end at a line boundary.
    */
   void parse(general_ifstream& fin, 
              sframe& output_frame, 
-             sarray<flexible_type>& errors) {
+             sarray<flexible_type>& errors,
+             size_t num_bytes = (size_t)(-1)) {
     size_t num_output_segments = output_frame.num_segments();
     size_t current_input_file_size = fin.file_size();
+    if (num_bytes != (size_t)(-1)) current_input_file_size = num_bytes;
+    bytes_remaining = num_bytes;
     try {
       timer ti;
       bool fill_buffer_is_good = true;
@@ -362,6 +378,8 @@ class parallel_csv_parser {
   size_t row_limit = 0;
   size_t cumulative_file_read_sizes = 0;
   size_t total_input_file_sizes = 0;
+  /// The number of bytes left to read from the current file
+  size_t bytes_remaining = (size_t)(-1);
 
   volatile bool background_thread_running = false;
   atomic<size_t> num_failures = 0;
@@ -604,6 +622,7 @@ class parallel_csv_parser {
    * ends with a line terminator, even the last line. 
    */
   void add_line_terminator_to_buffer() {
+    if (buffer.empty()) return;
     if (is_regular_line_terminator && 
         buffer[buffer.length() - 1] != '\n' && 
         buffer[buffer.length() - 1] != '\r') {
@@ -620,12 +639,14 @@ class parallel_csv_parser {
    * lines were read. False otherwise: indicating this is the last block.
    */
   bool fill_buffer(general_ifstream& fin) {
-    if (fin.good()) {
+    if (fin.good() && bytes_remaining > 0) {
       size_t oldsize = buffer.size();
-      size_t amount_to_read = SFRAME_CSV_PARSER_READ_SIZE;
+      size_t amount_to_read = std::min<size_t>(SFRAME_CSV_PARSER_READ_SIZE,
+                                               bytes_remaining);
       buffer.resize(buffer.size() + amount_to_read);
       fin.read(&(buffer[0]) + oldsize, buffer.size() - oldsize);
-      if ((size_t)fin.gcount() < amount_to_read) {
+      if (bytes_remaining != (size_t)(-1)) bytes_remaining -= fin.gcount();
+      if ((size_t)fin.gcount() < amount_to_read || bytes_remaining == 0) {
         // if we did not read till the entire buffer , this is an EOF
         buffer.resize(oldsize + fin.gcount());
         // EOF. Put a line_terminator to catch the last line
@@ -877,10 +898,37 @@ void get_column_types(csv_info& info,
 
 } // anonymous namespace
 
+/**
+ * A part of the input: a file, or the lines of a file between two byte
+ * offsets. Parts of files beginning after the first byte do not have the
+ * skipped rows and the header.
+ */
+struct csv_input_part {
+  std::string path;
+  size_t begin = 0;
+  /// (size_t)(-1) for the end of the file
+  size_t end = (size_t)(-1);
+};
+
+size_t find_line_start(const std::string& path, size_t offset) {
+  if (offset == 0) return 0;
+  general_ifstream fin(path);
+  size_t file_size = fin.file_size();
+  if (offset >= file_size) return file_size;
+  // the line containing the byte before offset ends before the next line
+  fin.seekg(offset - 1);
+  std::string line;
+  eol_safe_getline(fin, line);
+  if (!fin.good()) return file_size;
+  std::streamoff pos = fin.tellg();
+  if (pos < 0 || (size_t)pos > file_size) return file_size;
+  return pos;
+}
+
 /**
  * Parsed a CSV file to an SFrame.
  *
- * \param path The file to open as a csv
+ * \param part The file to open as a csv, or the part of it to parse
  * \param tokenizer The tokenizer configuration to use. This should be 
  *                  filled with all the tokenization rules (like what
  *                  separator character to use, what quoting character to use, 
@@ -892,7 +940,7 @@ void get_column_types(csv_info& info,
  * for each input file.
  */
 void parse_csv_to_sframe(
-    const std::string& path,
+    const csv_input_part& part,
     csv_line_tokenizer& tokenizer,
     csv_file_handling_options options,
     sframe& frame,
@@ -903,6 +951,7 @@ void parse_csv_to_sframe(
   auto continue_on_failure = options.continue_on_failure;
   auto store_errors = options.store_errors;
   auto skip_rows = options.skip_rows;
+  const std::string& path = part.path;
 
   logstream(LOG_INFO) << "Loading sframe from " << sanitize_url(path) << std::endl;
 
@@ -911,6 +960,13 @@ void parse_csv_to_sframe(
     general_ifstream fin(path);
     if (!fin.good()) log_and_throw("Cannot open " + sanitize_url(path));
 
+    if (part.begin > 0) {
+      // a later part of the file. The header is in the first part.
+      fin.seekg(part.begin);
+      use_header = false;
+      skip_rows = 0;
+    }
+
     // skip skip_rows lines
     std::string skip_string;
     for (size_t i = 0;i < skip_rows; ++i) {
@@ -944,10 +1000,16 @@ void parse_csv_to_sframe(
       file_errors->set_type(flex_type_enum::STRING);
     }
 
+    // the number of bytes to the end of the part
+    size_t num_bytes = (size_t)(-1);
+    if (part.end != (size_t)(-1)) {
+      std::streamoff pos = fin.tellg();
+      num_bytes = (pos >= 0 && (size_t)pos < part.end) ? part.end - pos : 0;
+    }
+
     try {
-      parser.parse(fin, frame, *file_errors);
+      parser.parse(fin, frame, *file_errors, num_bytes);
     } catch(const std::string& s) {
-      frame.close();
       if (store_errors) file_errors->close();
       log_and_throw(s);
     }
@@ -961,11 +1023,20 @@ void parse_csv_to_sframe(
     if (store_errors) {
       file_errors->close();
       if (file_errors->size() > 0) {
-        errors.insert(std::make_pair(path, file_errors));
+        // the errors of the earlier parts of the file come first
+        auto iter = errors.find(path);
+        if (iter == errors.end()) {
+          errors.insert(std::make_pair(path, file_errors));
+        } else {
+          iter->second = std::make_shared<sarray<flexible_type>>(
+              iter->second->append(*file_errors));
+        }
       }
     }
 
-    logprogress_stream << "Finished parsing file " << sanitize_url(path) << std::endl;
+    if (part.end == (size_t)(-1)) {
+      logprogress_stream << "Finished parsing file " << sanitize_url(path) << std::endl;
+    }
   }
 }
 
@@ -1075,41 +1146,185 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sfra
   // fill in the type information
   get_column_types(info, column_type_hints);
 
-  parallel_csv_parser parser(info.column_types, tokenizer,
-                             continue_on_failure, store_errors, row_limit,
-                             output_column_order);
   // get the total input file size so I can stripe it across segments
   size_t total_input_file_sizes = 0;
+  std::vector<size_t> file_sizes;
   for (auto file : files) {
     general_ifstream fin(file);
-    total_input_file_sizes += fin.file_size();
-  }
-  parser.set_total_input_size(total_input_file_sizes);
-
-  if (!frame.is_opened_for_write()) {
-    // open as many segments as there are temp directories.
-    // But at least one segment
-    frame.open_for_write(info.column_names, info.column_types, 
-                         frame_sidx_file, 
-                         std::max<size_t>(1, num_temp_directories()));
+    file_sizes.push_back(fin.file_size());
+    total_input_file_sizes += file_sizes.back();
   }
 
   // create the errors map
   std::map<std::string, std::shared_ptr<sarray<flexible_type>>> errors;
 
-  // start parser timer for cumulative time consumed (in seconds)
-  parser.start_timer();
+  /*
+   * Several files, or large uncompressed files, are parsed concurrently:
+   * the input is cut into parts (files, or ranges of lines of a file) which
+   * are assigned, in order, to groups of about equal size. Each group is
+   * parsed by its own parser, into its own segment, so the rows keep the
+   * order of the input.
+   *
+   * A row limit requires the rows to be read in order, and a frame opened
+   * by the caller has its own segments: these are parsed sequentially.
+   */
+  size_t max_groups = std::max<size_t>(1, thread::cpu_count() / 2);
+  std::vector<csv_input_part> parts;
+  if (row_limit == 0 && !frame.is_opened_for_write() && max_groups > 1) {
+    size_t range_size = std::max<size_t>(2 * SFRAME_CSV_PARSER_READ_SIZE,
+                                         total_input_file_sizes / max_groups);
+    for (size_t i = 0; i < files.size(); ++i) {
+      // only uncompressed files can be read from an offset, and only
+      // regular line terminators can be found by scanning back
+      bool splittable = file_sizes[i] > range_size &&
+          tokenizer.line_terminator == "\n" &&
+          !boost::algorithm::ends_with(files[i], ".gz");
+      if (splittable && use_header && !store_errors) {
+        // files with a mismatched header are skipped as a whole
+        size_t num_input_columns = output_column_order.empty() ?
+            info.ncols : output_column_order.size();
+        csv_info file_info;
+        try {
+          read_csv_header(file_info, files[i], tokenizer, use_header, skip_rows);
+          splittable = file_info.ncols == num_input_columns;
+        } catch (...) {
+          splittable = false;
+        }
+      }
+      if (!splittable) {
+        csv_input_part part;
+        part.path = files[i];
+        parts.push_back(part);
+        continue;
+      }
+      size_t begin = 0;
+      while (begin < file_sizes[i]) {
+        size_t end = find_line_start(files[i], begin + range_size);
+        if (end <= begin) end = file_sizes[i];
+        csv_input_part part;
+        part.path = files[i];
+        part.begin = begin;
+        part.end = end >= file_sizes[i] ? (size_t)(-1) : end;
+        parts.push_back(part);
+        begin = end;
+      }
+    }
+  }
+
+  size_t num_groups = std::min(parts.size(), max_groups);
+  if (num_groups > 1) {
+    // assign the parts to the groups, by their cumulative size
+    std::vector<std::vector<csv_input_part>> groups(num_groups);
+    size_t bytes_before = 0;
+    for (const auto& part: parts) {
+      size_t file_size = file_sizes[std::find(files.begin(), files.end(), part.path)
+                                    - files.begin()];
+      size_t part_end = std::min(part.end, file_size);
+      size_t group = std::min(num_groups - 1,
+                              bytes_before * num_groups /
+                                std::max<size_t>(total_input_file_sizes, 1));
+      groups[group].push_back(part);
+      bytes_before += part_end - std::min(part.begin, part_end);
+    }
+    logstream(LOG_INFO) << "Parsing " << parts.size() << " parts in "
+                        << num_groups << " groups" << std::endl;
+
+    frame.open_for_write(info.column_names, info.column_types,
+                         frame_sidx_file, num_groups);
+
+    size_t threads_per_group = std::max<size_t>(
+        2, thread_pool::get_instance().size() / num_groups + 1);
+    std::vector<std::unique_ptr<parallel_csv_parser>> parsers;
+    std::vector<csv_line_tokenizer> tokenizers(num_groups, tokenizer);
+    std::vector<std::map<std::string, std::shared_ptr<sarray<flexible_type>>>>
+        group_errors(num_groups);
+    std::vector<std::exception_ptr> group_exceptions(num_groups);
+    for (size_t i = 0; i < num_groups; ++i) {
+      parsers.emplace_back(new parallel_csv_parser(
+          info.column_types, tokenizers[i], continue_on_failure, store_errors,
+          row_limit, output_column_order, threads_per_group));
+      parsers[i]->set_output_segment(i);
+    }
 
-  for (auto file : files) {
-    // check that we've read < row_limit  
-    if (parser.num_lines_read() < row_limit || row_limit == 0) {      
-      parse_csv_to_sframe(file, tokenizer, options, frame, 
-                          frame_sidx_file, parser, errors);
-    } else break;
+    timer ti;
+    atomic<size_t> num_failed_groups = 0;
+    thread_group drivers;
+    for (size_t i = 0; i < num_groups; ++i) {
+      drivers.launch([&, i]() {
+        try {
+          parsers[i]->start_timer();
+          for (const auto& part: groups[i]) {
+            if (num_failed_groups.value > 0) break;
+            parse_csv_to_sframe(part, tokenizers[i], options, frame,
+                                frame_sidx_file, *parsers[i], group_errors[i]);
+          }
+        } catch (...) {
+          group_exceptions[i] = std::current_exception();
+          num_failed_groups.inc();
+        }
+      });
+    }
+    drivers.join();
+
+    // the error of the earliest group is reported
+    for (auto& e: group_exceptions) {
+      if (e) {
+        frame.close();
+        std::rethrow_exception(e);
+      }
+    }
+
+    size_t num_lines_read = 0;
+    for (size_t i = 0; i < num_groups; ++i) {
+      num_lines_read += parsers[i]->num_lines_read();
+      // the errors of a file split across groups are appended in order
+      for (auto& file_errors: group_errors[i]) {
+        auto iter = errors.find(file_errors.first);
+        if (iter == errors.end()) {
+          errors.insert(file_errors);
+        } else {
+          iter->second = std::make_shared<sarray<flexible_type>>(
+              iter->second->append(*file_errors.second));
+        }
+      }
+    }
+    logprogress_stream << "Parsing completed. Parsed " << num_lines_read
+                       << " lines in " << ti.current_time() << " secs."  << std::endl;
+  } else {
+    parallel_csv_parser parser(info.column_types, tokenizer,
+                               continue_on_failure, store_errors, row_limit,
+                               output_column_order);
+    parser.set_total_input_size(total_input_file_sizes);
+
+    if (!frame.is_opened_for_write()) {
+      // open as many segments as there are temp directories.
+      // But at least one segment
+      frame.open_for_write(info.column_names, info.column_types, 
+                           frame_sidx_file, 
+                           std::max<size_t>(1, num_temp_directories()));
+    }
+
+    // start parser timer for cumulative time consumed (in seconds)
+    parser.start_timer();
+
+    for (auto file : files) {
+      // check that we've read < row_limit  
+      if (parser.num_lines_read() < row_limit || row_limit == 0) {      
+        csv_input_part part;
+        part.path = file;
+        try {
+          parse_csv_to_sframe(part, tokenizer, options, frame, 
+                              frame_sidx_file, parser, errors);
+        } catch(const std::string&) {
+          frame.close();
+          throw;
+        }
+      } else break;
+    }
+    
+    logprogress_stream << "Parsing completed. Parsed " << parser.num_lines_read()
+                       << " lines in " << parser.get_time_elapsed() << " secs."  << std::endl;
   }
-  
-  logprogress_stream << "Parsing completed. Parsed " << parser.num_lines_read()
-                     << " lines in " << parser.get_time_elapsed() << " secs."  << std::endl;
 
   
   if (frame.is_opened_for_write()) frame.close();
@@ -18,6 +18,12 @@ namespace graphlab {
 
 std::istream& eol_safe_getline(std::istream& is, std::string& t);
 
+/**
+ * Returns the offset of the first line of a file which begins at or after
+ * offset. Only for uncompressed files with the regular line terminator.
+ */
+size_t find_line_start(const std::string& path, size_t offset);
+
 /**
  * All the options pertaining to top level CSV file handling
  */
@@ -0,0 +1,682 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <boost/algorithm/string.hpp>
+#include <logger/logger.hpp>
+#include <logger/assertions.hpp>
+#include <timer/timer.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <parallel/atomic.hpp>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/parallel_json_parser.hpp>
+#include <sframe/parallel_csv_parser.hpp>
+#include <fileio/general_fstream.hpp>
+#include <fileio/sanitize_url.hpp>
+#include <fileio/fs_utils.hpp>
+#include <cppipc/server/cancel_ops.hpp>
+#include <sframe/sframe_constants.hpp>
+
+namespace graphlab {
+
+namespace {
+
+/**
+ * Parses the JSON values of a line, in place. Every function returns false
+ * if the line is not valid JSON at the current position.
+ */
+class json_line_parser {
+ public:
+  json_line_parser(const char* begin, const char* end, bool parse_nested):
+      p(begin), end(end), parse_nested(parse_nested) { }
+
+  /// Returns true if the rest of the line is white space
+  bool at_end() {
+    return !skip_space();
+  }
+
+  /**
+   * Parses an object, calling get_value(key) for every field, which
+   * returns where to store the value of the field, or NULL to skip it.
+   * The rest of the line must be white space.
+   */
+  template <typename F>
+  bool parse_object_fields(F get_value) {
+    if (!consume('{')) return false;
+    if (consume('}')) return at_end();
+    while (true) {
+      if (!parse_string(key) || !consume(':')) return false;
+      flexible_type* value = get_value(key);
+      if (value == NULL) {
+        if (!skip_value()) return false;
+      } else if (!parse_value(*value, parse_nested)) {
+        return false;
+      }
+      if (consume(',')) continue;
+      if (consume('}')) return at_end();
+      return false;
+    }
+  }
+
+ private:
+  const char* p;
+  const char* end;
+  bool parse_nested;
+  std::string key;
+
+  /// Skips white space. Returns false at the end of the line.
+  bool skip_space() {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) ++p;
+    return p < end;
+  }
+
+  bool consume(char c) {
+    if (skip_space() && *p == c) {
+      ++p;
+      return true;
+    }
+    return false;
+  }
+
+  bool consume_literal(const char* literal, size_t length) {
+    if ((size_t)(end - p) < length || strncmp(p, literal, length) != 0) return false;
+    p += length;
+    return true;
+  }
+
+  bool parse_hex4(uint32_t& out) {
+    if (end - p < 4) return false;
+    out = 0;
+    for (size_t i = 0; i < 4; ++i, ++p) {
+      char c = *p;
+      out <<= 4;
+      if (c >= '0' && c <= '9') out += c - '0';
+      else if (c >= 'a' && c <= 'f') out += c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') out += c - 'A' + 10;
+      else return false;
+    }
+    return true;
+  }
+
+  static void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+      out += (char)cp;
+    } else if (cp < 0x800) {
+      out += (char)(0xC0 | (cp >> 6));
+      out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+      out += (char)(0xE0 | (cp >> 12));
+      out += (char)(0x80 | ((cp >> 6) & 0x3F));
+      out += (char)(0x80 | (cp & 0x3F));
+    } else {
+      out += (char)(0xF0 | (cp >> 18));
+      out += (char)(0x80 | ((cp >> 12) & 0x3F));
+      out += (char)(0x80 | ((cp >> 6) & 0x3F));
+      out += (char)(0x80 | (cp & 0x3F));
+    }
+  }
+
+  bool parse_string(std::string& out) {
+    if (!consume('"')) return false;
+    out.clear();
+    while (p < end) {
+      const char* run = p;
+      while (p < end && *p != '"' && *p != '\\') ++p;
+      out.append(run, p);
+      if (p == end) return false;
+      if (*p == '"') {
+        ++p;
+        return true;
+      }
+      // an escape sequence
+      ++p;
+      if (p == end) return false;
+      switch (*p++) {
+       case '"': out += '"'; break;
+       case '\\': out += '\\'; break;
+       case '/': out += '/'; break;
+       case 'b': out += '\b'; break;
+       case 'f': out += '\f'; break;
+       case 'n': out += '\n'; break;
+       case 'r': out += '\r'; break;
+       case 't': out += '\t'; break;
+       case 'u': {
+         uint32_t cp;
+         if (!parse_hex4(cp)) return false;
+         if (cp >= 0xD800 && cp < 0xDC00) {
+           // the high half of a surrogate pair
+           uint32_t low;
+           if (!consume_literal("\\u", 2) || !parse_hex4(low) ||
+               low < 0xDC00 || low >= 0xE000) {
+             return false;
+           }
+           cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+         }
+         append_utf8(out, cp);
+         break;
+       }
+       default:
+         return false;
+      }
+    }
+    return false;
+  }
+
+  bool skip_string() {
+    ++p;
+    while (p < end) {
+      if (*p == '\\') {
+        p += 2;
+      } else if (*p == '"') {
+        ++p;
+        return true;
+      } else {
+        ++p;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Skips a value without parsing it. Objects and arrays are only checked
+   * for balanced brackets.
+   */
+  bool skip_value() {
+    if (!skip_space()) return false;
+    if (*p == '"') return skip_string();
+    if (*p == '{' || *p == '[') {
+      size_t depth = 0;
+      while (p < end) {
+        char c = *p;
+        if (c == '"') {
+          if (!skip_string()) return false;
+          continue;
+        }
+        ++p;
+        if (c == '{' || c == '[') {
+          ++depth;
+        } else if (c == '}' || c == ']') {
+          if (--depth == 0) return true;
+        }
+      }
+      return false;
+    }
+    // a number or a literal
+    const char* begin = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+           *p != ' ' && *p != '\t' && *p != '\r') ++p;
+    return p > begin;
+  }
+
+  bool parse_number(flexible_type& out) {
+    const char* begin = p;
+    bool is_integer = true;
+    while (p < end) {
+      char c = *p;
+      if ((c >= '0' && c <= '9') || c == '-' || c == '+') {
+        ++p;
+      } else if (c == '.' || c == 'e' || c == 'E') {
+        is_integer = false;
+        ++p;
+      } else {
+        break;
+      }
+    }
+    if (p == begin) return false;
+    std::string number(begin, p);
+    char* number_end = NULL;
+    if (is_integer) {
+      errno = 0;
+      long long value = strtoll(number.c_str(), &number_end, 10);
+      if (errno == 0) {
+        out = flex_int(value);
+        return number_end == number.c_str() + number.length();
+      }
+      // too large for an integer
+    }
+    out = flex_float(strtod(number.c_str(), &number_end));
+    return number_end == number.c_str() + number.length();
+  }
+
+  bool parse_value(flexible_type& out, bool nested) {
+    if (!skip_space()) return false;
+    switch (*p) {
+     case '"': {
+       std::string value;
+       if (!parse_string(value)) return false;
+       out = std::move(value);
+       return true;
+     }
+     case '{':
+     case '[': {
+       if (!nested) {
+         // the JSON text of the value
+         const char* begin = p;
+         if (!skip_value()) return false;
+         out = flex_string(begin, p);
+         return true;
+       }
+       return *p == '{' ? parse_dict(out) : parse_list(out);
+     }
+     case 't':
+       if (!consume_literal("true", 4)) return false;
+       out = flex_int(1);
+       return true;
+     case 'f':
+       if (!consume_literal("false", 5)) return false;
+       out = flex_int(0);
+       return true;
+     case 'n':
+       if (!consume_literal("null", 4)) return false;
+       out = FLEX_UNDEFINED;
+       return true;
+     default:
+       return parse_number(out);
+    }
+  }
+
+  bool parse_dict(flexible_type& out) {
+    ++p;
+    flex_dict dict;
+    if (!consume('}')) {
+      while (true) {
+        std::string field;
+        flexible_type value;
+        if (!parse_string(field) || !consume(':') || !parse_value(value, true)) {
+          return false;
+        }
+        dict.push_back({flexible_type(std::move(field)), std::move(value)});
+        if (consume(',')) continue;
+        if (consume('}')) break;
+        return false;
+      }
+    }
+    out = std::move(dict);
+    return true;
+  }
+
+  /// Arrays of numbers are parsed into vectors, like in CSV files
+  bool parse_list(flexible_type& out) {
+    ++p;
+    flex_list list;
+    bool all_numeric = true;
+    if (!consume(']')) {
+      while (true) {
+        flexible_type value;
+        if (!parse_value(value, true)) return false;
+        all_numeric &= (value.get_type() == flex_type_enum::INTEGER ||
+                        value.get_type() == flex_type_enum::FLOAT);
+        list.push_back(std::move(value));
+        if (consume(',')) continue;
+        if (consume(']')) break;
+        return false;
+      }
+    }
+    if (all_numeric) {
+      flex_vec vec;
+      vec.reserve(list.size());
+      for (const auto& value: list) vec.push_back(value.to<flex_float>());
+      out = std::move(vec);
+    } else {
+      out = std::move(list);
+    }
+    return true;
+  }
+};
+
+/**
+ * The type of a column holding values of both types: numbers are floats,
+ * arrays are lists, and anything else is a string.
+ */
+flex_type_enum merge_types(flex_type_enum a, flex_type_enum b) {
+  if (a == flex_type_enum::UNDEFINED) return b;
+  if (b == flex_type_enum::UNDEFINED || a == b) return a;
+  auto either = [&](flex_type_enum x, flex_type_enum y) {
+    return (a == x && b == y) || (a == y && b == x);
+  };
+  if (either(flex_type_enum::INTEGER, flex_type_enum::FLOAT)) return flex_type_enum::FLOAT;
+  if (either(flex_type_enum::VECTOR, flex_type_enum::LIST)) return flex_type_enum::LIST;
+  return flex_type_enum::STRING;
+}
+
+/**
+ * Converts a value to the type of its column. Returns false if it cannot
+ * be converted without loss.
+ */
+bool convert_to_column_type(flexible_type& value, flex_type_enum type) {
+  flex_type_enum value_type = value.get_type();
+  if (value_type == type || value_type == flex_type_enum::UNDEFINED) return true;
+  switch (type) {
+   case flex_type_enum::FLOAT:
+     if (value_type != flex_type_enum::INTEGER) return false;
+     value = value.to<flex_float>();
+     return true;
+   case flex_type_enum::INTEGER: {
+     if (value_type != flex_type_enum::FLOAT) return false;
+     flex_float f = value.get<flex_float>();
+     if (f != (flex_float)(flex_int)f) return false;
+     value = (flex_int)f;
+     return true;
+   }
+   case flex_type_enum::STRING:
+     value = value.to<flex_string>();
+     return true;
+   case flex_type_enum::LIST: {
+     if (value_type != flex_type_enum::VECTOR) return false;
+     const flex_vec& vec = value.get<flex_vec>();
+     value = flex_list(vec.begin(), vec.end());
+     return true;
+   }
+   default:
+     return false;
+  }
+}
+
+/// The lines of a file between two byte offsets
+struct json_input_range {
+  std::string path;
+  size_t begin = 0;
+  /// (size_t)(-1) for the end of the file
+  size_t end = (size_t)(-1);
+};
+
+/**
+ * Calls fn(begin, end) for every line of the range, read block_size bytes
+ * at a time, until it returns false.
+ */
+template <typename F>
+void for_each_line(const json_input_range& range, size_t block_size, F fn) {
+  general_ifstream fin(range.path);
+  if (!fin.good()) log_and_throw("Cannot open " + sanitize_url(range.path));
+  if (range.begin > 0) fin.seekg(range.begin);
+  size_t bytes_remaining = (size_t)(-1);
+  if (range.end != (size_t)(-1)) bytes_remaining = range.end - range.begin;
+
+  std::string buffer;
+  bool eof = false;
+  while (!eof) {
+    size_t oldsize = buffer.size();
+    size_t amount_to_read = std::min(block_size, bytes_remaining);
+    buffer.resize(oldsize + amount_to_read);
+    fin.read(&(buffer[0]) + oldsize, amount_to_read);
+    size_t bytes_read = fin.gcount();
+    buffer.resize(oldsize + bytes_read);
+    if (bytes_remaining != (size_t)(-1)) bytes_remaining -= bytes_read;
+    eof = bytes_read < amount_to_read || bytes_remaining == 0 || !fin.good();
+
+    if(cppipc::must_cancel()) {
+      log_and_throw(std::string("JSON parsing cancelled"));
+    }
+
+    const char* line = buffer.data();
+    const char* buffer_end = line + buffer.size();
+    while (true) {
+      const char* newline = (const char*)memchr(line, '\n', buffer_end - line);
+      if (newline == NULL) break;
+      if (!fn(line, newline)) return;
+      line = newline + 1;
+    }
+    if (eof) {
+      // the last line may not be terminated
+      if (line < buffer_end) fn(line, buffer_end);
+    } else {
+      // keep the incomplete line for the next block
+      buffer.erase(0, line - buffer.data());
+    }
+  }
+}
+
+/// Truncates a line for error messages
+std::string line_for_message(const char* begin, const char* end) {
+  const size_t max_length = 100;
+  if ((size_t)(end - begin) <= max_length) return std::string(begin, end);
+  return std::string(begin, begin + max_length) + "...";
+}
+
+/**
+ * Infers the fields, if not given, and their types from the first lines
+ * of a file.
+ */
+void infer_fields(const std::string& path,
+                  const json_file_handling_options& options,
+                  std::vector<std::string>& fields,
+                  std::vector<flex_type_enum>& types) {
+  fields = options.fields;
+  bool add_fields = fields.empty();
+  std::unordered_map<std::string, size_t> field_index;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (field_index.count(fields[i])) log_and_throw("Duplicate field " + fields[i]);
+    field_index[fields[i]] = i;
+  }
+  types.assign(fields.size(), flex_type_enum::UNDEFINED);
+
+  size_t num_lines = 0;
+  std::vector<flexible_type> row;
+  json_input_range range;
+  range.path = path;
+  for_each_line(range, SFRAME_CSV_PARSER_READ_SIZE,
+                [&](const char* begin, const char* end) {
+    json_line_parser parser(begin, end, options.parse_nested);
+    if (parser.at_end()) return true;
+    row.assign(fields.size(), FLEX_UNDEFINED);
+    bool success = parser.parse_object_fields([&](const std::string& key)->flexible_type* {
+      auto iter = field_index.find(key);
+      if (iter == field_index.end()) {
+        if (!add_fields) return NULL;
+        iter = field_index.insert({key, fields.size()}).first;
+        fields.push_back(key);
+        types.push_back(flex_type_enum::UNDEFINED);
+        row.push_back(FLEX_UNDEFINED);
+      }
+      return &row[iter->second];
+    });
+    // the types of bad lines are not counted
+    if (success) {
+      for (size_t i = 0; i < row.size(); ++i) {
+        types[i] = merge_types(types[i], row[i].get_type());
+      }
+    }
+    return ++num_lines < options.sample_lines;
+  });
+
+  if (fields.empty()) {
+    log_and_throw("No fields found in the first lines of " + sanitize_url(path));
+  }
+
+  // fields with no values in the sample are strings, unless hinted
+  for (auto& type: types) {
+    if (type == flex_type_enum::UNDEFINED) type = flex_type_enum::STRING;
+  }
+  auto column_type_hints = options.column_type_hints;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (column_type_hints.count(fields[i])) {
+      types[i] = column_type_hints.at(fields[i]);
+      column_type_hints.erase(fields[i]);
+    }
+  }
+  if (column_type_hints.size() > 0) {
+    std::stringstream warning_msg;
+    warning_msg << "These column type hints were not used:";
+    for(const auto &hint : column_type_hints) {
+      warning_msg << " " << hint.first;
+    }
+    logprogress_stream << warning_msg.str() << std::endl;
+  }
+}
+
+} // anonymous namespace
+
+size_t parse_json_lines_to_sframe(
+    const std::string& url,
+    json_file_handling_options options,
+    sframe& frame,
+    std::string frame_sidx_file) {
+  ASSERT_FALSE(frame.is_opened_for_write());
+  std::vector<std::string> files;
+  std::vector<size_t> file_sizes;
+  for (auto p : fileio::get_glob_files(url)) {
+    if (p.second != fileio::file_status::REGULAR_FILE) continue;
+    general_ifstream fin(p.first);
+    size_t file_size = fin.file_size();
+    if (file_size == 0) {
+      logstream(LOG_INFO) << "Skipping file " << sanitize_url(p.first)
+                          << " because it appears to be empty" << std::endl;
+      continue;
+    }
+    files.push_back(p.first);
+    file_sizes.push_back(file_size);
+  }
+  if (files.empty()) {
+    log_and_throw(std::string("No files corresponding to the specified path (") +
+                  sanitize_url(url) + std::string(")."));
+  }
+
+  std::vector<std::string> fields;
+  std::vector<flex_type_enum> types;
+  infer_fields(files[0], options, fields, types);
+  std::unordered_map<std::string, size_t> field_index;
+  for (size_t i = 0; i < fields.size(); ++i) field_index[fields[i]] = i;
+
+  /*
+   * Cut the files, as if they were concatenated, into ranges of about equal
+   * size, at line starts. Compressed files cannot be read from an offset:
+   * their cuts are moved to the start of the next file.
+   */
+  size_t total_size = 0;
+  std::vector<size_t> file_offsets;
+  for (size_t file_size: file_sizes) {
+    file_offsets.push_back(total_size);
+    total_size += file_size;
+  }
+  size_t max_groups = 1;
+  if (options.row_limit == 0) max_groups = std::max<size_t>(1, thread::cpu_count());
+  size_t block_size = std::max<size_t>(SFRAME_CSV_PARSER_READ_SIZE / max_groups, 1024);
+  max_groups = std::max<size_t>(1, std::min(max_groups, total_size / block_size));
+
+  // the cuts, as (file, offset) pairs
+  std::vector<std::pair<size_t, size_t>> cuts{{0, 0}};
+  for (size_t i = 1; i < max_groups; ++i) {
+    size_t pos = total_size / max_groups * i;
+    size_t file = std::upper_bound(file_offsets.begin(), file_offsets.end(), pos)
+        - file_offsets.begin() - 1;
+    size_t offset = pos - file_offsets[file];
+    if (offset > 0 && !boost::algorithm::ends_with(files[file], ".gz")) {
+      offset = find_line_start(files[file], offset);
+    }
+    if (offset >= file_sizes[file] ||
+        (offset > 0 && boost::algorithm::ends_with(files[file], ".gz"))) {
+      ++file;
+      offset = 0;
+    }
+    if (std::make_pair(file, offset) > cuts.back()) cuts.push_back({file, offset});
+  }
+  if (cuts.back().first < files.size()) cuts.push_back({files.size(), 0});
+
+  size_t num_groups = cuts.size() - 1;
+  std::vector<std::vector<json_input_range>> groups(num_groups);
+  for (size_t g = 0; g < num_groups; ++g) {
+    for (size_t file = cuts[g].first;
+         file <= cuts[g + 1].first && file < files.size(); ++file) {
+      json_input_range range;
+      range.path = files[file];
+      if (file == cuts[g].first) range.begin = cuts[g].second;
+      if (file == cuts[g + 1].first) {
+        if (cuts[g + 1].second == 0) break;
+        range.end = cuts[g + 1].second;
+      }
+      groups[g].push_back(range);
+    }
+  }
+  logstream(LOG_INFO) << "Parsing " << files.size() << " JSON files in "
+                      << num_groups << " groups" << std::endl;
+
+  frame.open_for_write(fields, types, frame_sidx_file, num_groups);
+
+  timer ti;
+  atomic<size_t> num_lines_read = 0;
+  atomic<size_t> num_lines_failed = 0;
+  atomic<size_t> num_failed_groups = 0;
+  std::vector<std::exception_ptr> group_exceptions(num_groups);
+  thread_group workers;
+  for (size_t g = 0; g < num_groups; ++g) {
+    workers.launch([&, g]() {
+      try {
+        auto iter = frame.get_output_iterator(g);
+        std::vector<flexible_type> row(fields.size());
+        // stops when another group failed, or when the row limit is reached
+        auto must_stop = [&]() {
+          return num_failed_groups.value > 0 ||
+              (options.row_limit > 0 && num_lines_read.value >= options.row_limit);
+        };
+        for (const auto& range: groups[g]) {
+          if (must_stop()) break;
+          for_each_line(range, block_size, [&](const char* begin, const char* end) {
+            if (must_stop()) return false;
+            json_line_parser parser(begin, end, options.parse_nested);
+            if (parser.at_end()) return true;
+            std::fill(row.begin(), row.end(), FLEX_UNDEFINED);
+            bool success = parser.parse_object_fields(
+                [&](const std::string& key)->flexible_type* {
+                  auto iter = field_index.find(key);
+                  return iter == field_index.end() ? NULL : &row[iter->second];
+                });
+            for (size_t i = 0; success && i < row.size(); ++i) {
+              success = convert_to_column_type(row[i], types[i]);
+            }
+            if (!success) {
+              if (!options.continue_on_failure) {
+                log_and_throw("Unable to parse line \"" +
+                              line_for_message(begin, end) + "\"");
+              }
+              num_lines_failed.inc();
+              return true;
+            }
+            *iter = row;
+            size_t lines_read = num_lines_read.inc();
+            if (g == 0) {
+              logprogress_stream_ontick(5) << "Read " << lines_read << " lines. "
+                                           << "Lines per second: "
+                                           << lines_read / ti.current_time()
+                                           << std::endl;
+            }
+            return options.row_limit == 0 || lines_read < options.row_limit;
+          });
+        }
+      } catch (...) {
+        group_exceptions[g] = std::current_exception();
+        num_failed_groups.inc();
+      }
+    });
+  }
+  workers.join();
+
+  // the error of the earliest group is reported
+  for (auto& e: group_exceptions) {
+    if (e) {
+      frame.close();
+      std::rethrow_exception(e);
+    }
+  }
+  frame.close();
+
+  if (num_lines_failed.value > 0) {
+    logprogress_stream << num_lines_failed.value
+                       << " lines failed to parse correctly" << std::endl;
+  }
+  logprogress_stream << "Parsing completed. Parsed " << num_lines_read.value
+                     << " lines in " << ti.current_time() << " secs."  << std::endl;
+  return num_lines_failed.value;
+}
+
+} // namespace graphlab
@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_PARALLEL_JSON_PARSER_HPP
+#define GRAPHLAB_SFRAME_PARALLEL_JSON_PARSER_HPP
+#include <string>
+#include <vector>
+#include <map>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sframe.hpp>
+namespace graphlab {
+
+/**
+ * All the options pertaining to reading newline-delimited JSON files: one
+ * JSON object per line, each field of which is a column.
+ */
+struct json_file_handling_options {
+  /**
+   * The fields to extract, in column order. If empty, all the fields found
+   * in the sample lines, in the order they first appear.
+   */
+  std::vector<std::string> fields;
+
+  /// Collection of field name->type. The other types are inferred from the sample.
+  std::map<std::string, flex_type_enum> column_type_hints;
+
+  /**
+   * Whether nested objects and arrays are parsed into dictionary and list
+   * (or array, if all numeric) values. Otherwise they are stored as their
+   * JSON text, in string columns.
+   */
+  bool parse_nested = false;
+
+  /// Whether we should just skip lines which fail to parse.
+  bool continue_on_failure = false;
+
+  /// The number of rows to read.  If 0, all lines are read
+  size_t row_limit = 0;
+
+  /// The number of lines of the first file used to infer the column types
+  size_t sample_lines = 1000;
+};
+
+/**
+ * Parses newline-delimited JSON files into a frame, which must not be
+ * opened for write. The url is a file, a directory, or a glob pattern.
+ *
+ * The input is cut into ranges of lines of about equal size (compressed
+ * files are never cut), which are parsed in parallel, each into its own
+ * segment of the frame, so the rows keep the order of the input. Fields
+ * not extracted are skipped without being parsed into values. Missing
+ * fields and JSON nulls are missing values; true and false are 1 and 0.
+ *
+ * Returns the number of lines which failed to parse and were skipped.
+ */
+size_t parse_json_lines_to_sframe(
+    const std::string& url,
+    json_file_handling_options options,
+    sframe& frame,
+    std::string frame_sidx_file = "");
+
+}
+
+#endif // GRAPHLAB_SFRAME_PARALLEL_JSON_PARSER_HPP
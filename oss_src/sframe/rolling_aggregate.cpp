@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <cmath>
+#include <deque>
 #include <flexible_type/flexible_type.hpp>
 #include <boost/circular_buffer.hpp>
 #include <boost/algorithm/string.hpp>
@@ -22,6 +24,164 @@ size_t calculate_window_size(ssize_t start, ssize_t end) {
   return the_size;
 }
 
+/**
+ * Sum, count, average, variance and standard deviation of a window.
+ * Integer sums are kept exactly. Floating point values are accumulated with
+ * Welford's algorithm, which can be reversed to remove a value.
+ */
+class moments_window_aggregate : public window_aggregate {
+ public:
+  enum class output { SUM, COUNT, NON_NULL_COUNT, AVERAGE, VARIANCE, STDV };
+
+  moments_window_aggregate(output out, flex_type_enum input_type)
+      : m_output(out), m_input_type(input_type) { }
+
+  void add(const flexible_type& value) {
+    ++m_size;
+    if (value.get_type() == flex_type_enum::UNDEFINED) return;
+    ++m_count;
+    if (m_input_type == flex_type_enum::INTEGER) m_int_sum += value.get<flex_int>();
+    else m_float_sum += (double)value;
+    double delta = (double)value - m_mean;
+    m_mean += delta / m_count;
+    m_M2 += delta * ((double)value - m_mean);
+  }
+
+  void remove(const flexible_type& value) {
+    --m_size;
+    if (value.get_type() == flex_type_enum::UNDEFINED) return;
+    --m_count;
+    if (m_input_type == flex_type_enum::INTEGER) m_int_sum -= value.get<flex_int>();
+    else m_float_sum -= (double)value;
+    if (m_count == 0) {
+      m_mean = 0;
+      m_M2 = 0;
+      return;
+    }
+    double delta = (double)value - m_mean;
+    m_mean -= delta / m_count;
+    m_M2 -= delta * ((double)value - m_mean);
+    if (m_M2 < 0) m_M2 = 0;
+  }
+
+  void clear() {
+    m_size = 0;
+    m_count = 0;
+    m_int_sum = 0;
+    m_float_sum = 0;
+    m_mean = 0;
+    m_M2 = 0;
+  }
+
+  flexible_type emit() const {
+    switch(m_output) {
+     case output::SUM:
+       if (m_input_type == flex_type_enum::INTEGER) return m_int_sum;
+       return m_float_sum;
+     case output::COUNT:
+       return flexible_type(m_size);
+     case output::NON_NULL_COUNT:
+       return flexible_type(m_count);
+     case output::AVERAGE:
+       if (m_count == 0) return FLEX_UNDEFINED;
+       return m_mean;
+     case output::VARIANCE:
+       return m_count <= 1 ? flexible_type(0.0) : flexible_type(m_M2 / m_count);
+     case output::STDV:
+       return m_count <= 1 ? flexible_type(0.0) : flexible_type(std::sqrt(m_M2 / m_count));
+    }
+    return FLEX_UNDEFINED;
+  }
+
+ private:
+  output m_output;
+  flex_type_enum m_input_type;
+  size_t m_size = 0;
+  size_t m_count = 0;
+  flex_int m_int_sum = 0;
+  double m_float_sum = 0;
+  double m_mean = 0;
+  double m_M2 = 0;
+};
+
+/**
+ * Min or max of a window. The queue holds the values which can still become
+ * the extremum as older values leave the window, in window order; the front
+ * is the current extremum.
+ */
+class extremum_window_aggregate : public window_aggregate {
+ public:
+  explicit extremum_window_aggregate(bool is_max) : m_is_max(is_max) { }
+
+  void add(const flexible_type& value) {
+    size_t position = m_num_added++;
+    if (value.get_type() == flex_type_enum::UNDEFINED) return;
+    // like the aggregators, the earliest of equal values is kept
+    while (!m_candidates.empty() && dominates(value, m_candidates.back().second)) {
+      m_candidates.pop_back();
+    }
+    m_candidates.emplace_back(position, value);
+  }
+
+  void remove(const flexible_type& value) {
+    size_t position = m_num_removed++;
+    if (!m_candidates.empty() && m_candidates.front().first == position) {
+      m_candidates.pop_front();
+    }
+  }
+
+  void clear() {
+    m_candidates.clear();
+    m_num_added = 0;
+    m_num_removed = 0;
+  }
+
+  flexible_type emit() const {
+    if (m_candidates.empty()) return FLEX_UNDEFINED;
+    return m_candidates.front().second;
+  }
+
+ private:
+  /// True if a is strictly a better candidate than b
+  bool dominates(const flexible_type& a, const flexible_type& b) const {
+    return m_is_max ? (b < a) : (a < b);
+  }
+
+  bool m_is_max;
+  size_t m_num_added = 0;
+  size_t m_num_removed = 0;
+  std::deque<std::pair<size_t, flexible_type> > m_candidates;
+};
+
+std::unique_ptr<window_aggregate> make_window_aggregate(
+    const group_aggregate_value& agg_op,
+    flex_type_enum input_type) {
+  typedef moments_window_aggregate::output output;
+  std::unique_ptr<window_aggregate> ret;
+  bool numeric = (input_type == flex_type_enum::INTEGER ||
+                  input_type == flex_type_enum::FLOAT);
+  if (dynamic_cast<const groupby_operators::count*>(&agg_op)) {
+    ret.reset(new moments_window_aggregate(output::COUNT, input_type));
+  } else if (dynamic_cast<const groupby_operators::non_null_count*>(&agg_op)) {
+    ret.reset(new moments_window_aggregate(output::NON_NULL_COUNT, input_type));
+  } else if (dynamic_cast<const groupby_operators::min*>(&agg_op)) {
+    ret.reset(new extremum_window_aggregate(false));
+  } else if (dynamic_cast<const groupby_operators::max*>(&agg_op)) {
+    ret.reset(new extremum_window_aggregate(true));
+  } else if (!numeric) {
+    return ret;
+  } else if (dynamic_cast<const groupby_operators::sum*>(&agg_op)) {
+    ret.reset(new moments_window_aggregate(output::SUM, input_type));
+  } else if (dynamic_cast<const groupby_operators::average*>(&agg_op)) {
+    ret.reset(new moments_window_aggregate(output::AVERAGE, input_type));
+  } else if (dynamic_cast<const groupby_operators::stdv*>(&agg_op)) {
+    ret.reset(new moments_window_aggregate(output::STDV, input_type));
+  } else if (dynamic_cast<const groupby_operators::variance*>(&agg_op)) {
+    ret.reset(new moments_window_aggregate(output::VARIANCE, input_type));
+  }
+  return ret;
+}
+
 std::shared_ptr<sarray<flexible_type>> rolling_apply(
     const sarray<flexible_type> &input,
     std::shared_ptr<group_aggregate_value> agg_op,
@@ -80,6 +240,9 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
     seg_ranges[i] = std::make_pair(size_t(beg), size_t(end));
   }
   
+  // Whether the aggregate can be maintained incrementally
+  bool incremental = (make_window_aggregate(*agg_op, input.get_type()) != nullptr);
+
   // Store the type returned by the aggregation function of each segment
   std::vector<flex_type_enum> fn_returned_types(num_segments,
                                                 flex_type_enum::UNDEFINED);
@@ -116,16 +279,31 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
       }
     }
 
+    // The incremental aggregate over the window, and the number of non-NULL
+    // values in the window.
+    std::unique_ptr<window_aggregate> window_agg;
+    if (incremental) window_agg = make_window_aggregate(*agg_op, input.get_type());
+    size_t observations = 0;
+    for (const auto& val: window_buf) {
+      if (val.get_type() != flex_type_enum::UNDEFINED) ++observations;
+      if (window_agg) window_agg->add(val);
+    }
+    // The floating point state of the incremental aggregate is recomputed
+    // from the window every total_window_size steps so that rounding errors
+    // do not accumulate. This keeps the cost per row constant.
+    size_t steps_since_recompute = 0;
+
     // Go through array with window
     while(logical_pos < logical_end) {
       // First check if we have the minimum non-NULL observations. This is here
       // to remove the burden of checking from every aggregation function.
-      if(check_num_observations &&
-          !has_min_observations(min_observations,
-            window_buf.begin(), window_buf.end())) {
+      // (min_observations is at most the window size, which the window 
+      // buffer always has.)
+      if(check_num_observations && observations < min_observations) {
         *out_iter = flex_undefined();
       } else {
-        auto result = full_window_aggregate(agg_op, window_buf.begin(), window_buf.end());
+        auto result = window_agg ? window_agg->emit() :
+            full_window_aggregate(agg_op, window_buf.begin(), window_buf.end());
         // Record the emitted type from the function. We just take the first
         // one that is non-NULL.
         if(fn_returned_types[segment_id] == flex_type_enum::UNDEFINED && 
@@ -141,12 +319,30 @@ std::shared_ptr<sarray<flexible_type>> rolling_apply(
       ++my_logical_window.second;
 
       // Get the next value in the SArray
+      flexible_type next_value;
       if(my_logical_window.second >= 0 && buf_reader.has_next()) {
-        window_buf.push_back(buf_reader.next());
+        next_value = buf_reader.next();
       } else {
         // If this is a "fake" section of the logical window, just fill with
         // NULL values
-        window_buf.push_back(flex_undefined());
+        next_value = flex_undefined();
+      }
+
+      // Slide the window
+      const flexible_type& oldest_value = window_buf.front();
+      if (oldest_value.get_type() != flex_type_enum::UNDEFINED) --observations;
+      if (next_value.get_type() != flex_type_enum::UNDEFINED) ++observations;
+      if (window_agg && ++steps_since_recompute < total_window_size) {
+        window_agg->remove(oldest_value);
+        window_agg->add(next_value);
+        window_buf.push_back(next_value);
+      } else {
+        window_buf.push_back(next_value);
+        if (window_agg) {
+          window_agg->clear();
+          for (const auto& val: window_buf) window_agg->add(val);
+          steps_since_recompute = 0;
+        }
       }
     }
   }
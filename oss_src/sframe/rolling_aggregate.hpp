@@ -1,6 +1,7 @@
 #ifndef GRAPHLAB_SFRAME_ROLLING_AGGREGATE_HPP
 #define GRAPHLAB_SFRAME_ROLLING_AGGREGATE_HPP
 
+#include <memory>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sarray.hpp>
 #include <sframe/groupby_aggregate_operators.hpp>
@@ -59,6 +60,44 @@ flexible_type full_window_aggregate(std::shared_ptr<group_aggregate_value> agg_o
   return agg->emit();
 }
 
+/**
+ * An aggregate over a moving window which is updated as values enter and
+ * leave the window instead of being recomputed over the whole window.
+ *
+ * Values must be removed in the order they were added. emit() returns the
+ * same value as full_window_aggregate() over the values currently in the
+ * window (up to floating point rounding, see rolling_apply()).
+ */
+class window_aggregate {
+ public:
+  /// Adds a value entering the window (possibly UNDEFINED)
+  virtual void add(const flexible_type& value) = 0;
+
+  /// Removes the oldest value of the window
+  virtual void remove(const flexible_type& value) = 0;
+
+  /// Returns to the state of an empty window
+  virtual void clear() = 0;
+
+  /// Returns the aggregate of the values in the window
+  virtual flexible_type emit() const = 0;
+
+  virtual ~window_aggregate() { }
+};
+
+/**
+ * Returns an incremental version of agg_op (after set_input_type() was called
+ * on it) for the input type, or an empty pointer if there is none, in which
+ * case full_window_aggregate() must be used.
+ *
+ * Sum, count, average, variance and standard deviation are maintained by
+ * adding and removing values. Min and max are maintained with a monotonic
+ * queue of the candidates.
+ */
+std::unique_ptr<window_aggregate> make_window_aggregate(
+    const group_aggregate_value& agg_op,
+    flex_type_enum input_type);
+
 /**
  * Scans the current window to check for the number of non-NULL values.
  *
@@ -466,6 +466,8 @@ class sarray : public swriter_base<swriter_impl::output_iterator<T> > {
     ret.files_managed = files_managed;
 
     ret.index_info.nsegments += other.index_info.nsegments;
+    // the statistics only describe the rows of this array
+    ret.index_info.statistics.clear();
     std::copy(other.index_info.segment_sizes.begin(), other.index_info.segment_sizes.end(),
               std::inserter(ret.index_info.segment_sizes, ret.index_info.segment_sizes.end()));
     std::copy(other.index_info.segment_files.begin(), other.index_info.segment_files.end(),
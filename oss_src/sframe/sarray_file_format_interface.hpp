@@ -139,6 +139,18 @@ class sarray_format_reader<flexible_type>
     ret = read_rows(row_start, row_end, *(out_obj.get_columns()[0]));
     return ret;
   }
+
+  /**
+   * Reads a collection of rows of an integer or float column directly into
+   * the packed representation of \ref typed_column.
+   * Returns false if the format or column does not support this, in which
+   * case read_rows() should be used instead.
+   */
+  virtual bool read_typed_rows(size_t row_start, 
+                               size_t row_end, 
+                               typed_column& out_obj) {
+    return false;
+  }
 };
 
 
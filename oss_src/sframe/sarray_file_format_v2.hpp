@@ -22,9 +22,12 @@
 #include <fileio/temp_files.hpp>
 #include <serialization/serialization_includes.hpp>
 #include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_config.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
 #include <sframe/sarray_v2_block_writer.hpp>
 #include <sframe/sarray_v2_encoded_block.hpp>
+#include <sframe/sarray_v2_type_encoding.hpp>
+#include <sframe/typed_column.hpp>
 #include <cppipc/server/cancel_ops.hpp>
 namespace graphlab {
 
@@ -65,6 +68,7 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     close();
     m_index_info = index;
     m_block_list.clear();
+    m_block_dictionaries.clear();
     m_start_row.clear();
     m_segment_list.clear();
     m_num_rows = 0;
@@ -73,14 +77,26 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
       auto columnaddr =  m_manager.open_column(index.segment_files[i]);
       m_segment_list.push_back(columnaddr);
       size_t nblocks = m_manager.num_blocks_in_column(columnaddr);
+      auto dictionary = m_manager.get_column_dictionary(columnaddr);
       for (size_t j = 0; j < nblocks; ++j) {
         block_address blockaddr{std::get<0>(columnaddr), std::get<1>(columnaddr), j};
         m_start_row.push_back(row_count);
         row_count += m_manager.get_block_info(blockaddr).num_elem;
         m_block_list.push_back(blockaddr);
+        m_block_dictionaries.push_back(dictionary);
       }
     }
     for (auto& ssize: m_index_info.segment_sizes) m_num_rows += ssize;
+    m_packed_type = flex_type_enum::UNDEFINED;
+    if (m_index_info.metadata.count("__type__")) {
+      flex_type_enum column_type = 
+          flex_type_enum(std::stoi(m_index_info.metadata.at("__type__")));
+      if (column_type == flex_type_enum::INTEGER || 
+          column_type == flex_type_enum::FLOAT ||
+          column_type == flex_type_enum::STRING) {
+        m_packed_type = column_type;
+      }
+    }
     m_cache.clear();
     m_cache.resize(m_block_list.size());
     m_used_cache_entries.resize(m_block_list.size());
@@ -138,10 +154,30 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     return m_index_info.index_file;
   }
 
+  /**
+   * Reads a collection of rows into sframe_rows. Integer and float columns,
+   * and string columns stored with a column dictionary, are read as a typed
+   * column (see \ref read_typed_rows()).
+   */
   size_t read_rows(size_t row_start, 
                    size_t row_end, 
                    sframe_rows& out_obj);
 
+  /**
+   * Reads a collection of rows of an integer or float column directly into
+   * the packed representation of \ref typed_column, decoding each block
+   * once into a packed array without going through flexible_type.
+   * The blocks of a string column stored with a column dictionary (see
+   * \ref column_dictionary) are read as codes into the dictionary, without
+   * materializing the strings.
+   * Returns false if the rows cannot be read this way (for instance if they
+   * span segments with different dictionaries), in which case nothing is
+   * read.
+   */
+  bool read_typed_rows(size_t row_start, 
+                       size_t row_end, 
+                       typed_column& out_obj);
+
   /**
    * Reads a collection of rows, storing the result in out_obj.
    * This function is independent of the open_segment/read_segment/close_segment
@@ -188,8 +224,15 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
   /// NUmber of rows of this array
   size_t m_num_rows;
   std::vector<block_address> m_block_list;
+  /// The dictionary of the segment of each block. Parallel to m_block_list.
+  std::vector<std::shared_ptr<const column_dictionary> > m_block_dictionaries;
   std::vector<size_t> m_start_row;
   std::vector<column_address> m_segment_list;
+  /**
+   * INTEGER, FLOAT or STRING if the blocks may be decoded into a 
+   * typed_column
+   */
+  flex_type_enum m_packed_type = flex_type_enum::UNDEFINED;
 
   /**
    * this describes one cache block.
@@ -208,6 +251,8 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
    *    we evict the entry.)
    *  - If buffer_start_row does not match the first requested row, it is
    *    a random access and we use copies.
+   *  - Blocks read with read_typed_rows() are held decoded as a typed_column
+   *    instead, from which both sequential and random accesses copy. 
    *
    * The random eviction process works as such:
    *  - m_used_cache_entries is a bitfield which lists the buffers in use
@@ -223,9 +268,12 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     cache_entry(cache_entry&& other) {
       buffer_start_row = std::move(other.buffer_start_row);
       is_encoded = std::move(other.is_encoded);
+      is_typed = std::move(other.is_typed);
+      has_data = std::move(other.has_data);
       buffer = std::move(other.buffer);
       encoded_buffer = std::move(other.encoded_buffer);
       encoded_buffer_reader = std::move(other.encoded_buffer_reader);
+      typed_buffer = std::move(other.typed_buffer);
     }
 
     cache_entry& operator=(const cache_entry& other) = default;
@@ -233,21 +281,29 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     cache_entry& operator=(cache_entry&& other) {
       buffer_start_row = std::move(other.buffer_start_row);
       is_encoded = std::move(other.is_encoded);
+      is_typed = std::move(other.is_typed);
+      has_data = std::move(other.has_data);
       buffer = std::move(other.buffer);
       encoded_buffer = std::move(other.encoded_buffer);
       encoded_buffer_reader = std::move(other.encoded_buffer_reader);
+      typed_buffer = std::move(other.typed_buffer);
+      return *this;
     }
     graphlab::simple_spinlock lock;
     /// First accessible row in buffer. Either encoded or decoded.
     size_t buffer_start_row = 0;
     // whether this cache entry is held encoded or decoded
     bool is_encoded = false;
+    // whether this cache entry is held as a typed column
+    bool is_typed = false;
     bool has_data = false;
     // if it is held decoded
     std::shared_ptr<std::vector<T> > buffer;
     // if it is held encoded 
     v2_block_impl::encoded_block encoded_buffer;
     v2_block_impl::encoded_block_range encoded_buffer_reader;
+    // if it is held as a typed column
+    typed_column typed_buffer;
   };
 
   mutex m_lock;
@@ -288,6 +344,8 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
       m_cache[block_number].buffer.reset();
       m_cache[block_number].encoded_buffer.release();
       m_cache[block_number].encoded_buffer_reader.release();
+      m_cache[block_number].typed_buffer = typed_column();
+      m_cache[block_number].is_typed = false;
       m_cache[block_number].has_data = false;
       m_used_cache_entries.clear_bit(block_number);
       m_cache_size.dec();
@@ -319,6 +377,67 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
 
   void fetch_cache_from_file(size_t block_number, cache_entry& ret);
 
+  /**
+   * Reads a block from file into a cache entry held as a typed column.
+   * Returns false if the block cannot be decoded into a typed column. If
+   * the block had to be read to find out, the cache entry then holds it
+   * encoded, as by fetch_cache_from_file().
+   */
+  bool fetch_typed_cache_from_file(size_t block_number, cache_entry& ret);
+
+  /**
+   * Holds the bytes of a block read from file encoded in a cache entry.
+   */
+  void hold_encoded_block(size_t block_number, 
+                          const block_info& info, 
+                          const char* data, size_t length,
+                          std::shared_ptr<const void> owner,
+                          cache_entry& ret) {
+    if (ret.buffer) {
+      m_buffer_pool.release_buffer(std::move(ret.buffer));
+      ret.buffer.reset();
+    }
+    ret.buffer_start_row = m_start_row[block_number];
+    ret.encoded_buffer.init(info, data, length, owner, 
+                            m_block_dictionaries[block_number]);
+    ret.encoded_buffer_reader = ret.encoded_buffer.get_range();
+    ret.typed_buffer = typed_column();
+    ret.is_typed = false;
+    ret.is_encoded = true;
+    ret.has_data = true;
+    add_to_cache(block_number);
+  }
+
+  /**
+   * Marks a block as cached, evicting random blocks if there are too many.
+   */
+  void add_to_cache(size_t block_number) {
+    if (m_used_cache_entries.get(block_number) == false) m_cache_size.inc();
+    m_used_cache_entries.set_bit(block_number);
+    // evict something random
+    // we will only loop at most this number of times
+    int num_to_evict = (int)(m_cache_size.value) - 
+        SFRAME_MAX_BLOCKS_IN_CACHE;
+    while(num_to_evict > 0 && 
+          m_cache_size.value > SFRAME_MAX_BLOCKS_IN_CACHE) {
+      try_evict_something_from_cache();
+      --num_to_evict;
+    }
+  }
+
+  /**
+   * Starts reading the sframe_config::SFRAME_PREFETCH_NUM_BLOCKS blocks
+   * following block_number which are not cached yet in the background,
+   * on the assumption that reads are mostly sequential.
+   */
+  void prefetch_blocks_after(size_t block_number) {
+    size_t end = std::min(block_number + 1 + sframe_config::SFRAME_PREFETCH_NUM_BLOCKS,
+                          m_block_list.size());
+    for (size_t i = block_number + 1; i < end; ++i) {
+      if (!m_used_cache_entries.get(i)) m_manager.prefetch_block(m_block_list[i]);
+    }
+  }
+
   size_t block_offset_containing_row(size_t row) {
     auto pos = std::lower_bound(m_start_row.begin(), m_start_row.end(), row);
     size_t blocknum = std::distance(m_start_row.begin(), pos);
@@ -349,32 +468,68 @@ fetch_cache_from_file(size_t block_number, cache_entry& ret) {
 //   std::cerr << "Fetching from file: " << block_number << std::endl;
   // don't use the buffer. hold as encoded always when reading from a 
   // flexible_type file
-  if (ret.buffer) {
-    m_buffer_pool.release_buffer(std::move(ret.buffer));
-    ret.buffer.reset();
+  block_address block_addr = m_block_list[block_number];
+  v2_block_impl::block_info* info; 
+  // uncompressed blocks of mapped files are decoded in place
+  size_t length = 0;
+  std::shared_ptr<const void> owner;
+  const char* data = m_manager.read_block_view(block_addr, length, owner, &info);
+  if (data == nullptr) {
+    log_and_throw("Unexpected block read failure. Bad file?");
   }
+  prefetch_blocks_after(block_number);
+  hold_encoded_block(block_number, *info, data, length, owner, ret);
+}
+
+template <>
+inline bool
+sarray_format_reader_v2<flexible_type>::
+fetch_typed_cache_from_file(size_t block_number, cache_entry& ret) {
+  const auto& dictionary = m_block_dictionaries[block_number];
+  bool is_string = m_packed_type == flex_type_enum::STRING;
+  // only the strings encoded with a column dictionary are read as codes
+  if (is_string && dictionary == nullptr) return false;
   block_address block_addr = m_block_list[block_number];
   v2_block_impl::block_info* info; 
-  auto buffer = m_manager.read_block(block_addr, &info);
-  if (buffer == nullptr) {
+  size_t length = 0;
+  std::shared_ptr<const void> owner;
+  const char* data = m_manager.read_block_view(block_addr, length, owner, &info);
+  if (data == nullptr) {
     log_and_throw("Unexpected block read failure. Bad file?");
   }
+  prefetch_blocks_after(block_number);
+  typed_column column;
+  bool success = is_string ? 
+      v2_block_impl::typed_decode_string_codes(*info, data, length, 
+                                               dictionary, column) :
+      v2_block_impl::typed_decode_numeric(*info, data, length, 
+                                          m_packed_type, column);
+  if (!success) {
+    // keep the block for the flexible_type read which follows
+    hold_encoded_block(block_number, *info, data, length, owner, ret);
+    return false;
+  }
+  // drop the other representations of the block
+  if (ret.buffer) {
+    m_buffer_pool.release_buffer(std::move(ret.buffer));
+    ret.buffer.reset();
+  }
+  ret.encoded_buffer.release();
+  ret.encoded_buffer_reader.release();
   ret.buffer_start_row = m_start_row[block_number];
-  ret.encoded_buffer.init(*info, buffer);
-  ret.encoded_buffer_reader = ret.encoded_buffer.get_range();
-  ret.is_encoded = true;
+  ret.typed_buffer = std::move(column);
+  ret.is_typed = true;
+  ret.is_encoded = false;
   ret.has_data = true;
-  if (m_used_cache_entries.get(block_number) == false) m_cache_size.inc();
-  m_used_cache_entries.set_bit(block_number);
-  // evict something random
-  // we will only loop at most this number of times
-  int num_to_evict = (int)(m_cache_size.value) - 
-      SFRAME_MAX_BLOCKS_IN_CACHE;
-  while(num_to_evict > 0 && 
-        m_cache_size.value > SFRAME_MAX_BLOCKS_IN_CACHE) {
-    try_evict_something_from_cache();
-    --num_to_evict;
-  }
+  add_to_cache(block_number);
+  return true;
+}
+
+template <typename T>
+inline bool
+sarray_format_reader_v2<T>::
+fetch_typed_cache_from_file(size_t block_number, cache_entry& ret) {
+  return false;
 }
 
 template <typename T>
@@ -387,20 +542,11 @@ fetch_cache_from_file(size_t block_number, cache_entry& ret) {
   if (!m_manager.read_block(block_addr, *ret.buffer, NULL)) {
     log_and_throw("Unexpected block read failure. Bad file?");
   }
+  prefetch_blocks_after(block_number);
   ret.buffer_start_row = m_start_row[block_number];
   ret.is_encoded = false;
   ret.has_data = true;
-  if (m_used_cache_entries.get(block_number) == false) m_cache_size.inc();
-  m_used_cache_entries.set_bit(block_number);
-  // evict something random
-  // we will only loop at most this number of times
-  int num_to_evict = (int)(m_cache_size.value) - 
-      SFRAME_MAX_BLOCKS_IN_CACHE;
-  while(num_to_evict > 0 && 
-        m_cache_size.value > SFRAME_MAX_BLOCKS_IN_CACHE) {
-    try_evict_something_from_cache();
-    --num_to_evict;
-  }
+  add_to_cache(block_number);
 }
 
 
@@ -409,11 +555,11 @@ inline void sarray_format_reader_v2<flexible_type>::
 ensure_cache_decoded(cache_entry& cache, size_t block_number) {
   if (cache.is_encoded) {
     cache.buffer = m_buffer_pool.get_new_buffer();
-    auto data = cache.encoded_buffer.get_block_data();
     v2_block_impl::typed_decode(cache.encoded_buffer.get_block_info(),
-                                data->data(),
-                                data->size(),
-                                *cache.buffer);
+                                cache.encoded_buffer.get_block_data(),
+                                cache.encoded_buffer.get_block_data_length(),
+                                *cache.buffer,
+                                cache.encoded_buffer.get_dictionary());
     // clear the encoded buffer information
     cache.encoded_buffer.release();
     cache.encoded_buffer_reader.release();
@@ -447,7 +593,7 @@ fetch_rows_from_cache(size_t fetch_start,
     size_t last_row_to_fetch_in_this_block = std::min(fetch_end, m_start_row[i+1]);
     auto& cache = m_cache[i];
     std::unique_lock<graphlab::simple_spinlock> cache_lock_guard(cache.lock);
-    if (!cache.has_data) {
+    if (!cache.has_data || cache.is_typed) {
       fetch_cache_from_file(i, cache);
     } 
     if (cache.buffer_start_row < first_row_to_fetch_in_this_block && cache.is_encoded) {
@@ -538,11 +684,117 @@ fetch_rows_from_cache(size_t fetch_start,
   }
 }
 
+template <>
+inline bool sarray_format_reader_v2<flexible_type>::
+read_typed_rows(size_t row_start, 
+                size_t row_end, 
+                typed_column& out_obj) {
+  if (m_packed_type == flex_type_enum::UNDEFINED) return false;
+  if (row_end > m_num_rows) row_end = m_num_rows;
+  if (row_start >= row_end) return false;
+  size_t num_rows = row_end - row_start;
+  size_t start_offset = block_offset_containing_row(row_start);
+  size_t end_offset = block_offset_containing_row(row_end - 1) + 1;
+  bool is_integer = m_packed_type == flex_type_enum::INTEGER;
+  bool is_string = m_packed_type == flex_type_enum::STRING;
+  std::vector<flex_int> ints;
+  std::vector<flex_float> floats;
+  std::vector<uint32_t> codes;
+  // the dictionary of the codes read so far
+  std::shared_ptr<const column_dictionary> dictionary;
+  if (is_integer) ints.resize(num_rows);
+  else if (is_string) codes.resize(num_rows);
+  else floats.resize(num_rows);
+  // empty until the first undefined value is found
+  std::vector<uint64_t> validity;
+  size_t output_idx = 0;
+  for (size_t i = start_offset; i < end_offset; ++i) {
+    size_t first_row_to_fetch_in_this_block = std::max(row_start, m_start_row[i]);
+    size_t last_row_to_fetch_in_this_block = std::min(row_end, m_start_row[i+1]);
+    auto& cache = m_cache[i];
+    std::unique_lock<graphlab::simple_spinlock> cache_lock_guard(cache.lock);
+    if (!cache.has_data || !cache.is_typed) {
+      if (!fetch_typed_cache_from_file(i, cache)) return false;
+    } 
+    bool exhausted = last_row_to_fetch_in_this_block == m_start_row[i + 1];
+    const typed_column& block = cache.typed_buffer;
+    if (start_offset + 1 == end_offset && 
+        first_row_to_fetch_in_this_block == m_start_row[i] && exhausted) {
+      // the whole block is read. No copy is needed
+      out_obj = block;
+      release_cache(i);
+      return true;
+    }
+    size_t input_offset = first_row_to_fetch_in_this_block - m_start_row[i];
+    size_t num_elem = last_row_to_fetch_in_this_block - first_row_to_fetch_in_this_block;
+    if (is_integer) {
+      std::copy(block.int_data() + input_offset, 
+                block.int_data() + input_offset + num_elem,
+                ints.begin() + output_idx);
+    } else if (is_string) {
+      // codes of different segments may not be codes into the same 
+      // dictionary
+      if (dictionary && dictionary != block.dictionary()) return false;
+      dictionary = block.dictionary();
+      std::copy(block.code_data() + input_offset, 
+                block.code_data() + input_offset + num_elem,
+                codes.begin() + output_idx);
+    } else {
+      std::copy(block.float_data() + input_offset, 
+                block.float_data() + input_offset + num_elem,
+                floats.begin() + output_idx);
+    }
+    if (!block.all_defined() && validity.empty()) {
+      // all values read so far are defined
+      validity = typed_column::make_validity(num_rows);
+      for (size_t j = 0;j < output_idx; ++j) {
+        typed_column::set_defined(validity, j);
+      }
+    }
+    if (!validity.empty()) {
+      for (size_t j = 0;j < num_elem; ++j) {
+        if (block.is_defined(input_offset + j)) {
+          typed_column::set_defined(validity, output_idx + j);
+        }
+      }
+    }
+    output_idx += num_elem;
+    // we have exhausted this cache
+    if (exhausted) release_cache(i);
+  }
+  if (is_integer) {
+    out_obj = typed_column(std::move(ints), std::move(validity));
+  } else if (is_string) {
+    out_obj = typed_column(std::move(codes), dictionary, std::move(validity));
+  } else {
+    out_obj = typed_column(std::move(floats), std::move(validity));
+  }
+
+  if(cppipc::must_cancel()) {
+    throw(std::string("Cancelled by user."));
+  }
+  return true;
+}
+
+template <typename T>
+inline bool sarray_format_reader_v2<T>::
+read_typed_rows(size_t row_start, 
+                size_t row_end, 
+                typed_column& out_obj) {
+  return false;
+}
+
 template <>
 inline size_t sarray_format_reader_v2<flexible_type>::
 read_rows(size_t row_start, 
           size_t row_end, 
           sframe_rows& out_obj) {
+  typed_column column;
+  if (read_typed_rows(row_start, row_end, column)) {
+    out_obj.clear();
+    out_obj.add_typed_column(column);
+    return column.size();
+  }
   return sarray_format_reader<flexible_type>::read_rows(row_start, row_end, out_obj);
 }
 
@@ -256,6 +256,9 @@ group_index_file_information read_array_group_index_file(std::string group_index
       if (child.count("metadata")) {
         info.metadata = ini::read_dictionary_section<std::string>(child, "metadata");
       }
+      if (child.count("statistics")) {
+        info.statistics = ini::read_dictionary_section<std::string>(child, "statistics");
+      }
       if (info.segment_sizes.size() != info.nsegments) {
         log_and_throw(std::string("Malformed index_file_information. nsegments mismatch"));
       }
@@ -345,6 +348,9 @@ void write_array_group_index_file(std::string group_index_file,
     JSONNode column(JSON_NODE);
     column.push_back(JSONNode("content_type", info.columns[i].content_type));
     column.push_back(json::to_json_node("metadata", info.columns[i].metadata));
+    if (!info.columns[i].statistics.empty()) {
+      column.push_back(json::to_json_node("statistics", info.columns[i].statistics));
+    }
     ASSERT_EQ(info.columns[i].segment_sizes.size(), info.nsegments);
 
 #ifdef LEGACY_INDEX_FORMAT
@@ -46,6 +46,12 @@ struct index_file_information {
   std::vector<std::string> segment_files;
   /// Any additional metadata stored with the array
   std::map<std::string, std::string> metadata;
+  /**
+   * The summary statistics of the column (see column_statistics.hpp).
+   * Only stored in version 2 index files; empty if unknown. Not part of
+   * the serialized (save/load) representation.
+   */
+  std::map<std::string, std::string> statistics;
 
   void save(oarchive& oarc) const;
   void load(iarchive& iarc);
@@ -470,6 +470,18 @@ class sarray_reader: public siterable<sarray_iterator<T> > {
                    size_t row_end, 
                    sframe_rows& out_obj);
 
+  /**
+   * Reads a collection of rows of an integer or float column into a 
+   * \ref typed_column, without going through flexible_type.
+   * Returns false if the column cannot be read this way.
+   *
+   * This function should only be used for sarray<flexible_type> and
+   * will fail fatally otherwise.
+   */
+  bool read_typed_rows(size_t row_start, 
+                       size_t row_end, 
+                       typed_column& out_obj);
+
 
   /**
    * Resets all the file handles. All existing iterators are invalidated.
@@ -609,6 +621,23 @@ inline size_t sarray_reader<flexible_type>::read_rows(size_t row_start,
   return reader->read_rows(row_start, row_end, out_obj);
 }
 
+template <typename T>
+inline bool sarray_reader<T>::read_typed_rows(size_t row_start, 
+                                              size_t row_end, 
+                                              typed_column& out_obj) {
+  ASSERT_MSG(false, "read_typed_rows() not implemented for "
+                    "non-flexible_type templatizations of sarray");
+  return false;
+}
+
+template <>
+inline bool sarray_reader<flexible_type>::read_typed_rows(size_t row_start, 
+                                                          size_t row_end, 
+                                                          typed_column& out_obj) {
+  DASSERT_NE(reader, NULL);
+  return reader->read_typed_rows(row_start, row_end, out_obj);
+}
+
 
 } // namespace graphlab
 
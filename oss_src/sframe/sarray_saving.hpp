@@ -56,6 +56,8 @@ void sarray_save_blockwise(const sarray<T>& cur_column,
 
 
     writer.get_index_info().columns[0].metadata = col.column_index.metadata;
+    // the blocks are copied as is, so the column statistics still hold
+    writer.get_index_info().columns[0].statistics = col.column_index.statistics;
 
     while(!col.eof) {
       // read a block
@@ -65,10 +67,28 @@ void sarray_save_blockwise(const sarray<T>& cur_column,
                             {std::get<0>(col.segment_address),
                               std::get<1>(col.segment_address),
                               col.current_block_number};
-      auto data = block_manager.read_block(block_address , &infoptr);
-      info = *infoptr;
-      // write to segment 0. We have only 1 segment 
-      writer.write_block(0, col.column_number, data->data(), info);
+      if (block_manager.get_column_dictionary(col.segment_address)) {
+        // the strings of the block may be codes into the dictionary of
+        // the segment. Encode them again with the dictionary of the output.
+        std::vector<flexible_type> values;
+        if (!block_manager.read_typed_block(block_address, values)) {
+          log_and_throw("Unexpected block read failure. Bad file?");
+        }
+        writer.write_typed_block(0, col.column_number, values, 
+                                 v2_block_impl::block_info());
+      } else {
+        auto data = block_manager.read_block(block_address , &infoptr);
+        info = *infoptr;
+        // carry over the block statistics if there are any
+        const v2_block_impl::block_statistics* statsptr = 
+            block_manager.get_block_statistics(block_address);
+        // write to segment 0. We have only 1 segment 
+        if (statsptr) {
+          writer.write_block(0, col.column_number, data->data(), info, *statsptr);
+        } else {
+          writer.write_block(0, col.column_number, data->data(), info);
+        }
+      }
       // increment the block number
       advance_column_blocks_to_next_block(block_manager, col);
       // if there are still blocks. push it back 
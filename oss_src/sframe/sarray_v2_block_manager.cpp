@@ -8,18 +8,36 @@
 extern "C" {
 #include <lz4/lz4.h>
 }
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include <algorithm>
 #include <parallel/mutex.hpp>
 #include <boost/algorithm/string.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
 #include <sframe/sarray_index_file.hpp>
 #include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_config.hpp>
 #include <sframe/unfair_lock.hpp>
+#include <fileio/fs_utils.hpp>
 
 namespace graphlab {
 namespace v2_block_impl {
 
 static constexpr size_t NUM_IO_LOCKS = 16;
+
+/// The blocks and bytes read by the current thread (see thread_num_blocks_read())
+static __thread size_t thread_blocks_read = 0;
+static __thread size_t thread_bytes_read = 0;
+static __thread size_t thread_blocks_copied = 0;
+
+/// Whether the block lies within a segment file of the given size
+static bool block_in_file(size_t file_size, const block_info& info) {
+  return info.offset <= file_size && info.length <= file_size - info.offset;
+}
+
 static unfair_lock* get_io_locks() { 
   static unfair_lock iolocks[NUM_IO_LOCKS];
   return iolocks;
@@ -95,6 +113,7 @@ void block_manager::close_column(column_address addr) {
   } 
   if (segment_destroyed) {
     m_segments.erase(segment_id); 
+    discard_prefetched_blocks(segment_id);
   }
 }
 
@@ -116,6 +135,24 @@ const block_info& block_manager::get_block_info(block_address addr) {
   return seg->blocks[column_id][block_id];
 }
 
+const block_statistics* block_manager::get_block_statistics(block_address addr) {
+  size_t segment_id, column_id, block_id;
+  std::tie(segment_id, column_id, block_id) = addr;
+  // get the segment 
+  std::shared_ptr<segment> seg = get_segment(segment_id);
+  if (seg->statistics.empty()) return nullptr;
+  return &(seg->statistics[column_id][block_id]);
+}
+
+std::shared_ptr<const column_dictionary> 
+block_manager::get_column_dictionary(column_address addr) {
+  size_t segment_id, column_id;
+  std::tie(segment_id, column_id) = addr;
+  std::shared_ptr<segment> seg = get_segment(segment_id);
+  if (seg->dictionaries.empty()) return nullptr;
+  return seg->dictionaries[column_id];
+}
+
 std::shared_ptr<std::vector<char> > 
 block_manager::read_block(block_address addr, block_info** ret_info) {
 
@@ -123,62 +160,112 @@ block_manager::read_block(block_address addr, block_info** ret_info) {
   std::tie(segment_id, column_id, block_id) = addr;
   // get the segment 
   std::shared_ptr<segment> seg = get_segment(segment_id);
-  // get the block info
-  block_info& info = seg->blocks[column_id][block_id];
-
-  if(ret_info) (*ret_info) = &info;
-
-  // get the return buffer
-  // resize ret to the block length on disk
-  std::shared_ptr<std::vector<char> > ret = m_buffer_pool.get_new_buffer();
-  ret->resize(info.length);
+  if(ret_info) (*ret_info) = &(seg->blocks[column_id][block_id]);
+
+  ++thread_blocks_read;
+  ++thread_blocks_copied;
+  thread_bytes_read += seg->blocks[column_id][block_id].block_size;
+  std::shared_ptr<std::vector<char> > ret = take_prefetched_block(addr);
+  if (ret) return ret;
+  return read_segment_block(seg, column_id, block_id);
+}
 
-  // acquire lock on get the file handle and perform the read
-  std::unique_lock<graphlab::mutex> guard(seg->lock);
-  std::shared_ptr<general_ifstream> fin = get_segment_file_handle(seg);
-  fin->seekg(info.offset, std::ios_base::beg);
-  size_t iolockid = seg->io_parallelism_id;
-  bool use_io_lock = SFRAME_IO_READ_LOCK > 0 && 
-      (seg->file_size > SFRAME_IO_LOCK_FILE_SIZE_THRESHOLD);
-  if (use_io_lock && iolockid != (size_t)(-1)) get_io_locks()[iolockid].lock();
-  fin->read(ret->data(), info.length);
-  if (use_io_lock && iolockid != (size_t)(-1)) get_io_locks()[iolockid].unlock();
-  if (fin->fail()) {
-    m_buffer_pool.release_buffer(std::move(ret));
-    ret.reset();
-    return ret;
-  }
-  guard.unlock();
+size_t block_manager::thread_num_blocks_read() {
+  return thread_blocks_read;
+}
 
+size_t block_manager::thread_num_bytes_read() {
+  return thread_bytes_read;
+}
 
-  if (info.flags & LZ4_COMPRESSION) {
-    /*
-     * Decompress into another buffer.
-     */
-    std::shared_ptr<std::vector<char> > decompression_buffer = 
-        m_buffer_pool.get_new_buffer();
-    decompression_buffer->resize(info.block_size);
-    LZ4_decompress_safe(ret->data(),                   // src
-                        decompression_buffer->data(),  // target
-                        info.length,                   // src length
-                        info.block_size);              // target length
-    std::swap(ret, decompression_buffer);
-    m_buffer_pool.release_buffer(std::move(decompression_buffer));
-  } 
-  return ret;
+size_t block_manager::thread_num_blocks_copied() {
+  return thread_blocks_copied;
 }
 
+const char* block_manager::read_block_view(block_address addr,
+                                           size_t& length,
+                                           std::shared_ptr<const void>& owner,
+                                           block_info** ret_info) {
+  std::shared_ptr<segment> seg;
+  block_info* info = NULL;
+  const char* mapped = read_mapped_block(addr, seg, &info);
+  if (ret_info) (*ret_info) = info;
+  if (mapped) {
+    length = info->length;
+    owner = seg;
+    return mapped;
+  }
+  std::shared_ptr<std::vector<char> > buffer = read_block(addr, ret_info);
+  if (!buffer) return NULL;
+  length = buffer->size();
+  owner = buffer;
+  return buffer->data();
+}
 
+void block_manager::prefetch_block(block_address addr) {
+  size_t segment_id, column_id, block_id;
+  std::tie(segment_id, column_id, block_id) = addr;
+  std::shared_ptr<segment> seg = get_segment(segment_id);
+  // the mapped file is read ahead by the kernel
+  if (seg->mapped_data) return;
+  size_t num_bytes = seg->blocks[column_id][block_id].block_size;
+  std::shared_ptr<prefetched_block> block;
+  {
+    std::lock_guard<graphlab::mutex> guard(m_prefetch_lock);
+    if (m_prefetched_blocks.count(addr)) return;
+    if (!make_room_for_prefetch(num_bytes)) return;
+    block = std::make_shared<prefetched_block>();
+    block->num_bytes = num_bytes;
+    block->order_position = m_prefetch_order.insert(m_prefetch_order.end(), addr);
+    m_prefetched_blocks[addr] = block;
+    m_prefetched_bytes += num_bytes;
+    if (!m_prefetch_pool) {
+      m_prefetch_pool.reset(
+          new thread_pool(sframe_config::SFRAME_PREFETCH_NUM_THREADS));
+    }
+  }
+  m_prefetch_pool->launch([=]() mutable {
+    std::shared_ptr<std::vector<char> > buffer;
+    try {
+      buffer = read_segment_block(seg, column_id, block_id);
+    } catch (...) {
+      // leave it to the synchronous read to report the failure
+    }
+    std::lock_guard<graphlab::mutex> guard(m_prefetch_lock);
+    auto iter = m_prefetched_blocks.find(addr);
+    if (iter == m_prefetched_blocks.end() || iter->second != block) {
+      // the segment was closed in the meantime
+      if (buffer) m_buffer_pool.release_buffer(std::move(buffer));
+    } else {
+      block->buffer = buffer;
+    }
+    // wake up the readers waiting for it in any case
+    block->ready = true;
+    m_prefetch_cond.broadcast();
+  });
+}
 
 bool block_manager::read_typed_block(block_address addr, 
                                      std::vector<flexible_type>& ret,
                                      block_info** ret_info) {
   block_info* info;
+  // uncompressed blocks in a mapped file are decoded in place
+  std::shared_ptr<segment> seg;
+  const char* mapped = read_mapped_block(addr, seg, &info);
+  // read_mapped_block always sets seg
+  size_t column_id = std::get<1>(addr);
+  const column_dictionary* dictionary = 
+      seg->dictionaries.empty() ? NULL : seg->dictionaries[column_id].get();
+  if (mapped) {
+    if (ret_info) (*ret_info) = info;
+    return typed_decode(*info, mapped, info->length, ret, dictionary);
+  }
   std::shared_ptr<std::vector<char> > read_buffer = read_block(addr, &info);
   if (ret_info) (*ret_info) = info;
   if (!read_buffer) return false;
   // check that the block flags match
-  bool success = typed_decode(*info, read_buffer->data(), read_buffer->size(), ret);
+  bool success = typed_decode(*info, read_buffer->data(), read_buffer->size(), 
+                              ret, dictionary);
   m_buffer_pool.release_buffer(std::move(read_buffer));
   // check its the correct number of elements read
   return success;
@@ -225,6 +312,129 @@ block_manager::get_segment_file_handle(std::shared_ptr<segment>& group) {
   return fin;
 }
 
+std::shared_ptr<std::vector<char> > 
+block_manager::read_segment_block(std::shared_ptr<segment>& seg,
+                                  size_t column_id, size_t block_id) {
+  // get the block info
+  block_info& info = seg->blocks[column_id][block_id];
+
+  // get the return buffer
+  std::shared_ptr<std::vector<char> > ret = m_buffer_pool.get_new_buffer();
+
+  // blocks beyond the end of the mapped file go through the buffered read,
+  // which fails
+  if (seg->mapped_data && block_in_file(seg->file_size, info)) {
+    // copy (or decompress) straight out of the mapped file
+    advise_next_block(*seg, column_id, block_id);
+    const char* src = seg->mapped_data + info.offset;
+    if (info.flags & LZ4_COMPRESSION) {
+      ret->resize(info.block_size);
+      int decompressed = LZ4_decompress_safe(src,                // src
+                                             ret->data(),        // target
+                                             info.length,        // src length
+                                             info.block_size);   // target length
+      if (decompressed < 0 || size_t(decompressed) != info.block_size) {
+        m_buffer_pool.release_buffer(std::move(ret));
+        ret.reset();
+      }
+    } else {
+      ret->assign(src, src + info.length);
+    }
+    return ret;
+  }
+
+  // resize ret to the block length on disk
+  ret->resize(info.length);
+
+  // acquire lock on get the file handle and perform the read
+  std::unique_lock<graphlab::mutex> guard(seg->lock);
+  std::shared_ptr<general_ifstream> fin = get_segment_file_handle(seg);
+  fin->seekg(info.offset, std::ios_base::beg);
+  size_t iolockid = seg->io_parallelism_id;
+  bool use_io_lock = SFRAME_IO_READ_LOCK > 0 && 
+      (seg->file_size > SFRAME_IO_LOCK_FILE_SIZE_THRESHOLD);
+  if (use_io_lock && iolockid != (size_t)(-1)) get_io_locks()[iolockid].lock();
+  fin->read(ret->data(), info.length);
+  if (use_io_lock && iolockid != (size_t)(-1)) get_io_locks()[iolockid].unlock();
+  if (fin->fail()) {
+    m_buffer_pool.release_buffer(std::move(ret));
+    ret.reset();
+    return ret;
+  }
+  guard.unlock();
+
+
+  if (info.flags & LZ4_COMPRESSION) {
+    /*
+     * Decompress into another buffer.
+     */
+    std::shared_ptr<std::vector<char> > decompression_buffer = 
+        m_buffer_pool.get_new_buffer();
+    decompression_buffer->resize(info.block_size);
+    int decompressed = LZ4_decompress_safe(ret->data(),                   // src
+                                           decompression_buffer->data(),  // target
+                                           info.length,                   // src length
+                                           info.block_size);              // target length
+    std::swap(ret, decompression_buffer);
+    m_buffer_pool.release_buffer(std::move(decompression_buffer));
+    if (decompressed < 0 || size_t(decompressed) != info.block_size) {
+      m_buffer_pool.release_buffer(std::move(ret));
+      ret.reset();
+    }
+  } 
+  return ret;
+}
+
+std::shared_ptr<std::vector<char> > 
+block_manager::take_prefetched_block(block_address addr) {
+  std::shared_ptr<std::vector<char> > ret;
+  std::unique_lock<graphlab::mutex> guard(m_prefetch_lock);
+  auto iter = m_prefetched_blocks.find(addr);
+  if (iter == m_prefetched_blocks.end()) return ret;
+  std::shared_ptr<prefetched_block> block = iter->second;
+  m_prefetch_cond.wait(guard, [&]() { return block->ready; });
+  // only the first reader takes the block, and it may have been discarded
+  // while waiting: the other readers read it themselves.
+  iter = m_prefetched_blocks.find(addr);
+  if (iter == m_prefetched_blocks.end() || iter->second != block) return ret;
+  ret = std::move(block->buffer);
+  m_prefetched_bytes -= block->num_bytes;
+  m_prefetch_order.erase(block->order_position);
+  m_prefetched_blocks.erase(iter);
+  return ret;
+}
+
+bool block_manager::make_room_for_prefetch(size_t num_bytes) {
+  while (m_prefetched_bytes + num_bytes > sframe_config::SFRAME_PREFETCH_BUFFER_SIZE) {
+    if (m_prefetch_order.empty()) return false;
+    auto iter = m_prefetched_blocks.find(m_prefetch_order.front());
+    // the oldest block is still being read
+    if (!iter->second->ready) return false;
+    if (iter->second->buffer) {
+      m_buffer_pool.release_buffer(std::move(iter->second->buffer));
+    }
+    m_prefetched_bytes -= iter->second->num_bytes;
+    m_prefetched_blocks.erase(iter);
+    m_prefetch_order.pop_front();
+  }
+  return true;
+}
+
+void block_manager::discard_prefetched_blocks(size_t segment_id) {
+  std::lock_guard<graphlab::mutex> guard(m_prefetch_lock);
+  auto iter = m_prefetched_blocks.lower_bound(block_address{segment_id, 0, 0});
+  while (iter != m_prefetched_blocks.end() && 
+         std::get<0>(iter->first) == segment_id) {
+    // blocks still being read are released by the reading thread
+    if (iter->second->buffer) {
+      m_buffer_pool.release_buffer(std::move(iter->second->buffer));
+    }
+    m_prefetched_bytes -= iter->second->num_bytes;
+    m_prefetch_order.erase(iter->second->order_position);
+    iter = m_prefetched_blocks.erase(iter);
+  }
+}
+
 void block_manager::init_segment(std::shared_ptr<block_manager::segment>& seg) {
   // fast exit
   if (seg->inited) return;
@@ -241,14 +451,111 @@ void block_manager::init_segment(std::shared_ptr<block_manager::segment>& seg) {
   // read 8 bytes
   fin->read(reinterpret_cast<char*>(&footer_size), sizeof(footer_size));
 
-  // deserialize the block information
+  // read the footer
   fin->clear();
   fin->seekg(filesize - footer_size - sizeof(footer_size), std::ios_base::beg);
-  iarchive iarc(*fin);
+  std::vector<char> footer(footer_size);
+  fin->read(footer.data(), footer_size);
+  if (fin->fail()) {
+    log_and_throw_io_failure("Unable to read footer of " + seg->segment_file);
+  }
+
+  // deserialize the block information
+  iarchive iarc(footer.data(), footer.size());
   iarc >> seg->blocks;
 
+  // the block statistics, if present, follow the block information
+  if (iarc.off < footer.size()) {
+    iarc >> seg->statistics;
+    bool statistics_consistent = 
+        seg->statistics.size() == seg->blocks.size();
+    for (size_t i = 0; statistics_consistent && i < seg->blocks.size(); ++i) {
+      statistics_consistent = 
+          seg->statistics[i].size() == seg->blocks[i].size();
+    }
+    if (!statistics_consistent) {
+      logstream(LOG_WARNING) << "Ignoring inconsistent block statistics in " 
+                             << seg->segment_file << std::endl;
+      seg->statistics.clear();
+    }
+  }
+
+  // followed by the column dictionaries, if present
+  if (iarc.off < footer.size()) {
+    uint64_t num_columns = 0;
+    iarc >> num_columns;
+    ASSERT_EQ(num_columns, seg->blocks.size());
+    seg->dictionaries.resize(num_columns);
+    for (size_t i = 0;i < num_columns; ++i) {
+      auto dictionary = std::make_shared<column_dictionary>();
+      dictionary->load(iarc);
+      if (dictionary->size() > 0) seg->dictionaries[i] = dictionary;
+    }
+  }
+
   seg->inited = true;
   seg->file_size = filesize;
+  map_segment_file(*seg);
+}
+
+block_manager::segment::~segment() {
+#ifndef _WIN32
+  if (mapped_data) munmap(const_cast<char*>(mapped_data), file_size);
+#endif
+}
+
+void block_manager::map_segment_file(segment& seg) {
+#ifndef _WIN32
+  if (SFRAME_USE_MMAP == 0 || seg.file_size == 0) return;
+  std::string fname = parse_v2_segment_filename(seg.segment_file).first;
+  // only plain local files. (cache:// files may live in memory)
+  if (fileio::get_protocol(fname) != "") return;
+  int fd = ::open(fname.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  void* data = mmap(NULL, seg.file_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    logstream(LOG_DEBUG) << "Unable to map " << fname 
+                         << ". Falling back to buffered reads" << std::endl;
+    return;
+  }
+  // columns are interleaved in the file: disable the sequential readahead
+  // and rely on advise_next_block() instead.
+  madvise(data, seg.file_size, MADV_RANDOM);
+  seg.mapped_data = reinterpret_cast<const char*>(data);
+#endif
+}
+
+void block_manager::advise_next_block(segment& seg, 
+                                      size_t column_id, 
+                                      size_t block_id) {
+#ifndef _WIN32
+  if (seg.mapped_data == NULL || 
+      block_id + 1 >= seg.blocks[column_id].size()) return;
+  const block_info& next = seg.blocks[column_id][block_id + 1];
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t begin = next.offset - next.offset % page_size;
+  madvise(const_cast<char*>(seg.mapped_data) + begin, 
+          next.offset + next.length - begin, MADV_WILLNEED);
+#endif
+}
+
+const char* block_manager::read_mapped_block(block_address addr,
+                                             std::shared_ptr<segment>& seg,
+                                             block_info** ret_info) {
+  size_t segment_id, column_id, block_id;
+  std::tie(segment_id, column_id, block_id) = addr;
+  seg = get_segment(segment_id);
+  block_info& info = seg->blocks[column_id][block_id];
+  if(ret_info) (*ret_info) = &info;
+  if (seg->mapped_data == NULL || (info.flags & LZ4_COMPRESSION) ||
+      !block_in_file(seg->file_size, info)) {
+    return NULL;
+  }
+  ++thread_blocks_read;
+  thread_bytes_read += info.block_size;
+  advise_next_block(*seg, column_id, block_id);
+  return seg->mapped_data + info.offset;
 }
 
 
@@ -11,8 +11,11 @@
 #include <vector>
 #include <fstream>
 #include <tuple>
+#include <map>
+#include <list>
 #include <parallel/pthread_tools.hpp>
 #include <parallel/atomic.hpp>
+#include <parallel/thread_pool.hpp>
 #include <fileio/general_fstream.hpp>
 #include <sframe/sarray_index_file.hpp>
 #include <flexible_type/flexible_type.hpp>
@@ -54,7 +57,12 @@ namespace v2_block_impl {
  * Each segment file internally then has the following layout
  *  (1) Consecutive Block contents, each block 4K aligned.
  *  (2) A direct serialization of a vector<vector<block_info> > (blocks[column_id][block_id])
- *  (3) 8 bytes containing the file offset. at which (2) begins
+ *      followed by (optionally) a direct serialization of a 
+ *      vector<vector<block_statistics> > (block_statistics[column_id][block_id]),
+ *      and (optionally) the number of columns followed by the 
+ *      \ref column_dictionary of each column.
+ *      Older files do not have the block statistics or the dictionaries.
+ *  (3) 8 bytes containing the length of (2).
  *
  * For instance, if there are 2 segments with 3 columns each of 20 rows, 
  * we may get the following layout: 
@@ -180,6 +188,19 @@ class block_manager {
    */
   const block_info& get_block_info(block_address addr); 
 
+  /**
+   * Returns the summary statistics of a block (see \ref block_statistics).
+   * Returns NULL if the segment was written without block statistics.
+   */
+  const block_statistics* get_block_statistics(block_address addr);
+
+  /**
+   * Returns the dictionary of the strings of a column in a segment (see
+   * \ref column_dictionary), which the string blocks of the column may be
+   * encoded with. Returns NULL if the column has no dictionary.
+   */
+  std::shared_ptr<const column_dictionary> get_column_dictionary(column_address addr);
+
   /** 
    * Reads a block as bytes a block address ((array_group ID, segment ID, block
    * ID) tuple),  
@@ -195,6 +216,61 @@ class block_manager {
   std::shared_ptr<std::vector<char> >
     read_block(block_address addr, block_info** ret_info = NULL);
 
+  /**
+   * Reads a block as bytes without copying it if possible. Returns a
+   * pointer to the bytes of the block, and stores their length in length.
+   * The bytes remain valid for as long as owner is held.
+   *
+   * Uncompressed blocks of memory mapped segment files are returned in
+   * place, owner then keeping the mapping alive. The other blocks (compressed
+   * blocks, or segment files which are not on local storage) are read into
+   * a buffer, as by read_block(), which owner holds.
+   *
+   *  If info is not NULL, A pointer to the block information will be stored 
+   *  info *info (see read_block()).
+   *
+   *  Returns NULL on failure.
+   *
+   *  Safe for concurrent operation.
+   */
+  const char* read_block_view(block_address addr,
+                              size_t& length,
+                              std::shared_ptr<const void>& owner,
+                              block_info** ret_info = NULL);
+
+
+  /**
+   * Starts reading a block in the background, so that a following 
+   * read_block() of the same block does not wait on IO. Does nothing if
+   * the segment is memory mapped or the block is already prefetched. 
+   * The prefetched blocks which have not been read yet are kept within 
+   * sframe_config::SFRAME_PREFETCH_BUFFER_SIZE bytes, evicting the oldest
+   * ones first.
+   *
+   * Safe for concurrent operation.
+   */
+  void prefetch_block(block_address addr);
+
+  /**
+   * The number of blocks read by the calling thread since it started,
+   * through any of the read functions (prefetched blocks count when they
+   * are read, not when they are prefetched). Differences of this counter
+   * attribute the reads to the query operators (see query_profile.hpp).
+   */
+  static size_t thread_num_blocks_read();
+
+  /**
+   * The number of bytes, as stored in the segment files, of the blocks
+   * counted by thread_num_blocks_read().
+   */
+  static size_t thread_num_bytes_read();
+
+  /**
+   * The number of the blocks counted by thread_num_blocks_read() which were
+   * read into a buffer, rather than accessed in place in the memory mapped
+   * segment file.
+   */
+  static size_t thread_num_blocks_copied();
 
   /** 
    * Reads a block given a block address ((array_group ID, segment ID, block
@@ -234,6 +310,15 @@ class block_manager {
   bool read_block(block_address addr, 
                   std::vector<T>& ret, 
                   block_info** ret_info = NULL) {
+    std::shared_ptr<segment> seg;
+    block_info* info = NULL;
+    const char* mapped = read_mapped_block(addr, seg, &info);
+    if (ret_info) (*ret_info) = info;
+    if (mapped) {
+      graphlab::iarchive iarc(mapped, info->length);
+      iarc >> ret;
+      return true;
+    }
     bool success = false;
     auto buffer = read_block(addr, ret_info);
     if (buffer) {
@@ -275,7 +360,28 @@ class block_manager {
      */
     std::vector<std::vector<block_info> > blocks;
 
+    /** for each column in the segment, the statistics of each block.
+     * Empty if the segment file does not contain block statistics.
+     * Otherwise parallel to blocks.
+     */
+    std::vector<std::vector<block_statistics> > statistics;
+
+    /** for each column in the segment, the dictionary of its strings, 
+     * or NULL if the column has none. 
+     * Empty if the segment file does not contain dictionaries.
+     */
+    std::vector<std::shared_ptr<const column_dictionary> > dictionaries;
+
     graphlab::atomic<size_t> reference_count;
+
+    /**
+     * The whole segment file mapped read only into memory, or NULL if the 
+     * file is not on local storage or could not be mapped (see 
+     * SFRAME_USE_MMAP). Unmapped when the segment is destroyed.
+     */
+    const char* mapped_data = NULL;
+
+    ~segment();
   };
   
   /// All the internal segments
@@ -291,6 +397,31 @@ class block_manager {
   /// Pool of buffers used for decompression, returns, etc.
   buffer_pool<std::vector<char> > m_buffer_pool;
 
+  /**
+   * A block read in the background by prefetch_block().
+   * buffer is only valid once ready is set, and may then be empty if the 
+   * read failed. Entries are shared with the reading thread and with the
+   * readers waiting for them, as they may be removed from 
+   * m_prefetched_blocks in the meantime.
+   */
+  struct prefetched_block {
+    bool ready = false;
+    size_t num_bytes = 0;
+    std::shared_ptr<std::vector<char> > buffer;
+    /// position in m_prefetch_order
+    std::list<block_address>::iterator order_position;
+  };
+
+  graphlab::mutex m_prefetch_lock;
+  graphlab::conditional m_prefetch_cond;
+  std::map<block_address, std::shared_ptr<prefetched_block> > m_prefetched_blocks;
+  /// The prefetched blocks in the order they were requested.
+  std::list<block_address> m_prefetch_order;
+  /// The total num_bytes of m_prefetched_blocks
+  size_t m_prefetched_bytes = 0;
+  /// Created on the first prefetch
+  std::unique_ptr<thread_pool> m_prefetch_pool;
+
 /**************************************************************************/
 /*                                                                        */
 /*                           Private Functions                            */
@@ -318,9 +449,58 @@ class block_manager {
   bool read_block_from_stream(general_ifstream& fin, std::vector<char>& ret,
                               block_info& info);
 
+  /**
+   * Reads a block of a segment from the mapped file or from the file
+   * handle, decompressing it if necessary. Returns an empty pointer on 
+   * failure.
+   */
+  std::shared_ptr<std::vector<char> > 
+      read_segment_block(std::shared_ptr<segment>& seg,
+                         size_t column_id, size_t block_id);
+
+  /**
+   * Returns the block if it was prefetched, waiting for the background
+   * read to complete if necessary, and an empty pointer otherwise.
+   */
+  std::shared_ptr<std::vector<char> > take_prefetched_block(block_address addr);
+
+  /**
+   * Evicts the oldest completed prefetched blocks until num_bytes more 
+   * bytes fit in the prefetch budget. Returns false if they do not fit.
+   * m_prefetch_lock must be held.
+   */
+  bool make_room_for_prefetch(size_t num_bytes);
+
+  /// Forgets all the prefetched blocks of a segment which is closed.
+  void discard_prefetched_blocks(size_t segment_id);
+
   std::shared_ptr<segment> get_segment(size_t segmentid);
 
   void init_segment(std::shared_ptr<segment>& seg);
+
+  /**
+   * Maps the segment file into memory if it is on local storage.
+   * Leaves seg.mapped_data NULL on failure.
+   */
+  void map_segment_file(segment& seg);
+
+  /**
+   * Hints the kernel to read ahead the block following block_id in the 
+   * column, if the segment is mapped. Blocks of different columns are 
+   * interleaved in the segment file, so this is done per column rather than
+   * relying on the sequential readahead of the file.
+   */
+  void advise_next_block(segment& seg, size_t column_id, size_t block_id);
+
+  /**
+   * Returns a pointer to the bytes of the block inside the mapped segment
+   * file if the segment is mapped and the block is not compressed. The 
+   * pointer is valid for as long as seg is held. Returns NULL otherwise,
+   * in which case read_block() should be used.
+   */
+  const char* read_mapped_block(block_address addr,
+                                std::shared_ptr<segment>& seg,
+                                block_info** ret_info);
 };
 
 
@@ -0,0 +1,189 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <cmath>
+#include <logger/logger.hpp>
+#include <sframe/sarray_v2_block_statistics.hpp>
+#include <sframe/sarray_v2_block_manager.hpp>
+
+namespace graphlab {
+namespace v2_block_impl {
+
+/**
+ * Returns true if min/max statistics can be maintained for the type.
+ */
+static bool is_range_type(flex_type_enum t) {
+  return (t == flex_type_enum::INTEGER ||
+          t == flex_type_enum::FLOAT ||
+          t == flex_type_enum::STRING ||
+          t == flex_type_enum::DATETIME) && flex_type_has_binary_op(t, t, '<');
+}
+
+/**
+ * Returns the smallest string greater than every string starting with the
+ * first len bytes of s, in s. Returns false if there is none (the prefix
+ * is all 0xFF bytes).
+ */
+static bool truncated_upper_bound(std::string& s, size_t len) {
+  s.resize(len);
+  while (!s.empty()) {
+    unsigned char last = s.back();
+    if (last != 0xFF) {
+      s.back() = char(last + 1);
+      return true;
+    }
+    s.pop_back();
+  }
+  return false;
+}
+
+block_statistics compute_block_statistics(const std::vector<flexible_type>& data) {
+  block_statistics ret;
+  flex_type_enum range_type = flex_type_enum::UNDEFINED;
+  bool range_valid = true;
+  // the extreme values are tracked by reference, and copied once at the end
+  const flexible_type* min_value = nullptr;
+  const flexible_type* max_value = nullptr;
+  for (const auto& val: data) {
+    flex_type_enum t = val.get_type();
+    if (t == flex_type_enum::UNDEFINED) {
+      ++ret.num_undefined;
+      continue;
+    }
+    if (!range_valid) continue;
+    if (t == flex_type_enum::FLOAT && std::isnan(val.get<flex_float>())) {
+      // NaN is not ordered. We cannot maintain a range.
+      range_valid = false;
+    } else if (range_type == flex_type_enum::UNDEFINED) {
+      if (is_range_type(t)) {
+        range_type = t;
+        min_value = &val;
+        max_value = &val;
+      } else {
+        range_valid = false;
+      }
+    } else if (t != range_type) {
+      range_valid = false;
+    } else if (val < *min_value) {
+      min_value = &val;
+    } else if (*max_value < val) {
+      max_value = &val;
+    }
+  }
+  ret.has_range = range_valid && range_type != flex_type_enum::UNDEFINED;
+  if (!ret.has_range) return ret;
+
+  if (range_type != flex_type_enum::STRING) {
+    ret.min_value = *min_value;
+    ret.max_value = *max_value;
+    return ret;
+  }
+  const flex_string& min_string = min_value->get<flex_string>();
+  const flex_string& max_string = max_value->get<flex_string>();
+  if (min_string.size() <= MAX_STRING_BOUND_LENGTH) {
+    ret.min_value = *min_value;
+  } else {
+    ret.min_value = min_string.substr(0, MAX_STRING_BOUND_LENGTH);
+  }
+  if (max_string.size() <= MAX_STRING_BOUND_LENGTH) {
+    ret.max_value = *max_value;
+  } else {
+    flex_string bound = max_string.substr(0, MAX_STRING_BOUND_LENGTH);
+    if (truncated_upper_bound(bound, MAX_STRING_BOUND_LENGTH)) {
+      ret.max_value = bound;
+    } else {
+      ret.has_range = false;
+      ret.min_value = FLEX_UNDEFINED;
+    }
+  }
+  return ret;
+}
+
+bool block_may_satisfy(const block_statistics& stats,
+                       const std::string& op,
+                       const flexible_type& value) {
+  if (!stats.has_range) return true;
+  if (!flex_type_has_binary_op(stats.min_value.get_type(), value.get_type(), '<')) {
+    return true;
+  }
+  if (value.get_type() == flex_type_enum::FLOAT &&
+      std::isnan(value.get<flex_float>())) {
+    return true;
+  }
+  if (op == "<") {
+    return stats.min_value < value;
+  } else if (op == "<=") {
+    return !(value < stats.min_value);
+  } else if (op == ">") {
+    return value < stats.max_value;
+  } else if (op == ">=") {
+    return !(stats.max_value < value);
+  } else if (op == "==") {
+    // equality comparisons do not skip undefined values.
+    if (stats.num_undefined > 0) return true;
+    return !(value < stats.min_value) && !(stats.max_value < value);
+  }
+  return true;
+}
+
+bool find_candidate_row_ranges(const index_file_information& index,
+                               size_t begin, size_t end,
+                               std::function<bool(const block_statistics&)> may_match,
+                               std::vector<std::pair<size_t, size_t> >& ret) {
+  ret.clear();
+  if (index.version != 2) return false;
+  if (index.segment_files.size() != index.segment_sizes.size()) return false;
+
+  auto& manager = block_manager::get_instance();
+  bool has_statistics = false;
+  size_t segment_row_start = 0;
+  for (size_t i = 0; i < index.segment_files.size(); ++i) {
+    size_t segment_row_end = segment_row_start + index.segment_sizes[i];
+    // skip segments which do not intersect [begin, end)
+    if (segment_row_end <= begin || segment_row_start >= end) {
+      segment_row_start = segment_row_end;
+      continue;
+    }
+    column_address column = manager.open_column(index.segment_files[i]);
+    try {
+      size_t nblocks = manager.num_blocks_in_column(column);
+      size_t block_row_start = segment_row_start;
+      for (size_t b = 0; b < nblocks; ++b) {
+        block_address addr{std::get<0>(column), std::get<1>(column), b};
+        size_t block_row_end = block_row_start + manager.get_block_info(addr).num_elem;
+        if (block_row_end > begin && block_row_start < end) {
+          const block_statistics* stats = manager.get_block_statistics(addr);
+          if (stats) has_statistics = true;
+          if (stats == nullptr || may_match(*stats)) {
+            size_t range_begin = std::max(block_row_start, begin);
+            size_t range_end = std::min(block_row_end, end);
+            if (!ret.empty() && ret.back().second == range_begin) {
+              ret.back().second = range_end;
+            } else {
+              ret.push_back({range_begin, range_end});
+            }
+          }
+        }
+        block_row_start = block_row_end;
+      }
+      manager.close_column(column);
+      if (block_row_start != segment_row_end) {
+        logstream(LOG_WARNING) << "Segment size mismatch in "
+                               << index.segment_files[i] << std::endl;
+        return false;
+      }
+    } catch (...) {
+      manager.close_column(column);
+      throw;
+    }
+    segment_row_start = segment_row_end;
+  }
+  return has_statistics;
+}
+
+} // namespace v2_block_impl
+} // namespace graphlab
@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_SARRAY_V2_BLOCK_STATISTICS_HPP
+#define GRAPHLAB_SFRAME_SARRAY_V2_BLOCK_STATISTICS_HPP
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sarray_index_file.hpp>
+#include <sframe/sarray_v2_block_types.hpp>
+namespace graphlab {
+namespace v2_block_impl {
+
+/**
+ * The maximum length in bytes of the string bounds stored in the block
+ * statistics, so that long text columns do not bloat the segment footers.
+ */
+static constexpr size_t MAX_STRING_BOUND_LENGTH = 64;
+
+/**
+ * Computes the block statistics (see \ref block_statistics) of a block of
+ * values.
+ */
+block_statistics compute_block_statistics(const std::vector<flexible_type>& data);
+
+/**
+ * Returns false only if it can be proven from the block statistics that
+ * no value x in the block satisfies (x op value), where op is one of
+ * "<", ">", "<=", ">=", "==". UNDEFINED values are assumed never to satisfy
+ * "<", ">", "<=", ">=", and are assumed to possibly satisfy "==".
+ *
+ * Returns true otherwise (the block may contain matching values).
+ */
+bool block_may_satisfy(const block_statistics& stats,
+                       const std::string& op,
+                       const flexible_type& value);
+
+/**
+ * Scans the block statistics of a v2 sarray and finds the row ranges within
+ * [begin, end) which may contain rows satisfying a block predicate.
+ *
+ * \param index The index information of the sarray
+ * \param begin The first row to consider
+ * \param end One past the last row to consider
+ * \param may_match Called on the statistics of each block. Returns false
+ *                  if the block provably contains no matching rows.
+ * \param ret The candidate ranges [begin, end) in the row coordinates of the
+ *            sarray. Adjacent ranges are merged, and the ranges are sorted.
+ *
+ * Returns false if the ranges cannot be determined (for instance, the
+ * sarray is not in the v2 format, or was written without block statistics),
+ * in which case ret is undefined.
+ */
+bool find_candidate_row_ranges(const index_file_information& index,
+                               size_t begin, size_t end,
+                               std::function<bool(const block_statistics&)> may_match,
+                               std::vector<std::pair<size_t, size_t> >& ret);
+
+} // namespace v2_block_impl
+} // namespace graphlab
+#endif
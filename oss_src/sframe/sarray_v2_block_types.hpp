@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <tuple>
 #include <serialization/serializable_pod.hpp>
+#include <flexible_type/flexible_type.hpp>
 namespace graphlab {
 namespace v2_block_impl {
 
@@ -29,6 +30,18 @@ enum FLAGS {
 }
 
 
+/**
+ * The first byte of the encoding of a string block (see encode_string()).
+ * Blocks written by older versions only use the first two.
+ */
+namespace STRING_RESERVED_FLAGS {
+enum FLAGS {
+  DIRECT_ENCODING = 0,
+  DICTIONARY_ENCODING = 1,
+  COLUMN_DICTIONARY_ENCODING = 2
+};
+}
+
 namespace VECTOR_RESERVED_FLAGS {
 enum FLAGS {
   NEW_ENCODING = 0
@@ -66,6 +79,38 @@ struct block_info: public graphlab::IS_POD_TYPE {
   uint16_t content_type = 0;
 };
 
+/**
+ * Optional summary statistics about the contents of a typed block.
+ *
+ * These are written into the segment footer after the block_info array and
+ * allow readers to prove that a block cannot contain values in a given
+ * range without decoding the block.
+ *
+ * min_value and max_value are only meaningful if has_range is true, which
+ * is only the case if every value in the block which is not UNDEFINED is
+ * of the same, totally ordered type (integer, float, string or datetime),
+ * and the block contains at least one such value. Float blocks containing
+ * NaN values never have a range.
+ *
+ * The range is a bound, not necessarily attained: string bounds are cut to
+ * at most MAX_STRING_BOUND_LENGTH bytes (min_value is a prefix of the
+ * smallest string, and max_value is greater than the largest string).
+ */
+struct block_statistics {
+  bool has_range = false;
+  flexible_type min_value;
+  flexible_type max_value;
+  /// The number of UNDEFINED values in the block
+  uint64_t num_undefined = 0;
+
+  void save(oarchive& oarc) const {
+    oarc << has_range << min_value << max_value << num_undefined;
+  }
+  void load(iarchive& iarc) {
+    iarc >> has_range >> min_value >> max_value >> num_undefined;
+  }
+};
+
 } // v2_block_impl
 } // graphlab
 
@@ -10,8 +10,11 @@ extern "C" {
 }
 #include <sframe/sarray_v2_block_writer.hpp>
 #include <sframe/sarray_index_file.hpp>
+#include <algorithm>
 #include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_config.hpp>
 #include <sframe/sarray_v2_type_encoding.hpp>
+#include <sframe/sarray_v2_block_statistics.hpp>
 
 namespace graphlab {
 namespace v2_block_impl {
@@ -29,11 +32,17 @@ void block_writer::init(std::string group_index_file,
 
   m_blocks.resize(num_segments);
   for (auto& m_blockseg: m_blocks) m_blockseg.resize(num_columns);
+  m_block_statistics.resize(num_segments);
+  for (auto& m_statseg: m_block_statistics) m_statseg.resize(num_columns);
   m_index_info.group_index_file = group_index_file;
   m_index_info.version = 2;
   m_index_info.nsegments = num_segments;
   m_index_info.segment_files.resize(num_segments);
   m_index_info.columns.resize(num_columns);
+  m_column_statistics.resize(num_segments);
+  for (auto& segment_stats: m_column_statistics) segment_stats.resize(num_columns);
+  m_column_dictionaries.resize(num_columns);
+  m_column_dictionary_locks.resize(num_columns);
 
   // fill in the per column information of m_index_info. 
   for (size_t col = 0;col < m_index_info.columns.size(); ++col) {
@@ -77,6 +86,14 @@ size_t block_writer::write_block(size_t segment_id,
                                  size_t column_id, 
                                  char* data,
                                  block_info block) {
+  return write_block(segment_id, column_id, data, block, block_statistics());
+}
+
+size_t block_writer::write_block(size_t segment_id,
+                                 size_t column_id, 
+                                 char* data,
+                                 block_info block,
+                                 const block_statistics& stats) {
   DASSERT_LT(segment_id, m_index_info.nsegments);
   DASSERT_LT(column_id, m_index_info.columns.size());
   DASSERT_TRUE(m_output_files[segment_id] != NULL);
@@ -115,6 +132,7 @@ size_t block_writer::write_block(size_t segment_id,
   m_output_files[segment_id]->write(buffer_to_write, buffer_to_write_len);
   m_output_files[segment_id]->write(padding_bytes, padding);
   m_blocks[segment_id][column_id].push_back(block);
+  m_block_statistics[segment_id][column_id].push_back(stats);
   m_output_file_locks[segment_id].unlock();
 
   m_buffer_pool.release_buffer(std::move(compression_buffer));
@@ -131,8 +149,21 @@ size_t block_writer::write_typed_block(size_t segment_id,
                                        block_info block) {
   auto serialization_buffer = m_buffer_pool.get_new_buffer();
   oarchive oarc(*serialization_buffer);
-  typed_encode(data, block, oarc);
-  size_t ret = write_block(segment_id, column_id, serialization_buffer->data(), block);
+  // only string blocks use the column dictionary
+  bool has_strings = sframe_config::SFRAME_COLUMN_DICTIONARY_SIZE > 0 &&
+      std::any_of(data.begin(), data.end(), [](const flexible_type& f) {
+                    return f.get_type() == flex_type_enum::STRING;
+                  });
+  if (has_strings) {
+    std::lock_guard<graphlab::mutex> guard(m_column_dictionary_locks[column_id]);
+    typed_encode(data, block, oarc, &m_column_dictionaries[column_id],
+                 sframe_config::SFRAME_COLUMN_DICTIONARY_SIZE);
+  } else {
+    typed_encode(data, block, oarc);
+  }
+  m_column_statistics[segment_id][column_id].add(data);
+  size_t ret = write_block(segment_id, column_id, serialization_buffer->data(), 
+                           block, compute_block_statistics(data));
   m_buffer_pool.release_buffer(std::move(serialization_buffer));
   return ret;
 }
@@ -148,15 +179,36 @@ group_index_file_information& block_writer::get_index_info() {
 }
 
 void block_writer::write_index_file() {
+  for (size_t col = 0;col < m_index_info.columns.size(); ++col) {
+    auto& column_info = m_index_info.columns[col];
+    size_t num_rows = 0;
+    for (size_t segment_size: column_info.segment_sizes) num_rows += segment_size;
+    column_statistics_builder column_stats;
+    for (auto& segment_stats: m_column_statistics) column_stats.combine(segment_stats[col]);
+    if (num_rows > 0 && column_stats.num_rows() == num_rows) {
+      column_info.statistics = column_stats.finalize().to_map();
+    }
+  }
   write_array_group_index_file(m_index_info.group_index_file, 
                                m_index_info);
 }
 
 void block_writer::emit_footer(size_t segment_id) {
   // prepare the footer
-  // write out all the block headers
+  // write out all the block headers, followed by the block statistics, 
+  // and the column dictionaries.
+  // Readers which do not know about the block statistics will only
+  // deserialize the block headers and ignore the rest of the footer.
   oarchive oarc;
   oarc << m_blocks[segment_id];
+  oarc << m_block_statistics[segment_id];
+  // the dictionaries only grow, so they hold the strings of all the blocks 
+  // of the segment.
+  oarc << (uint64_t)m_column_dictionaries.size();
+  for (size_t col = 0;col < m_column_dictionaries.size(); ++col) {
+    std::lock_guard<graphlab::mutex> guard(m_column_dictionary_locks[col]);
+    m_column_dictionaries[col].save(oarc);
+  }
   m_output_files[segment_id]->write(oarc.buf, oarc.off);
   uint64_t footer_size = oarc.off;
 
@@ -18,6 +18,8 @@
 #include <flexible_type/flexible_type.hpp>
 #include <util/buffer_pool.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
+#include <sframe/column_statistics.hpp>
+#include <sframe/column_dictionary.hpp>
 
 namespace graphlab {
 namespace v2_block_impl {
@@ -79,6 +81,19 @@ class block_writer {
                    char* data,
                    block_info block);
 
+  /**
+   * Writes a block of data into a segment, together with the summary
+   * statistics of the block contents. The statistics are stored in the 
+   * segment footer. See \ref block_statistics.
+   *
+   * Returns the actual number of bytes written.
+   */
+  size_t write_block(size_t segment_id,
+                   size_t column_id,
+                   char* data,
+                   block_info block,
+                   const block_statistics& stats);
+
   /**
    * Writes a block of data into a segment.
    *
@@ -87,6 +102,12 @@ class block_writer {
    * \param block_info Metadata about the block. 
    *
    * No fields of block_info are required at the moment.
+   * The block statistics (see \ref block_statistics) are computed from 
+   * the data and stored in the segment footer. The data is also added to
+   * the statistics of the column (see column_statistics.hpp).
+   * The strings of a string block are stored as codes into the dictionary
+   * of the column (see \ref column_dictionary) as long as it holds at most
+   * sframe_config::SFRAME_COLUMN_DICTIONARY_SIZE strings.
    * Returns the actual number of bytes written.
    */
   size_t write_typed_block(size_t segment_id,
@@ -124,7 +145,11 @@ class block_writer {
   group_index_file_information& get_index_info();
 
   /**
-   * Writes the index file
+   * Writes the index file.
+   *
+   * The statistics of a column are stored in the index file if all its
+   * rows were written with write_typed_block(). Otherwise the statistics
+   * already in the index information (see get_index_info()) are kept.
    */
   void write_index_file();
  private:
@@ -149,9 +174,34 @@ class block_writer {
    */
   std::vector<std::vector<std::vector<block_info> > > m_blocks;
 
+  /**
+   * The statistics of each block. Written into the footer after m_blocks.
+   * Parallel to m_blocks: 
+   * block_statistics[segment_id][column_id][block_id]
+   */
+  std::vector<std::vector<std::vector<block_statistics> > > m_block_statistics;
+
+  /**
+   * The statistics of each column in each segment, accumulated by
+   * write_typed_block(), and merged by write_index_file().
+   * column_statistics[segment_id][column_id]
+   */
+  std::vector<std::vector<column_statistics_builder> > m_column_statistics;
+
   /// For each segment, for each column the number of rows written so far
   std::vector<std::vector<size_t> > m_column_row_counter;
 
+  /**
+   * The dictionary of the strings of each column, shared by the blocks of
+   * all the segments, so that a string has the same code throughout the
+   * column. Written into the footer of each segment after the block
+   * statistics.
+   */
+  std::vector<column_dictionary> m_column_dictionaries;
+
+  /// Locks on m_column_dictionaries
+  std::vector<graphlab::mutex> m_column_dictionary_locks;
+
   /// Writes the file footer
   void emit_footer(size_t segment_id);
 };
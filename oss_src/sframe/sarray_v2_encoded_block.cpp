@@ -14,14 +14,18 @@ encoded_block::encoded_block() {
 }
 
 void encoded_block::init(block_info info, std::vector<char>&& data) {
-  m_block = block{info, 
-    std::make_shared<std::vector<char>>(std::move(data))};
-  m_size = info.num_elem;
+  init(info, std::make_shared<std::vector<char>>(std::move(data)));
 }
 
 
 void encoded_block::init(block_info info, std::shared_ptr<std::vector<char> > data) {
-  m_block = block{info, data};
+  init(info, data->data(), data->size(), data);
+}
+
+void encoded_block::init(block_info info, const char* data, size_t length,
+                         std::shared_ptr<const void> owner,
+                         std::shared_ptr<const column_dictionary> dictionary) {
+  m_block = block{info, data, length, owner, dictionary};
   m_size = info.num_elem;
 }
 
@@ -30,8 +34,7 @@ encoded_block_range encoded_block::get_range() {
 }
 
 void encoded_block::release() {
-  m_block.m_data.reset();
-  m_block.m_block_info = block_info();
+  m_block = block();
 }
 
 encoded_block_range::encoded_block_range(const encoded_block& block) {
@@ -54,8 +57,8 @@ void encoded_block_range::coroutine_launch() {
             // which sticks stuff into the buffer. 
             // and triggers the sink when the buffer full.
             typed_decode_stream_callback(coro_m_block.m_block_info,
-                                         coro_m_block.m_data->data(),
-                                         coro_m_block.m_data->size(),
+                                         coro_m_block.m_data,
+                                         coro_m_block.m_length,
                                          [&coro_m_shared, &sink](const flexible_type& val) {
                                            auto& shared = *coro_m_shared;
                                            if (shared.terminate) {
@@ -72,7 +75,8 @@ void encoded_block_range::coroutine_launch() {
                                              shared.m_skip--;
                                              if (shared.m_skip == 0) sink();
                                            }
-                                         });
+                                         },
+                                         coro_m_block.m_dictionary.get());
             return;
       }));
 }
@@ -111,7 +115,7 @@ void encoded_block_range::release() {
   }
   source = std::move(coroutine_type());
   m_shared.reset();
-  m_block.m_data.reset();
+  m_block = encoded_block::block();
 }
 
 
@@ -13,6 +13,7 @@
 #include <memory>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
+#include <sframe/column_dictionary.hpp>
 namespace graphlab {
 namespace v2_block_impl {
 
@@ -72,6 +73,24 @@ class encoded_block {
    */
   void init(block_info info, std::shared_ptr<std::vector<char> > data);
 
+  /**
+   * Initializes this block to point to data owned by another object,
+   * for instance a block inside a memory mapped segment file, without
+   * copying it.
+   *
+   * Existing ranges are NOT invalidated.
+   * They will continue to point to what they used to point to.
+   * \param info The block information structure
+   * \param data The binary data
+   * \param length The length of the binary data
+   * \param owner Keeps the data alive for as long as it is held
+   * \param dictionary The dictionary of the column, for the string blocks
+   * encoded with it (see typed_encode())
+   */
+  void init(block_info info, const char* data, size_t length,
+            std::shared_ptr<const void> owner,
+            std::shared_ptr<const column_dictionary> dictionary = nullptr);
+
   /**
    * Returns an accessor to the contents of the block.
    *
@@ -93,10 +112,21 @@ class encoded_block {
     return m_block.m_block_info;
   }
 
-  std::shared_ptr<std::vector<char> > get_block_data() const {
+  /// The binary data of the block. Valid for as long as the block is held.
+  const char* get_block_data() const {
     return m_block.m_data;
   }
 
+  /// The length of the binary data of the block
+  size_t get_block_data_length() const {
+    return m_block.m_length;
+  }
+
+  /// The dictionary of the column of the block. May be NULL.
+  const column_dictionary* get_dictionary() const {
+    return m_block.m_dictionary.get();
+  }
+
   friend class encoded_block_range;
 
  private:
@@ -106,10 +136,15 @@ class encoded_block {
     /// The block information. Needed for the decode.
     block_info m_block_info;
     /// The actual block data.
-    std::shared_ptr<std::vector<char> > m_data;
+    const char* m_data;
+    size_t m_length;
+    /// Keeps m_data alive
+    std::shared_ptr<const void> m_owner;
+    /// The dictionary of the column. Needed for the decode of some strings.
+    std::shared_ptr<const column_dictionary> m_dictionary;
   };
 
-  block m_block;
+  block m_block = block();
   size_t m_size = 0;
 }; // class encoded_block
 
@@ -184,7 +219,7 @@ class encoded_block_range {
   /*                       The data I am reading from                       */
   /*                                                                        */
   /**************************************************************************/
-  encoded_block::block m_block;
+  encoded_block::block m_block = encoded_block::block();
 
   /**************************************************************************/
   /*                                                                        */
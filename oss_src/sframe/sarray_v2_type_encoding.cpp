@@ -5,6 +5,7 @@
  * This software may be modified and distributed under the terms
  * of the BSD license. See the LICENSE file for details.
  */
+#include <cstring>
 #include <functional>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
@@ -262,8 +263,13 @@ void decode_double(iarchive& iarc,
 /**
  * Encodes a collection of strings in data, skipping all UNDEFINED values.
  *
- * Two encoding strategies are used.
+ * Three encoding strategies are used. The encoding starts with one byte
+ * identifying the strategy (see STRING_RESERVED_FLAGS).
  * Strategy 1: 
+ * Column dictionary encode, if a column dictionary is given and all the
+ * strings fit in it. The dictionary is stored with the column.
+ *     - encode_number(codes of the strings in the column dictionary)
+ * Strategy 2: 
  * Dictionary encode:
  *  - A dictionary of unique strings are built, and an array of numbers 
  *    mapping to the string values are constructed.
@@ -272,7 +278,7 @@ void decode_double(iarchive& iarc,
  *         - variable_encode entry length
  *         - write bytes contents for each entry
  *     - encode_number(dictionary mapping)
- * Strategy 2:
+ * Strategy 3:
  * Direct encode:
  *  - encode_number(lengths of all the strings)
  *  - for each entry:
@@ -283,7 +289,30 @@ void decode_double(iarchive& iarc,
  */
 static void encode_string(block_info& info, 
                           oarchive& oarc, 
-                          const std::vector<flexible_type>& data) {
+                          const std::vector<flexible_type>& data,
+                          column_dictionary* dictionary,
+                          size_t max_dictionary_size) {
+  if (dictionary) {
+    std::vector<flexible_type> codes;
+    codes.reserve(data.size());
+    bool in_dictionary = true;
+    size_t code = 0;
+    for (const auto& f: data) {
+      if (f.get_type() == flex_type_enum::UNDEFINED) continue;
+      if (!dictionary->insert(f.get<flex_string>(), max_dictionary_size, code)) {
+        // the dictionary is full. Use a block dictionary instead.
+        in_dictionary = false;
+        break;
+      }
+      codes.push_back(flexible_type(flex_int(code)));
+    }
+    if (in_dictionary) {
+      char reserved = STRING_RESERVED_FLAGS::COLUMN_DICTIONARY_ENCODING;
+      oarc.write(&(reserved), sizeof(reserved));
+      encode_number(info, oarc, codes);
+      return;
+    }
+  }
   bool use_dictionary_encoding = true;
   std::unordered_map<std::string, size_t> unique_values;
   std::vector<flexible_type> idx_values;
@@ -297,7 +326,7 @@ static void encode_string(block_info& info,
         idx_values[idxctr++].mutable_get<flex_int>() = iter->second;
       } else {
         // if we have too many unique values, fail.
-        if (unique_values.size() >= 64) {
+        if (unique_values.size() >= MAX_STRING_DICTIONARY_SIZE) {
           use_dictionary_encoding = false;
           break;
         }
@@ -308,7 +337,10 @@ static void encode_string(block_info& info,
       }
     }
   }
-  oarc << use_dictionary_encoding;
+  char reserved = use_dictionary_encoding ? 
+      STRING_RESERVED_FLAGS::DICTIONARY_ENCODING : 
+      STRING_RESERVED_FLAGS::DIRECT_ENCODING;
+  oarc.write(&(reserved), sizeof(reserved));
   if (use_dictionary_encoding) {
     idx_values.resize(idxctr);
 
@@ -344,7 +376,8 @@ static void encode_string(block_info& info,
  */
 static void decode_string(iarchive& iarc, 
                           std::vector<flexible_type>& ret,
-                          size_t num_undefined) {
+                          size_t num_undefined,
+                          const column_dictionary* dictionary) {
   unsigned int last_id = 0;
   decode_string_stream(ret.size() - num_undefined, iarc, 
                        [&](flexible_type val) {
@@ -355,7 +388,7 @@ static void decode_string(iarchive& iarc,
                          ret[last_id] = val;
                          DASSERT_LT(last_id, ret.size());
                          ++last_id;
-                       });
+                       }, dictionary);
 }
 
 /**
@@ -425,7 +458,7 @@ static void decode_vector(iarchive& iarc,
  *   fields)
  * - type specific encoding:
  *     - if integer or float, encode_number() is called
- *     - if string, encode_string() is called
+ *     - if string, encode_string() is called, with the column dictionary
  *     - otherwise, direct serialization is currently used.
  *     - If UNDEFINED (i.e. array is of all UNDEFINED values, nothing is written)
  *
@@ -434,7 +467,9 @@ static void decode_vector(iarchive& iarc,
  */
 void typed_encode(const std::vector<flexible_type>& data, 
                   block_info& block,
-                  oarchive& oarc) {
+                  oarchive& oarc,
+                  column_dictionary* dictionary,
+                  size_t max_dictionary_size) {
   block.flags |= IS_FLEXIBLE_TYPE;
   block.num_elem = data.size();
  
@@ -489,7 +524,7 @@ void typed_encode(const std::vector<flexible_type>& data,
       block.flags |=  BLOCK_ENCODING_EXTENSION;
       encode_double(block, oarc, data);
     } else if (types_appeared.get((char)flex_type_enum::STRING)) {
-      encode_string(block, oarc, data);
+      encode_string(block, oarc, data, dictionary, max_dictionary_size);
     } else if (types_appeared.get((char)flex_type_enum::VECTOR)) {
       block.flags |=  BLOCK_ENCODING_EXTENSION;
       encode_vector(block, oarc, data);
@@ -515,8 +550,9 @@ void typed_encode(const std::vector<flexible_type>& data,
  * stored in the block_info (block.num_elem)
  */
 bool typed_decode(const block_info& info,
-                  char* start, size_t len,
-                  std::vector<flexible_type>& ret) {
+                  const char* start, size_t len,
+                  std::vector<flexible_type>& ret,
+                  const column_dictionary* dictionary) {
   if (!(info.flags & IS_FLEXIBLE_TYPE)) {
     logstream(LOG_ERROR) << "Attempting to decode a non-typed block"
                          << std::endl;
@@ -576,7 +612,7 @@ bool typed_decode(const block_info& info,
         decode_double_legacy(iarc, ret, num_undefined);
       }
     } else if (column_type == flex_type_enum::STRING) {
-      decode_string(iarc, ret, num_undefined);
+      decode_string(iarc, ret, num_undefined, dictionary);
     } else if (column_type == flex_type_enum::VECTOR) {
       decode_vector(iarc, ret, num_undefined, 
                     info.flags & BLOCK_ENCODING_EXTENSION);
@@ -599,8 +635,162 @@ bool typed_decode(const block_info& info,
   return true;
 }
 
+/**
+ * Decodes num_values integers written with frame_of_reference_encode_128()
+ * into output.
+ */
+static void decode_packed_integers(iarchive& iarc,
+                                   size_t num_values,
+                                   uint64_t* output) {
+  while(num_values > 0) {
+    size_t buflen = std::min<size_t>(num_values, MAX_INTEGERS_PER_BLOCK);
+    frame_of_reference_decode_128(iarc, buflen, output);
+    output += buflen;
+    num_values -= buflen;
+  }
+}
+
+/**
+ * Moves the num_defined values at the front of values to the positions
+ * flagged in validity, zeroing all other positions. Works backwards so that
+ * no value is overwritten before it is moved.
+ */
+template <typename T>
+static void scatter_defined_values(std::vector<T>& values,
+                                   size_t num_defined,
+                                   const std::vector<uint64_t>& validity) {
+  size_t j = num_defined;
+  for (size_t i = values.size(); i > 0; --i) {
+    size_t pos = i - 1;
+    if ((validity[pos / 64] >> (pos % 64)) & 1) {
+      values[pos] = values[--j];
+    } else {
+      values[pos] = 0;
+    }
+  }
+}
+
+/**
+ * Reads the header of a typed block (see typed_encode()) of values of the
+ * given type, filling in the validity bitmap of the block (empty if all
+ * values are defined) and the number of defined values. Returns false if 
+ * the block is not of the given type.
+ */
+static bool read_typed_header(const block_info& info,
+                              iarchive& iarc,
+                              flex_type_enum type,
+                              std::vector<uint64_t>& validity,
+                              size_t& num_defined) {
+  if (!(info.flags & IS_FLEXIBLE_TYPE) || 
+      (info.flags & MULTIPLE_TYPE_BLOCK)) {
+    return false;
+  }
+  size_t dsize = info.num_elem;
+  char num_types; iarc >> num_types;
+  validity.clear();
+  num_defined = dsize;
+  if (num_types == 1 || num_types == 2) {
+    char c;
+    iarc >> c;
+    flex_type_enum column_type = (flex_type_enum)c;
+    if (num_types == 1 && column_type == flex_type_enum::UNDEFINED) {
+      // all undefined
+      validity = typed_column::make_validity(dsize);
+      num_defined = 0;
+    } else if (column_type != type) {
+      return false;
+    } else if (num_types == 2) {
+      // the block stores the undefined entries. Flip them.
+      graphlab::dense_bitset d(dsize);
+      d.clear();
+      iarc.read((char*)d.array, sizeof(size_t)*d.arrlen);
+      num_defined = dsize - d.popcount();
+      validity.resize(d.arrlen);
+      for (size_t i = 0;i < d.arrlen; ++i) validity[i] = ~(uint64_t)d.array[i];
+      if (dsize % 64) validity.back() &= (uint64_t(1) << (dsize % 64)) - 1;
+    }
+  } else if (num_types != 0 || dsize != 0) {
+    return false;
+  }
+  return true;
+}
+
+bool typed_decode_numeric(const block_info& info,
+                          const char* start, size_t len,
+                          flex_type_enum type,
+                          typed_column& ret) {
+  if (type != flex_type_enum::INTEGER && type != flex_type_enum::FLOAT) {
+    return false;
+  }
+  graphlab::iarchive iarc(start, len);
+  size_t dsize = info.num_elem;
+  // the validity bitmap. Empty if all values are defined.
+  std::vector<uint64_t> validity;
+  size_t num_defined = 0;
+  if (!read_typed_header(info, iarc, type, validity, num_defined)) return false;
 
+  if (type == flex_type_enum::INTEGER) {
+    std::vector<flex_int> values(dsize, 0);
+    decode_packed_integers(iarc, num_defined, 
+                           reinterpret_cast<uint64_t*>(values.data()));
+    if (!validity.empty()) scatter_defined_values(values, num_defined, validity);
+    ret = typed_column(std::move(values), std::move(validity));
+  } else {
+    char reserved = DOUBLE_RESERVED_FLAGS::LEGACY_ENCODING;
+    if (num_defined > 0 && (info.flags & BLOCK_ENCODING_EXTENSION)) {
+      iarc.read(&(reserved), sizeof(reserved));
+    }
+    std::vector<flex_float> values(dsize, 0);
+    uint64_t* buf = reinterpret_cast<uint64_t*>(values.data());
+    decode_packed_integers(iarc, num_defined, buf);
+    if (reserved == DOUBLE_RESERVED_FLAGS::LEGACY_ENCODING) {
+      // right rotate, and the bits are those of the double.
+      for (size_t i = 0;i < num_defined; ++i) {
+        uint64_t bits = (buf[i] >> 1) | (buf[i] << 63);
+        std::memcpy(&values[i], &bits, sizeof(bits));
+      }
+    } else if (reserved == DOUBLE_RESERVED_FLAGS::INTEGER_ENCODING) {
+      for (size_t i = 0;i < num_defined; ++i) {
+        values[i] = (flex_float)(flex_int)(buf[i]);
+      }
+    } else {
+      return false;
+    }
+    if (!validity.empty()) scatter_defined_values(values, num_defined, validity);
+    ret = typed_column(std::move(values), std::move(validity));
+  }
+  return true;
+}
 
+bool typed_decode_string_codes(const block_info& info,
+                               const char* start, size_t len,
+                               const std::shared_ptr<const column_dictionary>& dictionary,
+                               typed_column& ret) {
+  if (dictionary == nullptr) return false;
+  graphlab::iarchive iarc(start, len);
+  size_t dsize = info.num_elem;
+  std::vector<uint64_t> validity;
+  size_t num_defined = 0;
+  if (!read_typed_header(info, iarc, flex_type_enum::STRING, 
+                         validity, num_defined)) {
+    return false;
+  }
+  std::vector<uint64_t> buf(num_defined);
+  if (num_defined > 0) {
+    char reserved = 0;
+    iarc.read(&(reserved), sizeof(reserved));
+    if (reserved != STRING_RESERVED_FLAGS::COLUMN_DICTIONARY_ENCODING) return false;
+    decode_packed_integers(iarc, num_defined, buf.data());
+  }
+  std::vector<uint32_t> codes(dsize, 0);
+  for (size_t i = 0;i < num_defined; ++i) {
+    ASSERT_LT(buf[i], dictionary->size());
+    codes[i] = buf[i];
+  }
+  if (!validity.empty()) scatter_defined_values(codes, num_defined, validity);
+  ret = typed_column(std::move(codes), dictionary, std::move(validity));
+  return true;
+}
 
 } // namespace v2_block_impl
 } // namespace graphlab
@@ -11,12 +11,19 @@
 #include <sframe/sarray_v2_block_types.hpp>
 #include <util/dense_bitset.hpp>
 #include <sframe/integer_pack.hpp>
+#include <sframe/typed_column.hpp>
+#include <sframe/column_dictionary.hpp>
 namespace graphlab {
 namespace v2_block_impl {
 using namespace graphlab::integer_pack;
 
 static const size_t MAX_INTEGERS_PER_BLOCK = 128;
 static const size_t MAX_DOUBLES_PER_BLOCK = 512;
+/**
+ * The maximum number of unique strings in a block for the block to be
+ * dictionary encoded. (Blocks written by older versions have at most 64.)
+ */
+static const size_t MAX_STRING_DICTIONARY_SIZE = 1024;
 
 void encode_number(block_info& info, 
                    oarchive& oarc, 
@@ -37,27 +44,70 @@ void decode_double_legacy(iarchive& iarc,
                           size_t num_undefined);
 /**
  * Decodes a type block. Reads from block_info and a buffer.
+ * dictionary is the dictionary of the column the block belongs to (see
+ * \ref typed_encode()), which is only needed by blocks encoded with it.
  * Returns false on failure. 
  */
 bool typed_decode(const block_info& info,
-                  char* start, size_t len,
-                  std::vector<flexible_type>& ret);
+                  const char* start, size_t len,
+                  std::vector<flexible_type>& ret,
+                  const column_dictionary* dictionary = NULL);
+
+/**
+ * Decodes a block of a column of the given type (INTEGER or FLOAT) directly
+ * into the packed representation of \ref typed_column, without going
+ * through flexible_type. A block which only contains UNDEFINED values is
+ * decoded as a packed column of the given type with no defined values.
+ *
+ * Returns false if the block cannot be decoded this way (for instance if it
+ * is not of the given type, or holds multiple types), in which case
+ * \ref typed_decode() should be used.
+ */
+bool typed_decode_numeric(const block_info& info,
+                          const char* start, size_t len,
+                          flex_type_enum type,
+                          typed_column& ret);
+
+/**
+ * Decodes a block of a string column encoded with the column dictionary
+ * (see \ref typed_encode()) into a \ref typed_column of codes into the
+ * dictionary, without materializing the strings. A block which only 
+ * contains UNDEFINED values is decoded as a column of codes with no
+ * defined values.
+ *
+ * Returns false if the block cannot be decoded this way (for instance if its
+ * strings are not encoded with the column dictionary), in which case
+ * \ref typed_decode() should be used.
+ */
+bool typed_decode_string_codes(const block_info& info,
+                               const char* start, size_t len,
+                               const std::shared_ptr<const column_dictionary>& dictionary,
+                               typed_column& ret);
 
 /**
  * Decodes a type block. Reads from block_info and a buffer.
  * Returns false on failure. 
  */
 bool typed_decode_stream_callback(const block_info& info,
-                                  char* start, size_t len,
-                                  std::function<void(flexible_type)> retcallback);
+                                  const char* start, size_t len,
+                                  std::function<void(flexible_type)> retcallback,
+                                  const column_dictionary* dictionary = NULL);
 
 /**
  * Encodes a type block. Serializes data into the output archive
  * and updates the block_info datastructure.
+ *
+ * If dictionary is not NULL, it is the dictionary of the column the block
+ * belongs to, which can hold up to max_dictionary_size strings. The
+ * strings of a string block are then stored as codes into the dictionary,
+ * adding the new strings to it, if they all fit. The dictionary must be
+ * stored alongside the block, as the block can only be decoded with it.
  */
 void typed_encode(const std::vector<flexible_type>& data, 
                   block_info& info,
-                  oarchive& oarc);
+                  oarchive& oarc,
+                  column_dictionary* dictionary = NULL,
+                  size_t max_dictionary_size = 0);
 
 
 
@@ -136,12 +186,19 @@ static void decode_double_stream(size_t num_elements,
 template <typename Fn> // Fn is a function like void(flexible_type)
 static void decode_string_stream(size_t num_elements,
                                  iarchive& iarc,
-                                 Fn callback) {
-  bool use_dictionary_encoding = false;
-  std::vector<flexible_type> idx_values;
-  idx_values.resize(num_elements, flexible_type(flex_type_enum::INTEGER));
-  iarc >> use_dictionary_encoding;
-  if (use_dictionary_encoding) {
+                                 Fn callback,
+                                 const column_dictionary* dictionary) {
+  char reserved = 0;
+  iarc.read(&(reserved), sizeof(reserved));
+  if (reserved == STRING_RESERVED_FLAGS::COLUMN_DICTIONARY_ENCODING) {
+    if (dictionary == NULL) {
+      log_and_throw("Missing the column dictionary of a string block");
+    }
+    decode_number_stream(num_elements, iarc,
+                         [&](const flexible_type& idx) {
+                           callback(dictionary->value(idx.get<flex_int>()));
+                         });
+  } else if (reserved == STRING_RESERVED_FLAGS::DICTIONARY_ENCODING) {
     uint64_t num_values;
     std::vector<flexible_type> str_values;
     variable_decode(iarc, num_values);
@@ -154,12 +211,16 @@ static void decode_string_stream(size_t num_elements,
       iarc.read(&(new_str[0]), str_len);
       str = std::move(new_str);
     }
-    decode_number(iarc, idx_values, 0);
-    for (size_t i = 0;i < num_elements; ++i) {
-      callback(str_values[idx_values[i].get<flex_int>()]);
-    }
+    // every row shares the (reference counted) string of its dictionary 
+    // entry: the strings are never copied.
+    decode_number_stream(num_elements, iarc,
+                         [&](const flexible_type& idx) {
+                           callback(str_values[idx.get<flex_int>()]);
+                         });
   } else {
     // get all the lengths
+    std::vector<flexible_type> idx_values;
+    idx_values.resize(num_elements, flexible_type(flex_type_enum::INTEGER));
     decode_number(iarc, idx_values, 0);
     flexible_type ret(flex_type_enum::STRING);
     for (size_t i = 0;i < num_elements; ++i) {
@@ -233,8 +294,9 @@ static void decode_vector_stream(size_t num_elements,
  */
 template <typename Fn> // Fn is a function like void(flexible_type)
 static bool typed_decode_stream_callback(const block_info& info,
-                                  char* start, size_t len,
-                                  Fn callback) {
+                                  const char* start, size_t len,
+                                  Fn callback,
+                                  const column_dictionary* dictionary = NULL) {
   if (!(info.flags & IS_FLEXIBLE_TYPE)) {
     logstream(LOG_ERROR) << "Attempting to decode a non-typed block"
                          << std::endl;
@@ -315,7 +377,7 @@ static bool typed_decode_stream_callback(const block_info& info,
         decode_double_stream_legacy(elements_to_decode, iarc, stream_callback); 
       }
     } else if (column_type == flex_type_enum::STRING) {
-      decode_string_stream(elements_to_decode, iarc, stream_callback); 
+      decode_string_stream(elements_to_decode, iarc, stream_callback, dictionary); 
     } else if (column_type == flex_type_enum::VECTOR) {
       decode_vector_stream(elements_to_decode, iarc, stream_callback, 
                            info.flags & BLOCK_ENCODING_EXTENSION); 
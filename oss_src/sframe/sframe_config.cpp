@@ -19,6 +19,10 @@ namespace graphlab {
 namespace sframe_config {
 EXPORT size_t SFRAME_SORT_BUFFER_SIZE = size_t(2*1024*1024)*size_t(1024);
 EXPORT size_t SFRAME_READ_BATCH_SIZE = 128;
+EXPORT size_t SFRAME_PREFETCH_NUM_BLOCKS = 4;
+EXPORT size_t SFRAME_PREFETCH_BUFFER_SIZE = 64*1024*1024;
+EXPORT size_t SFRAME_PREFETCH_NUM_THREADS = 4;
+EXPORT size_t SFRAME_COLUMN_DICTIONARY_SIZE = 4096;
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SFRAME_SORT_BUFFER_SIZE,
@@ -33,5 +37,26 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             true, 
                             +[](int64_t val){ return val >= 1; });
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_PREFETCH_NUM_BLOCKS, 
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_PREFETCH_BUFFER_SIZE, 
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
+
+// read once, when the first block is prefetched
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_PREFETCH_NUM_THREADS, 
+                            true, 
+                            +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_COLUMN_DICTIONARY_SIZE, 
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
+
 }
 }
@@ -24,6 +24,29 @@ namespace sframe_config {
   **  The number of rows to read each time for paralleliterator
   **/
   extern size_t SFRAME_READ_BATCH_SIZE;
+
+  /**
+  **  The number of blocks following a block read from a column which are
+  **  read ahead in the background. 0 disables prefetching.
+  **/
+  extern size_t SFRAME_PREFETCH_NUM_BLOCKS;
+
+  /**
+  **  The max number of bytes of prefetched blocks waiting to be read
+  **/
+  extern size_t SFRAME_PREFETCH_BUFFER_SIZE;
+
+  /**
+  **  The number of threads performing the background block reads
+  **/
+  extern size_t SFRAME_PREFETCH_NUM_THREADS;
+
+  /**
+  **  The max number of distinct strings of a column for its string blocks
+  **  to be stored as codes into a dictionary shared by the whole column. 
+  **  0 disables the column dictionaries.
+  **/
+  extern size_t SFRAME_COLUMN_DICTIONARY_SIZE;
 }
 
 }
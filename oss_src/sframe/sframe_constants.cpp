@@ -31,7 +31,9 @@ EXPORT size_t SFRAME_MAX_BLOCKS_IN_CACHE = 32;
 EXPORT size_t SFRAME_CSV_PARSER_READ_SIZE = 50 * 1024 * 1024; // 50MB
 EXPORT size_t SFRAME_GROUPBY_BUFFER_NUM_ROWS = 1024 * 1024;
 EXPORT size_t SFRAME_JOIN_BUFFER_NUM_CELLS = 50*1024*1024;
+EXPORT size_t SFRAME_JOIN_BROADCAST_NUM_CELLS = 1024*1024;
 EXPORT size_t SFRAME_IO_READ_LOCK = false;
+EXPORT size_t SFRAME_USE_MMAP = true;
 EXPORT size_t SFRAME_SORT_PIVOT_ESTIMATION_SAMPLE_SIZE = 2000000;
 EXPORT size_t SFRAME_SORT_MAX_SEGMENTS = 128;
 EXPORT const size_t SFRAME_IO_LOCK_FILE_SIZE_THRESHOLD = 4 * 1024 * 1024;
@@ -86,6 +88,12 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             +[](int64_t val){ return val >= 1024; });
 
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_JOIN_BROADCAST_NUM_CELLS,
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
+
+
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SFRAME_WRITER_MAX_BUFFERED_CELLS,
@@ -103,6 +111,11 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             true, 
                             +[](int64_t val){ return val == 0 || val == 1 ; });
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_USE_MMAP,
+                            true, 
+                            +[](int64_t val){ return val == 0 || val == 1 ; });
+
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SFRAME_SORT_PIVOT_ESTIMATION_SAMPLE_SIZE,
                             true, 
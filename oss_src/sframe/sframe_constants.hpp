@@ -135,6 +135,13 @@ extern size_t SFRAME_GROUPBY_BUFFER_NUM_ROWS;
  */
 extern size_t SFRAME_JOIN_BUFFER_NUM_CELLS;
 
+/**
+ * Joins against an input of at most this many cells (rows * columns) whose
+ * length is known are executed as broadcast joins: the small input is held
+ * in memory and the other input is streamed through it.
+ */
+extern size_t SFRAME_JOIN_BROADCAST_NUM_CELLS;
+
 /**
  * Whether locks are used when reading from SFrames on local storage. Good
  * for spinning disks, bad for SSDs.
@@ -148,6 +155,13 @@ extern size_t SFRAME_IO_READ_LOCK;
  */
 extern const size_t SFRAME_IO_LOCK_FILE_SIZE_THRESHOLD;
 
+/**
+ * Whether segment files on local storage are memory mapped for reading.
+ * Uncompressed blocks of mapped files are decoded in place without being
+ * copied. Only affects segments opened after the value is changed.
+ */
+extern size_t SFRAME_USE_MMAP;
+
 /**
  * Number of samples used to estimate the pivot positions to partition the
  * data for sorting.
@@ -99,8 +99,19 @@ size_t sframe_reader::read_rows(size_t row_start,
                                 sframe_rows& out_obj) {
   // sframe_rows is made up of a collection of columns
   out_obj.resize(column_data.size());
+  auto& columns = out_obj.get_columns();
+  // integer and float columns are read as typed columns
+  std::vector<std::pair<size_t, typed_column> > typed_columns;
   for (size_t i = 0;i < column_data.size(); ++i) {
-    column_data[i]->read_rows(row_start, row_end, *(out_obj.get_columns()[i]));
+    typed_column column;
+    if (column_data[i]->read_typed_rows(row_start, row_end, column)) {
+      typed_columns.emplace_back(i, std::move(column));
+    } else {
+      column_data[i]->read_rows(row_start, row_end, *(columns[i]));
+    }
+  }
+  for (auto& column: typed_columns) {
+    out_obj.set_typed_column(column.first, column.second);
   }
   return out_obj.num_rows();
 }
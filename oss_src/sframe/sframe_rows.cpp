@@ -30,9 +30,12 @@ void sframe_rows::resize(size_t num_cols, ssize_t num_rows) {
 
 void sframe_rows::clear() {
   m_decoded_columns.clear();
+  m_typed_columns.clear();
+  m_has_lazy_columns = false;
 }
 
 void sframe_rows::save(oarchive& oarc) const {
+  ensure_decoded();
   oarc << m_decoded_columns.size();
   oarchive temp_inmemory_arc;
   for (auto& i : m_decoded_columns) {
@@ -69,9 +72,54 @@ void sframe_rows::load(iarchive& iarc) {
 void sframe_rows::add_decoded_column(
     const sframe_rows::ptr_to_decoded_column_type& decoded_column) {
   m_decoded_columns.push_back(decoded_column);
+  if (!m_typed_columns.empty()) m_typed_columns.push_back(nullptr);
+}
+
+void sframe_rows::add_typed_column(const typed_column& column) {
+  m_typed_columns.resize(m_decoded_columns.size());
+  m_decoded_columns.push_back(nullptr);
+  m_typed_columns.push_back(std::make_shared<const typed_column>(column));
+  m_has_lazy_columns = true;
+}
+
+void sframe_rows::set_typed_column(size_t i, const typed_column& column) {
+  DASSERT_LT(i, m_decoded_columns.size());
+  m_typed_columns.resize(m_decoded_columns.size());
+  m_decoded_columns[i] = nullptr;
+  m_typed_columns[i] = std::make_shared<const typed_column>(column);
+  m_has_lazy_columns = true;
+}
+
+typed_column sframe_rows::get_typed_column(size_t i) const {
+  DASSERT_LT(i, m_decoded_columns.size());
+  if (!has_typed_column(i)) {
+    m_typed_columns.resize(m_decoded_columns.size());
+    m_typed_columns[i] = 
+        std::make_shared<const typed_column>(m_decoded_columns[i]);
+  }
+  return *m_typed_columns[i];
+}
+
+void sframe_rows::decode_typed_column(size_t i) const {
+  if (m_decoded_columns[i] == nullptr) {
+    auto decoded_column = std::make_shared<decoded_column_type>();
+    m_typed_columns[i]->to_flexible(*decoded_column);
+    m_decoded_columns[i] = decoded_column;
+  }
+}
+
+void sframe_rows::decode_typed_columns() const {
+  for (size_t i = 0;i < m_decoded_columns.size(); ++i) {
+    decode_typed_column(i);
+  }
+  m_has_lazy_columns = false;
 }
 
 void sframe_rows::ensure_unique() {
+  // the flexible_type columns may be modified after this, so the typed
+  // columns can no longer be kept.
+  ensure_decoded();
+  m_typed_columns.clear();
   if (m_is_unique) return;
   for (auto& col: m_decoded_columns) {
     if (!col.unique()) {
@@ -86,6 +134,12 @@ void sframe_rows::type_check_inplace(const std::vector<flex_type_enum>& typelist
   // one pass for column type check
   for (size_t c = 0; c < num_columns(); ++c) {
     if (typelist[c] != flex_type_enum::UNDEFINED) {
+      if (has_typed_column(c)) {
+        // a packed column of the right type needs no modification
+        if (m_typed_columns[c]->type() == typelist[c]) continue;
+        decode_typed_column(c);
+        m_typed_columns[c].reset();
+      }
       // assume no modification required first
       auto& arr = m_decoded_columns[c];
       auto length = arr->size();
@@ -10,6 +10,7 @@
 #include <vector>
 #include <map>
 #include <flexible_type/flexible_type.hpp>
+#include <sframe/typed_column.hpp>
 namespace graphlab {
 class oarchive;
 class iarchive;
@@ -36,6 +37,16 @@ class iarchive;
  * sframe_rows::get_columns() (returns a reference to the underlying vector)
  * or sframe_rows::cget_columns()
  *
+ * Columns may also be held in a packed int64/double representation (see
+ * \ref typed_column). Sources which can decode directly into the packed
+ * representation, and operators which perform numeric work emit columns
+ * with sframe_rows::add_typed_column(), and read them with
+ * sframe_rows::get_typed_column(). A typed column is only converted to a
+ * column of flexible_type the first time it is accessed through the
+ * flexible_type interface (get_columns(), the row iterators, etc). Since
+ * these conversions also happen in const accessors, a single sframe_rows
+ * object must not be accessed concurrently by multiple threads.
+ *
  * \TODO: We *could* templatize this around the column type, allowing this to
  * be used for anything.
  */
@@ -56,6 +67,8 @@ class sframe_rows {
    */
   sframe_rows(const sframe_rows& other) {
     m_decoded_columns = other.m_decoded_columns;
+    m_typed_columns = other.m_typed_columns;
+    m_has_lazy_columns = other.m_has_lazy_columns;
     m_is_unique = false;
     other.m_is_unique = false;
   }
@@ -70,6 +83,8 @@ class sframe_rows {
    */
   sframe_rows& operator=(const sframe_rows& other)  {
     m_decoded_columns = other.m_decoded_columns;
+    m_typed_columns = other.m_typed_columns;
+    m_has_lazy_columns = other.m_has_lazy_columns;
     m_is_unique = false;
     other.m_is_unique = false;
     return *this;
@@ -88,8 +103,9 @@ class sframe_rows {
   /// Returns the number of rows
   inline size_t num_rows() const {
     if (m_decoded_columns.empty()) return 0;
-    else if (m_decoded_columns[0] == nullptr) return 0;
-    else return m_decoded_columns[0]->size();
+    else if (m_decoded_columns[0] != nullptr) return m_decoded_columns[0]->size();
+    else if (has_typed_column(0)) return m_typed_columns[0]->size();
+    else return 0;
   }
 
   /**
@@ -115,6 +131,38 @@ class sframe_rows {
   void add_decoded_column(const ptr_to_decoded_column_type& decoded_column);
 
 
+  /**
+   * Adds to the right of the sframe_rows a typed column. The column is
+   * kept in the typed representation, and is only converted to 
+   * flexible_type when accessed through the flexible_type interface.
+   */
+  void add_typed_column(const typed_column& column);
+
+  /**
+   * Replaces column i with a typed column of the same length.
+   * \see add_typed_column
+   */
+  void set_typed_column(size_t i, const typed_column& column);
+
+  /**
+   * Returns column i in the typed representation. Integer and float 
+   * columns are packed into contiguous arrays; all other columns reference 
+   * the underlying flexible_type column. See \ref typed_column.
+   *
+   * This is free if the column is held in the typed representation (see
+   * \ref has_typed_column()). Otherwise the column is packed, and the 
+   * packed column is kept for subsequent calls.
+   */
+  typed_column get_typed_column(size_t i) const;
+
+  /**
+   * Returns true if column i is held in the typed representation, i.e. 
+   * \ref get_typed_column() does not need to pack it.
+   */
+  inline bool has_typed_column(size_t i) const {
+    return i < m_typed_columns.size() && m_typed_columns[i] != nullptr;
+  }
+
   /**
    * Returns a modifiable reference to the set of column groups
    *
@@ -122,7 +170,7 @@ class sframe_rows {
    * a full copy of the contents of sframe_rows.
    */
   inline std::vector<ptr_to_decoded_column_type>& get_columns() {
-    if (!m_is_unique) ensure_unique();
+    if (!m_is_unique || !m_typed_columns.empty()) ensure_unique();
     return m_decoded_columns;
   }
 
@@ -130,6 +178,7 @@ class sframe_rows {
    * Returns a const reference to the set of column groups
    */
   inline const std::vector<ptr_to_decoded_column_type>& get_columns() const {
+    ensure_decoded();
     return m_decoded_columns;
   }
 
@@ -137,6 +186,7 @@ class sframe_rows {
    * Returns a const reference to the set of column groups
    */
   inline const std::vector<ptr_to_decoded_column_type>& cget_columns() const {
+    ensure_decoded();
     return m_decoded_columns;
   }
 
@@ -426,6 +476,7 @@ class sframe_rows {
    * Gets a constant iterator to the first row of the sframe_rows.
    */
   inline const_iterator begin() const {
+    ensure_decoded();
     return const_iterator(this, 0);
   }
 
@@ -433,6 +484,7 @@ class sframe_rows {
    * Gets a constant iterator to the end of the sframe_rows.
    */
   inline const_iterator end() const {
+    ensure_decoded();
     return const_iterator(this, num_rows());
   }
 
@@ -440,6 +492,7 @@ class sframe_rows {
    * Gets a constant iterator to the first row of the sframe_rows.
    */
   inline const_iterator cbegin() const {
+    ensure_decoded();
     return const_iterator(this, 0);
   }
 
@@ -447,6 +500,7 @@ class sframe_rows {
    * Gets a constant iterator to the end of the sframe_rows.
    */
   inline const_iterator cend() const {
+    ensure_decoded();
     return const_iterator(this, num_rows());
   }
 
@@ -457,7 +511,7 @@ class sframe_rows {
    * a full copy of the contents of sframe_rows.
    */
   inline iterator begin() {
-    if (!m_is_unique) ensure_unique();
+    if (!m_is_unique || !m_typed_columns.empty()) ensure_unique();
     return iterator(this, 0);
   }
 
@@ -468,7 +522,7 @@ class sframe_rows {
    * a full copy of the contents of sframe_rows.
    */
   inline iterator end() {
-    if (!m_is_unique) ensure_unique();
+    if (!m_is_unique || !m_typed_columns.empty()) ensure_unique();
     return iterator(this, num_rows());
   }
 
@@ -476,6 +530,7 @@ class sframe_rows {
    * Reads a particular row of the sframe_rows object.
    */
   inline const row operator[](size_t i) const { 
+    ensure_decoded();
     return row(this, i);
   }
 
@@ -483,12 +538,14 @@ class sframe_rows {
    * gets a mutable reference to a particular row of the sframe_rows object
    */
   inline row operator[](size_t i) { 
-    if (!m_is_unique) ensure_unique();
+    if (!m_is_unique || !m_typed_columns.empty()) ensure_unique();
     return row(this, i);
   }
 
   /**
-   * Ensures that this is a unique copy
+   * Ensures that this is a unique copy. Typed columns are converted
+   * to flexible_type and dropped, since the flexible_type columns may 
+   * then be modified.
    */
   void ensure_unique();
 
@@ -505,7 +562,31 @@ class sframe_rows {
   sframe_rows type_check(const std::vector<flex_type_enum>& typelist) const;
 
    private:
-    std::vector<ptr_to_decoded_column_type> m_decoded_columns;
+    /**
+     * Converts the typed columns which have no flexible_type column
+     * yet to flexible_type.
+     */
+    inline void ensure_decoded() const {
+      if (m_has_lazy_columns) decode_typed_columns();
+    }
+
+    void decode_typed_columns() const;
+
+    void decode_typed_column(size_t i) const;
+
+    /**
+     * The flexible_type columns. An entry is NULL if the column is only 
+     * held in the typed representation and has not been converted yet.
+     */
+    mutable std::vector<ptr_to_decoded_column_type> m_decoded_columns;
+    /**
+     * The typed columns. Either empty, or of the same length as 
+     * m_decoded_columns where an entry is NULL if the column is only held
+     * as flexible_type.
+     */
+    mutable std::vector<std::shared_ptr<const typed_column> > m_typed_columns;
+    /// True if an entry of m_decoded_columns may be NULL
+    mutable bool m_has_lazy_columns = false;
     mutable bool m_is_unique = true;
   };  // class sframe_rows
 
@@ -142,6 +142,8 @@ void sframe_save_blockwise(const sframe& sf_source,
       }
 
       writer.get_index_info().columns[i].metadata = col.column_index.metadata;
+      // the blocks are copied as is, so the column statistics still hold
+      writer.get_index_info().columns[i].statistics = col.column_index.statistics;
     }
     // we are going to reorder the blocks so that the column with the lowest
     // row number get written first. So this is to be a min-heap
@@ -163,10 +165,29 @@ void sframe_save_blockwise(const sframe& sf_source,
                           {std::get<0>(cur.segment_address),
                            std::get<1>(cur.segment_address),
                            cur.current_block_number};
-      auto data = block_manager.read_block(block_address , &infoptr);
-      info = *infoptr;
-      // write to segment 0. We have only 1 segment 
-      writer.write_block(0, cur.column_number, data->data(), info);
+      if (block_manager.get_column_dictionary(cur.segment_address)) {
+        // the strings of the block may be codes into the dictionary of
+        // the segment. Encode them again with the dictionary of the output.
+        std::vector<flexible_type> values;
+        if (!block_manager.read_typed_block(block_address, values, &infoptr)) {
+          log_and_throw("Unexpected block read failure. Bad file?");
+        }
+        info = *infoptr;
+        writer.write_typed_block(0, cur.column_number, values, 
+                                 v2_block_impl::block_info());
+      } else {
+        auto data = block_manager.read_block(block_address , &infoptr);
+        info = *infoptr;
+        // carry over the block statistics if there are any
+        const v2_block_impl::block_statistics* statsptr = 
+            block_manager.get_block_statistics(block_address);
+        // write to segment 0. We have only 1 segment 
+        if (statsptr) {
+          writer.write_block(0, cur.column_number, data->data(), info, *statsptr);
+        } else {
+          writer.write_block(0, cur.column_number, data->data(), info);
+        }
+      }
       // increment the block number
       advance_column_blocks_to_next_block(block_manager, cur);
       // increment the row number
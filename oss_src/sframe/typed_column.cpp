@@ -0,0 +1,130 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <logger/assertions.hpp>
+#include <sframe/typed_column.hpp>
+
+namespace graphlab {
+
+typed_column::typed_column(const flexible_column_ptr& column) {
+  ASSERT_TRUE(column != nullptr);
+  const auto& values = *column;
+  m_size = values.size();
+
+  // figure out if the column can be packed
+  flex_type_enum packed_type = flex_type_enum::UNDEFINED;
+  bool has_undefined = false;
+  for (const auto& val: values) {
+    flex_type_enum t = val.get_type();
+    if (t == flex_type_enum::UNDEFINED) {
+      has_undefined = true;
+    } else if (packed_type == flex_type_enum::UNDEFINED &&
+               (t == flex_type_enum::INTEGER || t == flex_type_enum::FLOAT)) {
+      packed_type = t;
+    } else if (t != packed_type) {
+      // mixed or non-numeric values. Keep the original column.
+      m_flexible = column;
+      return;
+    }
+  }
+  if (packed_type == flex_type_enum::UNDEFINED) {
+    // empty, or all values are UNDEFINED
+    m_flexible = column;
+    return;
+  }
+
+  m_type = packed_type;
+  std::vector<uint64_t> validity;
+  if (has_undefined) validity = make_validity(m_size);
+  if (packed_type == flex_type_enum::INTEGER) {
+    std::vector<flex_int> ints(m_size, 0);
+    for (size_t i = 0;i < m_size; ++i) {
+      if (values[i].get_type() == flex_type_enum::INTEGER) {
+        ints[i] = values[i].get<flex_int>();
+        if (has_undefined) set_defined(validity, i);
+      }
+    }
+    m_ints = std::make_shared<const std::vector<flex_int> >(std::move(ints));
+  } else {
+    std::vector<flex_float> floats(m_size, 0);
+    for (size_t i = 0;i < m_size; ++i) {
+      if (values[i].get_type() == flex_type_enum::FLOAT) {
+        floats[i] = values[i].get<flex_float>();
+        if (has_undefined) set_defined(validity, i);
+      }
+    }
+    m_floats = std::make_shared<const std::vector<flex_float> >(std::move(floats));
+  }
+  if (has_undefined) {
+    m_validity = std::make_shared<const std::vector<uint64_t> >(std::move(validity));
+  }
+}
+
+typed_column::typed_column(std::vector<flex_int>&& values,
+                           std::vector<uint64_t>&& validity)
+    : m_type(flex_type_enum::INTEGER), m_size(values.size()),
+      m_ints(std::make_shared<const std::vector<flex_int> >(std::move(values))) {
+  ASSERT_TRUE(validity.empty() || validity.size() == (m_size + 63) / 64);
+  if (!validity.empty()) {
+    m_validity = std::make_shared<const std::vector<uint64_t> >(std::move(validity));
+  }
+}
+
+typed_column::typed_column(std::vector<flex_float>&& values,
+                           std::vector<uint64_t>&& validity)
+    : m_type(flex_type_enum::FLOAT), m_size(values.size()),
+      m_floats(std::make_shared<const std::vector<flex_float> >(std::move(values))) {
+  ASSERT_TRUE(validity.empty() || validity.size() == (m_size + 63) / 64);
+  if (!validity.empty()) {
+    m_validity = std::make_shared<const std::vector<uint64_t> >(std::move(validity));
+  }
+}
+
+typed_column::typed_column(std::vector<uint32_t>&& codes,
+                           std::shared_ptr<const column_dictionary> dictionary,
+                           std::vector<uint64_t>&& validity)
+    : m_type(flex_type_enum::STRING), m_size(codes.size()),
+      m_codes(std::make_shared<const std::vector<uint32_t> >(std::move(codes))),
+      m_dictionary(std::move(dictionary)) {
+  ASSERT_TRUE(m_dictionary != nullptr);
+  ASSERT_TRUE(validity.empty() || validity.size() == (m_size + 63) / 64);
+  if (!validity.empty()) {
+    m_validity = std::make_shared<const std::vector<uint64_t> >(std::move(validity));
+  }
+}
+
+flexible_type typed_column::at(size_t i) const {
+  DASSERT_LT(i, m_size);
+  if (m_type == flex_type_enum::UNDEFINED) return (*m_flexible)[i];
+  else if (!is_defined(i)) return FLEX_UNDEFINED;
+  else if (m_type == flex_type_enum::INTEGER) return (*m_ints)[i];
+  else if (m_type == flex_type_enum::FLOAT) return (*m_floats)[i];
+  else return m_dictionary->value((*m_codes)[i]);
+}
+
+void typed_column::to_flexible(std::vector<flexible_type>& out) const {
+  if (m_type == flex_type_enum::UNDEFINED) {
+    if (m_flexible) out = *m_flexible;
+    else out.clear();
+    return;
+  }
+  out.resize(m_size);
+  for (size_t i = 0;i < m_size; ++i) {
+    if (!is_defined(i)) {
+      out[i] = FLEX_UNDEFINED;
+    } else if (m_type == flex_type_enum::INTEGER) {
+      out[i] = (*m_ints)[i];
+    } else if (m_type == flex_type_enum::FLOAT) {
+      out[i] = (*m_floats)[i];
+    } else {
+      // the strings are shared with the dictionary, not copied
+      out[i] = m_dictionary->value((*m_codes)[i]);
+    }
+  }
+}
+
+} // namespace graphlab
@@ -0,0 +1,182 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_TYPED_COLUMN_HPP
+#define GRAPHLAB_SFRAME_TYPED_COLUMN_HPP
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/column_dictionary.hpp>
+namespace graphlab {
+
+/**
+ * A column of values in a typed, contiguous representation.
+ *
+ * If all the values in the column are INTEGER (or UNDEFINED), the column is
+ * stored as a contiguous array of flex_int, and if all the values are FLOAT
+ * (or UNDEFINED), as a contiguous array of flex_float. String columns read
+ * from dictionary encoded blocks (see \ref column_dictionary) are stored as
+ * a contiguous array of codes into the dictionary. UNDEFINED values are
+ * tracked with a validity bitmap (which is empty if all values are defined);
+ * the contents of the array at an UNDEFINED position are 0.
+ *
+ * All other columns fall back to the flexible_type representation, in which
+ * case \ref type() returns UNDEFINED and \ref flexible_data() should be used.
+ *
+ * The packed arrays allow numeric kernels to iterate over cache-dense data
+ * without a type switch per value, and are amenable to auto-vectorization.
+ *
+ * The contents of a typed_column are immutable: copies are cheap as they
+ * share the values.
+ *
+ * \code
+ * typed_column col(rows.cget_columns()[0]);
+ * if (col.type() == flex_type_enum::INTEGER) {
+ *   const flex_int* data = col.int_data();
+ *   for (size_t i = 0;i < col.size(); ++i) {
+ *     if (col.is_defined(i)) ... data[i] ...
+ *   }
+ * }
+ * \endcode
+ */
+class typed_column {
+ public:
+  typedef std::shared_ptr<const std::vector<flexible_type> > flexible_column_ptr;
+
+  /// Constructs an empty column
+  typed_column() = default;
+
+  /**
+   * Constructs a typed column from a column of flexible_type.
+   * The values are packed if possible; otherwise a reference to the
+   * column is kept.
+   */
+  explicit typed_column(const flexible_column_ptr& column);
+
+  /**
+   * Constructs an integer column. validity is either empty (all values
+   * are defined) or a bitmap as returned by \ref validity().
+   */
+  typed_column(std::vector<flex_int>&& values,
+               std::vector<uint64_t>&& validity = std::vector<uint64_t>());
+
+  /**
+   * Constructs a float column. validity is either empty (all values
+   * are defined) or a bitmap as returned by \ref validity().
+   */
+  typed_column(std::vector<flex_float>&& values,
+               std::vector<uint64_t>&& validity = std::vector<uint64_t>());
+
+  /**
+   * Constructs a string column of codes: value i is
+   * dictionary->value(codes[i]). validity is either empty (all values are
+   * defined) or a bitmap as returned by \ref validity().
+   */
+  typed_column(std::vector<uint32_t>&& codes,
+               std::shared_ptr<const column_dictionary> dictionary,
+               std::vector<uint64_t>&& validity = std::vector<uint64_t>());
+
+  /**
+   * Returns INTEGER, FLOAT or STRING if the column is packed, and UNDEFINED
+   * if the column uses the flexible_type representation.
+   */
+  inline flex_type_enum type() const {
+    return m_type;
+  }
+
+  /// Returns true if the column is packed.
+  inline bool is_packed() const {
+    return m_type != flex_type_enum::UNDEFINED;
+  }
+
+  /// Returns the number of values in the column
+  inline size_t size() const {
+    return m_size;
+  }
+
+  /// Returns the packed integer values. Only valid if type() == INTEGER.
+  inline const flex_int* int_data() const {
+    return m_ints->data();
+  }
+
+  /// Returns the packed float values. Only valid if type() == FLOAT.
+  inline const flex_float* float_data() const {
+    return m_floats->data();
+  }
+
+  /// Returns the string codes. Only valid if type() == STRING.
+  inline const uint32_t* code_data() const {
+    return m_codes->data();
+  }
+
+  /// Returns the dictionary of the string codes. Only valid if type() == STRING.
+  inline const std::shared_ptr<const column_dictionary>& dictionary() const {
+    return m_dictionary;
+  }
+
+  /// Returns the original values. Only valid if the column is not packed.
+  inline const std::vector<flexible_type>& flexible_data() const {
+    return *m_flexible;
+  }
+
+  /// Returns true if no value in a packed column is UNDEFINED.
+  inline bool all_defined() const {
+    return !m_validity || m_validity->empty();
+  }
+
+  /**
+   * Returns the validity bitmap of a packed column. Bit (i % 64) of word
+   * (i / 64) is set if value i is defined. Empty if all values are defined.
+   */
+  inline const std::vector<uint64_t>& validity() const {
+    static const std::vector<uint64_t> all_defined_validity;
+    return m_validity ? *m_validity : all_defined_validity;
+  }
+
+  /// Returns true if value i of a packed column is defined.
+  inline bool is_defined(size_t i) const {
+    return all_defined() || ((*m_validity)[i / 64] >> (i % 64)) & 1;
+  }
+
+  /**
+   * Returns the value at position i as a flexible_type. Works for both
+   * representations, but is slow. Use the packed arrays whenever possible.
+   */
+  flexible_type at(size_t i) const;
+
+  /**
+   * Converts the column to a flexible_type column, writing into out.
+   */
+  void to_flexible(std::vector<flexible_type>& out) const;
+
+  /**
+   * Returns a bitmap of n values with all bits cleared, in the layout of
+   * \ref validity().
+   */
+  static std::vector<uint64_t> make_validity(size_t n) {
+    return std::vector<uint64_t>((n + 63) / 64, 0);
+  }
+
+  /// Marks value i as defined in a bitmap created with \ref make_validity
+  static inline void set_defined(std::vector<uint64_t>& validity, size_t i) {
+    validity[i / 64] |= (uint64_t(1) << (i % 64));
+  }
+
+ private:
+  flex_type_enum m_type = flex_type_enum::UNDEFINED;
+  size_t m_size = 0;
+  std::shared_ptr<const std::vector<flex_int> > m_ints;
+  std::shared_ptr<const std::vector<flex_float> > m_floats;
+  std::shared_ptr<const std::vector<uint32_t> > m_codes;
+  std::shared_ptr<const column_dictionary> m_dictionary;
+  std::shared_ptr<const std::vector<uint64_t> > m_validity;
+  flexible_column_ptr m_flexible;
+};
+
+} // namespace graphlab
+#endif
@@ -22,14 +22,15 @@
 namespace graphlab {
 namespace query_eval {
 
-std::shared_ptr<sframe> 
-    groupby_aggregate(
-      const std::shared_ptr<planner_node>& source,
+void groupby_aggregate_output_schema(
       const std::vector<std::string>& source_column_names,
+      const std::vector<flex_type_enum>& source_types,
       const std::vector<std::string>& keys,
       const std::vector<std::string>& output_column_names,
       const std::vector<std::pair<std::vector<std::string>,
-                                  std::shared_ptr<group_aggregate_value>>>& groups) {
+                                  std::shared_ptr<group_aggregate_value>>>& groups,
+      std::vector<std::string>& column_names,
+      std::vector<flex_type_enum>& column_types) {
   // first, sanity checks
   // check that group keys exist
   if (output_column_names.size() != groups.size()) {
@@ -56,7 +57,6 @@ std::shared_ptr<sframe>
   for (size_t i = 0;i < source_column_names.size(); ++i) {
     source_column_to_index[source_column_names[i]] = i;
   }
-  auto source_types = infer_planner_node_type(source);
   ASSERT_EQ(source_column_names.size(), source_column_to_index.size());
   ASSERT_EQ(source_types.size(), source_column_names.size());
 
@@ -90,43 +90,13 @@ std::shared_ptr<sframe>
   }
 
   // key should not have repeated columns
-  std::set<std::string> key_columns;
-  std::set<std::string> group_columns;
-  for (const auto& key: keys) key_columns.insert(key);
-  for (const auto& group: groups) {
-    for(auto& col_name : group.first) {
-      group_columns.insert(col_name);
-    }
-  }
+  std::set<std::string> key_columns(keys.begin(), keys.end());
   if (key_columns.size() != keys.size()) {
       log_and_throw("Group by key cannot have repeated column names");
   }
 
-  // ok. select out just the columns I care about
-  // begin with the key columns
-  std::vector<std::string> relevant_column_names(key_columns.begin(), key_columns.end());
-  // then all the group columns (as long as they are not also key columns)
-  for (const auto& group_column: group_columns) {
-    if (group_column != "" && key_columns.count(group_column) == 0) {
-      relevant_column_names.push_back(group_column);
-    }
-  }
-  // column name to column number of the frame_with_relevant_cols
-  std::map<std::string, size_t> relevant_column_to_index;
-  // which columns from source SFrame to project over to this SFrame
-  std::vector<size_t> relevant_source_indices(relevant_column_names.size());
-  for (size_t i = 0;i < relevant_column_names.size(); ++i) {
-    relevant_source_indices[i] = source_column_to_index.at(relevant_column_names[i]);
-    relevant_column_to_index[relevant_column_names[i]] = i;
-  }
-  auto frame_with_relevant_cols = op_project::make_planner_node(source, 
-                                                                relevant_source_indices);
-
-
-  // prepare the output frame
-  auto output = std::make_shared<sframe>();;
-  std::vector<std::string> column_names;
-  std::vector<flex_type_enum> column_types;
+  column_names.clear();
+  column_types.clear();
   // output frame has the key column name and types
   for (const auto& key: key_columns) {
     column_names.push_back(key);
@@ -175,6 +145,59 @@ std::shared_ptr<sframe>
     auto output_type = group.second->set_input_types(input_types);
     column_types.push_back(output_type);
   }
+}
+
+std::shared_ptr<sframe> 
+    groupby_aggregate(
+      const std::shared_ptr<planner_node>& source,
+      const std::vector<std::string>& source_column_names,
+      const std::vector<std::string>& keys,
+      const std::vector<std::string>& output_column_names,
+      const std::vector<std::pair<std::vector<std::string>,
+                                  std::shared_ptr<group_aggregate_value>>>& groups) {
+  auto source_types = infer_planner_node_type(source);
+
+  // validate and prepare the output frame
+  std::vector<std::string> column_names;
+  std::vector<flex_type_enum> column_types;
+  groupby_aggregate_output_schema(source_column_names, source_types, keys,
+                                  output_column_names, groups,
+                                  column_names, column_types);
+
+  std::map<std::string, size_t> source_column_to_index;
+  for (size_t i = 0;i < source_column_names.size(); ++i) {
+    source_column_to_index[source_column_names[i]] = i;
+  }
+
+  std::set<std::string> key_columns(keys.begin(), keys.end());
+  std::set<std::string> group_columns;
+  for (const auto& group: groups) {
+    for(auto& col_name : group.first) {
+      group_columns.insert(col_name);
+    }
+  }
+
+  // ok. select out just the columns I care about
+  // begin with the key columns
+  std::vector<std::string> relevant_column_names(key_columns.begin(), key_columns.end());
+  // then all the group columns (as long as they are not also key columns)
+  for (const auto& group_column: group_columns) {
+    if (group_column != "" && key_columns.count(group_column) == 0) {
+      relevant_column_names.push_back(group_column);
+    }
+  }
+  // column name to column number of the frame_with_relevant_cols
+  std::map<std::string, size_t> relevant_column_to_index;
+  // which columns from source SFrame to project over to this SFrame
+  std::vector<size_t> relevant_source_indices(relevant_column_names.size());
+  for (size_t i = 0;i < relevant_column_names.size(); ++i) {
+    relevant_source_indices[i] = source_column_to_index.at(relevant_column_names[i]);
+    relevant_column_to_index[relevant_column_names[i]] = i;
+  }
+  auto frame_with_relevant_cols = op_project::make_planner_node(source, 
+                                                                relevant_source_indices);
+
+  auto output = std::make_shared<sframe>();;
 
   size_t nsegments = thread::cpu_count() * std::max<size_t>(1, log2(thread::cpu_count()));
 
@@ -209,9 +232,7 @@ std::shared_ptr<sframe>
                         [&](size_t segmentid, 
                             const std::shared_ptr<sframe_rows>& rows)->bool {
                           if (rows == nullptr) return true;
-                          for (auto& row: *rows) {
-                            container.add(row, num_keys);
-                          }
+                          container.add(*rows, num_keys);
                           return false;
                         },
                         thread::cpu_count());
@@ -5,8 +5,8 @@
  * This software may be modified and distributed under the terms
  * of the BSD license. See the LICENSE file for details.
  */
-#ifndef GRAPHLAB_SFRAME_QUERY_ENGINE_HPP
-#define GRAPHLAB_SFRAME_QUERY_ENGINE_HPP
+#ifndef GRAPHLAB_SFRAME_QUERY_ENGINE_GROUPBY_AGGREGATE_HPP
+#define GRAPHLAB_SFRAME_QUERY_ENGINE_GROUPBY_AGGREGATE_HPP
 #include <vector>
 #include <string>
 #include <utility>
@@ -17,6 +17,25 @@ namespace graphlab {
 class sframe;
 namespace query_eval {
 class planner_node;
+
+/**
+ * Validates the arguments of \ref groupby_aggregate and computes the names 
+ * and types of its output columns, without performing the aggregation.
+ * Throws on invalid arguments.
+ *
+ * The key columns come first in sorted order, followed by one column per 
+ * group. Empty output column names are given a generated unique name.
+ */
+void groupby_aggregate_output_schema(
+      const std::vector<std::string>& source_column_names,
+      const std::vector<flex_type_enum>& source_types,
+      const std::vector<std::string>& keys,
+      const std::vector<std::string>& output_column_names,
+      const std::vector<std::pair<std::vector<std::string>,
+                                  std::shared_ptr<group_aggregate_value>>>& groups,
+      std::vector<std::string>& column_names,
+      std::vector<flex_type_enum>& column_types);
+
 std::shared_ptr<sframe> groupby_aggregate(
       const std::shared_ptr<planner_node>& source,
       const std::vector<std::string>& source_column_names,
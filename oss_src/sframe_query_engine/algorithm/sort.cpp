@@ -275,6 +275,21 @@ std::shared_ptr<sframe> sort_sframe_in_memory(
   return ret;
 }
 
+void check_sort_column_types(const std::vector<flex_type_enum>& column_types,
+                             const std::vector<size_t>& sort_column_indices) {
+  std::vector<flex_type_enum> supported_types =
+      {flex_type_enum::STRING, flex_type_enum::INTEGER, flex_type_enum::FLOAT,flex_type_enum::DATETIME};
+  std::set<flex_type_enum> supported_type_set(supported_types.begin(), supported_types.end());
+
+  for(auto column_index: sort_column_indices) {
+    auto col_type = column_types[column_index];
+    if (supported_type_set.count(col_type) == 0) {
+      auto msg = std::string("Only column with type 'int', 'float', 'string', and 'datetime' can be sorted. Found column type: ") + flex_type_enum_to_name(col_type);
+      log_and_throw(msg);
+    }
+  }
+}
+
 /**
  * Main implementation of the top level sort API.
  */
@@ -315,18 +330,7 @@ std::shared_ptr<sframe> sort(
     num_rows = infer_planner_node_length(key_columns);
   }
 
-  // get sort column indices from column names and also check column types
-  std::vector<flex_type_enum> supported_types =
-      {flex_type_enum::STRING, flex_type_enum::INTEGER, flex_type_enum::FLOAT,flex_type_enum::DATETIME};
-  std::set<flex_type_enum> supported_type_set(supported_types.begin(), supported_types.end());
-
-  for(auto column_index: sort_column_indices) {
-    auto col_type = column_types[column_index];
-    if (supported_type_set.count(col_type) == 0) {
-      auto msg = std::string("Only column with type 'int', 'float', 'string', and 'datetime' can be sorted. Found column type: ") + flex_type_enum_to_name(col_type);
-      log_and_throw(msg);
-    }
-  }
+  check_sort_column_types(column_types, sort_column_indices);
 
   // TODO: Estimate the size of the sframe so that we could decide number of
   // chunks. To account for strings, we estimate each cell is 64 bytes.
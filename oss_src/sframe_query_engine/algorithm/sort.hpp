@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <memory>
+#include <flexible_type/flexible_type.hpp>
 
 namespace graphlab {
 
@@ -19,6 +20,13 @@ namespace query_eval {
 
 class planner_node;
 
+/**
+ * Throws if any of the sort columns has a type which cannot be sorted.
+ * Only 'int', 'float', 'string' and 'datetime' columns can be sorted.
+ */
+void check_sort_column_types(const std::vector<flex_type_enum>& column_types,
+                             const std::vector<size_t>& sort_column_indices);
+
 /**
  * Sort given SFrame.
  *
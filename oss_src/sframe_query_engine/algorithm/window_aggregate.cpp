@@ -0,0 +1,273 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <cmath>
+#include <algorithm>
+#include <logger/logger.hpp>
+#include <sframe/rolling_aggregate.hpp>
+#include <sframe_query_engine/algorithm/window_aggregate.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+namespace {
+
+/// Converts a value of the order column to a number, returning false if missing
+bool order_value(const flexible_type& v, double& ret) {
+  switch(v.get_type()) {
+    case flex_type_enum::INTEGER:
+      ret = v.get<flex_int>();
+      return true;
+    case flex_type_enum::FLOAT:
+      ret = v.get<flex_float>();
+      return true;
+    case flex_type_enum::DATETIME:
+      ret = v.get<flex_date_time>().microsecond_res_timestamp();
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// Equality of key values, where missing values are equal to each other
+bool same_key_value(const flexible_type& a, const flexible_type& b) {
+  return a.get_type() == b.get_type() &&
+      (a.get_type() == flex_type_enum::UNDEFINED || a == b);
+}
+
+} // anonymous namespace
+
+/**
+ * The window of a single partition. Rows are added in order; a row is
+ * written out (with its aggregate) as soon as a row past the end of its
+ * window has been added, or when the partition is finished.
+ *
+ * The rows held are the ones from the start of the window of the oldest
+ * row not yet written, up to the newest row added. Rows are identified by
+ * their position in the partition.
+ */
+class partition_window {
+ public:
+  partition_window(size_t order_column, size_t value_column,
+                   const std::shared_ptr<group_aggregate_value>& aggregator,
+                   flex_type_enum value_type,
+                   double range_start, double range_end)
+      : m_order_column(order_column), m_value_column(value_column),
+        m_aggregator(aggregator),
+        m_incremental(rolling_aggregate::make_window_aggregate(*aggregator, value_type)),
+        m_range_start(range_start), m_range_end(range_end) { }
+
+  /// Adds the next row, appending the rows whose window is complete to out.
+  void add(std::vector<flexible_type>&& row,
+           std::vector<std::vector<flexible_type> >& out) {
+    entry e;
+    e.has_time = order_value(row[m_order_column], e.time);
+    if (e.has_time) {
+      if (m_has_last_time && e.time < m_last_time) {
+        log_and_throw("window_aggregate: the input is not sorted by the order column");
+      }
+      m_has_last_time = true;
+      m_last_time = e.time;
+    }
+    e.value = row[m_value_column];
+    e.row = std::move(row);
+    m_rows.push_back(std::move(e));
+    if (m_rows.back().has_time) write_ready_rows(false, out);
+  }
+
+  /// Appends all the remaining rows to out, and starts a new partition.
+  void finish(std::vector<std::vector<flexible_type> >& out) {
+    write_ready_rows(true, out);
+    m_rows.clear();
+    m_first = m_lo = m_hi = m_next_output = 0;
+    m_has_last_time = false;
+    m_num_removed = 0;
+    if (m_incremental) m_incremental->clear();
+  }
+
+ private:
+  struct entry {
+    double time = 0;
+    bool has_time = false;
+    flexible_type value;
+    std::vector<flexible_type> row;
+  };
+
+  entry& at(size_t position) { return m_rows[position - m_first]; }
+
+  size_t end_position() const { return m_first + m_rows.size(); }
+
+  /**
+   * Appends the rows whose window is complete to out, which are all the
+   * remaining rows if finished is true.
+   */
+  void write_ready_rows(bool finished, std::vector<std::vector<flexible_type> >& out) {
+    while (m_next_output < end_position()) {
+      entry& e = at(m_next_output);
+      flexible_type result = FLEX_UNDEFINED;
+      if (e.has_time) {
+        if (!finished && !(e.time + m_range_end < m_last_time)) break;
+        advance_window(e.time + m_range_start, e.time + m_range_end);
+        result = window_result();
+      }
+      e.row.push_back(std::move(result));
+      out.push_back(std::move(e.row));
+      ++m_next_output;
+    }
+    // drop the rows which are neither in a window nor waiting to be written
+    while (m_first < std::min(m_lo, m_next_output)) {
+      m_rows.pop_front();
+      ++m_first;
+    }
+  }
+
+  /// Moves the window to the rows with order values in [lower, upper]
+  void advance_window(double lower, double upper) {
+    while (m_hi < end_position() &&
+           (!at(m_hi).has_time || at(m_hi).time <= upper)) {
+      if (at(m_hi).has_time && m_incremental) m_incremental->add(at(m_hi).value);
+      ++m_hi;
+    }
+    while (m_lo < m_hi &&
+           (!at(m_lo).has_time || at(m_lo).time < lower)) {
+      if (at(m_lo).has_time && m_incremental) {
+        m_incremental->remove(at(m_lo).value);
+        ++m_num_removed;
+      }
+      ++m_lo;
+    }
+    // Rebuild the incremental state once in a while so that floating
+    // point errors do not accumulate.
+    if (m_incremental && m_num_removed > std::max<size_t>(m_hi - m_lo, 1024)) {
+      m_incremental->clear();
+      for (size_t i = m_lo; i < m_hi; ++i) {
+        if (at(i).has_time) m_incremental->add(at(i).value);
+      }
+      m_num_removed = 0;
+    }
+  }
+
+  flexible_type window_result() {
+    if (m_incremental) return m_incremental->emit();
+    std::unique_ptr<group_aggregate_value> agg(m_aggregator->new_instance());
+    for (size_t i = m_lo; i < m_hi; ++i) {
+      if (at(i).has_time) agg->add_element_simple(at(i).value);
+    }
+    agg->partial_finalize();
+    return agg->emit();
+  }
+
+  size_t m_order_column;
+  size_t m_value_column;
+  std::shared_ptr<group_aggregate_value> m_aggregator;
+  std::unique_ptr<rolling_aggregate::window_aggregate> m_incremental;
+  double m_range_start;
+  double m_range_end;
+
+  std::deque<entry> m_rows;
+  /// position of m_rows.front()
+  size_t m_first = 0;
+  /// the window is the rows in positions [m_lo, m_hi)
+  size_t m_lo = 0;
+  size_t m_hi = 0;
+  /// position of the next row to write out
+  size_t m_next_output = 0;
+  bool m_has_last_time = false;
+  double m_last_time = 0;
+  size_t m_num_removed = 0;
+};
+
+
+flex_type_enum window_aggregate_output_type(
+      const std::vector<std::string>& source_column_names,
+      const std::vector<flex_type_enum>& source_types,
+      const std::vector<std::string>& keys,
+      const std::string& order_column,
+      const std::string& value_column,
+      const std::shared_ptr<group_aggregate_value>& aggregator,
+      double range_start,
+      double range_end) {
+  auto column_index = [&](const std::string& name)->size_t {
+    auto it = std::find(source_column_names.begin(), source_column_names.end(), name);
+    if (it == source_column_names.end()) {
+      log_and_throw("Column " + name + " does not exist.");
+    }
+    return it - source_column_names.begin();
+  };
+
+  std::set<std::string> unique_keys(keys.begin(), keys.end());
+  if (unique_keys.size() != keys.size()) {
+    log_and_throw("Partition columns must be unique.");
+  }
+  for (const auto& key: keys) column_index(key);
+
+  flex_type_enum order_type = source_types.at(column_index(order_column));
+  if (order_type != flex_type_enum::INTEGER &&
+      order_type != flex_type_enum::FLOAT &&
+      order_type != flex_type_enum::DATETIME) {
+    log_and_throw("The order column " + order_column +
+                  " must be of type int, float or datetime.");
+  }
+
+  if (!std::isfinite(range_start) || !std::isfinite(range_end)) {
+    log_and_throw("The window range must be finite.");
+  }
+  if (range_start > range_end) {
+    log_and_throw("The window start must not be after the window end.");
+  }
+
+  if (aggregator == nullptr) log_and_throw("No aggregator given.");
+  flex_type_enum value_type = source_types.at(column_index(value_column));
+  if (!aggregator->support_type(value_type)) {
+    log_and_throw("Cannot perform " + aggregator->name() +
+                  " aggregation on column " + value_column + " of type " +
+                  flex_type_enum_to_name(value_type));
+  }
+  return aggregator->set_input_type(value_type);
+}
+
+window_aggregate_stream::window_aggregate_stream(
+      const std::vector<size_t>& key_columns,
+      size_t order_column,
+      size_t value_column,
+      const std::shared_ptr<group_aggregate_value>& aggregator,
+      flex_type_enum value_type,
+      double range_start,
+      double range_end)
+    : m_key_columns(key_columns),
+      m_window(new partition_window(order_column, value_column, aggregator, value_type,
+                                    range_start, range_end)) { }
+
+window_aggregate_stream::~window_aggregate_stream() { }
+
+void window_aggregate_stream::add(std::vector<flexible_type>&& row,
+                                  std::vector<std::vector<flexible_type> >& out) {
+  bool new_partition = !m_started;
+  for (size_t i = 0; i < m_key_columns.size() && !new_partition; ++i) {
+    new_partition = !same_key_value(row[m_key_columns[i]], m_current_key[i]);
+  }
+  if (new_partition) {
+    if (m_started) m_window->finish(out);
+    m_started = true;
+    m_current_key.clear();
+    for (size_t c: m_key_columns) m_current_key.push_back(row[c]);
+  }
+  m_window->add(std::move(row), out);
+}
+
+void window_aggregate_stream::finish(std::vector<std::vector<flexible_type> >& out) {
+  m_window->finish(out);
+  m_started = false;
+  m_current_key.clear();
+}
+
+} // query_eval
+} // end of graphlab
@@ -0,0 +1,100 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_ENGINE_WINDOW_AGGREGATE_HPP
+#define GRAPHLAB_SFRAME_QUERY_ENGINE_WINDOW_AGGREGATE_HPP
+#include <vector>
+#include <string>
+#include <memory>
+#include <sframe/group_aggregate_value.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * Validates the arguments of a window aggregate (see
+ * \ref window_aggregate_stream) and returns the type of the aggregate
+ * column. Throws on invalid arguments.
+ *
+ * The order column must be an integer, float or datetime column (datetimes
+ * are compared in seconds), and range_start must not be greater than
+ * range_end.
+ */
+flex_type_enum window_aggregate_output_type(
+      const std::vector<std::string>& source_column_names,
+      const std::vector<flex_type_enum>& source_types,
+      const std::vector<std::string>& keys,
+      const std::string& order_column,
+      const std::string& value_column,
+      const std::shared_ptr<group_aggregate_value>& aggregator,
+      double range_start,
+      double range_end);
+
+class partition_window;
+
+/**
+ * Computes, for every row, the aggregate of the values of the rows of the
+ * same partition whose order value lies in a range relative to the order
+ * value of the row:
+ *
+ * \code
+ * SELECT *, aggregator(value) OVER (PARTITION BY keys ORDER BY order
+ *                                   RANGE BETWEEN range_start AND range_end)
+ * \endcode
+ *
+ * The rows are added in order, and must be sorted by the key columns, then
+ * by the order column; a row out of order throws. Every row is output, in
+ * the order it was added, followed by its aggregate, as soon as a row past
+ * the end of its window has been added. Rows with a missing order value are
+ * not part of any window, and have a missing aggregate.
+ *
+ * Only the rows of the current partition between the start of the window
+ * of the oldest row not yet output and the newest row added are held.
+ */
+class window_aggregate_stream {
+ public:
+  /**
+   * \param key_columns The indices of the partition columns in the rows
+   * \param order_column The index of the order column in the rows
+   * \param value_column The index of the aggregated column in the rows
+   * \param aggregator The aggregator, after set_input_type() was called
+   * \param value_type The type of the aggregated column
+   * \param range_start The start of the window relative to the order value
+   *                    of the row, inclusive
+   * \param range_end The end of the window relative to the order value of
+   *                  the row, inclusive
+   */
+  window_aggregate_stream(const std::vector<size_t>& key_columns,
+                          size_t order_column,
+                          size_t value_column,
+                          const std::shared_ptr<group_aggregate_value>& aggregator,
+                          flex_type_enum value_type,
+                          double range_start,
+                          double range_end);
+
+  ~window_aggregate_stream();
+
+  /**
+   * Adds the next row, appending the rows whose aggregate is known to out.
+   */
+  void add(std::vector<flexible_type>&& row,
+           std::vector<std::vector<flexible_type> >& out);
+
+  /**
+   * Appends all the remaining rows to out, at the end of the input.
+   */
+  void finish(std::vector<std::vector<flexible_type> >& out);
+
+ private:
+  std::vector<size_t> m_key_columns;
+  std::vector<flexible_type> m_current_key;
+  bool m_started = false;
+  std::unique_ptr<partition_window> m_window;
+};
+} // namespace query_eval
+} // namespace graphlab
+#endif
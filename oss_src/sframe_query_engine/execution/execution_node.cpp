@@ -181,8 +181,17 @@ std::shared_ptr<sframe_rows> execution_node::get_next(size_t consumer_id, bool s
   DASSERT_LT(consumer_id, m_consumer_pos.size());
 
   // consume from source when queue is empty and there is more in source
-  while (m_output_queue->empty(consumer_id) && m_source) {
-    m_source();
+  if (m_counters) {
+    // the time spent in the inputs is removed by get_next_from_input
+    profile_clock start = profile_clock::now();
+    while (m_output_queue->empty(consumer_id) && m_source) {
+      m_source();
+    }
+    m_counters->add_interval(start, profile_clock::now());
+  } else {
+    while (m_output_queue->empty(consumer_id) && m_source) {
+      m_source();
+    }
   }
   // end of data
   if (m_output_queue->empty(consumer_id) && !m_source) return nullptr;
@@ -198,15 +207,35 @@ std::shared_ptr<sframe_rows> execution_node::get_next(size_t consumer_id, bool s
 }
 
 void execution_node::add_operator_output(const std::shared_ptr<sframe_rows>& rows) {
+  if (m_counters && rows) m_counters->rows_out += rows->num_rows();
   m_output_queue->push(rows);
 }
 
 std::shared_ptr<sframe_rows> execution_node::get_next_from_input(size_t input_id, bool skip) {
   ASSERT_LT(input_id, m_inputs.size());
   auto& input = m_inputs[input_id];
+  if (m_counters) {
+    profile_clock start = profile_clock::now();
+    auto ret = input.m_node->get_next(input.m_consumer_id, skip);
+    m_counters->add_interval(start, profile_clock::now(), -1);
+    if (ret) m_counters->rows_in += ret->num_rows();
+    return ret;
+  }
   return input.m_node->get_next(input.m_consumer_id, skip);
 }
 
+void execution_node::enable_profiling() {
+  m_counters.reset(new operator_counters);
+  m_counters->num_instances = 1;
+}
+
+operator_counters execution_node::get_counters() const {
+  operator_counters ret;
+  if (m_counters) ret = *m_counters;
+  if (m_output_queue) ret.bytes_spilled = m_output_queue->num_bytes_spilled();
+  return ret;
+}
+
 size_t execution_node::register_consumer() {
   m_consumer_pos.push_back(0);
   return m_consumer_pos.size() - 1;
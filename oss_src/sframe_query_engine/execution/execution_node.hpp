@@ -15,6 +15,7 @@
 #include <flexible_type/flexible_type.hpp>
 #include <sframe_query_engine/operators/operator.hpp>
 #include <sframe_query_engine/util/broadcast_queue.hpp>
+#include <sframe_query_engine/execution/query_profile.hpp>
 
 namespace graphlab { 
 class sframe_rows;
@@ -214,6 +215,18 @@ class execution_node  : public std::enable_shared_from_this<execution_node> {
   std::exception_ptr get_exception() const {
     return m_exception;
   }
+
+  /**
+   * Starts counting the rows, time and blocks read of the operator (see
+   * \ref operator_counters). Must be called before the node is executed.
+   */
+  void enable_profiling();
+
+  /**
+   * Returns the counters of the operator, all zero if profiling was not
+   * enabled.
+   */
+  operator_counters get_counters() const;
  private:
   /**
    * Internal function used to add to the operator output
@@ -260,6 +273,9 @@ class execution_node  : public std::enable_shared_from_this<execution_node> {
   bool m_exception_occured = false;
   std::exception_ptr m_exception;
 
+  /// The operator counters. nullptr if profiling is not enabled.
+  std::unique_ptr<operator_counters> m_counters;
+
   friend class query_context;
 };
 
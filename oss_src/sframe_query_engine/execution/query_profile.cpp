@@ -0,0 +1,161 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <time.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <iomanip>
+#include <sframe/sarray_v2_block_manager.hpp>
+#include <sframe_query_engine/execution/query_profile.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+static const char* PROFILE_ID = "__profile_id__";
+
+profile_clock profile_clock::now() {
+  profile_clock ret;
+  ret.wall_time = std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    ret.cpu_time = ts.tv_sec + ts.tv_nsec * 1e-9;
+  }
+  ret.blocks_read = v2_block_impl::block_manager::thread_num_blocks_read();
+  ret.bytes_read = v2_block_impl::block_manager::thread_num_bytes_read();
+  return ret;
+}
+
+void operator_counters::add_interval(const profile_clock& start,
+                                     const profile_clock& end,
+                                     int sign) {
+  if (sign >= 0) {
+    wall_time += end.wall_time - start.wall_time;
+    cpu_time += end.cpu_time - start.cpu_time;
+    blocks_read += end.blocks_read - start.blocks_read;
+    bytes_read += end.bytes_read - start.bytes_read;
+  } else {
+    wall_time -= end.wall_time - start.wall_time;
+    cpu_time -= end.cpu_time - start.cpu_time;
+    blocks_read -= end.blocks_read - start.blocks_read;
+    bytes_read -= end.bytes_read - start.bytes_read;
+  }
+}
+
+void operator_counters::add(const operator_counters& other) {
+  num_instances += other.num_instances;
+  rows_in += other.rows_in;
+  rows_out += other.rows_out;
+  wall_time += other.wall_time;
+  cpu_time += other.cpu_time;
+  blocks_read += other.blocks_read;
+  bytes_read += other.bytes_read;
+  bytes_spilled += other.bytes_spilled;
+}
+
+size_t query_profile::begin_stage(const std::shared_ptr<planner_node>& plan,
+                                  const std::string& description) {
+  std::lock_guard<mutex> guard(m_lock);
+  stage_info stage;
+  stage.description = description;
+
+  // number the nodes, output first
+  std::map<const planner_node*, size_t> ids;
+  std::function<size_t(const std::shared_ptr<planner_node>&)> assign_ids =
+      [&](const std::shared_ptr<planner_node>& n)->size_t {
+        auto iter = ids.find(n.get());
+        if (iter != ids.end()) return iter->second;
+        size_t id = m_operators.size();
+        ids[n.get()] = id;
+        m_operators.emplace_back();
+        m_operators[id].name = planner_node_type_to_name(n->operator_type);
+        n->any_operator_parameters[PROFILE_ID] = id;
+        stage.operators.push_back(id);
+        std::vector<size_t> inputs;
+        for (const auto& input: n->inputs) inputs.push_back(assign_ids(input));
+        m_operators[id].inputs = inputs;
+        return id;
+      };
+  if (plan) assign_ids(plan);
+
+  m_stages.push_back(stage);
+  return m_stages.size() - 1;
+}
+
+void query_profile::end_stage(size_t stage_id, double wall_time) {
+  std::lock_guard<mutex> guard(m_lock);
+  ASSERT_LT(stage_id, m_stages.size());
+  auto& stage = m_stages[stage_id];
+  stage.wall_time = wall_time;
+  if (!stage.operators.empty()) {
+    stage.rows_out = m_operators[stage.operators[0]].counters.rows_out;
+  }
+}
+
+void query_profile::add_stage(const std::string& description,
+                              double wall_time, size_t rows_out) {
+  std::lock_guard<mutex> guard(m_lock);
+  stage_info stage;
+  stage.description = description;
+  stage.wall_time = wall_time;
+  stage.rows_out = rows_out;
+  m_stages.push_back(stage);
+}
+
+void query_profile::add_counters(const std::shared_ptr<planner_node>& pnode,
+                                 const operator_counters& counters) {
+  auto iter = pnode->any_operator_parameters.find(PROFILE_ID);
+  if (iter == pnode->any_operator_parameters.end()) return;
+  size_t id = iter->second.as<size_t>();
+  std::lock_guard<mutex> guard(m_lock);
+  if (id < m_operators.size()) m_operators[id].counters.add(counters);
+}
+
+std::vector<query_profile::stage_info> query_profile::stages() const {
+  std::lock_guard<mutex> guard(m_lock);
+  return m_stages;
+}
+
+query_profile::operator_info query_profile::get_operator(size_t operator_id) const {
+  std::lock_guard<mutex> guard(m_lock);
+  ASSERT_LT(operator_id, m_operators.size());
+  return m_operators[operator_id];
+}
+
+std::string query_profile::to_string() const {
+  std::lock_guard<mutex> guard(m_lock);
+  std::stringstream strm;
+  strm << std::fixed << std::setprecision(3);
+
+  std::function<void(size_t, size_t)> print_operator =
+      [&](size_t id, size_t depth) {
+        const auto& op = m_operators[id];
+        const auto& c = op.counters;
+        strm << std::string(2 * depth + 2, ' ') << "-> " << op.name
+             << " (rows in=" << c.rows_in << " out=" << c.rows_out
+             << ", time=" << c.wall_time << "s cpu=" << c.cpu_time << "s"
+             << ", blocks=" << c.blocks_read << " bytes=" << c.bytes_read;
+        if (c.bytes_spilled) strm << ", spilled=" << c.bytes_spilled;
+        strm << ", instances=" << c.num_instances << ")\n";
+        for (size_t input: op.inputs) print_operator(input, depth + 1);
+      };
+
+  for (size_t i = 0; i < m_stages.size(); ++i) {
+    const auto& stage = m_stages[i];
+    strm << "Stage " << i << ": " << stage.description
+         << " (time=" << stage.wall_time << "s, rows=" << stage.rows_out << ")\n";
+    if (!stage.operators.empty()) print_operator(stage.operators[0], 0);
+  }
+  return strm.str();
+}
+
+} // namespace query_eval
+} // namespace graphlab
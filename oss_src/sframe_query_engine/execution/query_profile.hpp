@@ -0,0 +1,163 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_ENGINE_EXECUTION_QUERY_PROFILE_HPP
+#define GRAPHLAB_SFRAME_QUERY_ENGINE_EXECUTION_QUERY_PROFILE_HPP
+#include <string>
+#include <vector>
+#include <memory>
+#include <parallel/mutex.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+struct planner_node;
+
+/**
+ * \ingroup sframe_query_engine
+ *
+ * A point in time of the calling thread: its wall and CPU clocks, and the
+ * number of blocks it read from the block manager.
+ */
+struct profile_clock {
+  double wall_time = 0;
+  double cpu_time = 0;
+  size_t blocks_read = 0;
+  size_t bytes_read = 0;
+
+  /// Returns the current point in time of the calling thread
+  static profile_clock now();
+};
+
+/**
+ * The counters of an operator of a query plan, accumulated over all the
+ * execution nodes running it (one per morsel, see subplan_executor.hpp).
+ *
+ * The times and block reads exclude the time spent, and blocks read, in
+ * the inputs of the operator. The wall times of the execution nodes
+ * running in parallel are added up.
+ */
+struct operator_counters {
+  /// The number of execution nodes which ran the operator
+  size_t num_instances = 0;
+  /// The number of rows read from the inputs, and output
+  size_t rows_in = 0;
+  size_t rows_out = 0;
+  /// Wall and CPU time, in seconds
+  double wall_time = 0;
+  double cpu_time = 0;
+  /// The blocks, and their stored size, read from the block manager
+  size_t blocks_read = 0;
+  size_t bytes_read = 0;
+  /// The bytes of output written to disk because consumers lagged behind
+  size_t bytes_spilled = 0;
+
+  /**
+   * Adds the resources used between two points in time of a thread, or
+   * removes them if sign is negative. Removals may precede the matching
+   * additions: the unsigned counters then wrap around, and end up exact.
+   */
+  void add_interval(const profile_clock& start, const profile_clock& end,
+                    int sign = 1);
+
+  /// Adds the counters of another instance of the operator
+  void add(const operator_counters& other);
+};
+
+/**
+ * \ingroup sframe_query_engine
+ *
+ * The profile of a materialization: for every stage of execution (a
+ * linear plan run by the subplan executor, or a blocking operator run by
+ * its algorithm), the counters of each of its operators.
+ *
+ * A profile is requested by setting materialize_options::profile. All the
+ * materializations performed on behalf of that materialization (partial
+ * materializations, the inputs of joins, sorts, ...) are recorded in the
+ * same profile.
+ *
+ * \code
+ * materialize_options opts;
+ * opts.profile = std::make_shared<query_profile>();
+ * planner().materialize(plan, opts);
+ * std::cout << opts.profile->to_string();
+ * \endcode
+ */
+class query_profile {
+ public:
+  /// An operator of a stage
+  struct operator_info {
+    /// The operator name (see planner_node_type_to_name)
+    std::string name;
+    /// The operator ids of the inputs
+    std::vector<size_t> inputs;
+    operator_counters counters;
+  };
+
+  /// A stage of execution
+  struct stage_info {
+    /// What the stage does ("execute", or the blocking operator name)
+    std::string description;
+    /// The elapsed time of the stage, in seconds
+    double wall_time = 0;
+    /// The number of rows output by the stage
+    size_t rows_out = 0;
+    /// The operator ids of the stage, the output operator first
+    std::vector<size_t> operators;
+  };
+
+  /**
+   * Starts a stage executing the plan. Every node of the plan is assigned
+   * a profile operator id, stored in its "__profile_id__" any parameter, which
+   * is inherited by the copies of the node made to parallelize the plan.
+   * Returns the stage id.
+   */
+  size_t begin_stage(const std::shared_ptr<planner_node>& plan,
+                     const std::string& description = "execute");
+
+  /**
+   * Records the duration of a stage begun with begin_stage. The output
+   * size of the stage is the output of its first operator.
+   */
+  void end_stage(size_t stage_id, double wall_time);
+
+  /**
+   * Records a stage without operators, for instance a blocking operator
+   * run by its algorithm. The materializations it performs are recorded
+   * as stages of their own.
+   */
+  void add_stage(const std::string& description, double wall_time, size_t rows_out);
+
+  /**
+   * Adds the counters of an execution node running the planner node.
+   * Does nothing if the planner node was not part of a stage.
+   * Safe for concurrent operation.
+   */
+  void add_counters(const std::shared_ptr<planner_node>& pnode,
+                    const operator_counters& counters);
+
+  /// Returns the stages, in the order they started
+  std::vector<stage_info> stages() const;
+
+  /// Returns the operator with the given id
+  operator_info get_operator(size_t operator_id) const;
+
+  /**
+   * Returns a readable report of all the stages: the tree of operators of
+   * each stage, output first, with their counters.
+   */
+  std::string to_string() const;
+
+ private:
+  mutable mutex m_lock;
+  std::vector<stage_info> m_stages;
+  std::vector<operator_info> m_operators;
+};
+
+} // namespace query_eval
+} // namespace graphlab
+#endif
@@ -5,13 +5,32 @@
  * This software may be modified and distributed under the terms
  * of the BSD license. See the LICENSE file for details.
  */
+#include <atomic>
+#include <algorithm>
 #include <parallel/lambda_omp.hpp>
+#include <parallel/mutex.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <globals/globals.hpp>
 #include <sframe_query_engine/execution/subplan_executor.hpp>
 #include <sframe_query_engine/execution/execution_node.hpp>
 #include <sframe_query_engine/operators/operator_properties.hpp> 
 
 namespace graphlab { namespace query_eval {
 
+size_t SFRAME_MORSEL_NUM_ROWS = 256*1024;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_MORSEL_NUM_ROWS,
+                            true,
+                            +[](int64_t val){ return val >= 1024; });
+
+size_t SFRAME_MORSEL_MAX_BUFFERED_BYTES = 512*1024*1024;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_MORSEL_MAX_BUFFERED_BYTES,
+                            true,
+                            +[](int64_t val){ return val >= 1024*1024; });
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static std::shared_ptr<execution_node> get_executor(
@@ -85,10 +104,14 @@ find_earliest_exception(std::shared_ptr<execution_node> tip,
 void subplan_executor::generate_to_callback_function(
     const std::shared_ptr<planner_node>& plan,
     size_t output_segment_id,
-    execution_callback out_function) {
+    execution_callback out_function,
+    const std::shared_ptr<query_profile>& profile) {
 
   std::map<std::shared_ptr<planner_node>, std::shared_ptr<execution_node> > memo;
   std::shared_ptr<execution_node> ex_op = get_executor(plan, memo);
+  if (profile) {
+    for(auto& nodes: memo) nodes.second->enable_profiling();
+  }
 
   size_t consumer_id = ex_op->register_consumer();
 
@@ -101,6 +124,10 @@ void subplan_executor::generate_to_callback_function(
     if(done)
       break;
   }
+
+  if (profile) {
+    for(auto& nodes: memo) profile->add_counters(nodes.first, nodes.second->get_counters());
+  }
   
   // look through the list of all nodes for exceptions
   bool has_exception = false;
@@ -119,7 +146,8 @@ void subplan_executor::generate_to_callback_function(
 
 void subplan_executor::generate_to_sframe_segment(const std::shared_ptr<planner_node>& plan,
                                           sframe& out,
-                                          size_t output_segment_id) {
+                                          size_t output_segment_id,
+                                          const std::shared_ptr<query_profile>& profile) {
 
   auto outiter = out.get_output_iterator(output_segment_id);
 
@@ -128,7 +156,8 @@ void subplan_executor::generate_to_sframe_segment(const std::shared_ptr<planner_
       [&](size_t segment_idx, const std::shared_ptr<sframe_rows>& rows) {
         (*outiter) = *rows;
         return false;
-      });
+      },
+      profile);
 }
 
 
@@ -136,7 +165,8 @@ sframe subplan_executor::run(const std::shared_ptr<planner_node>& pnode,
                              const materialize_options& exec_params) {
 
   if(exec_params.write_callback != nullptr) {
-    generate_to_callback_function(pnode, 0, exec_params.write_callback);
+    generate_to_callback_function(pnode, 0, exec_params.write_callback,
+                                  exec_params.profile);
 
     sframe ret;
     return ret;
@@ -144,7 +174,7 @@ sframe subplan_executor::run(const std::shared_ptr<planner_node>& pnode,
     sframe out = get_output_sframe_schema(pnode, 
                                           1, // just 1 segment will do
                                           exec_params.output_index_file); 
-    generate_to_sframe_segment(pnode, out, 0);
+    generate_to_sframe_segment(pnode, out, 0, exec_params.profile);
     out.close();
     return out;
   }
@@ -177,7 +207,8 @@ sframe subplan_executor::run_concat(
     execution_callback exec_f = exec_params.write_callback;
 
     parallel_for(0, stuff_to_run_in_parallel.size(), [&](size_t i) {
-        generate_to_callback_function(stuff_to_run_in_parallel[i], i, exec_f);
+        generate_to_callback_function(stuff_to_run_in_parallel[i], i, exec_f,
+                                      exec_params.profile);
       });
 
     // make an empty sframe and return
@@ -191,7 +222,8 @@ sframe subplan_executor::run_concat(
                                           exec_params.output_column_names);
 
     parallel_for(0, stuff_to_run_in_parallel.size(), [&](size_t i) {
-        generate_to_sframe_segment(stuff_to_run_in_parallel[i], ret, i);
+        generate_to_sframe_segment(stuff_to_run_in_parallel[i], ret, i,
+                                   exec_params.profile);
       });
 
     ret.close();
@@ -199,4 +231,254 @@ sframe subplan_executor::run_concat(
   }
 }
 
+// The approximate memory held by a batch of rows: the values themselves,
+// plus the contents of the strings and vectors.
+static size_t approximate_size(const sframe_rows& rows) {
+  size_t ret = rows.num_rows() * rows.num_columns() * sizeof(flexible_type);
+  for (const auto& column: rows.cget_columns()) {
+    for (const auto& value: *column) {
+      if (value.get_type() == flex_type_enum::STRING) {
+        ret += value.get<flex_string>().size();
+      } else if (value.get_type() == flex_type_enum::VECTOR) {
+        ret += value.get<flex_vec>().size() * sizeof(double);
+      }
+    }
+  }
+  return ret;
+}
+
+sframe subplan_executor::run_morsels(
+    const std::vector<std::shared_ptr<planner_node> >& morsels,
+    const materialize_options& exec_params) {
+
+  if (morsels.empty()) {
+    // make an empty sframe and return
+    sframe ret;
+    return ret;
+  }
+
+  const size_t num_morsels = morsels.size();
+  const size_t num_segments = std::max<size_t>(1, std::min(exec_params.num_segments,
+                                                           num_morsels));
+  // segment s holds the morsels m with (m * num_segments) / num_morsels == s
+  auto segment_of = [&](size_t morsel) {
+    return (morsel * num_segments) / num_morsels;
+  };
+  std::vector<size_t> segment_end(num_segments, 0);
+  for (size_t m = 0; m < num_morsels; ++m) segment_end[segment_of(m)] = m + 1;
+
+  sframe ret;
+  std::vector<sframe::iterator> output_iters;
+  bool to_sframe = (exec_params.write_callback == nullptr);
+  if (to_sframe) {
+    ret = get_output_sframe_schema(morsels[0],
+                                   num_segments,
+                                   exec_params.output_index_file,
+                                   exec_params.output_column_names);
+    for (size_t i = 0; i < num_segments; ++i) {
+      output_iters.push_back(ret.get_output_iterator(i));
+    }
+  }
+
+  // The output of the morsels which are not yet written out
+  struct output_slot {
+    std::vector<std::shared_ptr<sframe_rows> > rows;
+    size_t bytes = 0;
+    bool done = false;
+  };
+  std::vector<output_slot> slots(num_morsels);
+
+  // Per segment: the next morsel to hand out to a thread, the next morsel
+  // to write out, and whether the write callback stopped the segment.
+  // The morsels of a segment are handed out in order, so the next morsel
+  // to write out is always running, or done.
+  std::unique_ptr<std::atomic<size_t>[]> next_to_claim(new std::atomic<size_t>[num_segments]);
+  std::unique_ptr<std::atomic<size_t>[]> next_to_write(new std::atomic<size_t>[num_segments]);
+  for (size_t s = 0, m = 0; s < num_segments; m = segment_end[s], ++s) {
+    next_to_claim[s] = m;
+    next_to_write[s] = m;
+  }
+  std::vector<char> segment_stopped(num_segments, false);
+  std::vector<mutex> segment_locks(num_segments);
+
+  // The total size of the rows held in the slots. A morsel which is not
+  // at the head of its segment waits before buffering more once this
+  // reaches SFRAME_MORSEL_MAX_BUFFERED_BYTES, until the slots are written
+  // out or it reaches the head of its segment itself.
+  size_t buffered_bytes = 0;
+  mutex buffer_lock;
+  conditional buffer_cond;
+
+  std::atomic<bool> failed(false);
+  mutex exception_lock;
+  size_t exception_morsel = size_t(-1);
+  std::exception_ptr exception;
+
+  auto release_bytes = [&](size_t bytes) {
+    std::lock_guard<mutex> guard(buffer_lock);
+    buffered_bytes -= bytes;
+    buffer_cond.broadcast();
+  };
+
+  // Hands out the next morsel of a segment, or num_morsels if there is none
+  auto claim = [&](size_t segment) {
+    size_t m = next_to_claim[segment].load();
+    while (m < segment_end[segment]) {
+      if (next_to_claim[segment].compare_exchange_weak(m, m + 1)) return m;
+    }
+    return num_morsels;
+  };
+
+  // Writes a batch of rows out to a segment. Returns true if the
+  // segment is stopped.
+  auto write_rows = [&](size_t segment, const std::shared_ptr<sframe_rows>& rows) {
+    if (to_sframe) {
+      (*output_iters[segment]) = *rows;
+      return false;
+    } else {
+      return exec_params.write_callback(segment, rows);
+    }
+  };
+
+  // Writes out the completed morsels following the last one written.
+  // Segment lock held. Returns the number of bytes released.
+  auto flush_segment = [&](size_t segment) {
+    size_t next = next_to_write[segment];
+    size_t bytes = 0;
+    while (next < segment_end[segment] && slots[next].done) {
+      for (const auto& rows: slots[next].rows) {
+        if (segment_stopped[segment]) break;
+        if (write_rows(segment, rows)) segment_stopped[segment] = true;
+      }
+      slots[next].rows.clear();
+      bytes += slots[next].bytes;
+      next_to_write[segment] = ++next;
+    }
+    return bytes;
+  };
+
+  in_parallel([&](size_t thread_id, size_t num_threads) {
+    // Each thread starts on a different segment, and steals from the
+    // segment with the most morsels left once its own is exhausted.
+    size_t home = (thread_id * num_segments) / std::max<size_t>(num_threads, 1);
+    while (!failed) {
+      size_t m = claim(home);
+      while (m == num_morsels) {
+        size_t victim = 0, most_left = 0;
+        for (size_t s = 0; s < num_segments; ++s) {
+          size_t claimed = std::min(next_to_claim[s].load(), segment_end[s]);
+          if (segment_end[s] - claimed > most_left) {
+            most_left = segment_end[s] - claimed;
+            victim = s;
+          }
+        }
+        if (most_left == 0) break;
+        m = claim(victim);
+      }
+      if (m == num_morsels) break;
+      size_t segment = segment_of(m);
+
+      // If all the preceding morsels of the segment are written, the
+      // output is streamed directly. Only one morsel of a segment can be
+      // in that state at a time.
+      bool direct = false;
+      {
+        std::lock_guard<mutex> guard(segment_locks[segment]);
+        if (segment_stopped[segment]) {
+          slots[m].done = true;
+          release_bytes(flush_segment(segment));
+          continue;
+        }
+        direct = (next_to_write[segment] == m);
+      }
+
+      std::vector<std::shared_ptr<sframe_rows> > buffer;
+      size_t buffer_bytes = 0;
+
+      // Once the preceding morsels are written out, writes out the buffer
+      // and switches to streaming the output. Returns true if the segment
+      // is stopped.
+      auto become_direct = [&]() {
+        bool stopped = false;
+        {
+          std::lock_guard<mutex> guard(segment_locks[segment]);
+          for (const auto& rows: buffer) {
+            if (segment_stopped[segment]) break;
+            if (write_rows(segment, rows)) segment_stopped[segment] = true;
+          }
+          stopped = segment_stopped[segment];
+        }
+        buffer.clear();
+        release_bytes(buffer_bytes);
+        buffer_bytes = 0;
+        direct = true;
+        return stopped;
+      };
+
+      try {
+        generate_to_callback_function(
+            morsels[m], segment,
+            [&](size_t, const std::shared_ptr<sframe_rows>& rows) {
+              if (failed) return true;
+              if (!direct && next_to_write[segment] == m) {
+                if (become_direct()) return true;
+              }
+              if (direct) {
+                if (write_rows(segment, rows)) {
+                  std::lock_guard<mutex> guard(segment_locks[segment]);
+                  segment_stopped[segment] = true;
+                  return true;
+                }
+                return false;
+              }
+              // the execution nodes reuse their output buffers. 
+              // sframe_rows copies are copy-on-write.
+              size_t bytes = approximate_size(*rows);
+              {
+                std::unique_lock<mutex> guard(buffer_lock);
+                while (buffered_bytes > 0 &&
+                       buffered_bytes + bytes > SFRAME_MORSEL_MAX_BUFFERED_BYTES &&
+                       next_to_write[segment] != m && !failed) {
+                  buffer_cond.wait(guard);
+                }
+                buffered_bytes += bytes;
+              }
+              buffer_bytes += bytes;
+              buffer.push_back(std::make_shared<sframe_rows>(*rows));
+              if (failed) return true;
+              if (next_to_write[segment] == m) return become_direct();
+              return false;
+            },
+            exec_params.profile);
+
+        size_t released = 0;
+        {
+          std::lock_guard<mutex> guard(segment_locks[segment]);
+          slots[m].rows = std::move(buffer);
+          slots[m].bytes = buffer_bytes;
+          slots[m].done = true;
+          released = flush_segment(segment);
+        }
+        release_bytes(released);
+      } catch (...) {
+        {
+          std::lock_guard<mutex> guard(exception_lock);
+          if (m < exception_morsel) {
+            exception_morsel = m;
+            exception = std::current_exception();
+          }
+          failed = true;
+        }
+        release_bytes(0);
+        break;
+      }
+    }
+  });
+
+  if (exception != nullptr) std::rethrow_exception(exception);
+
+  if (to_sframe) ret.close();
+  return ret;
+}
+
 }}
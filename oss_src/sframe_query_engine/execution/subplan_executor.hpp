@@ -18,7 +18,21 @@ namespace graphlab { namespace query_eval {
 
 typedef std::function<bool(size_t, const std::shared_ptr<sframe_rows>&)> execution_callback;
 
+/**
+ * The number of rows of the sources read by each morsel in morsel-driven
+ * execution (see \ref subplan_executor::run_morsels).
+ */
+extern size_t SFRAME_MORSEL_NUM_ROWS;
+
+/**
+ * The approximate number of bytes of output which morsel-driven execution
+ * holds back while waiting for the preceding morsels of a segment to be
+ * written out (see \ref subplan_executor::run_morsels).
+ */
+extern size_t SFRAME_MORSEL_MAX_BUFFERED_BYTES;
+
 struct planner_node;
+class query_profile;
 
 /**
  * The subplan executor executes a restricted class of constant rate query
@@ -32,8 +46,9 @@ struct planner_node;
  *  - \ref planner::partial_materialize Handles the most general materializations 
  *                                      but performs all materializations except 
  *                                      for the last stage. A private function.
- *  - \ref planner::execute_node Replicates a plan for parallelization. 
- *                               A private function.
+ *  - \ref planner::execute_node Replicates a plan for parallelization,
+ *                               into morsels of SFRAME_MORSEL_NUM_ROWS
+ *                               rows. A private function.
  *  - \ref subplan_executor Executes a restricted plan.
  *
  * As described in \ref execution_node, to successfully execute a query plan 
@@ -79,6 +94,33 @@ class subplan_executor {
       const std::vector<std::shared_ptr<planner_node> >& stuff_to_run_in_parallel,
       const materialize_options& exec_params = materialize_options());
 
+  /**
+   * Runs a batch of planner nodes, the "morsels", in parallel, returning
+   * an SFrame comprising of the concatenation of their outputs in order.
+   *
+   * Unlike \ref run_concat, the number of morsels is not tied to the
+   * number of output segments or of threads, so that small morsels
+   * balance the load between the threads when some parts of the input are
+   * more expensive than others. The morsels are split evenly into
+   * exec_params.num_segments contiguous ranges, one per output segment,
+   * each handed out in order from its own queue. Each worker thread starts
+   * on a different segment and, once that is exhausted, steals from the
+   * segment with the most morsels left.
+   *
+   * A morsel whose predecessors in its segment are all written streams its
+   * output directly to the segment; the output of the other morsels is
+   * held in a per-morsel slot until their turn comes. Once the slots hold
+   * SFRAME_MORSEL_MAX_BUFFERED_BYTES, the morsels which are not at the
+   * head of their segment wait for them to be written out.
+   *
+   * All the morsels must share exactly the same schema. If a write
+   * callback is given, it is called with the output segment id, in order
+   * within each segment, and returning true stops the segment.
+   */
+  sframe run_morsels(
+      const std::vector<std::shared_ptr<planner_node> >& morsels,
+      const materialize_options& exec_params = materialize_options());
+
  private:
 
  /** 
@@ -87,16 +129,20 @@ class subplan_executor {
   */
   void generate_to_sframe_segment(const std::shared_ptr<planner_node>& run_this,
                                   sframe& out, 
-                                  size_t output_segment_id);
+                                  size_t output_segment_id,
+                                  const std::shared_ptr<query_profile>& profile = nullptr);
 
   /**
    * \internal
    * Runs a single job sequentially, calling the callback on each output.
+   * If profile is not null, the counters of the execution nodes are added
+   * to it.
    */
   void generate_to_callback_function(
     const std::shared_ptr<planner_node>& plan,
     size_t output_segment_id,
-    execution_callback out_f);
+    execution_callback out_f,
+    const std::shared_ptr<query_profile>& profile = nullptr);
 };
 
 }}
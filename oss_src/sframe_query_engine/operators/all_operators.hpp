@@ -22,6 +22,12 @@
 #include <sframe_query_engine/operators/generalized_union_project.hpp>
 #include <sframe_query_engine/operators/reduce.hpp>
 #include <sframe_query_engine/operators/lambda_transform.hpp>
+#include <sframe_query_engine/operators/groupby_aggregate.hpp>
+#include <sframe_query_engine/operators/sort.hpp>
+#include <sframe_query_engine/operators/join.hpp>
+#include <sframe_query_engine/operators/broadcast_join.hpp>
+#include <sframe_query_engine/operators/window_aggregate.hpp>
+#include <sframe_query_engine/operators/expression_transform.hpp>
 #include <sframe_query_engine/operators/optonly_identity_operator.hpp>
 
 
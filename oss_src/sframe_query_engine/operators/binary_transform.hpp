@@ -14,6 +14,7 @@
 #include <sframe_query_engine/operators/operator.hpp>
 #include <sframe_query_engine/execution/query_context.hpp>
 #include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/operators/binary_transform_kernels.hpp>
 
 namespace graphlab { 
 namespace query_eval {
@@ -24,6 +25,17 @@ typedef std::function<flexible_type(const sframe_rows::row&,
 /**
  * A "binary transform" operator applys a transform function on two
  * stream of input.
+ *
+ * If the transform function is a standard element-wise operation (see
+ * binary_transform_kernels.hpp), the name of the operation may be passed 
+ * as the "kernel". Blocks where both inputs are packed numeric columns 
+ * are then computed with the columnar kernel, and all other blocks with 
+ * the transform function. The two must have identical semantics.
+ *
+ * Likewise, the "expression" any-parameter may describe the transform
+ * function as an expression_ptr (see expression.hpp), where column 0 is
+ * the left input and column 1 the right input, to let the optimizer fuse
+ * the transform with its neighbours.
  */
 template<>
 class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_operator {
@@ -41,9 +53,11 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
   }
   
   inline operator_impl(const binary_transform_type& f,
-                       flex_type_enum output_type)
+                       flex_type_enum output_type,
+                       const std::string& kernel = "")
       : m_transform_fn(f)
       , m_output_type(output_type)
+      , m_kernel(binary_transform_kernels::get_kernel_op(kernel))
   { }
 
   inline std::shared_ptr<query_operator> clone() const {
@@ -60,6 +74,20 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
       ASSERT_EQ(rows_left->num_columns(), 1);
       ASSERT_EQ(rows_right->num_columns(), 1);
       auto output_buffer = context.get_output_buffer();
+
+      if (m_kernel != binary_transform_kernels::kernel_op::NONE) {
+        typed_column result;
+        if (binary_transform_kernels::apply_kernel(m_kernel,
+                                                   rows_left->get_typed_column(0),
+                                                   rows_right->get_typed_column(0),
+                                                   result)) {
+          output_buffer->clear();
+          output_buffer->add_typed_column(result);
+          context.emit(output_buffer);
+          continue;
+        }
+      }
+
       output_buffer->resize(1, rows_left->num_rows());
 
       auto left_iter = rows_left->cbegin();
@@ -79,10 +107,13 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
       std::shared_ptr<planner_node> left,
       std::shared_ptr<planner_node> right,
         binary_transform_type fn,
-      flex_type_enum output_type) {
+      flex_type_enum output_type,
+      const std::string& kernel = "") {
     
+    std::map<std::string, flexible_type> params{{"output_type", (int)(output_type)}};
+    if (!kernel.empty()) params["kernel"] = kernel;
     return planner_node::make_shared(planner_node_type::BINARY_TRANSFORM_NODE, 
-                                     {{"output_type", (int)(output_type)}},
+                                     params,
                                      {{"function", any(fn)}},
                                      {left, right});
   }
@@ -99,7 +130,11 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
         (flex_type_enum)(flex_int)(pnode->operator_parameters["output_type"]);
 
     fn = pnode->any_operator_parameters["function"].as<binary_transform_type>();
-    return std::make_shared<operator_impl>(fn, output_type);
+    std::string kernel;
+    if (pnode->operator_parameters.count("kernel")) {
+      kernel = pnode->operator_parameters["kernel"].get<flex_string>();
+    }
+    return std::make_shared<operator_impl>(fn, output_type, kernel);
   }
 
   static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
@@ -116,6 +151,7 @@ class operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> : public query_ope
  private:
    binary_transform_type m_transform_fn;
    flex_type_enum m_output_type;
+   binary_transform_kernels::kernel_op m_kernel;
 };
 
 typedef operator_impl<planner_node_type::BINARY_TRANSFORM_NODE> op_binary_transform;
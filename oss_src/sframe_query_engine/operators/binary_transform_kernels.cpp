@@ -0,0 +1,306 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <type_traits>
+#include <logger/assertions.hpp>
+#include <sframe_query_engine/operators/binary_transform_kernels.hpp>
+
+namespace graphlab {
+namespace query_eval {
+namespace binary_transform_kernels {
+
+kernel_op get_kernel_op(const std::string& op) {
+  if (op == "+") return kernel_op::PLUS;
+  else if (op == "-") return kernel_op::MINUS;
+  else if (op == "*") return kernel_op::MULTIPLY;
+  else if (op == "/") return kernel_op::DIVIDE;
+  else if (op == "%") return kernel_op::MOD;
+  else if (op == "<") return kernel_op::LT;
+  else if (op == ">") return kernel_op::GT;
+  else if (op == "<=") return kernel_op::LE;
+  else if (op == ">=") return kernel_op::GE;
+  else if (op == "==") return kernel_op::EQ;
+  else if (op == "!=") return kernel_op::NE;
+  else if (op == "&") return kernel_op::AND;
+  else if (op == "|") return kernel_op::OR;
+  else return kernel_op::NONE;
+}
+
+static bool is_numeric(flex_type_enum t) {
+  return t == flex_type_enum::INTEGER || t == flex_type_enum::FLOAT;
+}
+
+bool kernel_supports_types(kernel_op op, flex_type_enum left, flex_type_enum right) {
+  if (op == kernel_op::NONE) return false;
+  if (op == kernel_op::MOD) {
+    return left == flex_type_enum::INTEGER && right == flex_type_enum::INTEGER;
+  }
+  return is_numeric(left) && is_numeric(right);
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                             Kernel Helpers                             */
+/*                                                                        */
+/**************************************************************************/
+
+template <typename T>
+static const T* packed_data(const typed_column& c);
+
+template <>
+const flex_int* packed_data<flex_int>(const typed_column& c) {
+  return c.int_data();
+}
+
+template <>
+const flex_float* packed_data<flex_float>(const typed_column& c) {
+  return c.float_data();
+}
+
+/// A kernel operand reading the values of a packed column
+template <typename T>
+struct column_operand {
+  typedef T value_type;
+  const T* __restrict__ values;
+  inline T operator[](size_t i) const { return values[i]; }
+};
+
+/// A kernel operand broadcasting a scalar to every row
+template <typename T>
+struct scalar_operand {
+  typedef T value_type;
+  T value;
+  inline T operator[](size_t) const { return value; }
+};
+
+/**
+ * Computes out[i] = fn(l[i], r[i]). Kept as simple as possible so that
+ * the loop is vectorized.
+ */
+template <typename O, typename L, typename R, typename Fn>
+static std::vector<O> map_values(L l, R r, size_t n, Fn fn) {
+  std::vector<O> ret(n);
+  O* __restrict__ out = ret.data();
+  for (size_t i = 0; i < n; ++i) out[i] = fn(l[i], r[i]);
+  return ret;
+}
+
+/**
+ * The validity of the result of an operation which is UNDEFINED if
+ * either input is UNDEFINED. A NULL column is a scalar, which is defined.
+ */
+static std::vector<uint64_t> combine_validity(const typed_column* left,
+                                              const typed_column* right) {
+  if (left == NULL || left->all_defined()) {
+    return right == NULL ? std::vector<uint64_t>() : right->validity();
+  }
+  if (right == NULL || right->all_defined()) return left->validity();
+  std::vector<uint64_t> ret = left->validity();
+  const auto& rv = right->validity();
+  for (size_t i = 0; i < ret.size(); ++i) ret[i] &= rv[i];
+  return ret;
+}
+
+/**
+ * == and != are defined on UNDEFINED values: two UNDEFINED values are
+ * equal, and an UNDEFINED value is not equal to anything else. A NULL
+ * column is a scalar, which is defined.
+ */
+static void fix_undefined_equality(const typed_column* left,
+                                   const typed_column* right,
+                                   bool is_equality,
+                                   std::vector<flex_int>& values) {
+  bool left_defined = left == NULL || left->all_defined();
+  bool right_defined = right == NULL || right->all_defined();
+  if (left_defined && right_defined) return;
+  for (size_t i = 0; i < values.size(); ++i) {
+    bool ldef = left_defined || left->is_defined(i);
+    bool rdef = right_defined || right->is_defined(i);
+    if (!ldef || !rdef) {
+      values[i] = is_equality ? (ldef == rdef) : (ldef != rdef);
+    }
+  }
+}
+
+/**
+ * Applies the kernel to the operands l and r of n values. left and right
+ * are the columns of the operands, or NULL for scalar operands.
+ */
+template <typename LOperand, typename ROperand>
+static void apply_typed_kernel(kernel_op op,
+                               LOperand l, ROperand r, size_t n,
+                               const typed_column* left,
+                               const typed_column* right,
+                               typed_column& out) {
+  typedef typename LOperand::value_type L;
+  typedef typename ROperand::value_type R;
+  // +, -, * of integers return integers. Everything else returns floats.
+  typedef typename std::conditional<std::is_same<L, flex_int>::value &&
+                                    std::is_same<R, flex_int>::value,
+                                    flex_int, flex_float>::type arith_type;
+  switch(op) {
+   case kernel_op::PLUS:
+     out = typed_column(map_values<arith_type>(l, r, n, [](L a, R b) {
+                          return (arith_type)a + (arith_type)b; }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::MINUS:
+     out = typed_column(map_values<arith_type>(l, r, n, [](L a, R b) {
+                          return (arith_type)a - (arith_type)b; }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::MULTIPLY:
+     out = typed_column(map_values<arith_type>(l, r, n, [](L a, R b) {
+                          return (arith_type)a * (arith_type)b; }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::DIVIDE:
+     out = typed_column(map_values<flex_float>(l, r, n, [](L a, R b) {
+                          return (flex_float)a / (flex_float)b; }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::MOD:
+     {
+       // Only integers. Division by zero is UNDEFINED.
+       std::vector<uint64_t> validity = combine_validity(left, right);
+       std::vector<flex_int> values(n, 0);
+       for (size_t i = 0; i < n; ++i) {
+         if (r[i] != 0) {
+           values[i] = (flex_int)l[i] % (flex_int)r[i];
+         } else {
+           if (validity.empty()) validity.resize((n + 63) / 64, (uint64_t)(-1));
+           validity[i / 64] &= ~(uint64_t(1) << (i % 64));
+         }
+       }
+       out = typed_column(std::move(values), std::move(validity));
+     }
+     break;
+   case kernel_op::LT:
+     out = typed_column(map_values<flex_int>(l, r, n, [](L a, R b) {
+                          return (flex_int)(a < b); }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::GT:
+     out = typed_column(map_values<flex_int>(l, r, n, [](L a, R b) {
+                          return (flex_int)(a > b); }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::LE:
+     out = typed_column(map_values<flex_int>(l, r, n, [](L a, R b) {
+                          return (flex_int)(a <= b); }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::GE:
+     out = typed_column(map_values<flex_int>(l, r, n, [](L a, R b) {
+                          return (flex_int)(a >= b); }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::EQ:
+   case kernel_op::NE:
+     {
+       bool is_equality = (op == kernel_op::EQ);
+       std::vector<flex_int> values = is_equality ?
+           map_values<flex_int>(l, r, n, [](L a, R b) { return (flex_int)(a == b); }) :
+           map_values<flex_int>(l, r, n, [](L a, R b) { return (flex_int)(a != b); });
+       fix_undefined_equality(left, right, is_equality, values);
+       out = typed_column(std::move(values));
+     }
+     break;
+   case kernel_op::AND:
+     out = typed_column(map_values<flex_int>(l, r, n, [](L a, R b) {
+                          return (flex_int)((a != 0) & (b != 0)); }),
+                        combine_validity(left, right));
+     break;
+   case kernel_op::OR:
+     out = typed_column(map_values<flex_int>(l, r, n, [](L a, R b) {
+                          return (flex_int)((a != 0) | (b != 0)); }),
+                        combine_validity(left, right));
+     break;
+   default:
+     ASSERT_MSG(false, "Unexpected kernel");
+  }
+}
+
+template <typename L, typename R>
+static void apply_column_kernel(kernel_op op,
+                                const typed_column& left,
+                                const typed_column& right,
+                                typed_column& out) {
+  apply_typed_kernel(op,
+                     column_operand<L>{packed_data<L>(left)},
+                     column_operand<R>{packed_data<R>(right)},
+                     left.size(), &left, &right, out);
+}
+
+template <typename C, typename S>
+static void apply_column_scalar_kernel(kernel_op op,
+                                       const typed_column& column,
+                                       S scalar,
+                                       bool scalar_on_left,
+                                       typed_column& out) {
+  column_operand<C> c{packed_data<C>(column)};
+  scalar_operand<S> s{scalar};
+  if (scalar_on_left) {
+    apply_typed_kernel(op, s, c, column.size(), NULL, &column, out);
+  } else {
+    apply_typed_kernel(op, c, s, column.size(), &column, NULL, out);
+  }
+}
+
+bool apply_kernel(kernel_op op,
+                  const typed_column& left,
+                  const typed_column& right,
+                  typed_column& out) {
+  if (!left.is_packed() || !right.is_packed()) return false;
+  if (!kernel_supports_types(op, left.type(), right.type())) return false;
+  ASSERT_EQ(left.size(), right.size());
+
+  bool left_is_int = left.type() == flex_type_enum::INTEGER;
+  bool right_is_int = right.type() == flex_type_enum::INTEGER;
+  if (left_is_int && right_is_int) {
+    apply_column_kernel<flex_int, flex_int>(op, left, right, out);
+  } else if (left_is_int) {
+    apply_column_kernel<flex_int, flex_float>(op, left, right, out);
+  } else if (right_is_int) {
+    apply_column_kernel<flex_float, flex_int>(op, left, right, out);
+  } else {
+    apply_column_kernel<flex_float, flex_float>(op, left, right, out);
+  }
+  return true;
+}
+
+bool apply_scalar_kernel(kernel_op op,
+                         const typed_column& column,
+                         const flexible_type& scalar,
+                         bool scalar_on_left,
+                         typed_column& out) {
+  if (!column.is_packed()) return false;
+  flex_type_enum left_type = scalar_on_left ? scalar.get_type() : column.type();
+  flex_type_enum right_type = scalar_on_left ? column.type() : scalar.get_type();
+  if (!kernel_supports_types(op, left_type, right_type)) return false;
+
+  bool column_is_int = column.type() == flex_type_enum::INTEGER;
+  bool scalar_is_int = scalar.get_type() == flex_type_enum::INTEGER;
+  if (column_is_int && scalar_is_int) {
+    apply_column_scalar_kernel<flex_int>(op, column, scalar.get<flex_int>(),
+                                         scalar_on_left, out);
+  } else if (column_is_int) {
+    apply_column_scalar_kernel<flex_int>(op, column, scalar.get<flex_float>(),
+                                         scalar_on_left, out);
+  } else if (scalar_is_int) {
+    apply_column_scalar_kernel<flex_float>(op, column, scalar.get<flex_int>(),
+                                           scalar_on_left, out);
+  } else {
+    apply_column_scalar_kernel<flex_float>(op, column, scalar.get<flex_float>(),
+                                           scalar_on_left, out);
+  }
+  return true;
+}
+
+} // namespace binary_transform_kernels
+} // namespace query_eval
+} // namespace graphlab
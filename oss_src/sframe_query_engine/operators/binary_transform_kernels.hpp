@@ -0,0 +1,82 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_MANAGER_BINARY_TRANSFORM_KERNELS_HPP
+#define GRAPHLAB_SFRAME_QUERY_MANAGER_BINARY_TRANSFORM_KERNELS_HPP
+#include <string>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/typed_column.hpp>
+
+namespace graphlab {
+namespace query_eval {
+namespace binary_transform_kernels {
+
+/**
+ * The element-wise operations which have a columnar kernel.
+ */
+enum class kernel_op: int {
+  NONE = 0,
+  PLUS, MINUS, MULTIPLY, DIVIDE, MOD,
+  LT, GT, LE, GE, EQ, NE,
+  AND, OR
+};
+
+/**
+ * Returns the kernel for an operator name as used by the SArray binary
+ * operations ("+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==", "!=",
+ * "&", "|"). Returns kernel_op::NONE if there is no kernel for the operator.
+ */
+kernel_op get_kernel_op(const std::string& op);
+
+/**
+ * Returns true if the kernel can be applied to columns of the given types.
+ * Only INTEGER and FLOAT columns are supported.
+ */
+bool kernel_supports_types(kernel_op op, flex_type_enum left, flex_type_enum right);
+
+/**
+ * Applies a kernel element-wise to two columns of the same length.
+ *
+ * The semantics are identical to the SArray binary operations (see
+ * unity_sarray_binary_operations.hpp), including the handling of UNDEFINED
+ * values: the result is UNDEFINED if either value is UNDEFINED, except for
+ * "==" and "!=" which compare the missing-ness of the values.
+ *
+ * The kernels operate on the packed arrays of the typed columns in tight,
+ * branch-free loops which the compiler vectorizes.
+ *
+ * Returns false if either column is not packed, or the types are not
+ * supported by the kernel; out is then unmodified and the caller
+ * should fall back to the flexible_type implementation.
+ */
+bool apply_kernel(kernel_op op,
+                  const typed_column& left,
+                  const typed_column& right,
+                  typed_column& out);
+
+/**
+ * Applies a kernel element-wise to a column and a scalar, computing
+ * (column op scalar), or (scalar op column) if scalar_on_left is true.
+ *
+ * The result is the one of \ref apply_kernel on a column holding the scalar
+ * in every row, but the scalar is broadcast in the kernel loops instead of
+ * being expanded to a column.
+ *
+ * Returns false if the column is not packed, the scalar is not an INTEGER
+ * or a FLOAT, or the types are not supported by the kernel; out is then
+ * unmodified.
+ */
+bool apply_scalar_kernel(kernel_op op,
+                         const typed_column& column,
+                         const flexible_type& scalar,
+                         bool scalar_on_left,
+                         typed_column& out);
+
+} // namespace binary_transform_kernels
+} // namespace query_eval
+} // namespace graphlab
+#endif
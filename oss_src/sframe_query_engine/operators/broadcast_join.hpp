@@ -0,0 +1,316 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_MANAGER_BROADCAST_JOIN_HPP
+#define GRAPHLAB_SFRAME_QUERY_MANAGER_BROADCAST_JOIN_HPP
+
+#include <sstream>
+#include <flexible_type/flexible_type.hpp>
+#include <parallel/mutex.hpp>
+#include <sframe/join_impl.hpp>
+#include <sframe_query_engine/operators/operator.hpp>
+#include <sframe_query_engine/execution/query_context.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/planning/planner.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * The in-memory hash table of the small ("build") side of a broadcast join.
+ *
+ * The planner builds the table, materializing and indexing the build side,
+ * before executing a plan containing the join, and releases it once the
+ * execution is over (see execute_node_impl in planner.cpp). The table is
+ * shared, read only, by every instance of the operator in the meantime.
+ */
+class broadcast_join_table {
+ public:
+  broadcast_join_table(std::shared_ptr<planner_node> build_side,
+                       const std::vector<size_t>& build_keys)
+      : m_build_side(build_side), m_build_keys(build_keys) { }
+
+  /// Materializes the build side into the table, if not already done.
+  void build() {
+    {
+      std::lock_guard<graphlab::mutex> guard(m_lock);
+      if (m_table != nullptr) return;
+    }
+    sframe sf = planner().materialize(m_build_side);
+    auto table = std::make_shared<join_impl::join_hash_table>(m_build_keys,
+                                                              sf.num_columns());
+    std::vector<std::vector<flexible_type> > rows;
+    sf.get_reader()->read_rows(0, sf.num_rows(), rows);
+    for (const auto& row: rows) table->add_row(row);
+    table->build();
+    std::lock_guard<graphlab::mutex> guard(m_lock);
+    m_table = table;
+  }
+
+  /// Frees the table. The operators using it keep their own reference.
+  void release() {
+    std::lock_guard<graphlab::mutex> guard(m_lock);
+    m_table.reset();
+  }
+
+  /// Returns the table, building it first if the planner has not.
+  std::shared_ptr<join_impl::join_hash_table> get() {
+    {
+      std::lock_guard<graphlab::mutex> guard(m_lock);
+      if (m_table != nullptr) return m_table;
+    }
+    build();
+    std::lock_guard<graphlab::mutex> guard(m_lock);
+    return m_table;
+  }
+
+  std::shared_ptr<planner_node> build_side() const { return m_build_side; }
+
+ private:
+  std::shared_ptr<planner_node> m_build_side;
+  std::vector<size_t> m_build_keys;
+  graphlab::mutex m_lock;
+  std::shared_ptr<join_impl::join_hash_table> m_table;
+};
+
+
+/**
+ * A join of a stream of rows against a small input held in memory.
+ *
+ * The single input of the node is the large side of the join, which is
+ * streamed through the operator. The small side is kept (as a planner node)
+ * in the "build_table" parameter and is materialized into a hash table
+ * before the plan is executed. Unlike the JOIN_NODE, neither
+ * side is partitioned to disk, and the large side is never materialized.
+ *
+ * Only the joins where the unmatched rows of the small side are dropped can
+ * be executed this way: inner and left joins against a small right side,
+ * and inner and right joins against a small left side.
+ *
+ * The output schema is the same as the one of the JOIN_NODE: all the
+ * columns of the left input, followed by the non-key columns of the right
+ * input. Rows are output in the order of the large side.
+ */
+template <>
+class operator_impl<planner_node_type::BROADCAST_JOIN_NODE> : public query_operator {
+ public:
+  planner_node_type type() const { return planner_node_type::BROADCAST_JOIN_NODE; }
+
+  static std::string name() { return "broadcast_join"; }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::SUB_LINEAR;
+    ret.num_inputs = 1;
+    return ret;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  inline operator_impl(std::shared_ptr<join_impl::join_hash_table> table,
+                       bool build_is_right,
+                       bool keep_unmatched,
+                       const std::vector<size_t>& stream_keys,
+                       const std::vector<size_t>& build_keys,
+                       const std::vector<size_t>& right_value_columns,
+                       size_t num_left_columns)
+      : m_table(table), m_build_is_right(build_is_right),
+        m_keep_unmatched(keep_unmatched), m_stream_keys(stream_keys),
+        m_build_keys(build_keys), m_right_value_columns(right_value_columns),
+        m_num_left_columns(num_left_columns) { }
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(*this);
+  }
+
+  inline void execute(query_context& context) {
+    size_t ncols = m_num_left_columns + m_right_value_columns.size();
+    size_t nrows = context.block_size();
+    auto output_buffer = context.get_output_buffer();
+    output_buffer->resize(ncols, nrows);
+    size_t cur_output_index = 0;
+
+    std::vector<flexible_type> stream_row;
+    std::vector<std::vector<flexible_type> > matches;
+    while(1) {
+      auto rows = context.get_next(0);
+      if (rows == nullptr) break;
+      for (const auto& row: *rows) {
+        stream_row.resize(row.size());
+        for (size_t i = 0; i < row.size(); ++i) stream_row[i] = row[i];
+        size_t group = m_table->find(stream_row, m_stream_keys, false);
+        if (group != join_impl::join_hash_table::NOT_FOUND) {
+          m_table->get_group_rows(group, matches);
+        } else if (m_keep_unmatched) {
+          matches.clear();
+        } else {
+          continue;
+        }
+        size_t num_output = std::max<size_t>(matches.size(), 1);
+        for (size_t i = 0; i < num_output; ++i) {
+          write_row(stream_row, matches.empty() ? nullptr : &matches[i],
+                    *output_buffer, cur_output_index);
+          ++cur_output_index;
+          if (cur_output_index == nrows) {
+            context.emit(output_buffer);
+            output_buffer = context.get_output_buffer();
+            output_buffer->resize(ncols, nrows);
+            cur_output_index = 0;
+          }
+        }
+      }
+    }
+
+    if (cur_output_index > 0) {
+      output_buffer->resize(ncols, cur_output_index);
+      context.emit(output_buffer);
+    }
+  }
+
+  /**
+   * Creates a broadcast join computing the same output as a JOIN_NODE.
+   *
+   * \param join A JOIN_NODE
+   * \param build_is_right If true, the right input of the join is held in
+   *                       memory and the left input is streamed. Otherwise
+   *                       the other way around.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> join,
+      bool build_is_right) {
+    ASSERT_EQ((int)join->operator_type, (int)planner_node_type::JOIN_NODE);
+    const auto& params = join->operator_parameters;
+    const auto& left_names = params.at("left_column_names").get<flex_list>();
+    const auto& right_names = params.at("right_column_names").get<flex_list>();
+    const auto& left_key_names = params.at("left_keys").get<flex_list>();
+    const auto& right_key_names = params.at("right_keys").get<flex_list>();
+    const auto& join_type = params.at("join_type").get<flex_string>();
+
+    flex_list left_keys, right_keys, right_value_columns;
+    for (size_t i = 0; i < left_key_names.size(); ++i) {
+      left_keys.push_back(flex_int(
+          std::find(left_names.begin(), left_names.end(), left_key_names[i]) -
+          left_names.begin()));
+      right_keys.push_back(flex_int(
+          std::find(right_names.begin(), right_names.end(), right_key_names[i]) -
+          right_names.begin()));
+    }
+    for (size_t i = 0; i < right_names.size(); ++i) {
+      if (std::find(right_key_names.begin(), right_key_names.end(), right_names[i])
+          == right_key_names.end()) {
+        right_value_columns.push_back(flex_int(i));
+      }
+    }
+
+    bool keep_unmatched = build_is_right ? (join_type == "left") : (join_type == "right");
+    ASSERT_TRUE(join_type == "inner" || keep_unmatched);
+
+    pnode_ptr stream = join->inputs[build_is_right ? 0 : 1];
+    pnode_ptr build = join->inputs[build_is_right ? 1 : 0];
+    const flex_list& build_keys = build_is_right ? right_keys : left_keys;
+    auto table = std::make_shared<broadcast_join_table>(
+        build, from_flex_list(build_keys));
+
+    return planner_node::make_shared(
+        planner_node_type::BROADCAST_JOIN_NODE,
+        {{"build_is_right", flex_int(build_is_right)},
+         {"keep_unmatched", flex_int(keep_unmatched)},
+         {"join_type", join_type},
+         {"stream_keys", build_is_right ? left_keys : right_keys},
+         {"build_keys", build_keys},
+         {"right_value_columns", right_value_columns},
+         {"num_left_columns", flex_int(left_names.size())},
+         {"column_names", params.at("column_names")},
+         {"column_types", params.at("column_types")}},
+        {{"build_table", any(table)}},
+        {stream});
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::BROADCAST_JOIN_NODE);
+    ASSERT_EQ(pnode->inputs.size(), 1);
+    auto& params = pnode->operator_parameters;
+    auto table = pnode->any_operator_parameters.at("build_table")
+                     .as<std::shared_ptr<broadcast_join_table> >();
+    return std::make_shared<operator_impl>(
+        table->get(),
+        params["build_is_right"].get<flex_int>() != 0,
+        params["keep_unmatched"].get<flex_int>() != 0,
+        from_flex_list(params["stream_keys"]),
+        from_flex_list(params["build_keys"]),
+        from_flex_list(params["right_value_columns"]),
+        params["num_left_columns"].get<flex_int>());
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::BROADCAST_JOIN_NODE);
+    std::vector<flex_type_enum> ret;
+    for (const auto& t: pnode->operator_parameters["column_types"].get<flex_list>()) {
+      ret.push_back((flex_type_enum)(flex_int)t);
+    }
+    return ret;
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    return -1;
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger& get_tag) {
+    std::ostringstream out;
+    out << "BroadcastJoin_" << pnode->operator_parameters["join_type"].get<flex_string>()
+        << "(" << get_tag(pnode->inputs[0]) << ")";
+    return out.str();
+  }
+
+ private:
+  static std::vector<size_t> from_flex_list(const flexible_type& v) {
+    std::vector<size_t> ret;
+    for (const auto& i: v.get<flex_list>()) ret.push_back(i.get<flex_int>());
+    return ret;
+  }
+
+  /**
+   * Writes the output row for a row of the large side and one of its
+   * matches (or nullptr for an unmatched row) into row out_index of output.
+   */
+  void write_row(const std::vector<flexible_type>& stream_row,
+                 const std::vector<flexible_type>* match,
+                 sframe_rows& output, size_t out_index) const {
+    const std::vector<flexible_type>* left = m_build_is_right ? &stream_row : match;
+    const std::vector<flexible_type>* right = m_build_is_right ? match : &stream_row;
+    for (size_t i = 0; i < m_num_left_columns; ++i) {
+      output[out_index][i] = left ? (*left)[i] : FLEX_UNDEFINED;
+    }
+    if (left == nullptr) {
+      // an unmatched row of a right join takes its keys from the right side
+      for (size_t i = 0; i < m_build_keys.size(); ++i) {
+        output[out_index][m_build_keys[i]] = (*right)[m_stream_keys[i]];
+      }
+    }
+    for (size_t i = 0; i < m_right_value_columns.size(); ++i) {
+      output[out_index][m_num_left_columns + i] =
+          right ? (*right)[m_right_value_columns[i]] : FLEX_UNDEFINED;
+    }
+  }
+
+  std::shared_ptr<join_impl::join_hash_table> m_table;
+  bool m_build_is_right;
+  bool m_keep_unmatched;
+  std::vector<size_t> m_stream_keys;
+  std::vector<size_t> m_build_keys;
+  std::vector<size_t> m_right_value_columns;
+  size_t m_num_left_columns;
+};
+
+typedef operator_impl<planner_node_type::BROADCAST_JOIN_NODE> op_broadcast_join;
+
+} // query_eval
+} // graphlab
+
+#endif
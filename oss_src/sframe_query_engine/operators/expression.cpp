@@ -0,0 +1,538 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <atomic>
+#include <cmath>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <logger/assertions.hpp>
+#include <serialization/serialization_includes.hpp>
+#include <sframe_query_engine/operators/expression.hpp>
+#include <sframe_query_engine/operators/binary_transform_kernels.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**************************************************************************/
+/*                                                                        */
+/*                           Builtin Operators                            */
+/*                                                                        */
+/**************************************************************************/
+
+static bool is_numeric(const flexible_type& v) {
+  return v.get_type() == flex_type_enum::INTEGER ||
+         v.get_type() == flex_type_enum::FLOAT;
+}
+
+static expression::unary_fn_type builtin_unary_fn(const std::string& op) {
+  if (op == "-") {
+    return [](const flexible_type& v)->flexible_type {
+      if (v.get_type() == flex_type_enum::INTEGER) return -v.get<flex_int>();
+      else return -(flex_float)v;
+    };
+  } else if (op == "!") {
+    return [](const flexible_type& v)->flexible_type { return (int)v.is_zero(); };
+  } else if (op == "abs") {
+    return [](const flexible_type& v)->flexible_type {
+      if (v.get_type() == flex_type_enum::INTEGER) return std::abs(v.get<flex_int>());
+      else return std::fabs((flex_float)v);
+    };
+  } else if (op == "len") {
+    return [](const flexible_type& v)->flexible_type { return flex_int(v.size()); };
+  } else if (op == "lower") {
+    return [](const flexible_type& v)->flexible_type {
+      return boost::algorithm::to_lower_copy(v.get<flex_string>());
+    };
+  } else if (op == "upper") {
+    return [](const flexible_type& v)->flexible_type {
+      return boost::algorithm::to_upper_copy(v.get<flex_string>());
+    };
+  } else {
+    log_and_throw("Unknown unary expression operator " + op);
+  }
+}
+
+static expression::binary_fn_type builtin_binary_fn(const std::string& op,
+                                                    flex_type_enum output_type) {
+  // arithmetic on numbers is done in the output type, so that for instance
+  // integer + float is a float
+  bool float_out = output_type == flex_type_enum::FLOAT;
+  if (op == "+") {
+    return [=](const flexible_type& l, const flexible_type& r)->flexible_type {
+      if (float_out && is_numeric(l) && is_numeric(r)) return (flex_float)l + (flex_float)r;
+      return l + r;
+    };
+  } else if (op == "-") {
+    return [=](const flexible_type& l, const flexible_type& r)->flexible_type {
+      if (float_out && is_numeric(l) && is_numeric(r)) return (flex_float)l - (flex_float)r;
+      return l - r;
+    };
+  } else if (op == "*") {
+    return [=](const flexible_type& l, const flexible_type& r)->flexible_type {
+      if (float_out && is_numeric(l) && is_numeric(r)) return (flex_float)l * (flex_float)r;
+      return l * r;
+    };
+  } else if (op == "/") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type {
+      return (flex_float)l / (flex_float)r;
+    };
+  } else if (op == "%") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type {
+      flex_int rightval = r;
+      if (rightval != 0) return (flex_int)l % rightval;
+      else return FLEX_UNDEFINED;
+    };
+  } else if (op == "<") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type { return (int)(l < r); };
+  } else if (op == ">") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type { return (int)(l > r); };
+  } else if (op == "<=") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type { return (int)(l <= r); };
+  } else if (op == ">=") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type { return (int)(l >= r); };
+  } else if (op == "==") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type { return (int)(l == r); };
+  } else if (op == "!=") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type { return (int)(l != r); };
+  } else if (op == "&") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type {
+      return (int)((!l.is_zero()) && (!r.is_zero()));
+    };
+  } else if (op == "|") {
+    return [](const flexible_type& l, const flexible_type& r)->flexible_type {
+      return (int)((!l.is_zero()) || (!r.is_zero()));
+    };
+  } else {
+    log_and_throw("Unknown binary expression operator " + op);
+  }
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                              Construction                              */
+/*                                                                        */
+/**************************************************************************/
+
+/**
+ * Computes the key of an expression from its contents and the keys of its
+ * arguments.
+ */
+static void set_key(expression& expr) {
+  std::string type = std::to_string((int)expr.output_type);
+  // given functions are only known to be equal if they are the same object
+  std::string op = expr.op;
+  if (expr.function_id) op += "#" + std::to_string(expr.function_id);
+  switch(expr.type) {
+   case expression::expression_type::COLUMN:
+     expr.key = "col" + std::to_string(expr.column) + ":" + type;
+     break;
+   case expression::expression_type::CONSTANT: {
+     // the serialized value distinguishes all values, including floats
+     // which print identically
+     std::stringstream strm;
+     oarchive oarc(strm);
+     oarc << expr.value;
+     expr.key = "const(" + strm.str() + "):" + type;
+     break;
+   }
+   case expression::expression_type::UNARY:
+     expr.key = "unary" + op + "(" + expr.args[0]->key + "):" + type;
+     break;
+   case expression::expression_type::BINARY:
+     expr.key = "binary" + op + "(" + expr.args[0]->key + "," +
+                expr.args[1]->key + "):" + type;
+     break;
+   case expression::expression_type::CAST:
+     expr.key = "cast(" + expr.args[0]->key + "):" + type;
+     break;
+   case expression::expression_type::CONDITIONAL:
+     expr.key = "if(" + expr.args[0]->key + "," + expr.args[1]->key + "," +
+                expr.args[2]->key + "):" + type;
+     break;
+  }
+}
+
+/// Returns a new id for a function given to an UNARY or BINARY expression
+static size_t new_function_id() {
+  static std::atomic<size_t> last_id(0);
+  return ++last_id;
+}
+
+expression_ptr make_column_expression(size_t column, flex_type_enum type) {
+  auto ret = std::make_shared<expression>();
+  ret->type = expression::expression_type::COLUMN;
+  ret->column = column;
+  ret->output_type = type;
+  set_key(*ret);
+  return ret;
+}
+
+expression_ptr make_constant_expression(const flexible_type& value) {
+  auto ret = std::make_shared<expression>();
+  ret->type = expression::expression_type::CONSTANT;
+  ret->value = value;
+  ret->output_type = value.get_type();
+  set_key(*ret);
+  return ret;
+}
+
+expression_ptr make_unary_expression(const std::string& op,
+                                     expression_ptr arg,
+                                     flex_type_enum output_type,
+                                     expression::unary_fn_type fn) {
+  auto ret = std::make_shared<expression>();
+  ret->type = expression::expression_type::UNARY;
+  ret->op = op;
+  ret->args = {arg};
+  ret->output_type = output_type;
+  ret->unary_fn = fn ? fn : builtin_unary_fn(op);
+  if (fn) ret->function_id = new_function_id();
+  set_key(*ret);
+  return ret;
+}
+
+expression_ptr make_binary_expression(const std::string& op,
+                                      expression_ptr left,
+                                      expression_ptr right,
+                                      flex_type_enum output_type,
+                                      expression::binary_fn_type fn) {
+  auto ret = std::make_shared<expression>();
+  ret->type = expression::expression_type::BINARY;
+  ret->op = op;
+  ret->args = {left, right};
+  ret->output_type = output_type;
+  ret->binary_fn = fn ? fn : builtin_binary_fn(op, output_type);
+  if (fn) ret->function_id = new_function_id();
+  set_key(*ret);
+  return ret;
+}
+
+expression_ptr make_cast_expression(expression_ptr arg, flex_type_enum type) {
+  auto ret = std::make_shared<expression>();
+  ret->type = expression::expression_type::CAST;
+  ret->args = {arg};
+  ret->output_type = type;
+  set_key(*ret);
+  return ret;
+}
+
+expression_ptr make_conditional_expression(expression_ptr condition,
+                                           expression_ptr if_true,
+                                           expression_ptr if_false) {
+  auto ret = std::make_shared<expression>();
+  ret->type = expression::expression_type::CONDITIONAL;
+  ret->args = {condition, if_true, if_false};
+  ret->output_type = if_true->output_type != flex_type_enum::UNDEFINED ?
+                     if_true->output_type : if_false->output_type;
+  set_key(*ret);
+  return ret;
+}
+
+static expression_ptr substitute_columns(
+    const expression_ptr& expr,
+    const std::vector<expression_ptr>& columns,
+    std::map<const expression*, expression_ptr>& memo) {
+  auto iter = memo.find(expr.get());
+  if (iter != memo.end()) return iter->second;
+
+  expression_ptr ret;
+  if (expr->type == expression::expression_type::COLUMN) {
+    ASSERT_LT(expr->column, columns.size());
+    ret = columns[expr->column];
+  } else if (expr->args.empty()) {
+    ret = expr;
+  } else {
+    auto new_expr = std::make_shared<expression>(*expr);
+    for (auto& arg: new_expr->args) arg = substitute_columns(arg, columns, memo);
+    set_key(*new_expr);
+    ret = new_expr;
+  }
+  memo[expr.get()] = ret;
+  return ret;
+}
+
+expression_ptr substitute_columns(const expression_ptr& expr,
+                                  const std::vector<expression_ptr>& columns) {
+  std::map<const expression*, expression_ptr> memo;
+  return substitute_columns(expr, columns, memo);
+}
+
+/**************************************************************************/
+/*                                                                        */
+/*                               Evaluation                               */
+/*                                                                        */
+/**************************************************************************/
+
+expression_program::expression_program(const std::vector<expression_ptr>& outputs) {
+  std::map<std::string, size_t> step_ids;
+  for (const auto& expr: outputs) {
+    m_outputs.push_back(add_step(expr, step_ids));
+  }
+}
+
+size_t expression_program::add_step(const expression_ptr& expr,
+                                    std::map<std::string, size_t>& step_ids) {
+  auto iter = step_ids.find(expr->key);
+  if (iter != step_ids.end()) return iter->second;
+  step s;
+  s.expr = expr;
+  for (const auto& arg: expr->args) s.args.push_back(add_step(arg, step_ids));
+  // the arguments are added first, so the steps are in evaluation order
+  m_steps.push_back(s);
+  step_ids[expr->key] = m_steps.size() - 1;
+  return m_steps.size() - 1;
+}
+
+bool expression_program::uses_column(size_t i) const {
+  for (const auto& s: m_steps) {
+    if (s.expr->type == expression::expression_type::COLUMN &&
+        s.expr->column == i) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Returns the values of a column as flexible_type, using buffer if the
+ * column needs to be unpacked.
+ */
+static const std::vector<flexible_type>& flexible_values(const typed_column& column,
+                                                         std::vector<flexible_type>& buffer) {
+  if (column.is_packed()) {
+    column.to_flexible(buffer);
+    return buffer;
+  } else {
+    return column.flexible_data();
+  }
+}
+
+static inline flexible_type convert_value(flexible_type&& val, flex_type_enum type) {
+  if (type == flex_type_enum::UNDEFINED ||
+      val.get_type() == type ||
+      val.get_type() == flex_type_enum::UNDEFINED) {
+    return std::move(val);
+  }
+  flexible_type ret(type);
+  ret.soft_assign(val);
+  return ret;
+}
+
+static typed_column make_result(std::shared_ptr<std::vector<flexible_type> >&& values) {
+  // numeric results are packed so that the following steps can use the
+  // columnar kernels
+  return typed_column(typed_column::flexible_column_ptr(std::move(values)));
+}
+
+static typed_column evaluate_constant(const expression& expr, size_t num_rows) {
+  if (expr.value.get_type() == flex_type_enum::INTEGER) {
+    return typed_column(std::vector<flex_int>(num_rows, expr.value.get<flex_int>()));
+  } else if (expr.value.get_type() == flex_type_enum::FLOAT) {
+    return typed_column(std::vector<flex_float>(num_rows, expr.value.get<flex_float>()));
+  } else {
+    return typed_column(std::make_shared<std::vector<flexible_type> >(num_rows, expr.value));
+  }
+}
+
+static typed_column evaluate_unary(const expression& expr, const typed_column& arg) {
+  std::vector<flexible_type> buffer;
+  const auto& values = flexible_values(arg, buffer);
+  auto out = std::make_shared<std::vector<flexible_type> >(values.size(), FLEX_UNDEFINED);
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+      (*out)[i] = convert_value(expr.unary_fn(values[i]), expr.output_type);
+    }
+  }
+  return make_result(std::move(out));
+}
+
+static typed_column evaluate_binary(const expression& expr,
+                                    const typed_column& left,
+                                    const typed_column& right) {
+  auto kernel = binary_transform_kernels::get_kernel_op(expr.op);
+  if (kernel != binary_transform_kernels::kernel_op::NONE) {
+    typed_column result;
+    if (binary_transform_kernels::apply_kernel(kernel, left, right, result) &&
+        (result.type() == expr.output_type ||
+         expr.output_type == flex_type_enum::UNDEFINED)) {
+      return result;
+    }
+  }
+
+  std::vector<flexible_type> left_buffer, right_buffer;
+  const auto& l = flexible_values(left, left_buffer);
+  const auto& r = flexible_values(right, right_buffer);
+  bool is_equality = expr.op == "==";
+  bool is_inequality = expr.op == "!=";
+  auto out = std::make_shared<std::vector<flexible_type> >(l.size(), FLEX_UNDEFINED);
+  for (size_t i = 0; i < l.size(); ++i) {
+    bool ldef = l[i].get_type() != flex_type_enum::UNDEFINED;
+    bool rdef = r[i].get_type() != flex_type_enum::UNDEFINED;
+    if (ldef && rdef) {
+      (*out)[i] = convert_value(expr.binary_fn(l[i], r[i]), expr.output_type);
+    } else if (is_equality) {
+      (*out)[i] = flex_int(ldef == rdef);
+    } else if (is_inequality) {
+      (*out)[i] = flex_int(ldef != rdef);
+    }
+  }
+  return make_result(std::move(out));
+}
+
+/**
+ * Evaluates (column == value) or (column != value) on the codes of a string
+ * column read with its dictionary (see column_dictionary.hpp): value is
+ * looked up once in the dictionary, and the codes are compared with its
+ * code, without materializing the strings. Returns false if the operation
+ * cannot be evaluated this way.
+ */
+static bool evaluate_dictionary_comparison(const expression& expr,
+                                           const typed_column& column,
+                                           const flexible_type& value,
+                                           typed_column& out) {
+  bool is_equality = expr.op == "==";
+  if (!is_equality && expr.op != "!=") return false;
+  if (column.type() != flex_type_enum::STRING ||
+      value.get_type() != flex_type_enum::STRING ||
+      (expr.output_type != flex_type_enum::INTEGER &&
+       expr.output_type != flex_type_enum::UNDEFINED)) {
+    return false;
+  }
+  size_t n = column.size();
+  size_t code = 0;
+  if (!column.dictionary()->find(value.get<flex_string>(), code)) {
+    // no string of the column is equal to value
+    out = typed_column(std::vector<flex_int>(n, is_equality ? 0 : 1));
+    return true;
+  }
+  // an UNDEFINED value is different from any string
+  std::vector<flex_int> values(n);
+  const uint32_t* codes = column.code_data();
+  for (size_t i = 0; i < n; ++i) {
+    values[i] = ((codes[i] == code) && column.is_defined(i)) == is_equality;
+  }
+  out = typed_column(std::move(values));
+  return true;
+}
+
+/**
+ * Evaluates (column op value), or (value op column) if value_on_left is
+ * true, without expanding value to a column: on the codes of a string
+ * column, or with the column-vs-scalar kernel of a numeric column. Returns
+ * false if the operation cannot be evaluated this way.
+ */
+static bool evaluate_scalar_binary(const expression& expr,
+                                   const typed_column& column,
+                                   const flexible_type& value,
+                                   bool value_on_left,
+                                   typed_column& out) {
+  // == and != are symmetric
+  if (evaluate_dictionary_comparison(expr, column, value, out)) return true;
+  auto kernel = binary_transform_kernels::get_kernel_op(expr.op);
+  if (kernel == binary_transform_kernels::kernel_op::NONE) return false;
+  typed_column result;
+  if (!binary_transform_kernels::apply_scalar_kernel(kernel, column, value,
+                                                     value_on_left, result) ||
+      (result.type() != expr.output_type &&
+       expr.output_type != flex_type_enum::UNDEFINED)) {
+    return false;
+  }
+  out = std::move(result);
+  return true;
+}
+
+static typed_column evaluate_cast(const expression& expr, const typed_column& arg) {
+  if (arg.type() == expr.output_type) return arg;
+  std::vector<flexible_type> buffer;
+  const auto& values = flexible_values(arg, buffer);
+  auto out = std::make_shared<std::vector<flexible_type> >(values.size(), FLEX_UNDEFINED);
+  for (size_t i = 0; i < values.size(); ++i) {
+    (*out)[i] = convert_value(flexible_type(values[i]), expr.output_type);
+  }
+  return make_result(std::move(out));
+}
+
+static typed_column evaluate_conditional(const expression& expr,
+                                         const typed_column& condition,
+                                         const typed_column& if_true,
+                                         const typed_column& if_false) {
+  std::vector<flexible_type> c_buffer, t_buffer, f_buffer;
+  const auto& c = flexible_values(condition, c_buffer);
+  const auto& t = flexible_values(if_true, t_buffer);
+  const auto& f = flexible_values(if_false, f_buffer);
+  auto out = std::make_shared<std::vector<flexible_type> >(c.size(), FLEX_UNDEFINED);
+  for (size_t i = 0; i < c.size(); ++i) {
+    if (c[i].get_type() == flex_type_enum::UNDEFINED) continue;
+    const auto& val = c[i].is_zero() ? f[i] : t[i];
+    (*out)[i] = convert_value(flexible_type(val), expr.output_type);
+  }
+  return make_result(std::move(out));
+}
+
+void expression_program::evaluate(const std::vector<typed_column>& columns,
+                                  size_t num_rows,
+                                  std::vector<typed_column>& out) const {
+  std::vector<typed_column> results(m_steps.size());
+  // Constants are expanded to a column only when a step reads them as one,
+  // and not when they are the scalar operand of a binary operation.
+  std::vector<bool> evaluated(m_steps.size(), false);
+  auto result = [&](size_t step)->const typed_column& {
+    if (!evaluated[step]) {
+      results[step] = evaluate_constant(*(m_steps[step].expr), num_rows);
+      evaluated[step] = true;
+    }
+    return results[step];
+  };
+  for (size_t i = 0; i < m_steps.size(); ++i) {
+    const expression& expr = *(m_steps[i].expr);
+    const auto& args = m_steps[i].args;
+    switch(expr.type) {
+     case expression::expression_type::COLUMN:
+       ASSERT_LT(expr.column, columns.size());
+       results[i] = columns[expr.column];
+       break;
+     case expression::expression_type::CONSTANT:
+       // expanded by result() when read as a column
+       continue;
+     case expression::expression_type::UNARY:
+       results[i] = evaluate_unary(expr, result(args[0]));
+       break;
+     case expression::expression_type::BINARY:
+       {
+         const expression& left = *(m_steps[args[0]].expr);
+         const expression& right = *(m_steps[args[1]].expr);
+         if (right.type == expression::expression_type::CONSTANT &&
+             evaluate_scalar_binary(expr, result(args[0]), right.value,
+                                    false, results[i])) {
+           break;
+         }
+         if (left.type == expression::expression_type::CONSTANT &&
+             evaluate_scalar_binary(expr, result(args[1]), left.value,
+                                    true, results[i])) {
+           break;
+         }
+         results[i] = evaluate_binary(expr, result(args[0]), result(args[1]));
+       }
+       break;
+     case expression::expression_type::CAST:
+       results[i] = evaluate_cast(expr, result(args[0]));
+       break;
+     case expression::expression_type::CONDITIONAL:
+       results[i] = evaluate_conditional(expr, result(args[0]),
+                                         result(args[1]), result(args[2]));
+       break;
+    }
+    evaluated[i] = true;
+  }
+  out.resize(m_outputs.size());
+  for (size_t i = 0; i < m_outputs.size(); ++i) {
+    out[i] = result(m_outputs[i]);
+  }
+}
+
+} // namespace query_eval
+} // namespace graphlab
@@ -0,0 +1,191 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_MANAGER_EXPRESSION_HPP
+#define GRAPHLAB_SFRAME_QUERY_MANAGER_EXPRESSION_HPP
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/typed_column.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ *
+ * A small expression tree describing how a column is computed from other
+ * columns, so that the query optimizer can see through transforms.
+ *
+ * An expression is one of:
+ *  - COLUMN: column i of the input.
+ *  - CONSTANT: a constant value.
+ *  - UNARY: op(arg), e.g. "-", "!", "abs", "len", "lower", "upper".
+ *  - BINARY: arg0 op arg1, e.g. "+", "-", "*", "/", "%", "<", ">", "<=",
+ *    ">=", "==", "!=", "&", "|".
+ *  - CAST: arg converted to output_type.
+ *  - CONDITIONAL: arg1 if arg0 is non-zero, otherwise arg2.
+ *
+ * The UNDEFINED value propagates: the result of an operation is UNDEFINED
+ * if any argument is UNDEFINED, except for "==" and "!=" which compare the
+ * missing-ness of the values, as the SArray binary operations do. The value
+ * of an operation is always converted to its output_type.
+ *
+ * UNARY and BINARY expressions may carry the element function computing
+ * them (for instance the one of the SArray operations, see
+ * unity_sarray_binary_operations.hpp), which is only called on defined
+ * values. If no function is given, the builtin implementation of the
+ * operator is used, and the operator name, together with the types of the
+ * arguments, fully identifies the function. A given function is identified
+ * by a unique id instead. Two expressions with the same
+ * \ref expression::key compute the same values, which is what makes common
+ * subexpression elimination possible.
+ *
+ * Expressions are immutable and shared.
+ */
+struct expression {
+  enum class expression_type: int {
+    COLUMN, CONSTANT, UNARY, BINARY, CAST, CONDITIONAL
+  };
+
+  typedef std::function<flexible_type(const flexible_type&)> unary_fn_type;
+  typedef std::function<flexible_type(const flexible_type&,
+                                      const flexible_type&)> binary_fn_type;
+
+  expression_type type;
+  flex_type_enum output_type = flex_type_enum::UNDEFINED;
+  /// The input column of a COLUMN expression
+  size_t column = 0;
+  /// The value of a CONSTANT expression
+  flexible_type value;
+  /// The operator of an UNARY or BINARY expression
+  std::string op;
+  std::vector<std::shared_ptr<const expression> > args;
+  unary_fn_type unary_fn;
+  binary_fn_type binary_fn;
+  /// Unique id of the given unary_fn or binary_fn, 0 for builtin operators
+  size_t function_id = 0;
+  /**
+   * A structural description of the expression. Two expressions with the
+   * same key compute the same values.
+   */
+  std::string key;
+};
+
+typedef std::shared_ptr<const expression> expression_ptr;
+
+/// Returns the expression for input column i, of the given type
+expression_ptr make_column_expression(size_t column, flex_type_enum type);
+
+/// Returns a constant expression
+expression_ptr make_constant_expression(const flexible_type& value);
+
+/**
+ * Returns op(arg). If fn is empty, op must be one of the builtin unary
+ * operators "-", "!", "abs", "len", "lower", "upper".
+ */
+expression_ptr make_unary_expression(const std::string& op,
+                                     expression_ptr arg,
+                                     flex_type_enum output_type,
+                                     expression::unary_fn_type fn = nullptr);
+
+/**
+ * Returns left op right. If fn is empty, op must be one of the builtin
+ * binary operators "+", "-", "*", "/", "%", "<", ">", "<=", ">=", "==",
+ * "!=", "&", "|".
+ */
+expression_ptr make_binary_expression(const std::string& op,
+                                      expression_ptr left,
+                                      expression_ptr right,
+                                      flex_type_enum output_type,
+                                      expression::binary_fn_type fn = nullptr);
+
+/// Returns arg converted to type
+expression_ptr make_cast_expression(expression_ptr arg, flex_type_enum type);
+
+/**
+ * Returns if_true where condition is non-zero, and if_false elsewhere.
+ * The result is UNDEFINED where the condition is UNDEFINED.
+ *
+ * \note Both branches are evaluated on the whole block.
+ */
+expression_ptr make_conditional_expression(expression_ptr condition,
+                                           expression_ptr if_true,
+                                           expression_ptr if_false);
+
+/**
+ * Returns the expression with each COLUMN(i) expression replaced by
+ * columns[i]. This composes expressions: if expr is computed from the
+ * outputs of other expressions, the result is computed from their inputs.
+ */
+expression_ptr substitute_columns(const expression_ptr& expr,
+                                  const std::vector<expression_ptr>& columns);
+
+/**
+ * Evaluates a list of expressions over blocks of rows.
+ *
+ * The expressions are flattened into a list of steps, where identical
+ * subexpressions (within an expression or across expressions) appear only
+ * once. Each step is evaluated on the whole block at a time: numeric
+ * operations on packed columns use the columnar kernels (see
+ * binary_transform_kernels.hpp), and all other operations a single loop
+ * over the values.
+ *
+ * \code
+ * auto x = make_column_expression(0, flex_type_enum::INTEGER);
+ * auto y = make_column_expression(1, flex_type_enum::INTEGER);
+ * auto sum = make_binary_expression("+", x, y, flex_type_enum::INTEGER);
+ * expression_program program({sum, make_binary_expression("*", sum, sum,
+ *                                                         flex_type_enum::INTEGER)});
+ * // program.num_steps() == 4: x, y, x + y, (x + y) * (x + y)
+ * std::vector<typed_column> out;
+ * program.evaluate({rows.get_typed_column(0), rows.get_typed_column(1)},
+ *                  rows.num_rows(), out);
+ * \endcode
+ */
+class expression_program {
+ public:
+  expression_program() = default;
+
+  explicit expression_program(const std::vector<expression_ptr>& outputs);
+
+  /// The number of distinct steps evaluated per block
+  inline size_t num_steps() const { return m_steps.size(); }
+
+  /// The number of outputs
+  inline size_t num_outputs() const { return m_outputs.size(); }
+
+  /// Returns true if the program reads input column i
+  bool uses_column(size_t i) const;
+
+  /**
+   * Evaluates the expressions on a block. columns are the input columns
+   * (only the columns used by the program need to be set). Output i is
+   * written to out[i].
+   */
+  void evaluate(const std::vector<typed_column>& columns,
+                size_t num_rows,
+                std::vector<typed_column>& out) const;
+
+ private:
+  size_t add_step(const expression_ptr& expr,
+                  std::map<std::string, size_t>& step_ids);
+
+  struct step {
+    expression_ptr expr;
+    std::vector<size_t> args;
+  };
+  std::vector<step> m_steps;
+  std::vector<size_t> m_outputs;
+};
+
+} // namespace query_eval
+} // namespace graphlab
+#endif
@@ -0,0 +1,208 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_MANAGER_EXPRESSION_TRANSFORM_HPP
+#define GRAPHLAB_SFRAME_QUERY_MANAGER_EXPRESSION_TRANSFORM_HPP
+#include <flexible_type/flexible_type.hpp>
+#include <sframe_query_engine/operators/operator.hpp>
+#include <sframe_query_engine/execution/query_context.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/operators/expression.hpp>
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * An "expression transform" operator computes a list of expressions (see
+ * expression.hpp) over any number of inputs. Each expression produces one
+ * output column.
+ *
+ * The columns of the inputs are numbered in order: the expressions refer
+ * to column j of input i as column (number of columns of inputs 0..i-1) + j.
+ *
+ * The node is not created directly by the users of the query engine.
+ * Instead, transform and binary transform nodes may describe their
+ * function with an expression (the "expression" any-parameter), and the
+ * optimizer converts them into expression transforms, which are then fused
+ * together (see expression_transforms.hpp). Chains of transforms are then
+ * evaluated as a single operator, a whole block at a time, and identical
+ * subexpressions are computed once.
+ */
+template<>
+class operator_impl<planner_node_type::EXPRESSION_TRANSFORM_NODE> : public query_operator {
+ public:
+  planner_node_type type() const { return planner_node_type::EXPRESSION_TRANSFORM_NODE; }
+
+  static std::string name() { return "expression_transform"; }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::LINEAR;
+    ret.num_inputs = -1;
+    return ret;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  inline operator_impl(const std::vector<expression_ptr>& expressions,
+                       const std::vector<size_t>& input_num_columns)
+      : m_program(expressions), m_input_num_columns(input_num_columns) {
+    size_t num_columns = 0;
+    for (size_t n: input_num_columns) num_columns += n;
+    for (size_t i = 0; i < num_columns; ++i) {
+      m_column_used.push_back(m_program.uses_column(i));
+    }
+  }
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(*this);
+  }
+
+  inline void execute(query_context& context) {
+    size_t num_inputs = m_input_num_columns.size();
+    std::vector<std::shared_ptr<const sframe_rows> > inputs(num_inputs);
+    std::vector<typed_column> columns;
+    std::vector<typed_column> results;
+    while(1) {
+      bool all_null = true, any_null = false;
+      for (size_t i = 0; i < num_inputs; ++i) {
+        inputs[i] = context.get_next(i);
+        if (inputs[i] == nullptr) any_null = true;
+        else all_null = false;
+      }
+      if (any_null) {
+        ASSERT_TRUE(all_null);
+        break;
+      }
+
+      // only the columns the expressions read are converted
+      columns.clear();
+      for (size_t i = 0; i < num_inputs; ++i) {
+        ASSERT_EQ(inputs[i]->num_rows(), inputs[0]->num_rows());
+        for (size_t j = 0; j < m_input_num_columns[i]; ++j) {
+          if (m_column_used[columns.size()]) {
+            columns.push_back(inputs[i]->get_typed_column(j));
+          } else {
+            columns.push_back(typed_column());
+          }
+        }
+      }
+
+      m_program.evaluate(columns, inputs[0]->num_rows(), results);
+
+      auto output = context.get_output_buffer();
+      output->clear();
+      for (const auto& result: results) output->add_typed_column(result);
+      context.emit(output);
+    }
+  }
+
+  /**
+   * Creates an expression transform node. Inputs which are repeated, or
+   * not read by any expression, are removed (but at least one input is
+   * kept).
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      const std::vector<std::shared_ptr<planner_node> >& inputs,
+      const std::vector<expression_ptr>& expressions) {
+    ASSERT_GE(inputs.size(), 1);
+    ASSERT_GE(expressions.size(), 1);
+
+    // the columns read by the expressions
+    std::vector<size_t> input_column_begin;
+    size_t num_columns = 0;
+    for (const auto& input: inputs) {
+      input_column_begin.push_back(num_columns);
+      num_columns += infer_planner_node_num_output_columns(input);
+    }
+    expression_program program(expressions);
+
+    // keep the first occurrence of each used input, and renumber the columns
+    std::vector<std::shared_ptr<planner_node> > new_inputs;
+    std::vector<expression_ptr> column_map(num_columns);
+    std::map<std::shared_ptr<planner_node>, size_t> new_input_begin;
+    size_t new_num_columns = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      auto types = infer_planner_node_type(inputs[i]);
+      bool used = false;
+      for (size_t j = 0; j < types.size(); ++j) {
+        used = used || program.uses_column(input_column_begin[i] + j);
+      }
+      if (!used && !(i + 1 == inputs.size() && new_inputs.empty())) continue;
+      if (!new_input_begin.count(inputs[i])) {
+        new_input_begin[inputs[i]] = new_num_columns;
+        new_inputs.push_back(inputs[i]);
+        new_num_columns += types.size();
+      }
+      for (size_t j = 0; j < types.size(); ++j) {
+        column_map[input_column_begin[i] + j] =
+            make_column_expression(new_input_begin[inputs[i]] + j, types[j]);
+      }
+    }
+
+    std::vector<expression_ptr> new_expressions;
+    flex_list keys;
+    flex_list output_types;
+    for (const auto& expr: expressions) {
+      new_expressions.push_back(substitute_columns(expr, column_map));
+      keys.push_back(new_expressions.back()->key);
+      output_types.push_back((int)new_expressions.back()->output_type);
+    }
+
+    return planner_node::make_shared(planner_node_type::EXPRESSION_TRANSFORM_NODE,
+                                     {{"expression_keys", keys},
+                                      {"output_types", output_types}},
+                                     {{"expressions", any(new_expressions)}},
+                                     new_inputs);
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::EXPRESSION_TRANSFORM_NODE);
+    ASSERT_GE(pnode->inputs.size(), 1);
+    ASSERT_TRUE(pnode->any_operator_parameters.count("expressions"));
+    auto expressions = pnode->any_operator_parameters["expressions"]
+                           .as<std::vector<expression_ptr> >();
+    std::vector<size_t> input_num_columns;
+    for (const auto& input: pnode->inputs) {
+      input_num_columns.push_back(infer_planner_node_num_output_columns(input));
+    }
+    return std::make_shared<operator_impl>(expressions, input_num_columns);
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::EXPRESSION_TRANSFORM_NODE);
+    ASSERT_TRUE(pnode->operator_parameters.count("output_types"));
+    const flex_list& output_types =
+        pnode->operator_parameters["output_types"].get<flex_list>();
+    std::vector<flex_type_enum> ret;
+    for (const auto& t: output_types) ret.push_back((flex_type_enum)(flex_int)t);
+    return ret;
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::EXPRESSION_TRANSFORM_NODE);
+    return infer_planner_node_length(pnode->inputs[0]);
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger&) {
+    std::ostringstream out;
+    out << "Expr(" << pnode->operator_parameters["output_types"].size() << ")";
+    return out.str();
+  }
+
+ private:
+  expression_program m_program;
+  std::vector<size_t> m_input_num_columns;
+  std::vector<bool> m_column_used;
+};
+
+typedef operator_impl<planner_node_type::EXPRESSION_TRANSFORM_NODE> op_expression_transform;
+
+} // query_eval
+} // graphlab
+
+#endif // GRAPHLAB_SFRAME_QUERY_MANAGER_EXPRESSION_TRANSFORM_HPP
@@ -0,0 +1,146 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_MANAGER_GROUPBY_AGGREGATE_HPP
+#define GRAPHLAB_SFRAME_QUERY_MANAGER_GROUPBY_AGGREGATE_HPP
+
+#include <sstream>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/group_aggregate_value.hpp>
+#include <sframe_query_engine/operators/operator.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/algorithm/groupby_aggregate.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * A groupby-aggregate of its input.
+ *
+ * This is a blocking node: it is never executed as an operator, but is
+ * materialized by the planner using \ref query_eval::groupby_aggregate.
+ * Having it in the plan lets the optimizer see (and push filters and
+ * projections through) groupbys before anything is materialized.
+ *
+ * The output schema is computed when the node is created, so invalid
+ * arguments fail immediately.
+ */
+template <>
+class operator_impl<planner_node_type::GROUPBY_AGGREGATE_NODE> : public query_operator {
+ public:
+  typedef std::vector<std::pair<std::vector<std::string>,
+                                std::shared_ptr<group_aggregate_value> > > group_type;
+
+  planner_node_type type() const { return planner_node_type::GROUPBY_AGGREGATE_NODE; }
+
+  static std::string name() { return "groupby_aggregate"; }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::BLOCKING;
+    ret.num_inputs = 1;
+    return ret;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  inline operator_impl() {}
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(*this);
+  }
+
+  /**
+   * Creates a groupby-aggregate node. The arguments are the same as for
+   * \ref query_eval::groupby_aggregate.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> source,
+      const std::vector<std::string>& source_column_names,
+      const std::vector<std::string>& keys,
+      const std::vector<std::string>& output_column_names,
+      const group_type& groups) {
+    std::vector<std::string> column_names;
+    std::vector<flex_type_enum> column_types;
+    groupby_aggregate_output_schema(source_column_names,
+                                    infer_planner_node_type(source),
+                                    keys, output_column_names, groups,
+                                    column_names, column_types);
+
+    flex_list flex_column_types;
+    for (auto t: column_types) flex_column_types.push_back((flex_int)t);
+
+    return planner_node::make_shared(
+        planner_node_type::GROUPBY_AGGREGATE_NODE,
+        {{"source_column_names", to_flex_list(source_column_names)},
+         {"keys", to_flex_list(keys)},
+         {"output_column_names", to_flex_list(output_column_names)},
+         {"column_names", to_flex_list(column_names)},
+         {"column_types", flex_column_types}},
+        {{"groups", any(groups)}},
+        {source});
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::GROUPBY_AGGREGATE_NODE);
+    ASSERT_TRUE(pnode->operator_parameters.count("column_types"));
+    std::vector<flex_type_enum> ret;
+    for (const auto& t: pnode->operator_parameters["column_types"].get<flex_list>()) {
+      ret.push_back((flex_type_enum)(flex_int)t);
+    }
+    return ret;
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    return -1;
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger&) {
+    std::ostringstream out;
+    out << "GB(";
+    const auto& keys = pnode->operator_parameters["keys"].get<flex_list>();
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (i > 0) out << ",";
+      out << keys[i].get<flex_string>();
+    }
+    out << ")";
+    return out.str();
+  }
+
+  /**
+   * Runs the groupby described by the node.
+   */
+  static std::shared_ptr<sframe> execute(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::GROUPBY_AGGREGATE_NODE);
+    auto groups = pnode->any_operator_parameters.at("groups").as<group_type>();
+    return query_eval::groupby_aggregate(
+        pnode->inputs[0],
+        from_flex_list(pnode->operator_parameters["source_column_names"]),
+        from_flex_list(pnode->operator_parameters["keys"]),
+        from_flex_list(pnode->operator_parameters["output_column_names"]),
+        groups);
+  }
+
+ private:
+  static flex_list to_flex_list(const std::vector<std::string>& v) {
+    return flex_list(v.begin(), v.end());
+  }
+
+  static std::vector<std::string> from_flex_list(const flexible_type& v) {
+    std::vector<std::string> ret;
+    for (const auto& s: v.get<flex_list>()) ret.push_back(s.get<flex_string>());
+    return ret;
+  }
+};
+
+typedef operator_impl<planner_node_type::GROUPBY_AGGREGATE_NODE> op_groupby_aggregate;
+
+} // query_eval
+} // graphlab
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_MANAGER_JOIN_HPP
+#define GRAPHLAB_SFRAME_QUERY_MANAGER_JOIN_HPP
+
+#include <sstream>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/join.hpp>
+#include <sframe_query_engine/operators/operator.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/planning/planner.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * A join of two inputs on a set of key columns.
+ *
+ * This is a blocking node: it is never executed as an operator, but is
+ * materialized by the planner using \ref graphlab::join on the materialized
+ * inputs. The output has all the columns of the left input, followed by
+ * the non-key columns of the right input (see \ref join_output_schema).
+ */
+template <>
+class operator_impl<planner_node_type::JOIN_NODE> : public query_operator {
+ public:
+  planner_node_type type() const { return planner_node_type::JOIN_NODE; }
+
+  static std::string name() { return "join"; }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::BLOCKING;
+    ret.num_inputs = 2;
+    return ret;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  inline operator_impl() {}
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(*this);
+  }
+
+  /**
+   * Creates a join node.
+   *
+   * \param left The left input
+   * \param right The right input
+   * \param left_column_names The column names of the left input
+   * \param right_column_names The column names of the right input
+   * \param join_type One of "inner", "left", "right" or "outer"
+   * \param join_columns Map from the left key column names to the
+   *                     right key column names
+   * \param left_num_rows The number of rows of the left input, -1 to infer
+   *                      it from the node
+   * \param right_num_rows The number of rows of the right input, -1 to
+   *                       infer it from the node
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> left,
+      std::shared_ptr<planner_node> right,
+      const std::vector<std::string>& left_column_names,
+      const std::vector<std::string>& right_column_names,
+      const std::string& join_type,
+      const std::map<std::string, std::string>& join_columns,
+      int64_t left_num_rows = -1,
+      int64_t right_num_rows = -1) {
+    if (left_num_rows == -1) left_num_rows = infer_planner_node_length(left);
+    if (right_num_rows == -1) right_num_rows = infer_planner_node_length(right);
+    std::vector<std::string> column_names;
+    std::vector<flex_type_enum> column_types;
+    join_output_schema(left_column_names, infer_planner_node_type(left),
+                       right_column_names, infer_planner_node_type(right),
+                       join_type, join_columns,
+                       column_names, column_types,
+                       left_num_rows, right_num_rows);
+
+    flex_list left_keys, right_keys;
+    for (const auto& kv: join_columns) {
+      left_keys.push_back(kv.first);
+      right_keys.push_back(kv.second);
+    }
+    flex_list flex_column_types;
+    for (auto t: column_types) flex_column_types.push_back((flex_int)t);
+
+    return planner_node::make_shared(
+        planner_node_type::JOIN_NODE,
+        {{"left_column_names", flex_list(left_column_names.begin(), left_column_names.end())},
+         {"right_column_names", flex_list(right_column_names.begin(), right_column_names.end())},
+         {"join_type", boost::algorithm::to_lower_copy(join_type)},
+         {"left_keys", left_keys},
+         {"right_keys", right_keys},
+         {"column_names", flex_list(column_names.begin(), column_names.end())},
+         {"column_types", flex_column_types}},
+        {},
+        {left, right});
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::JOIN_NODE);
+    ASSERT_TRUE(pnode->operator_parameters.count("column_types"));
+    std::vector<flex_type_enum> ret;
+    for (const auto& t: pnode->operator_parameters["column_types"].get<flex_list>()) {
+      ret.push_back((flex_type_enum)(flex_int)t);
+    }
+    return ret;
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    return -1;
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger&) {
+    std::ostringstream out;
+    out << "JOIN_" << pnode->operator_parameters["join_type"].get<flex_string>() << "(";
+    const auto& left_keys = pnode->operator_parameters["left_keys"].get<flex_list>();
+    const auto& right_keys = pnode->operator_parameters["right_keys"].get<flex_list>();
+    for (size_t i = 0; i < left_keys.size(); ++i) {
+      if (i > 0) out << ",";
+      out << left_keys[i].get<flex_string>() << "=" << right_keys[i].get<flex_string>();
+    }
+    out << ")";
+    return out.str();
+  }
+
+  /**
+   * Runs the join described by the node. Both inputs are materialized first.
+   */
+  static std::shared_ptr<sframe> execute(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::JOIN_NODE);
+    ASSERT_EQ(pnode->inputs.size(), 2);
+    sframe left = materialize_with_names(pnode->inputs[0],
+                                         pnode->operator_parameters["left_column_names"]);
+    sframe right = materialize_with_names(pnode->inputs[1],
+                                          pnode->operator_parameters["right_column_names"]);
+    std::map<std::string, std::string> join_columns;
+    const auto& left_keys = pnode->operator_parameters["left_keys"].get<flex_list>();
+    const auto& right_keys = pnode->operator_parameters["right_keys"].get<flex_list>();
+    for (size_t i = 0; i < left_keys.size(); ++i) {
+      join_columns[left_keys[i].get<flex_string>()] = right_keys[i].get<flex_string>();
+    }
+    return std::make_shared<sframe>(
+        graphlab::join(left, right, pnode->operator_parameters["join_type"].get<flex_string>(),
+                       join_columns));
+  }
+
+ private:
+  static sframe materialize_with_names(std::shared_ptr<planner_node> pnode,
+                                       const flexible_type& names) {
+    sframe sf = planner().materialize(pnode);
+    std::vector<std::shared_ptr<sarray<flexible_type> > > columns;
+    std::vector<std::string> column_names;
+    for (size_t i = 0; i < sf.num_columns(); ++i) {
+      columns.push_back(sf.select_column(i));
+      column_names.push_back(names.get<flex_list>()[i].get<flex_string>());
+    }
+    return sframe(columns, column_names);
+  }
+};
+
+typedef operator_impl<planner_node_type::JOIN_NODE> op_join;
+
+} // query_eval
+} // graphlab
+
+#endif
@@ -12,6 +12,7 @@
 #include <sframe_query_engine/execution/query_context.hpp>
 #include <sframe_query_engine/operators/operator_properties.hpp>
 #include <lambda/pylambda_function.hpp>
+#include <lambda/lualambda_function.hpp>
 #include <exceptions/error_types.hpp>
 namespace graphlab { 
 namespace query_eval {
@@ -19,6 +20,11 @@ namespace query_eval {
 /**
  * A "transform" operator that applies a python lambda function to a 
  * single stream of input.
+ *
+ * If the lambda string is a Lua lambda (see lambda::is_lua_lambda), it is
+ * instead evaluated in process: every operator instance (one per executing
+ * thread) compiles its own copy of the lambda, and applies it directly to
+ * the incoming batches, without going through the pylambda workers.
  */
 template<>
 class operator_impl<planner_node_type::LAMBDA_TRANSFORM_NODE> : public query_operator {
@@ -42,6 +48,12 @@ class operator_impl<planner_node_type::LAMBDA_TRANSFORM_NODE> : public query_ope
       : m_lambda(lambda), m_output_type(output_type),
         m_column_names(column_names) { }
 
+  inline operator_impl(std::shared_ptr<lambda::lualambda_function> lua_lambda,
+                       flex_type_enum output_type,
+                       const std::vector<std::string>& column_names = {})
+      : m_lua_lambda(lua_lambda), m_output_type(output_type),
+        m_column_names(column_names) { }
+
   inline std::shared_ptr<query_operator> clone() const {
     return std::make_shared<operator_impl>(*this);
   }
@@ -57,7 +69,13 @@ class operator_impl<planner_node_type::LAMBDA_TRANSFORM_NODE> : public query_ope
       std::vector<flexible_type> out;
 
       // TODO exception handling
-      if (m_column_names.empty()) {
+      if (m_lua_lambda) {
+        if (m_column_names.empty()) {
+          m_lua_lambda->eval(*rows, out);
+        } else {
+          m_lua_lambda->eval(m_column_names, *rows, out);
+        }
+      } else if (m_column_names.empty()) {
         // evalute on sarray
         m_lambda->eval(*rows, out);
       } else {
@@ -81,6 +99,20 @@ class operator_impl<planner_node_type::LAMBDA_TRANSFORM_NODE> : public query_ope
       int random_seed = -1) {
 
     flex_list column_names_list(column_names.begin(), column_names.end());
+    if (lambda::is_lua_lambda(lambda_str)) {
+      // Lua lambdas are compiled by each operator instance
+      if (!lambda::lua_lambda_supported()) {
+        log_and_throw("Lua lambdas are not supported: this build does not include LuaJIT");
+      }
+      return planner_node::make_shared(planner_node_type::LAMBDA_TRANSFORM_NODE,
+                                       {{"output_type", (int)(output_type)},
+                                        {"lambda_str", lambda_str},
+                                        {"skip_undefined", (int)(skip_undefined)},
+                                        {"random_seed", (int)(random_seed)},
+                                        {"column_names", column_names_list}},
+                                        {},
+                                       {source});
+    }
     auto lambda_function = std::make_shared<lambda::pylambda_function>(lambda_str);
     lambda_function->set_skip_undefined(skip_undefined);
     lambda_function->set_random_seed(random_seed);
@@ -103,7 +135,6 @@ class operator_impl<planner_node_type::LAMBDA_TRANSFORM_NODE> : public query_ope
     ASSERT_TRUE(pnode->operator_parameters.count("column_names"));
     ASSERT_TRUE(pnode->operator_parameters.count("skip_undefined"));
     ASSERT_TRUE(pnode->operator_parameters.count("random_seed"));
-    ASSERT_TRUE(pnode->any_operator_parameters.count("lambda_fn"));
 
     flex_type_enum output_type = 
         (flex_type_enum)(flex_int)(pnode->operator_parameters["output_type"]);
@@ -111,6 +142,15 @@ class operator_impl<planner_node_type::LAMBDA_TRANSFORM_NODE> : public query_ope
         (pnode->operator_parameters["column_names"]).get<flex_list>();
     std::vector<std::string> column_names(column_names_list.begin(), column_names_list.end());
 
+    std::string lambda_str = pnode->operator_parameters["lambda_str"].get<flex_string>();
+    if (lambda::is_lua_lambda(lambda_str)) {
+      auto lua_fn = std::make_shared<lambda::lualambda_function>(lambda_str);
+      lua_fn->set_skip_undefined(pnode->operator_parameters["skip_undefined"].get<flex_int>());
+      return std::make_shared<operator_impl>(lua_fn, output_type, column_names);
+    }
+
+    ASSERT_TRUE(pnode->any_operator_parameters.count("lambda_fn"));
+
     auto fn = pnode->any_operator_parameters["lambda_fn"]
                             .as<std::shared_ptr<lambda::pylambda_function>>();
     return std::make_shared<operator_impl>(fn, output_type, column_names);
@@ -129,7 +169,12 @@ class operator_impl<planner_node_type::LAMBDA_TRANSFORM_NODE> : public query_ope
 
   static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger&) {
     std::ostringstream out;
-    out << "PyLambda";
+    if (lambda::is_lua_lambda(
+            pnode->operator_parameters["lambda_str"].get<flex_string>())) {
+      out << "LuaLambda";
+    } else {
+      out << "PyLambda";
+    }
 
     flex_list column_names_list =
         (pnode->operator_parameters["column_names"]).get<flex_list>();
@@ -149,6 +194,7 @@ class operator_impl<planner_node_type::LAMBDA_TRANSFORM_NODE> : public query_ope
 
  private:
   std::shared_ptr<lambda::pylambda_function> m_lambda;
+  std::shared_ptr<lambda::lualambda_function> m_lua_lambda;
   flex_type_enum m_output_type;
   std::vector<std::string> m_column_names;
 
@@ -41,13 +41,73 @@ class operator_impl<planner_node_type::LOGICAL_FILTER_NODE> : public query_opera
     return std::make_shared<operator_impl>(*this);
   }
 
-  // tests if the first column of col is all zeros
-  bool is_all_zero(const std::shared_ptr<const sframe_rows>& col) {
-    // if it is all zero, we can skip the left data
-    for (auto& row: *col) {
-      if (!(row[0].is_zero())) return false;
-    } 
-    return true;
+  /**
+   * Computes for each row of the first column of col, whether the row
+   * passes the filter (i.e. is not zero). Returns the number of selected rows.
+   * The mask is read in place, in a single pass: selected is resized, and
+   * its storage reused from block to block. If the mask is held as a 
+   * packed typed column, the packed values are read directly.
+   */
+  size_t compute_selection(const std::shared_ptr<const sframe_rows>& col,
+                           std::vector<unsigned char>& selected) {
+    if (col->has_typed_column(0)) {
+      typed_column typed_mask = col->get_typed_column(0);
+      if (typed_mask.type() == flex_type_enum::INTEGER) {
+        return compute_packed_selection(typed_mask, typed_mask.int_data(), selected);
+      } else if (typed_mask.type() == flex_type_enum::FLOAT) {
+        return compute_packed_selection(typed_mask, typed_mask.float_data(), selected);
+      }
+    }
+    const auto& mask = *(col->cget_columns()[0]);
+    size_t n = mask.size();
+    selected.resize(n);
+    size_t num_selected = 0;
+    for (size_t i = 0; i < n; ++i) {
+      const flexible_type& value = mask[i];
+      unsigned char is_selected;
+      switch (value.get_type()) {
+       case flex_type_enum::INTEGER:
+         is_selected = (value.get<flex_int>() != 0);
+         break;
+       case flex_type_enum::FLOAT:
+         is_selected = (value.get<flex_float>() != 0);
+         break;
+       case flex_type_enum::UNDEFINED:
+         is_selected = 0;
+         break;
+       default:
+         is_selected = !value.is_zero();
+      }
+      selected[i] = is_selected;
+      num_selected += is_selected;
+    }
+    return num_selected;
+  }
+
+  /**
+   * compute_selection() over the values of a packed typed column.
+   */
+  template <typename T>
+  size_t compute_packed_selection(const typed_column& mask,
+                                  const T* values,
+                                  std::vector<unsigned char>& selected) {
+    size_t n = mask.size();
+    selected.resize(n);
+    size_t num_selected = 0;
+    if (mask.all_defined()) {
+      for (size_t i = 0; i < n; ++i) {
+        unsigned char is_selected = (values[i] != 0);
+        selected[i] = is_selected;
+        num_selected += is_selected;
+      }
+    } else {
+      for (size_t i = 0; i < n; ++i) {
+        unsigned char is_selected = mask.is_defined(i) && (values[i] != 0);
+        selected[i] = is_selected;
+        num_selected += is_selected;
+      }
+    }
+    return num_selected;
   }
 
   inline void execute(query_context& context) {
@@ -65,14 +125,15 @@ class operator_impl<planner_node_type::LOGICAL_FILTER_NODE> : public query_opera
     output_buffer->resize(ncols, nrows);
 
 
+    std::vector<unsigned char> selected;
+    compute_selection(rows_right, selected);
     while(1) {
       ASSERT_TRUE(rows_left != nullptr && rows_right != nullptr);
       ASSERT_EQ(rows_left->num_rows(), rows_right->num_rows());
 
       auto left_iter = rows_left->cbegin();
-      auto right_iter = rows_right->cbegin();
-      while(left_iter != rows_left->cend()) {
-        if (!(*right_iter)[0].is_zero()) {
+      for (size_t i = 0; i < selected.size(); ++i, ++left_iter) {
+        if (selected[i]) {
           (*output_buffer)[cur_output_index] = (*left_iter);
           ++cur_output_index;
           if (cur_output_index == nrows) {
@@ -82,15 +143,13 @@ class operator_impl<planner_node_type::LOGICAL_FILTER_NODE> : public query_opera
             cur_output_index = 0;
           }
         }
-        ++left_iter;
-        ++right_iter;
       }
       bool has_data = false;
       do {
         // get the binary column first
         rows_right = context.get_next(1);
         // skip left if it is all zeros
-        if (rows_right != nullptr && is_all_zero(rows_right)) {
+        if (rows_right != nullptr && compute_selection(rows_right, selected) == 0) {
           context.skip_next(0);
         } else {
           has_data = true;
@@ -41,6 +41,12 @@ struct query_operator_attributes {
                             * only, possibly used in the query
                             * optimizer. */
 
+    BLOCKING = 16, /* A blocking operator must consume all of its inputs
+                    * before it can produce any output (groupby, sort,
+                    * join). It never turns into an executor; the planner
+                    * materializes it directly with the corresponding
+                    * algorithm. */
+
     SUPPORTS_SKIPPING = 256, /* If the operator can correctly handle the
                                 skip_next_block emit state */
 
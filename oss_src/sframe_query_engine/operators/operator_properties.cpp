@@ -50,6 +50,18 @@ RetType extract_field(planner_node_type ptype, CallArgs... call_args) {
       return FieldExtractionVisitor<planner_node_type::REDUCE_NODE>::get(call_args...);
     case planner_node_type::GENERALIZED_UNION_PROJECT_NODE:
       return FieldExtractionVisitor<planner_node_type::GENERALIZED_UNION_PROJECT_NODE>::get(call_args...);
+    case planner_node_type::GROUPBY_AGGREGATE_NODE:
+      return FieldExtractionVisitor<planner_node_type::GROUPBY_AGGREGATE_NODE>::get(call_args...);
+    case planner_node_type::SORT_NODE:
+      return FieldExtractionVisitor<planner_node_type::SORT_NODE>::get(call_args...);
+    case planner_node_type::JOIN_NODE:
+      return FieldExtractionVisitor<planner_node_type::JOIN_NODE>::get(call_args...);
+    case planner_node_type::BROADCAST_JOIN_NODE:
+      return FieldExtractionVisitor<planner_node_type::BROADCAST_JOIN_NODE>::get(call_args...);
+    case planner_node_type::WINDOW_AGGREGATE_NODE:
+      return FieldExtractionVisitor<planner_node_type::WINDOW_AGGREGATE_NODE>::get(call_args...);
+    case planner_node_type::EXPRESSION_TRANSFORM_NODE:
+      return FieldExtractionVisitor<planner_node_type::EXPRESSION_TRANSFORM_NODE>::get(call_args...);
     case planner_node_type::IDENTITY_NODE:
       return FieldExtractionVisitor<planner_node_type::IDENTITY_NODE>::get(call_args...);
     case planner_node_type::INVALID:
@@ -265,6 +277,16 @@ bool is_source_node(const pnode_ptr& n) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool is_blocking_node(const query_operator_attributes& attributes) {
+  return attributes.attribute_bitfield & query_operator_attributes::BLOCKING;
+}
+
+bool is_blocking_node(const pnode_ptr& n) {
+  return is_blocking_node(planner_node_type_to_attributes(n->operator_type));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 static size_t _propagate_parallel_slicing(
     const pnode_ptr& n, std::map<pnode_ptr, size_t>& visited, size_t& counter) {
 
@@ -38,6 +38,12 @@ enum class planner_node_type : int {
     UNION_NODE,
     GENERALIZED_UNION_PROJECT_NODE,
     REDUCE_NODE,
+    GROUPBY_AGGREGATE_NODE,
+    SORT_NODE,
+    JOIN_NODE,
+    BROADCAST_JOIN_NODE,
+    WINDOW_AGGREGATE_NODE,
+    EXPRESSION_TRANSFORM_NODE,
 
       // These are used as logical-node-only types.  Do not actually become an operator.
       IDENTITY_NODE,
@@ -132,6 +138,15 @@ bool is_sublinear_transform(const std::shared_ptr<planner_node>& n);
 bool is_source_node(const query_operator_attributes& attr);
 bool is_source_node(const std::shared_ptr<planner_node>& n);
 
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * This operator must see all of its input before producing output, and is
+ * materialized by the planner rather than executed.
+ */
+bool is_blocking_node(const query_operator_attributes& attr);
+bool is_blocking_node(const std::shared_ptr<planner_node>& n);
+
 /** Returns true if the output of this node can be parallel sliceable
  *  by the sources on this block, and false otherwise. 
  */
@@ -52,6 +52,11 @@ struct operator_impl<planner_node_type::REDUCE_NODE> : public query_operator {
       auto rows = context.get_next(0);
       if (rows == nullptr)
         break;
+      // a single typed column may be aggregated without conversion
+      if (rows->num_columns() == 1 && rows->has_typed_column(0) &&
+          m_aggregator->add_typed_column(rows->get_typed_column(0))) {
+        continue;
+      }
       for (const auto& row : *rows) {
         // TODO make add_element take a sframe_row::row_reference instead
         if (row.size() == 1) m_aggregator->add_element_simple(row[0]);
@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_MANAGER_SORT_HPP
+#define GRAPHLAB_SFRAME_QUERY_MANAGER_SORT_HPP
+
+#include <sstream>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe_query_engine/operators/operator.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/algorithm/sort.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * Sorts its input on a subset of the columns.
+ *
+ * This is a blocking node: it is never executed as an operator, but is
+ * materialized by the planner using \ref query_eval::sort.
+ * The output has the same schema and length as the input.
+ */
+template <>
+class operator_impl<planner_node_type::SORT_NODE> : public query_operator {
+ public:
+  planner_node_type type() const { return planner_node_type::SORT_NODE; }
+
+  static std::string name() { return "sort"; }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::BLOCKING;
+    ret.num_inputs = 1;
+    return ret;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  inline operator_impl() {}
+
+  inline std::shared_ptr<query_operator> clone() const {
+    return std::make_shared<operator_impl>(*this);
+  }
+
+  /**
+   * Creates a sort node. The arguments are the same as for
+   * \ref query_eval::sort.
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> source,
+      const std::vector<std::string>& column_names,
+      const std::vector<size_t>& sort_column_indices,
+      const std::vector<bool>& sort_orders) {
+    ASSERT_EQ(sort_column_indices.size(), sort_orders.size());
+    auto column_types = infer_planner_node_type(source);
+    for (size_t idx: sort_column_indices) ASSERT_LT(idx, column_types.size());
+    check_sort_column_types(column_types, sort_column_indices);
+
+    flex_list flex_column_names(column_names.begin(), column_names.end());
+    flex_list flex_indices(sort_column_indices.begin(), sort_column_indices.end());
+    flex_list flex_orders;
+    for (bool order: sort_orders) flex_orders.push_back((flex_int)order);
+
+    return planner_node::make_shared(planner_node_type::SORT_NODE,
+                                     {{"column_names", flex_column_names},
+                                      {"sort_column_indices", flex_indices},
+                                      {"sort_orders", flex_orders}},
+                                     {},
+                                     {source});
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::SORT_NODE);
+    return infer_planner_node_type(pnode->inputs[0]);
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::SORT_NODE);
+    return infer_planner_node_length(pnode->inputs[0]);
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger&) {
+    const auto& indices = pnode->operator_parameters["sort_column_indices"].get<flex_list>();
+    const auto& orders = pnode->operator_parameters["sort_orders"].get<flex_list>();
+    std::ostringstream out;
+    out << "SORT(";
+    for (size_t i = 0; i < indices.size(); ++i) {
+      if (i > 0) out << ",";
+      out << indices[i] << (orders[i].get<flex_int>() ? "+" : "-");
+    }
+    out << ")";
+    return out.str();
+  }
+
+  /**
+   * Runs the sort described by the node.
+   */
+  static std::shared_ptr<sframe> execute(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::SORT_NODE);
+    std::vector<std::string> column_names;
+    for (const auto& name: pnode->operator_parameters["column_names"].get<flex_list>()) {
+      column_names.push_back(name.get<flex_string>());
+    }
+    std::vector<size_t> sort_column_indices;
+    for (const auto& idx: pnode->operator_parameters["sort_column_indices"].get<flex_list>()) {
+      sort_column_indices.push_back(idx.get<flex_int>());
+    }
+    std::vector<bool> sort_orders;
+    for (const auto& order: pnode->operator_parameters["sort_orders"].get<flex_list>()) {
+      sort_orders.push_back(order.get<flex_int>() != 0);
+    }
+    return query_eval::sort(pnode->inputs[0], column_names, sort_column_indices, sort_orders);
+  }
+};
+
+typedef operator_impl<planner_node_type::SORT_NODE> op_sort;
+
+} // query_eval
+} // graphlab
+
+#endif
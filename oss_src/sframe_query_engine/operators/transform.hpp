@@ -13,6 +13,7 @@
 #include <sframe_query_engine/operators/operator.hpp>
 #include <sframe_query_engine/execution/query_context.hpp>
 #include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/operators/expression.hpp>
 namespace graphlab { 
 namespace query_eval {
 
@@ -21,6 +22,26 @@ typedef std::function<flexible_type(const sframe_rows::row&)> transform_type;
 /**
  * A "transform" operator applys a transform function on a 
  * stream of input.
+ *
+ * The transform function is opaque to the query optimizer. The creator of
+ * the planner node may however describe the function with the following
+ * optional operator parameters, which the optimizer may use (for instance
+ * to skip blocks using block statistics):
+ *  - "predicate_op", "predicate_value": The transform computes the 
+ *  comparison (input predicate_op predicate_value) where predicate_op is one
+ *  of "<", ">", "<=", ">=", "==", "!=". UNDEFINED inputs produce UNDEFINED
+ *  outputs, except for "==" and "!=".
+ *  - "predicate_passthrough": The output is zero if and only if the input 
+ *  is zero.
+ *
+ * The creator may also attach the "expression" any-parameter, an
+ * expression_ptr (see expression.hpp) over the input columns which computes
+ * exactly the same values as the transform function. The optimizer then
+ * fuses the transform with neighbouring transforms into a single
+ * expression transform. If the transform is not optimized away, the 
+ * expression is still used to evaluate the transform a whole block at a
+ * time over the typed input columns, instead of calling the function on
+ * each row.
  */
 template<>
 class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
@@ -40,9 +61,14 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
 
   inline operator_impl(const transform_type& f, 
                        flex_type_enum output_type, 
-                       int random_seed=-1)
-      : m_transform_fn(f), m_output_type(output_type), m_random_seed(random_seed)
-  { }
+                       int random_seed=-1,
+                       const expression_ptr& expression = expression_ptr())
+      : m_transform_fn(f), m_output_type(output_type), m_random_seed(random_seed) {
+    if (expression) {
+      m_program = std::make_shared<expression_program>(
+          std::vector<expression_ptr>{expression});
+    }
+  }
   
   inline std::shared_ptr<query_operator> clone() const {
     return std::make_shared<operator_impl>(*this);
@@ -52,11 +78,29 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
     if (m_random_seed != -1){
       random::get_source().seed(m_random_seed + thread::thread_id());
     }
+    std::vector<typed_column> columns;
+    std::vector<typed_column> results;
     while(1) {
       auto rows = context.get_next(0);
       if (rows == nullptr)
         break;
       auto output = context.get_output_buffer();
+      if (m_program) {
+        // only the columns the expression reads are converted
+        columns.clear();
+        for (size_t i = 0; i < rows->num_columns(); ++i) {
+          if (m_program->uses_column(i)) {
+            columns.push_back(rows->get_typed_column(i));
+          } else {
+            columns.push_back(typed_column());
+          }
+        }
+        m_program->evaluate(columns, rows->num_rows(), results);
+        output->clear();
+        output->add_typed_column(results[0]);
+        context.emit(output);
+        continue;
+      }
       output->resize(1, rows->num_rows());
 
       auto iter = rows->cbegin();
@@ -102,7 +146,11 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
         (flex_type_enum)(flex_int)(pnode->operator_parameters["output_type"]);
     fn = pnode->any_operator_parameters["function"].as<transform_type>();
     int random_seed = (int)(flex_int)(pnode->operator_parameters["random_seed"]);
-    return std::make_shared<operator_impl>(fn, output_type, random_seed);
+    expression_ptr expression;
+    if (pnode->any_operator_parameters.count("expression")) {
+      expression = pnode->any_operator_parameters["expression"].as<expression_ptr>();
+    }
+    return std::make_shared<operator_impl>(fn, output_type, random_seed, expression);
   }
 
   static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
@@ -120,6 +168,8 @@ class operator_impl<planner_node_type::TRANSFORM_NODE> : public query_operator {
   transform_type m_transform_fn;
   flex_type_enum m_output_type;
   int m_random_seed;
+  /// Evaluates the "expression" parameter, if any
+  std::shared_ptr<expression_program> m_program;
 };
 
 typedef operator_impl<planner_node_type::TRANSFORM_NODE> op_transform; 
@@ -0,0 +1,258 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_MANAGER_WINDOW_AGGREGATE_HPP
+#define GRAPHLAB_SFRAME_QUERY_MANAGER_WINDOW_AGGREGATE_HPP
+
+#include <sstream>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/group_aggregate_value.hpp>
+#include <sframe_query_engine/operators/operator.hpp>
+#include <sframe_query_engine/execution/query_context.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/operators/sort.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/algorithm/window_aggregate.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * An aggregate over a range of order values, per partition:
+ *
+ * \code
+ * SELECT *, aggregator(value) OVER (PARTITION BY keys ORDER BY order
+ *                                   RANGE BETWEEN range_start AND range_end)
+ * \endcode
+ *
+ * The input of the node is sorted by the keys and the order column; unless
+ * the source is known to be sorted already, the node is created on top of a
+ * SORT_NODE of the source. The node itself streams its input through a
+ * \ref window_aggregate_stream, holding only the rows of the current
+ * windows: over a sorted source, nothing is materialized.
+ *
+ * The output has all the columns of the source followed by the aggregate,
+ * in sorted order. Since the windows span blocks, the node consumes its
+ * input at a different rate than it produces its output, and is not
+ * parallel sliceable.
+ */
+template <>
+class operator_impl<planner_node_type::WINDOW_AGGREGATE_NODE> : public query_operator {
+ public:
+  planner_node_type type() const { return planner_node_type::WINDOW_AGGREGATE_NODE; }
+
+  static std::string name() { return "window_aggregate"; }
+
+  static query_operator_attributes attributes() {
+    query_operator_attributes ret;
+    ret.attribute_bitfield = query_operator_attributes::NONE;
+    ret.num_inputs = 1;
+    return ret;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+
+  inline operator_impl(const std::vector<size_t>& key_columns,
+                       size_t order_column,
+                       size_t value_column,
+                       std::shared_ptr<group_aggregate_value> aggregator,
+                       flex_type_enum value_type,
+                       double range_start,
+                       double range_end)
+      : m_key_columns(key_columns), m_order_column(order_column),
+        m_value_column(value_column), m_aggregator(aggregator),
+        m_value_type(value_type), m_range_start(range_start),
+        m_range_end(range_end) {}
+
+  inline std::shared_ptr<query_operator> clone() const {
+    std::shared_ptr<group_aggregate_value> agg(m_aggregator->new_instance());
+    return std::make_shared<operator_impl>(m_key_columns, m_order_column,
+                                           m_value_column, agg, m_value_type,
+                                           m_range_start, m_range_end);
+  }
+
+  inline void execute(query_context& context) {
+    window_aggregate_stream stream(m_key_columns, m_order_column, m_value_column,
+                                   m_aggregator, m_value_type,
+                                   m_range_start, m_range_end);
+    std::vector<std::vector<flexible_type> > ready;
+    while (auto rows = context.get_next(0)) {
+      for (const auto& row: *rows) {
+        stream.add(std::vector<flexible_type>(row), ready);
+      }
+      emit_rows(context, ready, false);
+    }
+    stream.finish(ready);
+    emit_rows(context, ready, true);
+  }
+
+  /**
+   * Creates a window aggregate node.
+   *
+   * \param source The source
+   * \param source_column_names The column names of the source
+   * \param keys The partition columns. May be empty.
+   * \param order_column The int, float or datetime column ordering the rows
+   *                     of a partition (datetimes are in seconds)
+   * \param value_column The aggregated column
+   * \param aggregator The aggregator, as used by groupby
+   * \param range_start The start of the window relative to the order value
+   *                    of each row, inclusive
+   * \param range_end The end of the window relative to the order value of
+   *                  each row, inclusive
+   * \param output_column_name The name of the aggregate column
+   * \param source_is_sorted If true, the source is already sorted by the
+   *                         keys and the order column, and is not sorted
+   *                         again
+   */
+  static std::shared_ptr<planner_node> make_planner_node(
+      std::shared_ptr<planner_node> source,
+      const std::vector<std::string>& source_column_names,
+      const std::vector<std::string>& keys,
+      const std::string& order_column,
+      const std::string& value_column,
+      std::shared_ptr<group_aggregate_value> aggregator,
+      double range_start,
+      double range_end,
+      const std::string& output_column_name,
+      bool source_is_sorted = false) {
+    auto source_types = infer_planner_node_type(source);
+    flex_type_enum output_type = window_aggregate_output_type(
+        source_column_names, source_types, keys, order_column, value_column,
+        aggregator, range_start, range_end);
+    if (std::find(source_column_names.begin(), source_column_names.end(),
+                  output_column_name) != source_column_names.end()) {
+      log_and_throw("Column " + output_column_name + " already exists.");
+    }
+
+    flex_list key_indices;
+    std::vector<size_t> sort_indices;
+    for (const auto& key: keys) {
+      key_indices.push_back(flex_int(index_of(source_column_names, key)));
+      sort_indices.push_back(index_of(source_column_names, key));
+    }
+    sort_indices.push_back(index_of(source_column_names, order_column));
+    if (!source_is_sorted) {
+      source = op_sort::make_planner_node(source, source_column_names, sort_indices,
+                                          std::vector<bool>(sort_indices.size(), true));
+    }
+
+    flex_list column_names(source_column_names.begin(), source_column_names.end());
+    column_names.push_back(output_column_name);
+    flex_list column_types;
+    for (auto t: source_types) column_types.push_back((flex_int)t);
+    column_types.push_back((flex_int)output_type);
+
+    return planner_node::make_shared(
+        planner_node_type::WINDOW_AGGREGATE_NODE,
+        {{"key_columns", key_indices},
+         {"order_column", flex_int(index_of(source_column_names, order_column))},
+         {"value_column", flex_int(index_of(source_column_names, value_column))},
+         {"range_start", flex_float(range_start)},
+         {"range_end", flex_float(range_end)},
+         {"column_names", column_names},
+         {"column_types", column_types}},
+        {{"aggregator", any(aggregator)}},
+        {source});
+  }
+
+  static std::vector<flex_type_enum> infer_type(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::WINDOW_AGGREGATE_NODE);
+    ASSERT_TRUE(pnode->operator_parameters.count("column_types"));
+    std::vector<flex_type_enum> ret;
+    for (const auto& t: pnode->operator_parameters["column_types"].get<flex_list>()) {
+      ret.push_back((flex_type_enum)(flex_int)t);
+    }
+    return ret;
+  }
+
+  static int64_t infer_length(std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::WINDOW_AGGREGATE_NODE);
+    return infer_planner_node_length(pnode->inputs[0]);
+  }
+
+  static std::string repr(std::shared_ptr<planner_node> pnode, pnode_tagger& get_tag) {
+    auto& params = pnode->operator_parameters;
+    const auto& names = params["column_names"].get<flex_list>();
+    std::ostringstream out;
+    out << "Window(" << get_tag(pnode->inputs[0]) << ",";
+    for (const auto& key: params["key_columns"].get<flex_list>()) {
+      out << names[key.get<flex_int>()].get<flex_string>() << ",";
+    }
+    out << names[params["order_column"].get<flex_int>()].get<flex_string>()
+        << "[" << params["range_start"].get<flex_float>()
+        << "," << params["range_end"].get<flex_float>() << "])";
+    return out.str();
+  }
+
+  static std::shared_ptr<query_operator> from_planner_node(
+      std::shared_ptr<planner_node> pnode) {
+    ASSERT_EQ((int)pnode->operator_type, (int)planner_node_type::WINDOW_AGGREGATE_NODE);
+    ASSERT_EQ(pnode->inputs.size(), 1);
+    auto& params = pnode->operator_parameters;
+    // every instance aggregates with its own copy of the aggregator
+    auto aggregator = pnode->any_operator_parameters.at("aggregator")
+                          .as<std::shared_ptr<group_aggregate_value> >();
+    std::shared_ptr<group_aggregate_value> agg(aggregator->new_instance());
+    std::vector<size_t> key_columns;
+    for (const auto& key: params["key_columns"].get<flex_list>()) {
+      key_columns.push_back(key.get<flex_int>());
+    }
+    size_t value_column = params["value_column"].get<flex_int>();
+    return std::make_shared<operator_impl>(
+        key_columns,
+        params["order_column"].get<flex_int>(),
+        value_column,
+        agg,
+        infer_planner_node_type(pnode->inputs[0])[value_column],
+        params["range_start"].get<flex_float>(),
+        params["range_end"].get<flex_float>());
+  }
+
+ private:
+  /**
+   * Emits the rows of ready in blocks of the block size, leaving the rows
+   * which do not fill a block in ready unless all is true.
+   */
+  static void emit_rows(query_context& context,
+                        std::vector<std::vector<flexible_type> >& ready,
+                        bool all) {
+    size_t begin = 0;
+    while (ready.size() - begin >= context.block_size() ||
+           (all && begin < ready.size())) {
+      size_t num_rows = std::min(context.block_size(), ready.size() - begin);
+      auto out = context.get_output_buffer();
+      out->resize(ready[begin].size(), num_rows);
+      for (size_t i = 0; i < num_rows; ++i) {
+        auto& row = ready[begin + i];
+        for (size_t j = 0; j < row.size(); ++j) (*out)[i][j] = std::move(row[j]);
+      }
+      context.emit(out);
+      begin += num_rows;
+    }
+    ready.erase(ready.begin(), ready.begin() + begin);
+  }
+
+  std::vector<size_t> m_key_columns;
+  size_t m_order_column;
+  size_t m_value_column;
+  std::shared_ptr<group_aggregate_value> m_aggregator;
+  flex_type_enum m_value_type;
+  double m_range_start;
+  double m_range_end;
+
+  static size_t index_of(const std::vector<std::string>& names, const std::string& name) {
+    return std::find(names.begin(), names.end(), name) - names.begin();
+  }
+};
+
+typedef operator_impl<planner_node_type::WINDOW_AGGREGATE_NODE> op_window_aggregate;
+
+} // query_eval
+} // graphlab
+
+#endif
@@ -0,0 +1,383 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <set>
+#include <algorithm>
+#include <sframe/sarray.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe_query_engine/planning/cost_model.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/operators/expression.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * The cost per row of the operators, relative to a simple transform.
+ */
+static constexpr double SOURCE_ROW_COST = 0.5;
+static constexpr double LINEAR_ROW_COST = 1;
+static constexpr double LAMBDA_ROW_COST = 20;
+/**
+ * The cost per cell of the blocking operators, and of writing a cell to
+ * disk and reading it back.
+ */
+static constexpr double BLOCKING_CELL_COST = 4;
+static constexpr double MATERIALIZE_CELL_COST = 2;
+
+/**
+ * The size on disk of a cell of a numeric column, and of any other
+ * column, before compression.
+ */
+static constexpr double NUMERIC_CELL_BYTES = 8;
+static constexpr double OTHER_CELL_BYTES = 32;
+
+/**
+ * Returns the estimate of a column of unknown contents, in an output of
+ * num_rows rows.
+ */
+static column_estimate unknown_column(double num_rows) {
+  column_estimate ret;
+  ret.num_distinct = num_rows;
+  return ret;
+}
+
+/**
+ * Returns the estimate of a stored column, of which num_rows rows are
+ * read.
+ */
+static column_estimate stored_column(const sarray<flexible_type>& column, double num_rows) {
+  auto stats = std::make_shared<column_statistics>();
+  if (!stats->from_map(column.get_index_info().statistics)) {
+    return unknown_column(num_rows);
+  }
+  column_estimate ret;
+  ret.num_distinct = std::min(stats->num_distinct, num_rows);
+  ret.statistics = stats;
+  return ret;
+}
+
+/// Limits the number of distinct values of the columns to the number of rows
+static void limit_num_distinct(node_estimate& est) {
+  for (auto& col: est.columns) {
+    col.num_distinct = std::min(col.num_distinct, est.num_rows);
+  }
+}
+
+/// Returns the index of a name in a list of names, or -1 if not found
+static int64_t find_name(const flexible_type& names, const flexible_type& name) {
+  const auto& list = names.get<flex_list>();
+  auto iter = std::find(list.begin(), list.end(), name);
+  if (iter == list.end()) return -1;
+  return iter - list.begin();
+}
+
+const node_estimate& cost_model::estimate(const pnode_ptr& n) {
+  auto iter = m_estimates.find(n.get());
+  if (iter != m_estimates.end()) return iter->second;
+  node_estimate est = estimate_impl(n);
+  int64_t length = infer_planner_node_length(n);
+  if (length >= 0) {
+    est.num_rows = length;
+    est.exact = true;
+  }
+  size_t num_columns = infer_planner_node_num_output_columns(n);
+  while (est.columns.size() < num_columns) est.columns.push_back(unknown_column(est.num_rows));
+  est.columns.resize(num_columns);
+  limit_num_distinct(est);
+  return m_estimates[n.get()] = est;
+}
+
+node_estimate cost_model::estimate_impl(const pnode_ptr& n) {
+  node_estimate ret;
+  // the columns of the inputs, concatenated
+  std::vector<column_estimate> input_columns;
+  double input_rows = 0;
+  for (const auto& input: n->inputs) {
+    const auto& input_est = estimate(input);
+    input_rows = std::max(input_rows, input_est.num_rows);
+    input_columns.insert(input_columns.end(),
+                         input_est.columns.begin(), input_est.columns.end());
+  }
+  ret.num_rows = input_rows;
+  const auto& params = n->operator_parameters;
+
+  switch(n->operator_type) {
+   case planner_node_type::SARRAY_SOURCE_NODE: {
+     const auto& sa = n->any_operator_parameters.at("sarray")
+         .as<std::shared_ptr<sarray<flexible_type> > >();
+     ret.num_rows = params.at("end_index").get<flex_int>() -
+                    params.at("begin_index").get<flex_int>();
+     ret.columns.push_back(stored_column(*sa, ret.num_rows));
+     break;
+   }
+   case planner_node_type::SFRAME_SOURCE_NODE: {
+     const auto& sf = n->any_operator_parameters.at("sframe").as<sframe>();
+     ret.num_rows = params.at("end_index").get<flex_int>() -
+                    params.at("begin_index").get<flex_int>();
+     for (size_t i = 0; i < sf.num_columns(); ++i) {
+       ret.columns.push_back(stored_column(*sf.select_column(i), ret.num_rows));
+     }
+     break;
+   }
+   case planner_node_type::CONSTANT_NODE: {
+     column_estimate col;
+     col.num_distinct = 1;
+     ret.columns.push_back(col);
+     break;
+   }
+   case planner_node_type::PROJECT_NODE:
+     for (const auto& idx: params.at("indices").get<flex_list>()) {
+       ret.columns.push_back(input_columns.at(idx.get<flex_int>()));
+     }
+     break;
+   case planner_node_type::UNION_NODE:
+     ret.columns = input_columns;
+     break;
+   case planner_node_type::GENERALIZED_UNION_PROJECT_NODE: {
+     // the columns are (input, column) pairs
+     std::vector<size_t> input_begin;
+     size_t num_columns = 0;
+     for (const auto& input: n->inputs) {
+       input_begin.push_back(num_columns);
+       num_columns += infer_planner_node_num_output_columns(input);
+     }
+     for (const auto& p: params.at("index_map").get<flex_dict>()) {
+       ret.columns.push_back(input_columns.at(input_begin.at(p.first.get<flex_int>()) +
+                                              p.second.get<flex_int>()));
+     }
+     break;
+   }
+   case planner_node_type::APPEND_NODE: {
+     const auto& first = estimate(n->inputs[0]);
+     const auto& second = estimate(n->inputs[1]);
+     ret.num_rows = first.num_rows + second.num_rows;
+     for (size_t i = 0; i < first.columns.size(); ++i) {
+       column_estimate col;
+       col.num_distinct = std::max(first.columns[i].num_distinct,
+                                   second.columns[i].num_distinct);
+       ret.columns.push_back(col);
+     }
+     break;
+   }
+   case planner_node_type::LOGICAL_FILTER_NODE:
+     ret.num_rows = estimate(n->inputs[0]).num_rows * estimate_selectivity(n->inputs[1]);
+     ret.columns = estimate(n->inputs[0]).columns;
+     break;
+   case planner_node_type::EXPRESSION_TRANSFORM_NODE: {
+     // expressions which copy a column keep its estimate
+     const auto& expressions = n->any_operator_parameters.at("expressions")
+         .as<std::vector<expression_ptr> >();
+     for (const auto& expr: expressions) {
+       if (expr->type == expression::expression_type::COLUMN) {
+         ret.columns.push_back(input_columns.at(expr->column));
+       } else {
+         ret.columns.push_back(unknown_column(ret.num_rows));
+       }
+     }
+     break;
+   }
+   case planner_node_type::REDUCE_NODE:
+     ret.num_rows = 1;
+     break;
+   case planner_node_type::SORT_NODE:
+     ret.columns = input_columns;
+     break;
+   case planner_node_type::WINDOW_AGGREGATE_NODE:
+     // the input columns, followed by the aggregates
+     ret.columns = input_columns;
+     ret.columns.resize(infer_planner_node_num_output_columns(n), unknown_column(ret.num_rows));
+     break;
+   case planner_node_type::GROUPBY_AGGREGATE_NODE:
+     return estimate_groupby(n);
+   case planner_node_type::JOIN_NODE:
+     return estimate_join(n);
+   default:
+     // every other node produces as many rows as its inputs, with
+     // new columns
+     break;
+  }
+  return ret;
+}
+
+node_estimate cost_model::estimate_join(const pnode_ptr& n) {
+  const auto& params = n->operator_parameters;
+  const auto& left = estimate(n->inputs[0]);
+  const auto& right = estimate(n->inputs[1]);
+  const auto& left_names = params.at("left_column_names");
+  const auto& right_names = params.at("right_column_names");
+  const auto& left_keys = params.at("left_keys").get<flex_list>();
+  const auto& right_keys = params.at("right_keys").get<flex_list>();
+  const auto& join_type = params.at("join_type").get<flex_string>();
+
+  // The number of distinct keys on each side. Multiple key columns are
+  // assumed independent.
+  double left_distinct = 1, right_distinct = 1;
+  std::set<int64_t> right_key_columns;
+  for (size_t i = 0; i < left_keys.size(); ++i) {
+    int64_t l = find_name(left_names, left_keys[i]);
+    int64_t r = find_name(right_names, right_keys[i]);
+    left_distinct *= l >= 0 ? std::max(left.columns.at(l).num_distinct, 1.0) : left.num_rows;
+    right_distinct *= r >= 0 ? std::max(right.columns.at(r).num_distinct, 1.0) : right.num_rows;
+    right_key_columns.insert(r);
+  }
+  left_distinct = std::max(1.0, std::min(left_distinct, left.num_rows));
+  right_distinct = std::max(1.0, std::min(right_distinct, right.num_rows));
+
+  node_estimate ret;
+  double matched = left.num_rows * right.num_rows / std::max(left_distinct, right_distinct);
+  if (join_type == "left") {
+    ret.num_rows = std::max(matched, left.num_rows);
+  } else if (join_type == "right") {
+    ret.num_rows = std::max(matched, right.num_rows);
+  } else if (join_type == "outer") {
+    ret.num_rows = std::max(matched, std::max(left.num_rows, right.num_rows));
+  } else {
+    ret.num_rows = matched;
+  }
+  // all the left columns, followed by the right value columns
+  ret.columns = left.columns;
+  for (size_t i = 0; i < right.columns.size(); ++i) {
+    if (!right_key_columns.count(i)) ret.columns.push_back(right.columns[i]);
+  }
+  limit_num_distinct(ret);
+  return ret;
+}
+
+node_estimate cost_model::estimate_groupby(const pnode_ptr& n) {
+  const auto& params = n->operator_parameters;
+  const auto& input = estimate(n->inputs[0]);
+  const auto& source_names = params.at("source_column_names");
+  const auto& keys = params.at("keys").get<flex_list>();
+
+  // the key columns, followed by the aggregates
+  node_estimate ret;
+  double num_groups = 1;
+  for (const auto& key: keys) {
+    int64_t idx = find_name(source_names, key);
+    column_estimate col = idx >= 0 ? input.columns.at(idx) : unknown_column(input.num_rows);
+    num_groups *= std::max(col.num_distinct, 1.0);
+    ret.columns.push_back(col);
+  }
+  ret.num_rows = std::min(num_groups, input.num_rows);
+  limit_num_distinct(ret);
+  return ret;
+}
+
+double cost_model::estimate_selectivity(const pnode_ptr& mask) {
+  pnode_ptr cur = mask;
+  while(cur->operator_type == planner_node_type::TRANSFORM_NODE
+        && cur->operator_parameters.count("predicate_passthrough")) {
+    cur = cur->inputs[0];
+  }
+
+  // a comparison of a column against a constant
+  std::string op;
+  flexible_type value;
+  column_estimate column;
+  if (cur->operator_type == planner_node_type::TRANSFORM_NODE
+      && cur->operator_parameters.count("predicate_op")
+      && cur->operator_parameters.count("predicate_value")) {
+    op = cur->operator_parameters.at("predicate_op").get<flex_string>();
+    value = cur->operator_parameters.at("predicate_value");
+    column = estimate(cur->inputs[0]).columns.at(0);
+  } else if (cur->operator_type == planner_node_type::EXPRESSION_TRANSFORM_NODE) {
+    const auto& expressions = cur->any_operator_parameters.at("expressions")
+        .as<std::vector<expression_ptr> >();
+    if (expressions.size() != 1) return DEFAULT_SELECTIVITY;
+    const auto& expr = expressions[0];
+    if (expr->type != expression::expression_type::BINARY ||
+        expr->args[0]->type != expression::expression_type::COLUMN ||
+        expr->args[1]->type != expression::expression_type::CONSTANT) {
+      return DEFAULT_SELECTIVITY;
+    }
+    op = expr->op;
+    value = expr->args[1]->value;
+    std::vector<column_estimate> input_columns;
+    for (const auto& input: cur->inputs) {
+      const auto& cols = estimate(input).columns;
+      input_columns.insert(input_columns.end(), cols.begin(), cols.end());
+    }
+    column = input_columns.at(expr->args[0]->column);
+  } else {
+    return DEFAULT_SELECTIVITY;
+  }
+  if (op != "<" && op != ">" && op != "<=" && op != ">=" && op != "==" && op != "!=") {
+    return DEFAULT_SELECTIVITY;
+  }
+
+  if (column.statistics) return column.statistics->selectivity(op, value);
+  // without statistics, only equality can be estimated
+  double equal = 1.0 / std::max(column.num_distinct, 1.0);
+  if (op == "==") return equal;
+  else if (op == "!=") return 1.0 - equal;
+  else return DEFAULT_SELECTIVITY;
+}
+
+double cost_model::node_cost(const pnode_ptr& n) {
+  double rows = estimate(n).num_rows;
+  double input_rows = 0, input_cells = 0;
+  for (const auto& input: n->inputs) {
+    const auto& est = estimate(input);
+    input_rows = std::max(input_rows, est.num_rows);
+    input_cells += est.num_rows * est.columns.size();
+  }
+  switch(n->operator_type) {
+   case planner_node_type::SARRAY_SOURCE_NODE:
+   case planner_node_type::SFRAME_SOURCE_NODE:
+     return rows * infer_planner_node_num_output_columns(n) * SOURCE_ROW_COST;
+   case planner_node_type::LAMBDA_TRANSFORM_NODE:
+     return input_rows * LAMBDA_ROW_COST;
+   case planner_node_type::PROJECT_NODE:
+   case planner_node_type::UNION_NODE:
+   case planner_node_type::GENERALIZED_UNION_PROJECT_NODE:
+   case planner_node_type::APPEND_NODE:
+     // no computation
+     return 0;
+   default:
+     if (is_blocking_node(n)) return input_cells * BLOCKING_CELL_COST;
+     return input_rows * LINEAR_ROW_COST;
+  }
+}
+
+double cost_model::compute_cost(const pnode_ptr& n) {
+  std::set<const planner_node*> visited;
+  std::vector<pnode_ptr> stack{n};
+  double ret = 0;
+  while (!stack.empty()) {
+    pnode_ptr cur = stack.back();
+    stack.pop_back();
+    if (!visited.insert(cur.get()).second) continue;
+    ret += node_cost(cur);
+    stack.insert(stack.end(), cur->inputs.begin(), cur->inputs.end());
+  }
+  return ret;
+}
+
+double cost_model::materialize_cost(const pnode_ptr& n) {
+  const auto& est = estimate(n);
+  return est.num_rows * est.columns.size() * MATERIALIZE_CELL_COST;
+}
+
+double cost_model::estimate_num_bytes(const pnode_ptr& n) {
+  double bytes_per_row = 0;
+  for (auto type: infer_planner_node_type(n)) {
+    switch(type) {
+     case flex_type_enum::INTEGER:
+     case flex_type_enum::FLOAT:
+     case flex_type_enum::DATETIME:
+       bytes_per_row += NUMERIC_CELL_BYTES;
+       break;
+     default:
+       bytes_per_row += OTHER_CELL_BYTES;
+    }
+  }
+  return estimate(n).num_rows * bytes_per_row;
+}
+
+} // namespace query_eval
+} // namespace graphlab
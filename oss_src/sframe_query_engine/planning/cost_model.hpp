@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_ENGINE_COST_MODEL_HPP
+#define GRAPHLAB_SFRAME_QUERY_ENGINE_COST_MODEL_HPP
+#include <map>
+#include <memory>
+#include <vector>
+#include <sframe/column_statistics.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * \ingroup sframe_query_engine
+ *
+ * The estimated contents of a column of a planner node.
+ */
+struct column_estimate {
+  /// The estimated number of distinct values
+  double num_distinct = 0;
+  /**
+   * The statistics of the stored column the values are read from, if the
+   * values are the values of a stored column (possibly a subset of its
+   * rows). NULL otherwise.
+   */
+  std::shared_ptr<const column_statistics> statistics;
+};
+
+/**
+ * The estimated output of a planner node.
+ */
+struct node_estimate {
+  /// The estimated number of rows
+  double num_rows = 0;
+  /// True if num_rows is exact (see infer_planner_node_length)
+  bool exact = false;
+  /// The estimate of each output column
+  std::vector<column_estimate> columns;
+};
+
+/**
+ * \ingroup sframe_query_engine
+ *
+ * Estimates the number of rows produced by the nodes of a query plan, and
+ * the cost of computing them, so that the optimizer and the planner can
+ * choose between equivalent plans.
+ *
+ * The number of rows of a node is exact when it can be inferred
+ * (see infer_planner_node_length). Otherwise, it is estimated from the
+ * statistics of the stored columns (see column_statistics.hpp), which are
+ * computed when the columns are written:
+ *  - The selectivity of a logical filter is estimated from the quantiles
+ *    and the number of distinct values of the column the mask compares
+ *    against a constant. Masks which cannot be analyzed pass
+ *    DEFAULT_SELECTIVITY of the rows.
+ *  - An inner join produces |L| * |R| / max(distinct(L keys), distinct(R keys))
+ *    rows; left, right and outer joins also keep their unmatched rows.
+ *  - A groupby produces at most the product of the number of distinct
+ *    values of its keys.
+ *
+ * The cost of a plan is expressed in units of one row passing through a
+ * simple operator. It is only meaningful relative to other costs.
+ *
+ * The estimates are memoized: the graph must not be modified during the
+ * lifetime of the cost_model.
+ */
+class cost_model {
+ public:
+  /// The fraction of rows which pass a filter which cannot be analyzed
+  static constexpr double DEFAULT_SELECTIVITY = 1.0 / 3;
+
+  /// Returns the estimated output of a node.
+  const node_estimate& estimate(const pnode_ptr& n);
+
+  /// Returns the estimated number of rows of a node.
+  inline double estimate_num_rows(const pnode_ptr& n) {
+    return estimate(n).num_rows;
+  }
+
+  /// Returns the estimated fraction of the rows where the mask is non-zero.
+  double estimate_selectivity(const pnode_ptr& mask);
+
+  /**
+   * Returns the estimated cost of computing the node, including all the
+   * nodes it depends on. Each node is counted once, even if it is used
+   * several times.
+   */
+  double compute_cost(const pnode_ptr& n);
+
+  /**
+   * Returns the estimated cost of materializing the output of the node
+   * to disk and reading it back (not including the cost of computing it).
+   */
+  double materialize_cost(const pnode_ptr& n);
+
+  /**
+   * Returns the estimated size in bytes of the output of the node once
+   * written to disk.
+   */
+  double estimate_num_bytes(const pnode_ptr& n);
+
+ private:
+  node_estimate estimate_impl(const pnode_ptr& n);
+  node_estimate estimate_join(const pnode_ptr& n);
+  node_estimate estimate_groupby(const pnode_ptr& n);
+  double node_cost(const pnode_ptr& n);
+
+  std::map<const planner_node*, node_estimate> m_estimates;
+};
+
+} // namespace query_eval
+} // namespace graphlab
+#endif
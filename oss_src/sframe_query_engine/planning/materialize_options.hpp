@@ -17,6 +17,8 @@ namespace graphlab {
 class sframe_rows;
 namespace query_eval {
 
+class query_profile;
+
 /**  
  * Materialization options.
  *
@@ -47,7 +49,8 @@ struct materialize_options {
   std::function<bool(size_t, const std::shared_ptr<sframe_rows>&)> write_callback;
 
   /**
-   * Disables query optimizations.
+   * Disables query optimizations, including the reuse of cached
+   * results (see subplan_cache.hpp).
    */
   bool disable_optimization = false;
 
@@ -89,6 +92,13 @@ struct materialize_options {
    * This argument has no effect if \ref write_callback is set.
    */
   std::vector<std::string> output_column_names;
+
+  /**
+   * If set, the rows, time, blocks read and bytes spilled of every
+   * operator executed are recorded in the profile (see query_profile.hpp).
+   * Profiling adds a little overhead to every batch of rows.
+   */
+  std::shared_ptr<query_profile> profile;
 };
 
 } // query_eval
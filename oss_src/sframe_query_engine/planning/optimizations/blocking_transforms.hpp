@@ -0,0 +1,508 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_OPTIMIZATION_BLOCKING_TRANSFORMS_H_
+#define GRAPHLAB_SFRAME_QUERY_OPTIMIZATION_BLOCKING_TRANSFORMS_H_
+
+#include <sframe_query_engine/planning/optimizations/optimization_transforms.hpp>
+#include <sframe_query_engine/planning/optimization_engine.hpp>
+#include <sframe_query_engine/operators/all_operators.hpp>
+#include <sframe_query_engine/planning/optimization_node_info.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/planning/cost_model.hpp>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sframe_constants.hpp>
+
+#include <set>
+#include <algorithm>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * Rewrites a logical filter mask which is computed from the output of a
+ * blocking node so that it is computed from an input of the blocking node
+ * instead.
+ *
+ * column_map[i] is the input column holding the values of output column i,
+ * or -1 if output column i is not available from the input. The mask may
+ * only depend on the blocking node through linear transforms and projections
+ * of mapped columns. Returns nullptr if the mask cannot be rewritten.
+ *
+ * All the nodes of the original mask graph are added to mask_nodes.
+ */
+inline pnode_ptr rewrite_mask_through_blocking_node(
+    pnode_ptr mask, pnode_ptr blocking_node, pnode_ptr input,
+    const std::vector<int64_t>& column_map,
+    std::map<pnode_ptr, pnode_ptr>& memo,
+    std::set<pnode_ptr>& mask_nodes) {
+
+  auto it = memo.find(mask);
+  if (it != memo.end()) return it->second;
+  mask_nodes.insert(mask);
+
+  pnode_ptr ret;
+  if (mask == blocking_node) {
+    std::vector<size_t> indices;
+    for (int64_t c: column_map) {
+      if (c < 0) return memo[mask] = nullptr;
+      indices.push_back(c);
+    }
+    ret = op_project::make_planner_node(input, indices);
+  } else if (mask->operator_type == planner_node_type::PROJECT_NODE
+             && mask->inputs[0] == blocking_node) {
+    std::vector<size_t> indices;
+    for (const auto& idx: mask->operator_parameters.at("indices").get<flex_list>()) {
+      int64_t c = column_map[idx.get<flex_int>()];
+      if (c < 0) return memo[mask] = nullptr;
+      indices.push_back(c);
+    }
+    ret = op_project::make_planner_node(input, indices);
+  } else if (is_linear_transform(mask)) {
+    ret = mask->clone();
+    // the length changes with the input
+    ret->any_operator_parameters.erase("__length_memo__");
+    for (auto& in: ret->inputs) {
+      in = rewrite_mask_through_blocking_node(in, blocking_node, input,
+                                              column_map, memo, mask_nodes);
+      if (in == nullptr) return memo[mask] = nullptr;
+    }
+  }
+  // Anything else (sources, filters, other blocking nodes) depends on
+  // more than the rows of the blocking node.
+  return memo[mask] = ret;
+}
+
+class opt_logical_filter_blocking_node_exchange : public opt_transform {
+
+  bool transform_applies(planner_node_type t) {
+    return (t == planner_node_type::LOGICAL_FILTER_NODE);
+  }
+
+  std::string description() {
+    return "logical_filter(blocking(a), f(blocking(a))) -> blocking(logical_filter(a, f(a)))";
+  }
+
+  /**
+   * Tries to push the filter n into input input_index of its blocking
+   * node. column_map is as in rewrite_mask_through_blocking_node.
+   */
+  bool push_filter(optimization_engine *opt_manager, cnode_info_ptr n,
+                   size_t input_index, const std::vector<int64_t>& column_map) {
+    pnode_ptr blocking_node = n->inputs[0]->pnode;
+    pnode_ptr input = blocking_node->inputs[input_index];
+
+    std::map<pnode_ptr, pnode_ptr> memo;
+    std::set<pnode_ptr> mask_nodes;
+    pnode_ptr new_mask = rewrite_mask_through_blocking_node(
+        n->inputs[1]->pnode, blocking_node, input, column_map, memo, mask_nodes);
+    if (new_mask == nullptr) return false;
+
+    // The blocking node must not be used by anything else, or it would
+    // be computed twice.
+    for (const auto& out: n->inputs[0]->outputs) {
+      if (out->pnode != n->pnode && mask_nodes.count(out->pnode) == 0) return false;
+    }
+
+    pnode_ptr new_blocking_node = blocking_node->clone();
+    new_blocking_node->any_operator_parameters.erase("__length_memo__");
+    new_blocking_node->inputs[input_index] =
+        op_logical_filter::make_planner_node(input, new_mask);
+
+    opt_manager->replace_node(n, new_blocking_node);
+    return true;
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::LOGICAL_FILTER_NODE);
+
+    const auto& b = n->inputs[0];
+
+    if (b->type == planner_node_type::SORT_NODE) {
+      // Row-wise predicates commute with reordering.
+      std::vector<int64_t> column_map(b->num_columns());
+      std::iota(column_map.begin(), column_map.end(), 0);
+      return push_filter(opt_manager, n, 0, column_map);
+
+    } else if (b->type == planner_node_type::GROUPBY_AGGREGATE_NODE) {
+      // A predicate on the keys alone keeps or drops whole groups.
+      const auto& source_names = b->p("source_column_names").get<flex_list>();
+      const auto& output_names = b->p("column_names").get<flex_list>();
+      size_t num_keys = b->p("keys").get<flex_list>().size();
+      std::vector<int64_t> column_map(b->num_columns(), -1);
+      for (size_t i = 0; i < num_keys; ++i) {
+        auto it = std::find(source_names.begin(), source_names.end(), output_names[i]);
+        DASSERT_TRUE(it != source_names.end());
+        column_map[i] = it - source_names.begin();
+      }
+      return push_filter(opt_manager, n, 0, column_map);
+
+    } else if (b->type == planner_node_type::WINDOW_AGGREGATE_NODE) {
+      // A predicate on the partition columns alone keeps or drops whole
+      // partitions, which does not change any window.
+      std::vector<int64_t> column_map(b->num_columns(), -1);
+      for (const auto& key: b->p("key_columns").get<flex_list>()) {
+        column_map[key.get<flex_int>()] = key.get<flex_int>();
+      }
+      return push_filter(opt_manager, n, 0, column_map);
+
+    } else if (b->type == planner_node_type::JOIN_NODE) {
+      // A predicate on the columns of one side can be pushed into that
+      // side, as long as the join does not produce rows with missing values
+      // for that side.
+      const auto& join_type = b->p("join_type").get<flex_string>();
+      const auto& left_names = b->p("left_column_names").get<flex_list>();
+      const auto& right_names = b->p("right_column_names").get<flex_list>();
+      const auto& right_keys = b->p("right_keys").get<flex_list>();
+      size_t num_left = left_names.size();
+
+      if (join_type == "inner" || join_type == "left") {
+        std::vector<int64_t> column_map(b->num_columns(), -1);
+        std::iota(column_map.begin(), column_map.begin() + num_left, 0);
+        if (push_filter(opt_manager, n, 0, column_map)) return true;
+      }
+      if (join_type == "inner" || join_type == "right") {
+        std::vector<int64_t> column_map(b->num_columns(), -1);
+        size_t out_idx = num_left;
+        for (size_t i = 0; i < right_names.size(); ++i) {
+          if (std::find(right_keys.begin(), right_keys.end(), right_names[i])
+              == right_keys.end()) {
+            column_map[out_idx++] = i;
+          }
+        }
+        if (push_filter(opt_manager, n, 1, column_map)) return true;
+      }
+      return false;
+    }
+    return false;
+  }
+};
+
+/** Pushes a projection through a join, so that columns which are not
+ *  needed are never materialized or joined.
+ */
+class opt_project_join_exchange : public opt_transform {
+
+  bool transform_applies(planner_node_type t) {
+    return (t == planner_node_type::PROJECT_NODE);
+  }
+
+  std::string description() {
+    return "project(join(a, b)) -> project(join(project(a), project(b)))";
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::PROJECT_NODE);
+
+    const auto& j = n->inputs[0];
+    if (j->type != planner_node_type::JOIN_NODE || j->outputs.size() > 1)
+      return false;
+
+    const auto& left_names = j->p("left_column_names").get<flex_list>();
+    const auto& right_names = j->p("right_column_names").get<flex_list>();
+    const auto& left_keys = j->p("left_keys").get<flex_list>();
+    const auto& right_keys = j->p("right_keys").get<flex_list>();
+    size_t num_left = left_names.size();
+
+    // The output column each right column becomes, or -1 for keys.
+    std::vector<int64_t> right_output(right_names.size(), -1);
+    for (size_t i = 0, out_idx = num_left; i < right_names.size(); ++i) {
+      if (std::find(right_keys.begin(), right_keys.end(), right_names[i]) == right_keys.end()) {
+        right_output[i] = out_idx++;
+      }
+    }
+
+    std::set<size_t> needed;
+    for (const auto& idx: n->p("indices").get<flex_list>()) needed.insert(idx.get<flex_int>());
+
+    // The keys are always needed.
+    std::vector<size_t> left_columns, right_columns;
+    for (size_t i = 0; i < num_left; ++i) {
+      if (needed.count(i) ||
+          std::find(left_keys.begin(), left_keys.end(), left_names[i]) != left_keys.end()) {
+        left_columns.push_back(i);
+      }
+    }
+    for (size_t i = 0; i < right_names.size(); ++i) {
+      if (right_output[i] == -1 || needed.count(right_output[i])) {
+        right_columns.push_back(i);
+      }
+    }
+
+    if (left_columns.size() == num_left && right_columns.size() == right_names.size())
+      return false;
+
+    std::vector<std::string> new_left_names, new_right_names;
+    std::map<size_t, size_t> new_output_index;
+    for (size_t i = 0; i < left_columns.size(); ++i) {
+      new_left_names.push_back(left_names[left_columns[i]].get<flex_string>());
+      new_output_index[left_columns[i]] = i;
+    }
+    for (size_t i = 0, out_idx = left_columns.size(); i < right_columns.size(); ++i) {
+      new_right_names.push_back(right_names[right_columns[i]].get<flex_string>());
+      if (right_output[right_columns[i]] != -1) {
+        new_output_index[right_output[right_columns[i]]] = out_idx++;
+      }
+    }
+
+    std::map<std::string, std::string> join_columns;
+    for (size_t i = 0; i < left_keys.size(); ++i) {
+      join_columns[left_keys[i].get<flex_string>()] = right_keys[i].get<flex_string>();
+    }
+
+    pnode_ptr left = j->inputs[0]->pnode;
+    pnode_ptr right = j->inputs[1]->pnode;
+    if (left_columns.size() < num_left) {
+      left = op_project::make_planner_node(left, left_columns);
+    }
+    if (right_columns.size() < right_names.size()) {
+      right = op_project::make_planner_node(right, right_columns);
+    }
+    pnode_ptr new_join = op_join::make_planner_node(
+        left, right, new_left_names, new_right_names,
+        j->p("join_type").get<flex_string>(), join_columns);
+
+    std::vector<size_t> indices;
+    for (const auto& idx: n->p("indices").get<flex_list>()) {
+      indices.push_back(new_output_index.at(idx.get<flex_int>()));
+    }
+
+    opt_manager->replace_node(n, op_project::make_planner_node(new_join, indices));
+    return true;
+  }
+};
+
+/** Pushes a projection through a sort, so that only the needed columns
+ *  are sorted.
+ */
+class opt_project_sort_exchange : public opt_transform {
+
+  bool transform_applies(planner_node_type t) {
+    return (t == planner_node_type::PROJECT_NODE);
+  }
+
+  std::string description() {
+    return "project(sort(a)) -> project(sort(project(a)))";
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::PROJECT_NODE);
+
+    const auto& s = n->inputs[0];
+    if (s->type != planner_node_type::SORT_NODE || s->outputs.size() > 1)
+      return false;
+
+    const auto& column_names = s->p("column_names").get<flex_list>();
+    const auto& sort_column_indices = s->p("sort_column_indices").get<flex_list>();
+
+    std::set<size_t> needed;
+    for (const auto& idx: n->p("indices").get<flex_list>()) needed.insert(idx.get<flex_int>());
+    for (const auto& idx: sort_column_indices) needed.insert(idx.get<flex_int>());
+
+    if (needed.size() == s->num_columns())
+      return false;
+
+    std::vector<size_t> columns(needed.begin(), needed.end());
+    std::map<size_t, size_t> new_index;
+    std::vector<std::string> new_column_names;
+    for (size_t i = 0; i < columns.size(); ++i) {
+      new_index[columns[i]] = i;
+      new_column_names.push_back(column_names[columns[i]].get<flex_string>());
+    }
+
+    std::vector<size_t> new_sort_column_indices;
+    std::vector<bool> sort_orders;
+    for (const auto& idx: sort_column_indices) {
+      new_sort_column_indices.push_back(new_index.at(idx.get<flex_int>()));
+    }
+    for (const auto& order: s->p("sort_orders").get<flex_list>()) {
+      sort_orders.push_back(order.get<flex_int>() != 0);
+    }
+
+    pnode_ptr new_sort = op_sort::make_planner_node(
+        op_project::make_planner_node(s->inputs[0]->pnode, columns),
+        new_column_names, new_sort_column_indices, sort_orders);
+
+    std::vector<size_t> indices;
+    for (const auto& idx: n->p("indices").get<flex_list>()) {
+      indices.push_back(new_index.at(idx.get<flex_int>()));
+    }
+
+    opt_manager->replace_node(n, op_project::make_planner_node(new_sort, indices));
+    return true;
+  }
+};
+
+/** Reorders two consecutive inner joins so that the join producing the
+ *  fewest rows (as estimated by the cost model, see cost_model.hpp) is
+ *  computed first.
+ *
+ *  Applies to join(join(a, b), c) when the keys of the outer join are
+ *  columns of a, and the inner join is not used elsewhere. The result is
+ *  join(join(a, c), b), with the columns projected back in the original
+ *  order.
+ */
+class opt_join_reorder : public opt_transform {
+
+  bool transform_applies(planner_node_type t) {
+    return (t == planner_node_type::JOIN_NODE);
+  }
+
+  std::string description() {
+    return "join(join(a, b), c) -> project(join(join(a, c), b))";
+  }
+
+  /**
+   * The joins are only reordered if the new intermediate result is
+   * estimated to be this much smaller, as the estimates are approximate.
+   */
+  static constexpr double MIN_REORDER_GAIN = 2;
+
+  static std::vector<std::string> to_strings(const flex_list& list) {
+    std::vector<std::string> ret;
+    for (const auto& v: list) ret.push_back(v.get<flex_string>());
+    return ret;
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::JOIN_NODE);
+    if (n->p("join_type").get<flex_string>() != "inner") return false;
+
+    cnode_info_ptr inner = n->inputs[0];
+    if (inner->type != planner_node_type::JOIN_NODE
+        || inner->p("join_type").get<flex_string>() != "inner") {
+      return false;
+    }
+    for (const auto& out: inner->outputs) {
+      if (out.get() != n.get()) return false;
+    }
+
+    // The names of the columns of join(a, b), as seen by the outer join.
+    // The first num_a are the columns of a.
+    std::vector<std::string> names = to_strings(n->p("left_column_names").get<flex_list>());
+    std::vector<std::string> inner_a_names =
+        to_strings(inner->p("left_column_names").get<flex_list>());
+    size_t num_a = inner_a_names.size();
+    std::vector<std::string> a_names(names.begin(), names.begin() + num_a);
+
+    std::vector<std::string> outer_left_keys = to_strings(n->p("left_keys").get<flex_list>());
+    std::vector<std::string> outer_right_keys = to_strings(n->p("right_keys").get<flex_list>());
+    std::map<std::string, std::string> ac_keys;
+    for (size_t i = 0; i < outer_left_keys.size(); ++i) {
+      if (std::find(a_names.begin(), a_names.end(), outer_left_keys[i]) == a_names.end()) {
+        return false;
+      }
+      ac_keys[outer_left_keys[i]] = outer_right_keys[i];
+    }
+
+    pnode_ptr a = inner->inputs[0]->pnode;
+    pnode_ptr b = inner->inputs[1]->pnode;
+    pnode_ptr c = n->inputs[1]->pnode;
+    pnode_ptr ac = op_join::make_planner_node(
+        a, c, a_names, to_strings(n->p("right_column_names").get<flex_list>()),
+        "inner", ac_keys);
+
+    cost_model costs;
+    if (MIN_REORDER_GAIN * costs.estimate_num_rows(ac) >= costs.estimate_num_rows(inner->pnode)) {
+      return false;
+    }
+
+    // The keys of the inner join, with the names of the columns of a as
+    // seen by the outer join.
+    std::vector<std::string> inner_left_keys = to_strings(inner->p("left_keys").get<flex_list>());
+    std::vector<std::string> inner_right_keys = to_strings(inner->p("right_keys").get<flex_list>());
+    std::map<std::string, std::string> acb_keys;
+    for (size_t i = 0; i < inner_left_keys.size(); ++i) {
+      size_t pos = std::find(inner_a_names.begin(), inner_a_names.end(), inner_left_keys[i])
+                   - inner_a_names.begin();
+      ASSERT_LT(pos, num_a);
+      acb_keys[a_names[pos]] = inner_right_keys[i];
+    }
+    pnode_ptr acb = op_join::make_planner_node(
+        ac, b, to_strings(ac->operator_parameters.at("column_names").get<flex_list>()),
+        to_strings(inner->p("right_column_names").get<flex_list>()),
+        "inner", acb_keys);
+
+    // Restore the column order: a, the values of b, the values of c.
+    size_t num_b_values = infer_planner_node_num_output_columns(inner->pnode) - num_a;
+    size_t num_c_values = infer_planner_node_num_output_columns(ac) - num_a;
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < num_a; ++i) indices.push_back(i);
+    for (size_t i = 0; i < num_b_values; ++i) indices.push_back(num_a + num_c_values + i);
+    for (size_t i = 0; i < num_c_values; ++i) indices.push_back(num_a + i);
+
+    opt_manager->replace_node(n, op_project::make_planner_node(acb, indices));
+    return true;
+  }
+};
+
+/** Turns a join against a small input into a broadcast join, which holds
+ *  the small input in memory and streams the other one.
+ *
+ *  The size of an input of unknown length (for instance, a filtered input)
+ *  is estimated by the cost model (see cost_model.hpp).
+ */
+class opt_join_to_broadcast_join : public opt_transform {
+
+  bool transform_applies(planner_node_type t) {
+    return (t == planner_node_type::JOIN_NODE);
+  }
+
+  std::string description() {
+    return "join(a, small) -> broadcast_join(a)";
+  }
+
+  /**
+   * An estimated input (for instance, a filtered input) is only held in
+   * memory if its estimated size is this many times below the limit, since
+   * the estimate may be off.
+   */
+  static constexpr double ESTIMATE_SAFETY_FACTOR = 4;
+
+  /// The number of cells of an input. Estimated if the length is not known.
+  static double num_cells(cost_model& costs, const cnode_info_ptr& input) {
+    return costs.estimate_num_rows(input->pnode) * input->num_columns();
+  }
+
+  /// Returns true if an input is small enough to be held in memory.
+  static bool is_small(cost_model& costs, const cnode_info_ptr& input) {
+    double limit = SFRAME_JOIN_BROADCAST_NUM_CELLS;
+    if (!costs.estimate(input->pnode).exact) limit /= ESTIMATE_SAFETY_FACTOR;
+    return num_cells(costs, input) <= limit;
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::JOIN_NODE);
+
+    const auto& join_type = n->p("join_type").get<flex_string>();
+    cost_model costs;
+    double left_cells = num_cells(costs, n->inputs[0]);
+    double right_cells = num_cells(costs, n->inputs[1]);
+    bool left_small = is_small(costs, n->inputs[0]);
+    bool right_small = is_small(costs, n->inputs[1]);
+
+    // The unmatched rows of the small side can not be emitted while
+    // streaming the other side.
+    bool can_build_right = right_small && (join_type == "inner" || join_type == "left");
+    bool can_build_left = left_small && (join_type == "inner" || join_type == "right");
+
+    bool build_is_right;
+    if (can_build_right && can_build_left) {
+      build_is_right = right_cells <= left_cells;
+    } else if (can_build_right || can_build_left) {
+      build_is_right = can_build_right;
+    } else {
+      return false;
+    }
+
+    opt_manager->replace_node(n, op_broadcast_join::make_planner_node(n->pnode, build_is_right));
+    return true;
+  }
+};
+
+}}
+#endif
@@ -0,0 +1,176 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_OPTIMIZATION_EXPRESSION_TRANSFORMS_H_
+#define GRAPHLAB_SFRAME_QUERY_OPTIMIZATION_EXPRESSION_TRANSFORMS_H_
+
+#include <sframe_query_engine/planning/optimizations/optimization_transforms.hpp>
+#include <sframe_query_engine/planning/optimization_engine.hpp>
+#include <sframe_query_engine/operators/all_operators.hpp>
+#include <sframe_query_engine/planning/optimization_node_info.hpp>
+#include <sframe_query_engine/operators/operator_properties.hpp>
+#include <flexible_type/flexible_type.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * Returns the column expressions for all the columns of the inputs,
+ * numbered from offset.
+ */
+static inline std::vector<expression_ptr> expression_input_columns(
+    const std::vector<pnode_ptr>& inputs, size_t offset = 0) {
+  std::vector<expression_ptr> ret;
+  for (const auto& input: inputs) {
+    for (flex_type_enum t: infer_planner_node_type(input)) {
+      ret.push_back(make_column_expression(offset + ret.size(), t));
+    }
+  }
+  return ret;
+}
+
+/**
+ * Returns true if n is an expression transform which is only read by
+ * the node consumer.
+ */
+static inline bool is_fusable_expression(const cnode_info_ptr& n,
+                                         const cnode_info_ptr& consumer) {
+  if (n->type != planner_node_type::EXPRESSION_TRANSFORM_NODE) return false;
+  for (const auto& out: n->outputs) {
+    if (out.get() != consumer.get()) return false;
+  }
+  return true;
+}
+
+/**
+ * Transforms and binary transforms described by an expression become
+ * expression transforms, so that the following transforms can fuse them.
+ */
+class opt_transform_to_expression : public opt_transform {
+
+  std::string description() { return "transform(a) -> expression_transform(a)"; }
+
+  bool transform_applies(planner_node_type t) {
+    return (t == planner_node_type::TRANSFORM_NODE
+            || t == planner_node_type::BINARY_TRANSFORM_NODE);
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    if (!n->has_any_p("expression")) return false;
+    const auto& expr = n->any_p<expression_ptr>("expression");
+    opt_manager->replace_node(
+        n, op_expression_transform::make_planner_node(n->pnode->inputs, {expr}));
+    return true;
+  }
+};
+
+/**
+ * Expression transforms which read the output of other expression
+ * transforms are composed into a single expression transform.
+ */
+class opt_merge_expression_transforms : public opt_transform {
+
+  std::string description() {
+    return "expression_transform(expression_transform(a), b) -> expression_transform(a, b)";
+  }
+
+  bool transform_applies(planner_node_type t) {
+    return t == planner_node_type::EXPRESSION_TRANSFORM_NODE;
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    bool any_fusable = false;
+    for (const auto& input: n->inputs) {
+      any_fusable = any_fusable || is_fusable_expression(input, n);
+    }
+    if (!any_fusable) return false;
+
+    // the expression computing each column of the inputs of n, in terms of
+    // the new inputs
+    std::vector<pnode_ptr> new_inputs;
+    std::vector<expression_ptr> column_map;
+    size_t num_columns = 0;
+    for (const auto& input: n->inputs) {
+      std::vector<pnode_ptr> inputs;
+      if (is_fusable_expression(input, n)) {
+        inputs = input->pnode->inputs;
+        auto columns = expression_input_columns(inputs, num_columns);
+        for (const auto& expr: input->any_p<std::vector<expression_ptr> >("expressions")) {
+          column_map.push_back(substitute_columns(expr, columns));
+        }
+      } else {
+        inputs = {input->pnode};
+        auto columns = expression_input_columns(inputs, num_columns);
+        column_map.insert(column_map.end(), columns.begin(), columns.end());
+      }
+      for (const auto& i: inputs) {
+        num_columns += infer_planner_node_num_output_columns(i);
+        new_inputs.push_back(i);
+      }
+    }
+
+    std::vector<expression_ptr> expressions;
+    for (const auto& expr: n->any_p<std::vector<expression_ptr> >("expressions")) {
+      expressions.push_back(substitute_columns(expr, column_map));
+    }
+    opt_manager->replace_node(
+        n, op_expression_transform::make_planner_node(new_inputs, expressions));
+    return true;
+  }
+};
+
+/**
+ * Expression transforms which are unioned together are merged into a
+ * single expression transform, so that the subexpressions they have in
+ * common are computed once.
+ */
+class opt_union_expression_merge : public opt_transform {
+
+  std::string description() {
+    return "union(expression_transform(a), expression_transform(b)) -> expression_transform(a, b)";
+  }
+
+  bool transform_applies(planner_node_type t) {
+    return t == planner_node_type::UNION_NODE;
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    // merge the first two consecutive expression transforms; the
+    // optimizer takes care of the following ones
+    for (size_t i = 0; i + 1 < n->inputs.size(); ++i) {
+      const auto& first = n->inputs[i];
+      const auto& second = n->inputs[i + 1];
+      if (!is_fusable_expression(first, n) || !is_fusable_expression(second, n)) {
+        continue;
+      }
+      std::vector<pnode_ptr> inputs = first->pnode->inputs;
+      size_t offset = 0;
+      for (const auto& input: inputs) offset += infer_planner_node_num_output_columns(input);
+      std::vector<expression_ptr> expressions =
+          first->any_p<std::vector<expression_ptr> >("expressions");
+      auto columns = expression_input_columns(second->pnode->inputs, offset);
+      for (const auto& expr: second->any_p<std::vector<expression_ptr> >("expressions")) {
+        expressions.push_back(substitute_columns(expr, columns));
+      }
+      inputs.insert(inputs.end(), second->pnode->inputs.begin(), second->pnode->inputs.end());
+      auto merged = op_expression_transform::make_planner_node(inputs, expressions);
+
+      std::vector<pnode_ptr> union_inputs;
+      for (size_t j = 0; j < n->inputs.size(); ++j) {
+        if (j == i) union_inputs.push_back(merged);
+        else if (j != i + 1) union_inputs.push_back(n->inputs[j]->pnode);
+      }
+      opt_manager->replace_node(n, op_union::make_planner_node(union_inputs));
+      return true;
+    }
+    return false;
+  }
+};
+
+}}
+
+#endif
@@ -13,6 +13,8 @@
 #include <sframe_query_engine/operators/all_operators.hpp>
 #include <sframe_query_engine/planning/optimization_node_info.hpp>
 #include <sframe_query_engine/operators/operator_properties.hpp>
+#include <sframe_query_engine/operators/operator_transformations.hpp>
+#include <sframe/sarray_v2_block_statistics.hpp>
 #include <flexible_type/flexible_type.hpp>
 
 #include <array>
@@ -161,6 +163,147 @@ class opt_merge_identical_logical_filters
   }
 };
 
+/** Uses the block statistics of the column a logical filter mask is 
+ *  computed from to drop the row ranges which provably cannot pass the 
+ *  filter.
+ *
+ *  Applies when the mask is a comparison against a constant (a transform 
+ *  annotated with "predicate_op" / "predicate_value", see 
+ *  operators/transform.hpp), possibly followed by transforms annotated with
+ *  "predicate_passthrough", on a single column source. The filter is then
+ *  replaced by an append of filters over the candidate row ranges.
+ */
+class opt_logical_filter_block_statistics_pruning
+    : public opt_logical_filter_transform {
+
+  /// The maximum number of row ranges the filter is split into.
+  static constexpr size_t MAX_PRUNED_RANGES = 16;
+
+  std::string description() {
+    return "logical_filter(a, pred(source)) -> append(logical_filter(a[r], pred(source[r])), ...)";
+  }
+
+  /** 
+   * Finds the sarray and the predicate the mask is computed from.
+   * Returns false if the mask is not of the required form.
+   */
+  static bool get_mask_predicate(pnode_ptr mask,
+                                 std::shared_ptr<sarray<flexible_type> >& column,
+                                 size_t& begin_index, size_t& end_index,
+                                 std::string& op, flexible_type& value) {
+    pnode_ptr cur = mask;
+    while(cur->operator_type == planner_node_type::TRANSFORM_NODE
+          && cur->operator_parameters.count("predicate_passthrough")) {
+      cur = cur->inputs[0];
+    }
+    if (cur->operator_type != planner_node_type::TRANSFORM_NODE
+        || !cur->operator_parameters.count("predicate_op")
+        || !cur->operator_parameters.count("predicate_value")) {
+      return false;
+    }
+    op = cur->operator_parameters.at("predicate_op").get<flex_string>();
+    value = cur->operator_parameters.at("predicate_value");
+    cur = cur->inputs[0];
+
+    size_t column_index = 0;
+    bool projected = false;
+    if (cur->operator_type == planner_node_type::PROJECT_NODE) {
+      const auto& indices = cur->operator_parameters.at("indices").get<flex_list>();
+      if (indices.size() != 1) return false;
+      column_index = indices[0];
+      projected = true;
+      cur = cur->inputs[0];
+      if (cur->operator_type != planner_node_type::SFRAME_SOURCE_NODE) return false;
+    }
+
+    if (cur->operator_type == planner_node_type::SARRAY_SOURCE_NODE) {
+      column = cur->any_operator_parameters.at("sarray")
+          .as<std::shared_ptr<sarray<flexible_type> > >();
+    } else if (cur->operator_type == planner_node_type::SFRAME_SOURCE_NODE) {
+      const auto& sf = cur->any_operator_parameters.at("sframe").as<sframe>();
+      if (!projected && sf.num_columns() != 1) return false;
+      if (column_index >= sf.num_columns()) return false;
+      column = sf.select_column(column_index);
+    } else {
+      return false;
+    }
+    begin_index = cur->operator_parameters.at("begin_index");
+    end_index = cur->operator_parameters.at("end_index");
+    return true;
+  }
+
+  bool apply_transform(optimization_engine *opt_manager, cnode_info_ptr n) {
+    DASSERT_TRUE(n->type == planner_node_type::LOGICAL_FILTER_NODE);
+
+    // Do not prune the same filter twice
+    if(n->has_p("block_statistics_pruned"))
+      return false;
+
+    pnode_ptr data = n->inputs[0]->pnode;
+    pnode_ptr mask = n->inputs[1]->pnode;
+
+    std::shared_ptr<sarray<flexible_type> > column;
+    size_t begin_index = 0, end_index = 0;
+    std::string op;
+    flexible_type value;
+    if (!get_mask_predicate(mask, column, begin_index, end_index, op, value))
+      return false;
+
+    // Both sides must be sliceable to the same row ranges.
+    size_t length = end_index - begin_index;
+    if (!is_linear_graph(data) || !is_linear_graph(mask)
+        || infer_planner_node_length(mask) != int64_t(length)
+        || infer_planner_node_length(data) != int64_t(length)) {
+      return false;
+    }
+
+    std::vector<std::pair<size_t, size_t> > ranges;
+    bool success = v2_block_impl::find_candidate_row_ranges(
+        column->get_index_info(), begin_index, end_index,
+        [&](const v2_block_impl::block_statistics& stats) {
+          return v2_block_impl::block_may_satisfy(stats, op, value);
+        }, ranges);
+    if (!success) return false;
+
+    // Merge the ranges separated by the smallest gaps until there are
+    // few enough of them.
+    while (ranges.size() > MAX_PRUNED_RANGES) {
+      size_t best = 0;
+      for (size_t i = 1; i + 1 < ranges.size(); ++i) {
+        if (ranges[i + 1].first - ranges[i].second <
+            ranges[best + 1].first - ranges[best].second) {
+          best = i;
+        }
+      }
+      ranges[best].second = ranges[best + 1].second;
+      ranges.erase(ranges.begin() + best + 1);
+    }
+
+    // Only worth it if at least half the rows are skipped.
+    size_t candidate_rows = 0;
+    for (const auto& r : ranges) candidate_rows += r.second - r.first;
+    if (2 * candidate_rows > length) return false;
+
+    // Nothing can pass. Keep an empty filter so the types are preserved.
+    if (ranges.empty()) ranges.push_back({begin_index, begin_index});
+
+    pnode_ptr ret;
+    for (const auto& r : ranges) {
+      // data and mask are sliced together so that shared inputs stay shared.
+      std::map<pnode_ptr, pnode_ptr> memo;
+      pnode_ptr sliced_data = make_sliced_graph(data, r.first - begin_index,
+                                                r.second - begin_index, memo);
+      pnode_ptr sliced_mask = make_sliced_graph(mask, r.first - begin_index,
+                                                r.second - begin_index, memo);
+      pnode_ptr filter = op_logical_filter::make_planner_node(sliced_data, sliced_mask);
+      filter->operator_parameters["block_statistics_pruned"] = 1;
+      ret = (ret == nullptr) ? filter : op_append::make_planner_node(ret, filter);
+    }
+
+    opt_manager->replace_node(n, ret);
+    return true;
+  }
+};
 
 }}
 #endif
@@ -12,6 +12,8 @@
 #include <sframe_query_engine/planning/optimizations/logical_filter_transforms.hpp>
 #include <sframe_query_engine/planning/optimizations/general_union_project_transforms.hpp>
 #include <sframe_query_engine/planning/optimizations/source_transforms.hpp>
+#include <sframe_query_engine/planning/optimizations/blocking_transforms.hpp>
+#include <sframe_query_engine/planning/optimizations/expression_transforms.hpp>
 
 namespace graphlab {
 namespace query_eval {
@@ -78,13 +80,17 @@ void populate_transforms(optimization_transform_registry *otr) {
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_union_project_exchange>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_project_append_exchange>());
   otr->register_optimization({1, 2, 3}, std::make_shared<opt_eliminate_singleton_union>());
+  otr->register_optimization({1, 2, 3}, std::make_shared<opt_project_join_exchange>());
+  otr->register_optimization({1, 2, 3}, std::make_shared<opt_project_sort_exchange>());
 
   ////////////////////////////////////////////////////////////////////////////////
   // Optimizations that are allowed to turn the graph into a state
   // which cannot be materialized.
 
+  otr->register_optimization({2}, std::make_shared<opt_logical_filter_block_statistics_pruning>());
   otr->register_optimization({2}, std::make_shared<opt_project_logical_filter_exchange>());
   otr->register_optimization({2}, std::make_shared<opt_logical_filter_linear_transform_exchange>());
+  otr->register_optimization({2}, std::make_shared<opt_logical_filter_blocking_node_exchange>());
 
   // Better logical filter exchanges
   otr->register_optimization({2, 3}, std::make_shared<opt_logical_filter_expanding_project_exchange>());
@@ -95,6 +101,16 @@ void populate_transforms(optimization_transform_registry *otr) {
 
   otr->register_optimization({3}, std::make_shared<opt_merge_identical_logical_filters>());
 
+  // Only once filters and projections were pushed through the joins.
+  otr->register_optimization({3}, std::make_shared<opt_join_reorder>());
+  otr->register_optimization({3}, std::make_shared<opt_join_to_broadcast_join>());
+
+  // Once the filters are in place, fuse the transforms described by
+  // expressions, so that chains of them are evaluated as one operator.
+  otr->register_optimization({3}, std::make_shared<opt_transform_to_expression>());
+  otr->register_optimization({3}, std::make_shared<opt_merge_expression_transforms>());
+  otr->register_optimization({3}, std::make_shared<opt_union_expression_merge>());
+
   ////////////////////////////////////////////////////////////////////////////////
   // Cleanup part 1: merge all the same sources into common nodes.
 
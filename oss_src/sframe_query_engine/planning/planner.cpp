@@ -5,16 +5,21 @@
  * This software may be modified and distributed under the terms
  * of the BSD license. See the LICENSE file for details.
  */
+#include <set>
 #include <dot_graph_printer/dot_graph.hpp>
 #include <sframe_query_engine/execution/execution_node.hpp>
 #include <sframe_query_engine/planning/planner_node.hpp>
 #include <sframe_query_engine/execution/subplan_executor.hpp> 
+#include <sframe_query_engine/execution/query_profile.hpp>
 #include <sframe_query_engine/operators/operator_transformations.hpp>
 #include <sframe_query_engine/operators/all_operators.hpp>
 #include <sframe_query_engine/planning/planner.hpp>
 #include <sframe_query_engine/planning/optimization_engine.hpp>
+#include <sframe_query_engine/planning/cost_model.hpp>
+#include <sframe_query_engine/planning/subplan_cache.hpp>
 #include <sframe_query_engine/query_engine_lock.hpp>
 #include <globals/globals.hpp>
+#include <timer/timer.hpp>
 #include <sframe/sframe.hpp>
 
 namespace graphlab { namespace query_eval {
@@ -23,35 +28,226 @@ size_t SFRAME_MAX_LAZY_NODE_SIZE = 10000;
 
 REGISTER_GLOBAL(int64_t, SFRAME_MAX_LAZY_NODE_SIZE, true);
 
+/**
+ * The depth of the nested calls to planner::materialize.
+ * Protected by the global query lock.
+ */
+static size_t materialize_depth = 0;
+
+struct materialize_depth_guard {
+  materialize_depth_guard() { ++materialize_depth; }
+  ~materialize_depth_guard() { --materialize_depth; }
+};
+
+/**
+ * The profile of the outermost profiled materialization, inherited by the
+ * materializations performed on its behalf (partial materializations,
+ * blocking algorithms, ...). Protected by the global query lock.
+ */
+static std::shared_ptr<query_profile> current_profile;
+
+struct current_profile_guard {
+  std::shared_ptr<query_profile> previous;
+  explicit current_profile_guard(const std::shared_ptr<query_profile>& profile)
+      : previous(current_profile) {
+    current_profile = profile;
+  }
+  ~current_profile_guard() { current_profile = previous; }
+};
+
+
+/**
+ * Returns the largest number of rows read from a source of the graph.
+ */
+static size_t max_source_length(pnode_ptr n) {
+  size_t ret = 0;
+  std::set<pnode_ptr> visited;
+  std::vector<pnode_ptr> stack{n};
+  while (!stack.empty()) {
+    pnode_ptr cur = stack.back();
+    stack.pop_back();
+    if (!visited.insert(cur).second) continue;
+    if (is_source_node(cur)) {
+      if (cur->operator_parameters.count("begin_index") &&
+          cur->operator_parameters.count("end_index")) {
+        size_t begin_index = cur->operator_parameters.at("begin_index");
+        size_t end_index = cur->operator_parameters.at("end_index");
+        ret = std::max(ret, end_index - begin_index);
+      }
+    } else {
+      stack.insert(stack.end(), cur->inputs.begin(), cur->inputs.end());
+    }
+  }
+  return ret;
+}
+
+/**
+ * Builds the in-memory tables of the broadcast joins of a plan before it is
+ * executed, so that they are not materialized from within the worker
+ * threads, and releases them once the execution is over.
+ */
+class broadcast_join_tables_guard {
+ public:
+  explicit broadcast_join_tables_guard(pnode_ptr tip) {
+    std::set<pnode_ptr> visited;
+    find_tables(tip, visited);
+    for (const auto& table: m_tables) table->build();
+  }
+
+  ~broadcast_join_tables_guard() {
+    for (const auto& table: m_tables) table->release();
+  }
+
+ private:
+  void find_tables(pnode_ptr n, std::set<pnode_ptr>& visited) {
+    if (!visited.insert(n).second) return;
+    if (n->operator_type == planner_node_type::BROADCAST_JOIN_NODE) {
+      m_tables.push_back(n->any_operator_parameters.at("build_table")
+                             .as<std::shared_ptr<broadcast_join_table> >());
+    }
+    for (const auto& input: n->inputs) find_tables(input, visited);
+  }
+
+  std::vector<std::shared_ptr<broadcast_join_table> > m_tables;
+};
 
 /**
  * Directly executes a linear query plan potentially parallelizing it if possible.
  * No fast path optimizations. You should use execute_node.
  */
 static sframe execute_node_impl(pnode_ptr input_n, const materialize_options& exec_params) {
+  broadcast_join_tables_guard broadcast_tables(input_n);
+
+  // The profile operator ids are assigned before the graph is segmented,
+  // so that the segments share them.
+  const auto& profile = exec_params.profile;
+  size_t stage_id = 0;
+  timer ti;
+  if (profile) {
+    stage_id = profile->begin_stage(input_n);
+    ti.start();
+  }
+
+  sframe ret;
   // Either run directly, or split it up into a parallel section
   if(is_parallel_slicable(input_n) && (exec_params.num_segments != 0)) {
+    // The sources are split into morsels of about SFRAME_MORSEL_NUM_ROWS
+    // rows, and at least one per output segment, pulled by the worker
+    // threads as they become idle.
     size_t num_segments = exec_params.num_segments;
+    size_t length = max_source_length(input_n);
+    size_t num_morsels = std::max(num_segments,
+                                  (length + SFRAME_MORSEL_NUM_ROWS - 1) / SFRAME_MORSEL_NUM_ROWS);
 
-    std::vector<pnode_ptr> segments(num_segments);
+    std::vector<pnode_ptr> morsels(num_morsels);
 
-    for(size_t segment_idx = 0; segment_idx < num_segments; ++segment_idx) {
+    for(size_t morsel_idx = 0; morsel_idx < num_morsels; ++morsel_idx) {
       std::map<pnode_ptr, pnode_ptr> memo;
-      segments[segment_idx] = make_segmented_graph(input_n, segment_idx, num_segments, memo);
+      morsels[morsel_idx] = make_segmented_graph(input_n, morsel_idx, num_morsels, memo);
     }
 
-    return subplan_executor().run_concat(segments, exec_params);
+    ret = subplan_executor().run_morsels(morsels, exec_params);
   } else {
-    return subplan_executor().run(input_n, exec_params);
+    ret = subplan_executor().run(input_n, exec_params);
   }
+
+  if (profile) profile->end_stage(stage_id, ti.current_time());
+  return ret;
 }
 
 
+/**
+ * The inputs of a node which are materialized separately (for instance,
+ * the two sides of a join) each compute the nodes they have in common.
+ * This materializes the topmost shared nodes once, in place, when reading
+ * them back is estimated to be cheaper than computing them again for each
+ * input (see cost_model.hpp).
+ */
+static void materialize_shared_subplans(const std::vector<pnode_ptr>& inputs) {
+  if (inputs.size() < 2) return;
+
+  // The number of inputs each node is used by
+  std::map<const planner_node*, size_t> num_users;
+  for (const auto& input: inputs) {
+    std::set<const planner_node*> visited;
+    std::vector<const planner_node*> stack{input.get()};
+    while (!stack.empty()) {
+      const planner_node* cur = stack.back();
+      stack.pop_back();
+      if (!visited.insert(cur).second) continue;
+      ++num_users[cur];
+      for (const auto& i: cur->inputs) stack.push_back(i.get());
+    }
+  }
+
+  // The topmost shared nodes, in a deterministic order
+  std::vector<pnode_ptr> shared;
+  std::set<pnode_ptr> visited;
+  std::vector<pnode_ptr> stack(inputs.rbegin(), inputs.rend());
+  while (!stack.empty()) {
+    pnode_ptr cur = stack.back();
+    stack.pop_back();
+    if (!visited.insert(cur).second) continue;
+    if (num_users[cur.get()] > 1) {
+      if (!is_source_node(cur)) shared.push_back(cur);
+    } else {
+      stack.insert(stack.end(), cur->inputs.rbegin(), cur->inputs.rend());
+    }
+  }
+
+  cost_model costs;
+  for (const auto& n: shared) {
+    double recompute_cost = (num_users[n.get()] - 1) * costs.compute_cost(n);
+    if (recompute_cost > costs.materialize_cost(n)) {
+      logstream(LOG_INFO) << "Materializing shared subplan: " << n << std::endl;
+      planner().materialize(n);
+    }
+  }
+}
+
+/**
+ * Materializes a blocking node (groupby, sort, join) using the
+ * corresponding algorithm.
+ */
+static std::shared_ptr<sframe> execute_blocking_node(pnode_ptr input_n) {
+  timer ti;
+  ti.start();
+  materialize_shared_subplans(input_n->inputs);
+  std::shared_ptr<sframe> ret;
+  switch(input_n->operator_type) {
+    case planner_node_type::GROUPBY_AGGREGATE_NODE:
+      ret = op_groupby_aggregate::execute(input_n);
+      break;
+    case planner_node_type::SORT_NODE:
+      ret = op_sort::execute(input_n);
+      break;
+    case planner_node_type::JOIN_NODE:
+      ret = op_join::execute(input_n);
+      break;
+    default:
+      ASSERT_MSG(false, "Not a blocking node");
+      return nullptr;
+  }
+  // the materializations of the inputs are recorded as stages of their own
+  if (current_profile) {
+    current_profile->add_stage(planner_node_type_to_name(input_n->operator_type),
+                               ti.current_time(), ret->num_rows());
+  }
+  return ret;
+}
+
 /**
  * Executes a query plan, potentially parallelizing it if possible.
  * Also implements fast paths in the event the input node is a source node.
  */
 static sframe execute_node(pnode_ptr input_n, const materialize_options& exec_params) {
+  // Blocking nodes are computed by their algorithm; the result is then
+  // written out like any other source.
+  if (is_blocking_node(input_n)) {
+    auto sf = execute_blocking_node(input_n);
+    return execute_node(op_sframe_source::make_planner_node(*sf), exec_params);
+  }
+
   // fast path for SFRAME_SOURCE. If I am not streaming into
   // a callback, I can just call save
   if (exec_params.write_callback == nullptr &&
@@ -188,6 +384,7 @@ static pnode_ptr partial_materialize_impl(pnode_ptr n,
   if(!consumes_inputs_at_same_rates(n)) {
     // consumes inputs at different rates. 
     // materialize all inputs into this node
+    materialize_shared_subplans(n->inputs);
     for(auto& i: n->inputs) {
       // logprogress_stream << "Partial Materializing: " << i << std::endl;
       auto optimized_i = optimization_engine::optimize_planner_graph(i, exec_params);
@@ -209,6 +406,90 @@ static pnode_ptr partial_materialize_impl(pnode_ptr n,
   return memo[n];
 }
 
+/**
+ * Replaces the nodes of the graph whose result is in the subplan cache
+ * (see subplan_cache.hpp) by sources reading the cached results.
+ */
+static void reuse_cached_subplans(pnode_ptr tip) {
+  std::map<const planner_node*, std::pair<bool, uint128_t> > memo;
+  std::set<pnode_ptr> visited;
+  std::vector<pnode_ptr> stack{tip};
+  while (!stack.empty()) {
+    pnode_ptr cur = stack.back();
+    stack.pop_back();
+    if (is_source_node(cur) || !visited.insert(cur).second) continue;
+    uint128_t key = 0;
+    sframe cached;
+    if (subplan_cache::structural_key(cur, key, memo) &&
+        subplan_cache::get_instance().lookup(key, cached)) {
+      logstream(LOG_INFO) << "Reusing cached subplan: " << cur << std::endl;
+      (*cur) = (*op_sframe_source::make_planner_node(cached));
+    } else {
+      stack.insert(stack.end(), cur->inputs.begin(), cur->inputs.end());
+    }
+  }
+}
+
+/**
+ * Materializes the topmost nodes of the graph which are also referenced
+ * from outside of it, for instance a filtered SFrame several columns of
+ * which are materialized one after the other. The other users then read
+ * the result, and graphs built again from the same sources find it in the
+ * subplan cache.
+ *
+ * A node is referenced from outside of the graph if an SArray or an SFrame
+ * holds it through a pnode_handle (see planner_node.hpp). The pnode_ptr
+ * references held only while building or optimizing a graph do not count.
+ *
+ * A node is only materialized if it can be cached, if its estimated size
+ * fits in the cache, and if computing it once more is estimated to cost
+ * more than writing it out (see cost_model.hpp).
+ */
+static void cache_shared_subplans(pnode_ptr tip) {
+  // The nodes referenced from outside of the graph
+  std::set<const planner_node*> shared;
+  std::set<const planner_node*> visited;
+  std::vector<pnode_ptr> stack{tip};
+  while (!stack.empty()) {
+    pnode_ptr cur = stack.back();
+    stack.pop_back();
+    if (!visited.insert(cur.get()).second) continue;
+    if (cur != tip && !is_source_node(cur) && has_external_handles(cur.get())) {
+      shared.insert(cur.get());
+    }
+    stack.insert(stack.end(), cur->inputs.begin(), cur->inputs.end());
+  }
+  if (shared.empty()) return;
+
+  // The topmost shared nodes worth caching. The decisions are all taken
+  // before materializing anything, since materializing modifies the graph.
+  cost_model costs;
+  std::vector<pnode_ptr> to_materialize;
+  visited.clear();
+  std::map<const planner_node*, std::pair<bool, uint128_t> > memo;
+  stack.push_back(tip);
+  while (!stack.empty()) {
+    pnode_ptr cur = stack.back();
+    stack.pop_back();
+    if (!visited.insert(cur.get()).second) continue;
+    if (shared.count(cur.get())) {
+      uint128_t key = 0;
+      if (subplan_cache::structural_key(cur, key, memo) &&
+          costs.estimate_num_bytes(cur) <= SFRAME_SUBPLAN_CACHE_SIZE &&
+          costs.compute_cost(cur) > costs.materialize_cost(cur)) {
+        to_materialize.push_back(cur);
+        continue;
+      }
+    }
+    stack.insert(stack.end(), cur->inputs.begin(), cur->inputs.end());
+  }
+
+  for (const auto& n: to_materialize) {
+    logstream(LOG_INFO) << "Materializing shared subplan for caching: " << n << std::endl;
+    planner().materialize(n);
+  }
+}
+
 pnode_ptr naive_partial_materialize(pnode_ptr n, const materialize_options& exec_params) {
 
   // Recursively call materialize on all parent nodes, replacing them
@@ -244,10 +525,32 @@ static pnode_ptr partial_materialize(pnode_ptr ptip,
 sframe planner::materialize(pnode_ptr ptip, 
                             materialize_options exec_params) {
   std::lock_guard<recursive_mutex> GLOBAL_LOCK(global_query_lock);
+  materialize_depth_guard depth_guard;
+  if (exec_params.profile == nullptr) exec_params.profile = current_profile;
+  current_profile_guard profile_guard(exec_params.profile);
   if (exec_params.num_segments == 0) {
     exec_params.num_segments = thread::cpu_count();
   }
   auto original_ptip = ptip;
+
+  // Reuse the results of the subplans materialized before, and cache the
+  // subplans other graphs depend on. Nested materializations compute
+  // parts of a graph already examined, so only the outermost one looks
+  // for shared subplans. The final result is cached if it is not written
+  // to a location chosen by the caller.
+  uint128_t tip_key = 0;
+  bool cache_result = false;
+  if (exec_params.write_callback == nullptr && !exec_params.naive_mode &&
+      !exec_params.disable_optimization &&
+      SFRAME_SUBPLAN_CACHE_SIZE > 0 && !is_source_node(ptip)) {
+    cache_result = exec_params.output_index_file.empty() &&
+        subplan_cache::structural_key(ptip, tip_key);
+    reuse_cached_subplans(ptip);
+    if (materialize_depth == 1 && !is_source_node(ptip)) {
+      cache_shared_subplans(ptip);
+    }
+  }
+
   // Optimize Query Plan
   if (!is_source_node(ptip)) {
     logstream(LOG_INFO) << "Materializing: " << ptip << std::endl;
@@ -280,6 +583,7 @@ sframe planner::materialize(pnode_ptr ptip,
     // Rewrite the query node to be materialized source node
     auto ret_sf = execute_node(final_node, exec_params);
     (*original_ptip) = (*(op_sframe_source::make_planner_node(ret_sf)));
+    if (cache_result) subplan_cache::get_instance().insert(tip_key, ret_sf);
     return ret_sf;
   } else {
     // there is a callback. push it through to execute parameters.
@@ -46,6 +46,11 @@ class planner {
    *  - \ref planner::execute_node Replicates a plan for parallelization. 
    *                               A private function.
    *  - \ref subplan_executor Executes a restricted plan.
+   *
+   * Results of graphs which can be identified structurally are kept in the
+   * \ref subplan_cache, and the subgraphs found in the cache are replaced
+   * by the cached results. Subgraphs which are also referenced outside of
+   * the graph materialized may be materialized and cached first.
    */
   sframe materialize(std::shared_ptr<planner_node> tip, 
                      materialize_options exec_params = materialize_options());
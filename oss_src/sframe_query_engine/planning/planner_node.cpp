@@ -5,3 +5,33 @@
  * This software may be modified and distributed under the terms
  * of the BSD license. See the LICENSE file for details.
  */
+#include <map>
+#include <mutex>
+#include <parallel/mutex.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/// The number of handles to each node referenced by a pnode_handle
+static mutex handle_lock;
+static std::map<const planner_node*, size_t> num_handles;
+
+void pnode_handle::reset(const pnode_ptr& n) {
+  if (n == m_node) return;
+  std::lock_guard<mutex> guard(handle_lock);
+  if (n) ++num_handles[n.get()];
+  if (m_node) {
+    auto iter = num_handles.find(m_node.get());
+    if (--iter->second == 0) num_handles.erase(iter);
+  }
+  m_node = n;
+}
+
+bool has_external_handles(const planner_node* n) {
+  std::lock_guard<mutex> guard(handle_lock);
+  return num_handles.count(n) > 0;
+}
+
+} // namespace query_eval
+} // namespace graphlab
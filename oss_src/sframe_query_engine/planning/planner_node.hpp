@@ -109,6 +109,49 @@ struct planner_node {
 // A handy typedef 
 typedef std::shared_ptr<planner_node> pnode_ptr; 
 
+/**
+ * A reference to a planner node held by a user visible object (an SArray
+ * or an SFrame), as opposed to the transient references held while
+ * building or optimizing a graph.
+ *
+ * The planner uses the handles to tell which nodes of a graph are also
+ * reachable on their own (see has_external_handles()): further queries are
+ * likely to be built on them, so they may be worth materializing and
+ * caching. A handle otherwise behaves as a pnode_ptr.
+ */
+class pnode_handle {
+ public:
+  pnode_handle() = default;
+  pnode_handle(const pnode_ptr& n) { reset(n); }
+  pnode_handle(const pnode_handle& other) { reset(other.m_node); }
+  pnode_handle& operator=(const pnode_handle& other) {
+    reset(other.m_node);
+    return *this;
+  }
+  pnode_handle& operator=(const pnode_ptr& n) {
+    reset(n);
+    return *this;
+  }
+  ~pnode_handle() { reset(nullptr); }
+
+  /// Points the handle to another node (or to none)
+  void reset(const pnode_ptr& n = pnode_ptr());
+
+  inline operator const pnode_ptr&() const { return m_node; }
+  inline planner_node* operator->() const { return m_node.get(); }
+  inline planner_node& operator*() const { return *m_node; }
+  inline planner_node* get() const { return m_node.get(); }
+  inline explicit operator bool() const { return m_node != nullptr; }
+
+ private:
+  pnode_ptr m_node;
+};
+
+/**
+ * Returns true if the node is referenced by at least one \ref pnode_handle.
+ */
+bool has_external_handles(const planner_node* n);
+
 
 } // namespace query_eval
 } // namespace graphlab
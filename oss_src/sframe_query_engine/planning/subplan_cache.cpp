@@ -0,0 +1,169 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <set>
+#include <algorithm>
+#include <globals/globals.hpp>
+#include <fileio/general_fstream.hpp>
+#include <sframe_query_engine/planning/subplan_cache.hpp>
+#include <sframe_query_engine/operators/expression.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+size_t SFRAME_SUBPLAN_CACHE_SIZE = size_t(1024)*1024*1024;
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t,
+                            SFRAME_SUBPLAN_CACHE_SIZE,
+                            true,
+                            +[](int64_t val){ return val >= 0; });
+
+subplan_cache& subplan_cache::get_instance() {
+  static subplan_cache instance;
+  return instance;
+}
+
+/**
+ * The "any" parameters which do not prevent a node from being identified
+ * structurally: they are redundant with the portable parameters.
+ */
+static bool is_redundant_any_parameter(const pnode_ptr& n,
+                                       const std::string& name) {
+  if (name.compare(0, 2, "__") == 0) return true;
+  switch(n->operator_type) {
+   case planner_node_type::SFRAME_SOURCE_NODE:
+     // identified by "index"
+     return name == "sframe";
+   case planner_node_type::SARRAY_SOURCE_NODE:
+     return name == "sarray";
+   case planner_node_type::LAMBDA_TRANSFORM_NODE:
+     // identified by "lambda_str"
+     return name == "lambda_fn";
+   case planner_node_type::EXPRESSION_TRANSFORM_NODE:
+     // identified by "expression_keys"
+     return name == "expressions";
+   case planner_node_type::TRANSFORM_NODE:
+   case planner_node_type::BINARY_TRANSFORM_NODE:
+     // the function computes the "expression"
+     return name == "function" && n->any_operator_parameters.count("expression");
+   default:
+     return false;
+  }
+}
+
+bool subplan_cache::structural_key(const pnode_ptr& n, uint128_t& key) {
+  std::map<const planner_node*, std::pair<bool, uint128_t> > memo;
+  return structural_key(n, key, memo);
+}
+
+bool subplan_cache::structural_key(const pnode_ptr& n, uint128_t& key,
+                                   std::map<const planner_node*,
+                                            std::pair<bool, uint128_t> >& memo) {
+  auto iter = memo.find(n.get());
+  if (iter != memo.end()) {
+    key = iter->second.second;
+    return iter->second.first;
+  }
+
+  bool ok = true;
+  uint128_t h = hash128(uint64_t(n->operator_type));
+  for (const auto& param: n->operator_parameters) {
+    if (param.first.compare(0, 2, "__") == 0) continue;
+    h = hash128_update(h, param.first);
+    h = hash128_update(h, param.second);
+  }
+  for (const auto& param: n->any_operator_parameters) {
+    if (param.first == "expression" &&
+        (n->operator_type == planner_node_type::TRANSFORM_NODE ||
+         n->operator_type == planner_node_type::BINARY_TRANSFORM_NODE)) {
+      h = hash128_update(h, param.first);
+      h = hash128_update(h, param.second.as<expression_ptr>()->key);
+    } else if (!is_redundant_any_parameter(n, param.first)) {
+      ok = false;
+    }
+  }
+  for (const auto& input: n->inputs) {
+    uint128_t input_key = 0;
+    if (!ok || !structural_key(input, input_key, memo)) {
+      ok = false;
+      break;
+    }
+    h = hash128_combine(h, input_key);
+  }
+
+  memo[n.get()] = {ok, h};
+  key = h;
+  return ok;
+}
+
+bool subplan_cache::lookup(const uint128_t& key, sframe& result) {
+  std::lock_guard<mutex> guard(m_lock);
+  auto iter = m_index.find(key);
+  if (iter == m_index.end()) return false;
+  // move to the front
+  m_entries.splice(m_entries.begin(), m_entries, iter->second);
+  result = iter->second->result;
+  return true;
+}
+
+size_t subplan_cache::file_size(const sframe& sf) {
+  // the columns of an sframe are usually segments of the same files
+  std::set<std::string> files;
+  for (size_t i = 0; i < sf.num_columns(); ++i) {
+    for (const auto& segment: sf.select_column(i)->get_index_info().segment_files) {
+      files.insert(parse_v2_segment_filename(segment).first);
+    }
+  }
+  size_t ret = 0;
+  for (const auto& file: files) {
+    try {
+      general_ifstream fin(file);
+      size_t size = fin.file_size();
+      if (size != (size_t)(-1)) ret += size;
+    } catch (...) {
+      logstream(LOG_WARNING) << "Unable to obtain the size of " << file << std::endl;
+    }
+  }
+  return ret;
+}
+
+void subplan_cache::insert(const uint128_t& key, const sframe& result) {
+  size_t num_bytes = std::max<size_t>(1, file_size(result));
+  std::lock_guard<mutex> guard(m_lock);
+  if (m_index.count(key)) return;
+  if (num_bytes > SFRAME_SUBPLAN_CACHE_SIZE) return;
+  evict(SFRAME_SUBPLAN_CACHE_SIZE - num_bytes);
+  m_entries.push_front(entry{key, result, num_bytes});
+  m_index[key] = m_entries.begin();
+  m_num_bytes += num_bytes;
+}
+
+void subplan_cache::evict(size_t max_bytes) {
+  while (m_num_bytes > max_bytes && !m_entries.empty()) {
+    m_num_bytes -= m_entries.back().num_bytes;
+    m_index.erase(m_entries.back().key);
+    m_entries.pop_back();
+  }
+}
+
+void subplan_cache::clear() {
+  std::lock_guard<mutex> guard(m_lock);
+  evict(0);
+}
+
+size_t subplan_cache::num_entries() const {
+  std::lock_guard<mutex> guard(m_lock);
+  return m_entries.size();
+}
+
+size_t subplan_cache::num_bytes() const {
+  std::lock_guard<mutex> guard(m_lock);
+  return m_num_bytes;
+}
+
+} // namespace query_eval
+} // namespace graphlab
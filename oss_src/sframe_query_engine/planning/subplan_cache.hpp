@@ -0,0 +1,116 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#ifndef GRAPHLAB_SFRAME_QUERY_ENGINE_SUBPLAN_CACHE_HPP
+#define GRAPHLAB_SFRAME_QUERY_ENGINE_SUBPLAN_CACHE_HPP
+#include <map>
+#include <list>
+#include <memory>
+#include <sframe/sframe.hpp>
+#include <parallel/mutex.hpp>
+#include <util/cityhash_gl.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+
+namespace graphlab {
+namespace query_eval {
+
+/**
+ * The maximum total size in bytes of the files of the results held by the
+ * subplan cache. 0 disables the cache.
+ */
+extern size_t SFRAME_SUBPLAN_CACHE_SIZE;
+
+/**
+ * \ingroup sframe_query_engine
+ *
+ * A bounded cache of materialized query results, keyed by the structure of
+ * the planner_node subgraph which computed them, so that materializing a
+ * graph equal to one materialized before (for instance, the same filter of
+ * the same SFrame built again) reuses the result.
+ *
+ * The structural key of a node is a 128 bit hash of its operator type, its
+ * operator parameters and the keys of its inputs. Source nodes are
+ * identified by their index files and row ranges. The "any" parameters
+ * cannot be compared in general: the ones which are redundant with
+ * portable parameters ("sframe", "sarray", "lambda_fn", "expressions") or
+ * which describe the operator structurally ("expression", see
+ * expression.hpp) are accounted for, and a node with any other "any"
+ * parameter (for instance an opaque transform function) has no key. Nor
+ * do the nodes which depend on such a node.
+ *
+ * The cached results are SFrames backed by temporary files: the cache
+ * holds disk space, not memory, and the file of an entry is deleted once
+ * the entry is evicted and no other SFrame references it. The entries are
+ * evicted in least recently used order to keep the total size of their
+ * files below SFRAME_SUBPLAN_CACHE_SIZE. Since the cached results are
+ * immutable, the entries never become invalid.
+ */
+class subplan_cache {
+ public:
+  /// Returns the process-wide cache
+  static subplan_cache& get_instance();
+
+  /**
+   * Computes the structural key of a node. Returns false if the node
+   * cannot be identified structurally.
+   */
+  static bool structural_key(const pnode_ptr& n, uint128_t& key);
+
+  /**
+   * \overload
+   * memo holds the keys of the nodes already visited (or false), and may
+   * be shared by several calls over the same graph.
+   */
+  static bool structural_key(const pnode_ptr& n, uint128_t& key,
+                             std::map<const planner_node*,
+                                      std::pair<bool, uint128_t> >& memo);
+
+  /**
+   * Looks up the result of the subgraph with the given key. Returns true
+   * and sets result on a hit.
+   */
+  bool lookup(const uint128_t& key, sframe& result);
+
+  /**
+   * Stores the result of the subgraph with the given key, evicting the
+   * least recently used entries if needed. Results larger than the whole
+   * budget are not stored.
+   */
+  void insert(const uint128_t& key, const sframe& result);
+
+  /// Removes all the entries
+  void clear();
+
+  /// The number of entries
+  size_t num_entries() const;
+
+  /// The total size in bytes of the files of the entries
+  size_t num_bytes() const;
+
+  /// Returns the total size in bytes of the files an SFrame is stored in
+  static size_t file_size(const sframe& sf);
+
+ private:
+  struct entry {
+    uint128_t key;
+    sframe result;
+    size_t num_bytes;
+  };
+
+  /// Evicts entries until the total is at most max_bytes. Lock held.
+  void evict(size_t max_bytes);
+
+  mutable mutex m_lock;
+  /// The entries, most recently used first
+  std::list<entry> m_entries;
+  std::map<uint128_t, std::list<entry>::iterator> m_index;
+  size_t m_num_bytes = 0;
+};
+
+} // namespace query_eval
+} // namespace graphlab
+#endif
@@ -17,19 +17,27 @@ namespace query_eval {
 
 
 /**
- * Implements a generic aggregator
+ * Implements a generic aggregator.
+ *
+ * An optional column function of the form 
+ * bool f(const typed_column&, T&) aggregates a whole typed column at once.
+ * It returns false if it does not support the column, in which case the 
+ * values are aggregated one at a time.
  */
 template <typename T, typename AggregateFunctionType>
 class generic_aggregator: public group_aggregate_value {
  public:
+   typedef std::function<bool(const typed_column&, T&)> column_function_type;
+
    generic_aggregator():value(T()) { }
-   generic_aggregator(AggregateFunctionType fn, const T& t):
-       fn(fn), initial_value(t), value(t) { }
+   generic_aggregator(AggregateFunctionType fn, const T& t,
+                      column_function_type column_fn = column_function_type()):
+       fn(fn), column_fn(column_fn), initial_value(t), value(t) { }
 
    /// Returns a new empty instance of sum with the same type
    group_aggregate_value* new_instance() const {
      generic_aggregator* ret = 
-         new generic_aggregator(fn, initial_value);
+         new generic_aggregator(fn, initial_value, column_fn);
      return ret;
    }
 
@@ -38,6 +46,11 @@ class generic_aggregator: public group_aggregate_value {
      fn(flex, value);
    }
 
+   /// Adds a typed column, if there is a column function
+   bool add_typed_column(const typed_column& column) {
+     return column_fn && column_fn(column, value);
+   }
+
    /// Emits the result
    flexible_type emit() const {
      // we just emit strings
@@ -72,10 +85,39 @@ class generic_aggregator: public group_aggregate_value {
    }
  private:
    AggregateFunctionType fn;
+   column_function_type column_fn;
    T initial_value;
    T value;
 };
 
+/**
+ * Materializes a reduction of input with the aggregator agg, and combines
+ * the per segment results with aggregate_fn. Used by \ref reduce().
+ */
+template <typename ResultType, 
+          typename AggregateFunctionType>
+ResultType reduce_with_aggregator(
+  std::shared_ptr<planner_node> input,
+  group_aggregate_value& agg,
+  AggregateFunctionType aggregate_fn,
+  ResultType init) {
+  auto output = op_reduce::make_planner_node(input, agg, flex_type_enum::STRING);
+  sframe sf = planner().materialize(output);
+  auto sfreader = sf.get_reader(1);
+  auto iter = sfreader->begin(0);
+  ResultType result = init;
+  ResultType curval;
+  while(iter != sfreader->end(0)) {
+    // data is serialized in an archive:w
+    std::string st = (*iter)[0];
+    iarchive iarc(st.c_str(), st.length());
+    iarc >> curval;
+    aggregate_fn(curval, result);
+    ++iter;
+  }
+  return result;
+}
+
 /**
  * Performs a reduction on input in parallel, this function decides the
  * degree of parallelism, usually depend on number of CPUs.
@@ -101,21 +143,31 @@ ResultType reduce(
   ResultType init = ResultType()) {
  
   generic_aggregator<ResultType, ReduceFunctionType> agg(reduce_fn, init);
-  auto output = op_reduce::make_planner_node(input, agg, flex_type_enum::STRING);
-  sframe sf = planner().materialize(output);
-  auto sfreader = sf.get_reader(1);
-  auto iter = sfreader->begin(0);
-  ResultType result = init;
-  ResultType curval;
-  while(iter != sfreader->end(0)) {
-    // data is serialized in an archive:w
-    std::string st = (*iter)[0];
-    iarchive iarc(st.c_str(), st.length());
-    iarc >> curval;
-    aggregate_fn(curval, result);
-    ++iter;
-  }
-  return result;
+  return reduce_with_aggregator(input, agg, aggregate_fn, init);
+}
+
+/**
+ * Performs a reduction on input in parallel as \ref reduce() above, 
+ * additionally reducing the blocks of input held as typed columns (see 
+ * \ref typed_column) with column_reduce_fn. column_reduce_fn must be
+ * of the form bool f(const typed_column&, reduction_type&), and return
+ * false if it does not support the column, in which case reduce_fn is
+ * used on each value of the column instead.
+ */
+template <typename ResultType, 
+         typename ReduceFunctionType, 
+         typename ColumnReduceFunctionType, 
+          typename AggregateFunctionType>
+ResultType reduce(
+  std::shared_ptr<planner_node> input,
+  ReduceFunctionType reduce_fn,
+  ColumnReduceFunctionType column_reduce_fn,
+  AggregateFunctionType aggregate_fn,
+  ResultType init) {
+ 
+  generic_aggregator<ResultType, ReduceFunctionType> agg(reduce_fn, init, 
+                                                         column_reduce_fn);
+  return reduce_with_aggregator(input, agg, aggregate_fn, init);
 }
 
 } // namespace query_eval
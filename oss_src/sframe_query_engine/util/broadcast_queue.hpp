@@ -297,6 +297,14 @@ class broadcast_queue {
     return m_element_count;
   }
 
+  /**
+   * Returns the number of bytes written to disk so far. A file is
+   * accounted for when it is first read back.
+   */
+  size_t num_bytes_spilled() const {
+    return m_num_bytes_spilled;
+  }
+
   /**
    * Deletes all unused cache files
    */
@@ -311,6 +319,7 @@ class broadcast_queue {
 
   size_t m_cache_limit = 0;
   size_t m_element_count = 0;
+  size_t m_num_bytes_spilled = 0;
   Serializer m_serializer;
 
   /**
@@ -526,6 +535,7 @@ class broadcast_queue {
     m_push_queue.file_name.clear();
     pq->read_handle = std::make_shared<general_ifstream>(pq->file_name);
     pq->file_length = pq->read_handle->file_size();
+    m_num_bytes_spilled += pq->file_length;
     pq->nelements = m_push_queue.nelements - m_push_queue.element_cache.size();
     // insert into the queue
     // update the linked list managed by pop_queue::next_queue
@@ -0,0 +1,60 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <unity/lib/toolkit_function_macros.hpp>
+#include <unity/lib/gl_sframe.hpp>
+#include <sframe/arrow_file.hpp>
+
+using namespace graphlab;
+
+/**
+ * Reads an Arrow IPC file into an SFrame. See read_arrow_file. If columns
+ * is empty, all the columns are read; if record_batches is empty, all the
+ * record batches are read.
+ */
+static gl_sframe read_arrow(const std::string& url,
+                            const std::vector<std::string>& columns,
+                            const std::vector<flexible_type>& record_batches) {
+  arrow_read_options options;
+  options.columns = columns;
+  for (const auto& batch: record_batches) {
+    options.record_batches.push_back(batch.to<flex_int>());
+  }
+  return gl_sframe(read_arrow_file(url, options));
+}
+
+/**
+ * Writes an SFrame of integer, float and string columns into an Arrow IPC
+ * file. See write_arrow_file.
+ */
+static void write_arrow(gl_sframe frame, const std::string& url,
+                        size_t rows_per_batch) {
+  write_arrow_file(frame.materialize_to_sframe(), url, rows_per_batch);
+}
+
+/**
+ * Returns the column names, the column types, and the number of rows of
+ * each record batch of an Arrow IPC file.
+ */
+static flex_dict arrow_info(const std::string& url) {
+  auto info = read_arrow_file_info(url);
+  flex_list names(info.column_names.begin(), info.column_names.end());
+  flex_list types;
+  for (auto type: info.column_types) types.push_back(flex_type_enum_to_name(type));
+  flex_list lengths(info.record_batch_lengths.begin(), info.record_batch_lengths.end());
+  return {{"column_names", names},
+          {"column_types", types},
+          {"record_batch_lengths", lengths}};
+}
+
+BEGIN_FUNCTION_REGISTRATION;
+REGISTER_NAMED_FUNCTION("arrow.read_arrow_file", read_arrow,
+                        "url", "columns", "record_batches");
+REGISTER_NAMED_FUNCTION("arrow.write_arrow_file", write_arrow,
+                        "frame", "url", "rows_per_batch");
+REGISTER_NAMED_FUNCTION("arrow.arrow_file_info", arrow_info, "url");
+END_FUNCTION_REGISTRATION;
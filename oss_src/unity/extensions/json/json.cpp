@@ -3,6 +3,8 @@
 
 #include <unity/lib/toolkit_function_macros.hpp>
 #include <unity/lib/toolkit_class_macros.hpp>
+#include <unity/lib/gl_sframe.hpp>
+#include <sframe/parallel_json_parser.hpp>
 
 #include <iostream>
 
@@ -16,8 +18,37 @@ static flexible_type _test_flexible_type(const flexible_type& value) {
   return value;
 }
 
+/**
+ * Reads newline-delimited JSON files into an SFrame, one column per field.
+ * See parse_json_lines_to_sframe. The column type hints map field names to
+ * type names ("integer", "float", "string", "array", "list", "dictionary").
+ * If fields is empty, all the fields found in the first lines are read.
+ */
+static gl_sframe read_json_lines(const std::string& url,
+                                 const std::vector<std::string>& fields,
+                                 const flex_dict& column_type_hints,
+                                 int parse_nested,
+                                 int continue_on_failure,
+                                 size_t row_limit) {
+  json_file_handling_options options;
+  options.fields = fields;
+  for (const auto& hint: column_type_hints) {
+    options.column_type_hints[hint.first.to<flex_string>()] =
+        flex_type_enum_from_name(hint.second.to<flex_string>());
+  }
+  options.parse_nested = parse_nested;
+  options.continue_on_failure = continue_on_failure;
+  options.row_limit = row_limit;
+  sframe frame;
+  parse_json_lines_to_sframe(url, options, frame);
+  return gl_sframe(frame);
+}
+
 BEGIN_FUNCTION_REGISTRATION;
 REGISTER_NAMED_FUNCTION("json.to_serializable", JSON::to_serializable, "input");
 REGISTER_NAMED_FUNCTION("json.from_serializable", JSON::from_serializable, "data", "schema");
+REGISTER_NAMED_FUNCTION("json.read_json_lines", read_json_lines,
+                        "url", "fields", "column_type_hints", "parse_nested",
+                        "continue_on_failure", "row_limit");
 REGISTER_NAMED_FUNCTION("json._test_flexible_type", _test_flexible_type, "input");
 END_FUNCTION_REGISTRATION;
@@ -61,11 +61,16 @@ GENERATE_INTERFACE_AND_PROXY(unity_sframe_base, unity_sframe_proxy,
                                               (const std::vector<std::vector<std::string>>&)
                                               (const std::vector<std::string>&)
                                               (const std::vector<std::string>&))
+      (std::shared_ptr<unity_sframe_base>, window_aggregate, (const std::vector<std::string>&)
+                                              (const std::string&)(const std::string&)
+                                              (const std::string&)(double)(double)
+                                              (const std::string&)(bool))
       (std::shared_ptr<unity_sframe_base>, append, (std::shared_ptr<unity_sframe_base>))
       (void, materialize, )
       (bool, is_materialized, )
       (bool, has_size, )
       (std::string, query_plan_string, )
+      (std::string, explain_analyze, )
       (std::shared_ptr<unity_sframe_base>, join, (std::shared_ptr<unity_sframe_base>)(const std::string)(string_map))
       (std::shared_ptr<unity_sframe_base>, sort, (const std::vector<std::string>&)(const std::vector<int>&))
       (std::shared_ptr<unity_sarray_base>, pack_columns, (const std::vector<std::string>&)(const std::vector<std::string>&)(flex_type_enum)(const flexible_type&))
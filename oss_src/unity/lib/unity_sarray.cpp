@@ -6,6 +6,7 @@
  * of the BSD license. See the LICENSE file for details.
  */
 #include <cmath>
+#include <numeric>
 #include <boost/heap/priority_queue.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/date_time/local_time/local_time.hpp>
@@ -66,6 +67,60 @@ static std::shared_ptr<sarray<flexible_type>> get_empty_sarray() {
   return *empty_sarray;
 }
 
+/**
+ * Updates extreme with the largest (if is_max) or the smallest defined 
+ * value of a packed typed column.
+ */
+template <typename T>
+static void packed_min_max(const typed_column& column, const T* values,
+                           bool is_max, flexible_type& extreme) {
+  bool found = false;
+  T best = 0;
+  for (size_t i = 0;i < column.size(); ++i) {
+    if (column.is_defined(i) &&
+        (!found || (is_max ? values[i] > best : values[i] < best))) {
+      best = values[i];
+      found = true;
+    }
+  }
+  if (!found) return;
+  flexible_type best_val(best);
+  if (extreme.get_type() == flex_type_enum::UNDEFINED ||
+      (is_max ? best_val > extreme : best_val < extreme)) {
+    extreme = best_val;
+  }
+}
+
+/**
+ * Calls packed_min_max on a typed column. Returns false if the column is
+ * not packed.
+ */
+static bool typed_column_min_max(const typed_column& column, 
+                                 bool is_max, flexible_type& extreme) {
+  if (column.type() == flex_type_enum::INTEGER) {
+    packed_min_max(column, column.int_data(), is_max, extreme);
+  } else if (column.type() == flex_type_enum::FLOAT) {
+    packed_min_max(column, column.float_data(), is_max, extreme);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Adds the defined values of a packed typed column to a running mean.
+ */
+template <typename T>
+static void packed_mean(const typed_column& column, const T* values,
+                        std::pair<double, size_t>& mean) {
+  for (size_t i = 0;i < column.size(); ++i) {
+    if (column.is_defined(i)) {
+      ++mean.second;
+      mean.first += ((double)values[i] - mean.first) / double(mean.second);
+    }
+  }
+}
+
 unity_sarray::unity_sarray() {
   // make empty sarray and keep it around, reusing it whenever
   // I need an empty sarray
@@ -567,6 +622,10 @@ unity_sarray::logical_filter(std::shared_ptr<unity_sarray_base> index) {
             [](const flexible_type& f)->flexible_type {
               return (flex_int)(!f.is_zero());
             }, flex_type_enum::INTEGER, true, 0));
+  if (other_array_binarized->m_planner_node->operator_type == 
+      planner_node_type::TRANSFORM_NODE) {
+    other_array_binarized->m_planner_node->operator_parameters["predicate_passthrough"] = 1;
+  }
 
   auto ret = std::make_shared<unity_sarray>();
   ret->construct_from_planner_node(
@@ -756,9 +815,13 @@ flexible_type unity_sarray::max() {
                             if(f > maxv) maxv = f;
                           }
                         };
+    auto column_reductionfn = [](const typed_column& col, flexible_type& maxv)->bool {
+                                return typed_column_min_max(col, true, maxv);
+                              };
 
     max_val =
       query_eval::reduce<flexible_type>(m_planner_node, reductionfn,
+                                        column_reductionfn,
                                         reductionfn, flex_undefined());
 
     return max_val;
@@ -790,9 +853,13 @@ flexible_type unity_sarray::min() {
                       if(f < minv) minv = f;
                     }
                   };
+    auto column_reductionfn = [](const typed_column& col, flexible_type& minv)->bool {
+                    return typed_column_min_max(col, false, minv);
+                  };
 
     min_val =
         query_eval::reduce<flexible_type>(m_planner_node, reductionfn,
+                                          column_reductionfn,
                                           reductionfn, flex_undefined());
     return min_val;
   } else {
@@ -822,9 +889,26 @@ flexible_type unity_sarray::sum() {
             sum += f;
           }
         };
+    // undefined values are held as 0 in packed columns
+    auto column_reductionfn =
+        [](const typed_column& col, flexible_type& sum)->bool {
+          if (col.type() == flex_type_enum::INTEGER) {
+            sum += flexible_type(std::accumulate(col.int_data(), 
+                                                 col.int_data() + col.size(), 
+                                                 flex_int(0)));
+          } else if (col.type() == flex_type_enum::FLOAT) {
+            sum += flexible_type(std::accumulate(col.float_data(), 
+                                                 col.float_data() + col.size(), 
+                                                 flex_float(0)));
+          } else {
+            return false;
+          }
+          return true;
+        };
 
     flexible_type sum_val =
         query_eval::reduce<flexible_type>(m_planner_node, reductionfn, 
+                                          column_reductionfn,
                                           reductionfn, start_val);
 
     return sum_val;
@@ -918,8 +1002,22 @@ flexible_type unity_sarray::mean() {
       }
     };
 
+    auto column_reductionfn =
+        [](const typed_column& col,
+           std::pair<double, size_t>& mean)->bool {
+          if (col.type() == flex_type_enum::INTEGER) {
+            packed_mean(col, col.int_data(), mean);
+          } else if (col.type() == flex_type_enum::FLOAT) {
+            packed_mean(col, col.float_data(), mean);
+          } else {
+            return false;
+          }
+          return true;
+        };
+
     std::pair<double, size_t> mean_val =
         query_eval::reduce<std::pair<double, size_t> >(m_planner_node, reductionfn, 
+                                                       column_reductionfn,
                                                        aggregatefn, start_val);
 
     if (mean_val.second == 0) return flex_undefined();
@@ -1409,6 +1507,63 @@ size_t unity_sarray::nnz() {
                                     reductionfn, combinefn, 0);
 }
 
+/**
+ * Describes the transform computing arr with an expression, so that the
+ * optimizer can fuse it with neighbouring transforms.
+ */
+static void annotate_expression(std::shared_ptr<unity_sarray_base> arr,
+                                query_eval::expression_ptr expr) {
+  auto pnode = std::static_pointer_cast<unity_sarray>(arr)->get_planner_node();
+  if (pnode->operator_type != planner_node_type::TRANSFORM_NODE &&
+      pnode->operator_type != planner_node_type::BINARY_TRANSFORM_NODE) return;
+  pnode->any_operator_parameters["expression"] = expr;
+}
+
+/**
+ * Returns true if the builtin expression operator op computes the same values
+ * as the SArray operator op on the given types. Those expressions are built
+ * without the operator function, so that the same operation applied twice
+ * gets the same key and is shared by the optimizer.
+ */
+static bool has_builtin_expression_operator(flex_type_enum left_type,
+                                            flex_type_enum right_type,
+                                            const std::string& op) {
+  bool numeric = (left_type == flex_type_enum::INTEGER ||
+                  left_type == flex_type_enum::FLOAT) &&
+                 (right_type == flex_type_enum::INTEGER ||
+                  right_type == flex_type_enum::FLOAT);
+  if (op == "+" || op == "-" || op == "*" || op == "/") return numeric;
+  // % is 0 on anything but two integers
+  if (op == "%") return left_type == flex_type_enum::INTEGER &&
+                        right_type == flex_type_enum::INTEGER;
+  return op == "<" || op == ">" || op == "<=" || op == ">=" ||
+         op == "==" || op == "!=" || op == "&" || op == "|";
+}
+
+/**
+ * Records a comparison of the column against a constant on the transform
+ * node computing it, so that the query optimizer can skip the blocks of the
+ * column which cannot satisfy it (see operators/transform.hpp).
+ */
+static void annotate_predicate(std::shared_ptr<unity_sarray_base> arr,
+                               std::string op,
+                               const flexible_type& other,
+                               bool right_operator) {
+  if (other.get_type() == flex_type_enum::UNDEFINED) return;
+  if (op != "<" && op != ">" && op != "<=" && op != ">=" && op != "==") return;
+  // other [op] array is the same as array [flipped op] other
+  if (right_operator) {
+    if (op == "<") op = ">";
+    else if (op == ">") op = "<";
+    else if (op == "<=") op = ">=";
+    else if (op == ">=") op = "<=";
+  }
+  auto pnode = std::static_pointer_cast<unity_sarray>(arr)->get_planner_node();
+  if (pnode->operator_type != planner_node_type::TRANSFORM_NODE) return;
+  pnode->operator_parameters["predicate_op"] = op;
+  pnode->operator_parameters["predicate_value"] = other;
+}
+
 std::shared_ptr<unity_sarray_base> unity_sarray::scalar_operator(flexible_type other,
                                                                  std::string op,
                                                                  bool right_operator) {
@@ -1451,16 +1606,36 @@ std::shared_ptr<unity_sarray_base> unity_sarray::scalar_operator(flexible_type o
   //     like == or != or in.
   //  - Or if the other scalar value is undefined.
   bool op_is_equality_compare = (op == "==" || op == "!=" || op == "in");
+  // When annotated, the transform evaluates its blocks with the expression,
+  // which applies the column-vs-scalar kernels to the constant (see
+  // binary_transform_kernels::apply_scalar_kernel); the lambda is only the
+  // fallback for the row-wise path.
+  auto column_expression = query_eval::make_column_expression(0, dtype());
+  auto constant_expression = query_eval::make_constant_expression(other);
+  auto scalar_expression = query_eval::make_binary_expression(
+      op,
+      right_operator ? constant_expression : column_expression,
+      right_operator ? column_expression : constant_expression,
+      output_type,
+      has_builtin_expression_operator(left_type, right_type, op) ?
+          query_eval::expression::binary_fn_type() : binaryfn);
   if (other.get_type() == flex_type_enum::UNDEFINED || op_is_equality_compare) {
     auto transformfn =  
         [=](const flexible_type& f)->flexible_type {
           return right_operator ? binaryfn(other, f) : binaryfn(f, other);
         };
 
-    return transform_lambda(transformfn, 
-                            output_type,
-                            false/*skip undefined*/, 
-                            0 /*random seed*/);
+    auto ret = transform_lambda(transformfn, 
+                                output_type,
+                                false/*skip undefined*/, 
+                                0 /*random seed*/);
+    annotate_predicate(ret, op, other, right_operator);
+    // comparing an UNDEFINED value for equality gives the same result as
+    // the expression, but "in" does not
+    if (other.get_type() != flex_type_enum::UNDEFINED && op != "in") {
+      annotate_expression(ret, scalar_expression);
+    }
+    return ret;
   } else {
     auto transformfn = [=](const flexible_type& f)->flexible_type {
           if (f.get_type() == flex_type_enum::UNDEFINED) {
@@ -1469,10 +1644,13 @@ std::shared_ptr<unity_sarray_base> unity_sarray::scalar_operator(flexible_type o
             return right_operator ? binaryfn(other, f) : binaryfn(f, other);
           }
         };
-    return transform_lambda(transformfn, 
-                            output_type,
-                            true /*skip undefined*/, 
-                            0 /*random seed*/);
+    auto ret = transform_lambda(transformfn, 
+                                output_type,
+                                true /*skip undefined*/, 
+                                0 /*random seed*/);
+    annotate_predicate(ret, op, other, right_operator);
+    annotate_expression(ret, scalar_expression);
+    return ret;
   } 
 
   return ret_unity_sarray;
@@ -1543,7 +1721,16 @@ std::shared_ptr<unity_sarray_base> unity_sarray::vector_operator(
       op_binary_transform::make_planner_node(m_planner_node,
                                              other_unity_sarray->m_planner_node,
                                              transform_fn_with_undefined_checking,
-                                             output_type));
+                                             output_type,
+                                             op /* columnar kernel for numeric blocks */));
+  // the undefined checking above is the one of the expressions
+  annotate_expression(ret, query_eval::make_binary_expression(
+      op,
+      query_eval::make_column_expression(0, dtype()),
+      query_eval::make_column_expression(1, other->dtype()),
+      output_type,
+      has_builtin_expression_operator(dtype(), other->dtype(), op) ?
+          query_eval::expression::binary_fn_type() : transformfn));
   return ret;
 }
 
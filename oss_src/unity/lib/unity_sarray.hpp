@@ -12,6 +12,7 @@
 #include <memory>
 #include <flexible_type/flexible_type.hpp>
 #include <unity/lib/api/unity_sarray_interface.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
 
 namespace graphlab {
 
@@ -23,10 +24,6 @@ class sarray_reader;
 template <typename T>
 class sarray_iterator;
 
-namespace query_eval {
-class planner_node;
-} // query_eval
-
 /**
  * This is the SArray object exposed to Python. Abstractly, it stores a
  * single column of a flexible_type. An Sarray represents a single immutable
@@ -747,7 +744,7 @@ class unity_sarray: public unity_sarray_base {
    * Pointer to the lazy evaluator logical operator node.
    * This can never be NULL.
    */
-  std::shared_ptr<query_eval::planner_node> m_planner_node;
+  query_eval::pnode_handle m_planner_node;
 
   /**
    * Supports \ref begin_iterator() and \ref iterator_get_next().
@@ -6,6 +6,8 @@
  * of the BSD license. See the LICENSE file for details.
  */
 #include <set>
+#include <fstream>
+#include <iomanip>
 #include <boost/algorithm/string.hpp>
 #include <unity/lib/unity_sframe.hpp>
 #include <sframe/sframe.hpp>
@@ -15,6 +17,9 @@
 #include <sframe/algorithm.hpp>
 #include <fileio/temp_files.hpp>
 #include <fileio/sanitize_url.hpp>
+#include <fileio/general_fstream.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <util/try_finally.hpp>
 #include <unity/lib/unity_global.hpp>
 #include <unity/lib/unity_global_singleton.hpp>
 #include <sframe/groupby_aggregate.hpp>
@@ -26,6 +31,7 @@
 #include <unity/lib/auto_close_sarray.hpp>
 #include <sframe_query_engine/planning/planner.hpp>
 #include <sframe_query_engine/planning/optimization_engine.hpp>
+#include <sframe_query_engine/execution/query_profile.hpp>
 #include <sframe_query_engine/operators/all_operators.hpp>
 #include <sframe_query_engine/operators/operator_properties.hpp>
 #include <sframe_query_engine/algorithm/sort.hpp>
@@ -38,6 +44,22 @@ namespace graphlab {
 
 using namespace graphlab::query_eval;
 
+/**
+ * The url of a shard of an output: the shard number is inserted before the
+ * extensions of the file name. For instance out.csv.gz becomes
+ * out_00001.csv.gz
+ */
+static std::string shard_url(const std::string& url, size_t shard, size_t num_shards) {
+  std::stringstream strm;
+  strm << "_" << std::setw(std::max<size_t>(5, std::to_string(num_shards - 1).length()))
+       << std::setfill('0') << shard;
+  size_t name_begin = url.find_last_of('/');
+  name_begin = (name_begin == std::string::npos) ? 0 : name_begin + 1;
+  size_t extension_begin = url.find('.', name_begin);
+  if (extension_begin == std::string::npos) return url + strm.str();
+  return url.substr(0, extension_begin) + strm.str() + url.substr(extension_begin);
+}
+
 static std::shared_ptr<sframe> get_empty_sframe() {
   // make empty sframe and keep it around, reusing it whenever
   // I need an empty sframe. We are intentionally leaking this object.
@@ -760,6 +782,10 @@ std::shared_ptr<unity_sframe_base> unity_sframe::logical_filter(
             [](const flexible_type& f)->flexible_type {
               return (flex_int)(!f.is_zero());
             }, flex_type_enum::INTEGER, true, 0));
+  if (other_array_binarized->get_planner_node()->operator_type ==
+      planner_node_type::TRANSFORM_NODE) {
+    other_array_binarized->get_planner_node()->operator_parameters["predicate_passthrough"] = 1;
+  }
 
 
   auto equal_length = query_eval::planner().test_equal_length(this->get_planner_node(),
@@ -950,44 +976,161 @@ void unity_sframe::save_as_csv(const std::string& url,
     no_prefix_on_first_value = !writing_config["_no_prefix_on_first_value"].is_zero();
   }
 
-  general_ofstream fout(url);
-  if (!file_header.empty()) fout << file_header << writer.line_terminator;
-  if (!fout.good()) {
-    log_and_throw(std::string("Unable to open " + sanitize_url(url) + " for write"));
+  bool sharded = false;
+  size_t num_shards = 0;
+  if (writing_config.count("sharded")) {
+    sharded = !writing_config["sharded"].is_zero();
+  }
+  if (writing_config.count("num_shards")) {
+    num_shards = (flex_int)(writing_config["num_shards"]);
   }
 
   // write the header
   size_t num_cols = this->num_columns();
-  if (num_cols == 0) return;
-
-  if (writer.header) writer.write_verbatim(fout, this->column_names());
-  
-  bool first_value = true;
-  auto write_callback = [&writer, &fout, &line_prefix, 
-       &no_prefix_on_first_value, &first_value]
-      (size_t segment_id, const std::shared_ptr<sframe_rows>& data) {
+  if (num_cols == 0) {
+    general_ofstream fout(url);
+    if (!file_header.empty()) fout << file_header << writer.line_terminator;
+    if (!fout.good()) {
+      log_and_throw(std::string("Unable to open " + sanitize_url(url) + " for write"));
+    }
+    return;
+  }
+
+  /*
+   * Every segment of the output is formatted by its own writer, on its own
+   * thread, into its own file: a shard of the output, or a temporary file
+   * appended to the output in order. Gzip compressed outputs (ending in
+   * ".gz") are compressed segment by segment: a sequence of gzip members
+   * is a gzip file.
+   *
+   * Each shard is a complete file, with the file header and footer, the
+   * column header, and the first line without the prefix if
+   * _no_prefix_on_first_value is set. When concatenating, the prefix of
+   * the first line of a segment depends on whether the earlier segments
+   * have lines: it is appended to the previous segment once all are written.
+   *
+   * Concatenating copies the temporary files into the output, so all but
+   * the first segment are written twice. The sizes of the formatted
+   * segments are not known in advance, so they cannot be written straight
+   * to their final positions; but when the output is a local file, the
+   * first segment is written directly into it and the others are appended.
+   * The temporary files are deleted even if writing fails.
+   */
+  bool gzip_compress = boost::algorithm::ends_with(url, ".gz");
+  size_t num_segments = num_shards;
+  if (num_segments == 0) num_segments = std::max<size_t>(1, thread::cpu_count());
+  const size_t write_buffer_size = 1024 * 1024;
+  bool first_segment_in_place = !sharded && fileio::get_protocol(url) == "";
+
+  // declared before the output streams, so that they are closed first
+  scoped_finally temp_file_cleanup;
+  std::vector<std::string> segment_urls(num_segments);
+  std::vector<std::unique_ptr<general_ofstream>> segment_out(num_segments);
+  std::vector<csv_writer> writers(num_segments, writer);
+  std::vector<std::string> buffers(num_segments);
+  // not a vector<bool>: the segments are written concurrently
+  std::vector<char> segment_has_lines(num_segments, false);
+  std::vector<char> prefix_first_line(num_segments, false);
+  for (size_t i = 0; i < num_segments; ++i) {
+    if (sharded) {
+      segment_urls[i] = shard_url(url, i, num_segments);
+    } else if (i == 0 && first_segment_in_place) {
+      segment_urls[i] = url;
+    } else {
+      std::string temp_url = get_temp_name();
+      segment_urls[i] = temp_url;
+      temp_file_cleanup.add([temp_url]() { delete_temp_file(temp_url); });
+    }
+    segment_out[i].reset(new general_ofstream(segment_urls[i], gzip_compress));
+    if (!segment_out[i]->good()) {
+      log_and_throw(std::string("Unable to open " + sanitize_url(segment_urls[i]) +
+                                " for write"));
+    }
+    if (sharded || i == 0) {
+      if (!file_header.empty()) {
+        buffers[i] += file_header;
+        buffers[i] += writer.line_terminator;
+      }
+      if (writer.header) {
+        std::stringstream strm;
+        writers[i].write_verbatim(strm, this->column_names());
+        buffers[i] += strm.str();
+      }
+      prefix_first_line[i] = !no_prefix_on_first_value;
+    }
+  }
+
+  auto write_callback = [&](size_t segment_id, const std::shared_ptr<sframe_rows>& data) {
+    auto& buffer = buffers[segment_id];
+    auto& segment_writer = writers[segment_id];
     for (const auto& row : *(data)) {
-      if (!line_prefix.empty()) {
-        if ((!first_value) || // not the first value. write the line prefix
-            (!no_prefix_on_first_value) // first value, write line prefix if
-                                        // no_prefix_on_first_value == false
-                                        // (yes the double negative is annoying)
-            ) {
-          fout.write(line_prefix.c_str(), line_prefix.size());
-        } 
+      if (!line_prefix.empty() &&
+          (segment_has_lines[segment_id] || prefix_first_line[segment_id])) {
+        buffer += line_prefix;
       }
-      first_value = false;
-      writer.write(fout, row);
+      segment_has_lines[segment_id] = true;
+      segment_writer.write(buffer, row);
+    }
+    if (buffer.size() >= write_buffer_size) {
+      segment_out[segment_id]->write(buffer.c_str(), buffer.size());
+      buffer.clear();
     }
     return false;
   };
 
-  query_eval::planner().materialize(this->get_planner_node(), write_callback, 1);
-  if (!fout.good()) {
-    log_and_throw_io_failure("Fail to write.");
+  query_eval::planner().materialize(this->get_planner_node(), write_callback,
+                                    num_segments);
+
+  bool has_lines = segment_has_lines[0];
+  for (size_t i = 1; i < num_segments && !sharded; ++i) {
+    if (segment_has_lines[i] && !line_prefix.empty() &&
+        (has_lines || !no_prefix_on_first_value)) {
+      buffers[i - 1] += line_prefix;
+    }
+    has_lines |= segment_has_lines[i];
+  }
+  for (size_t i = 0; i < num_segments; ++i) {
+    if (!file_footer.empty() && (sharded || i + 1 == num_segments)) {
+      buffers[i] += file_footer;
+      buffers[i] += writer.line_terminator;
+    }
+    segment_out[i]->write(buffers[i].c_str(), buffers[i].size());
+    bool good = segment_out[i]->good();
+    segment_out[i]->close();
+    if (!good) log_and_throw_io_failure("Fail to write.");
+  }
+
+  if (!sharded) {
+    // the segments are already compressed
+    std::vector<char> buffer(write_buffer_size);
+    auto append_segments = [&](std::ostream& fout) {
+      for (size_t i = first_segment_in_place ? 1 : 0; i < num_segments; ++i) {
+        general_ifstream fin(segment_urls[i], false);
+        while (fin.good()) {
+          fin.read(buffer.data(), buffer.size());
+          fout.write(buffer.data(), fin.gcount());
+        }
+      }
+      if (!fout.good()) {
+        log_and_throw_io_failure("Fail to write.");
+      }
+    };
+    if (first_segment_in_place) {
+      std::ofstream fout(url, std::ios::binary | std::ios::app);
+      if (!fout.good()) {
+        log_and_throw(std::string("Unable to open " + sanitize_url(url) + " for write"));
+      }
+      append_segments(fout);
+      fout.close();
+    } else {
+      general_ofstream fout(url, false);
+      if (!fout.good()) {
+        log_and_throw(std::string("Unable to open " + sanitize_url(url) + " for write"));
+      }
+      append_segments(fout);
+      fout.close();
+    }
   }
-  if (!file_footer.empty()) fout << file_footer << writer.line_terminator;
-  fout.close();
 }
 
 std::shared_ptr<unity_sframe_base> unity_sframe::sample(float percent,
@@ -1023,6 +1166,16 @@ std::string unity_sframe::query_plan_string() {
   return ss.str();
 }
 
+std::string unity_sframe::explain_analyze() {
+  std::stringstream ss;
+  ss << get_planner_node() << std::endl;
+  materialize_options opts;
+  opts.profile = std::make_shared<query_eval::query_profile>();
+  query_eval::planner().materialize(m_planner_node, opts);
+  ss << opts.profile->to_string();
+  return ss.str();
+}
+
 std::list<std::shared_ptr<unity_sframe_base>>
 unity_sframe::random_split(float percent, int random_seed) {
   log_func_entry();
@@ -1081,14 +1234,44 @@ std::shared_ptr<unity_sframe_base> unity_sframe::groupby_aggregate(
     operators.push_back( {column_names, group_operations[i]} );
   }
 
-  auto grouped_sf = query_eval::groupby_aggregate(get_planner_node(),
-                                                  column_names(),
-                                                  key_columns,
-                                                  group_output_columns,
-                                                  operators);
+  auto grouped_node = query_eval::op_groupby_aggregate::make_planner_node(
+      get_planner_node(), column_names(), key_columns, group_output_columns, operators);
+
+  std::vector<std::string> grouped_column_names;
+  for (const auto& name: grouped_node->operator_parameters["column_names"].get<flex_list>()) {
+    grouped_column_names.push_back(name.get<flex_string>());
+  }
 
   std::shared_ptr<unity_sframe> ret(new unity_sframe());
-  ret->construct_from_sframe(*grouped_sf);
+  ret->construct_from_planner_node(grouped_node, grouped_column_names);
+  return ret;
+}
+
+std::shared_ptr<unity_sframe_base> unity_sframe::window_aggregate(
+    const std::vector<std::string>& key_columns,
+    const std::string& order_column,
+    const std::string& value_column,
+    const std::string& operation,
+    double range_start,
+    double range_end,
+    const std::string& output_column_name,
+    bool source_is_sorted) {
+  log_func_entry();
+  logstream(LOG_INFO) << "Args: " << order_column << ", " << value_column << ", "
+                      << operation << ", [" << range_start << ", " << range_end
+                      << "], " << output_column_name << ", " << source_is_sorted
+                      << std::endl;
+
+  auto window_node = query_eval::op_window_aggregate::make_planner_node(
+      get_planner_node(), column_names(), key_columns, order_column, value_column,
+      get_builtin_group_aggregator(operation), range_start, range_end,
+      output_column_name, source_is_sorted);
+
+  std::vector<std::string> window_column_names = column_names();
+  window_column_names.push_back(output_column_name);
+
+  std::shared_ptr<unity_sframe> ret(new unity_sframe());
+  ret->construct_from_planner_node(window_node, window_column_names);
   return ret;
 }
 
@@ -1101,13 +1284,34 @@ std::shared_ptr<unity_sframe_base> unity_sframe::join(
   std::shared_ptr<unity_sframe> ret(new unity_sframe());
   std::shared_ptr<unity_sframe> us_right = std::static_pointer_cast<unity_sframe>(right);
 
-  auto sframe_ptr = get_underlying_sframe();
-  auto right_sframe_ptr = us_right->get_underlying_sframe();
-  sframe joined_sf = graphlab::join(*sframe_ptr,
-                                    *right_sframe_ptr,
-                                    join_type,
-                                    join_keys);
-  ret->construct_from_sframe(joined_sf);
+  // keys of different types are only allowed if one of the frames is empty:
+  // only then are the lengths needed, even if they must be computed.
+  int64_t left_num_rows = -1, right_num_rows = -1;
+  for (const auto& key: join_keys) {
+    // missing columns are reported by make_planner_node
+    if (contains_column(key.first) && us_right->contains_column(key.second) &&
+        dtype()[column_index(key.first)] !=
+        us_right->dtype()[us_right->column_index(key.second)]) {
+      left_num_rows = size();
+      right_num_rows = us_right->size();
+      break;
+    }
+  }
+
+  auto joined_node = query_eval::op_join::make_planner_node(get_planner_node(),
+                                                           us_right->get_planner_node(),
+                                                           column_names(),
+                                                           us_right->column_names(),
+                                                           join_type,
+                                                           join_keys,
+                                                           left_num_rows,
+                                                           right_num_rows);
+
+  std::vector<std::string> joined_column_names;
+  for (const auto& name: joined_node->operator_parameters["column_names"].get<flex_list>()) {
+    joined_column_names.push_back(name.get<flex_string>());
+  }
+  ret->construct_from_planner_node(joined_node, joined_column_names);
   return ret;
 }
 
@@ -1130,12 +1334,12 @@ unity_sframe::sort(const std::vector<std::string>& sort_keys,
     b_sort_ascending.push_back((bool)sort_order);
   }
 
-  auto sorted_sf = graphlab::sort(this->get_planner_node(),
-                                  this->column_names(),
-                                  sort_indices,
-                                  b_sort_ascending);
+  auto sorted_node = query_eval::op_sort::make_planner_node(this->get_planner_node(),
+                                                           this->column_names(),
+                                                           sort_indices,
+                                                           b_sort_ascending);
   std::shared_ptr<unity_sframe> ret(new unity_sframe());
-  ret->construct_from_sframe(*sorted_sf);
+  ret->construct_from_planner_node(sorted_node, this->column_names());
   return ret;
 }
 
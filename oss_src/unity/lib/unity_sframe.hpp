@@ -24,10 +24,6 @@ class dataframe;
 class sframe_reader;
 class sframe_iterator;
 
-namespace query_eval {
-class planner_node;
-} // query_eval
-
 
 /**
  * This is the SFrame object exposed to Python. It stores internally an
@@ -380,6 +376,13 @@ class unity_sframe : public unity_sframe_base {
    *  - double_quote : True if not is zero()
    *  - quote_char : First character if flexible_type is a string
    *  - use_quote_char : First character if flexible_type is a string
+   *  - sharded : True if not is_zero(). Writes one complete file per
+   *    segment, named after the url with the segment number inserted before
+   *    the extension, instead of a single file.
+   *  - num_shards : The number of segments. Defaults to the number of CPUs.
+   *
+   * The segments are formatted in parallel, each by its own writer. Outputs
+   * ending in ".gz" are gzip compressed segment by segment, in parallel.
    */
   void save_as_csv(const std::string& url,
                    std::map<std::string, flexible_type> writing_config);
@@ -415,6 +418,14 @@ class unity_sframe : public unity_sframe_base {
    */
   std::string query_plan_string();
 
+  /**
+   * Materializes the sframe, returning the query plan followed by the
+   * profile of its execution: the rows, time and blocks read of every
+   * operator (see query_profile.hpp). An sframe already materialized has
+   * nothing to profile.
+   */
+  std::string explain_analyze();
+
   /**
    * Return true if the sframe size is known.
    */
@@ -441,6 +452,28 @@ class unity_sframe : public unity_sframe_base {
       const std::vector<std::string>& group_output_columns,
       const std::vector<std::shared_ptr<group_aggregate_value>>& group_operations);
 
+  /**
+   * Returns a new SFrame with all the columns of this SFrame followed by a
+   * column holding, for every row, the aggregate of value_column over the
+   * rows with the same key_columns values whose order_column value lies in
+   * [order + range_start, order + range_end]. The rows are sorted by the
+   * key columns, then by the order column.
+   *
+   * operation is the name of a builtin aggregator, as in groupby_aggregate.
+   * If source_is_sorted is true, the SFrame must already be sorted by the
+   * key columns, then by the order column: the rows are then aggregated as
+   * they are read, without sorting or materializing the SFrame.
+   */
+  std::shared_ptr<unity_sframe_base> window_aggregate(
+      const std::vector<std::string>& key_columns,
+      const std::string& order_column,
+      const std::string& value_column,
+      const std::string& operation,
+      double range_start,
+      double range_end,
+      const std::string& output_column_name,
+      bool source_is_sorted);
+
   /**
    * Returns a new SFrame which contains all rows combined from current SFrame and "other"
    * The "other" SFrame has to have the same number of columns with the same column names
@@ -558,7 +591,7 @@ class unity_sframe : public unity_sframe_base {
    * Pointer to the lazy evaluator logical operator node.
    * Should never be NULL.
    */
-  std::shared_ptr<query_eval::planner_node> m_planner_node;
+  query_eval::pnode_handle m_planner_node;
 
   std::vector<std::string> m_column_names;
 
@@ -57,11 +57,13 @@ cdef extern from "<unity/lib/api/unity_sframe_interface.hpp>" namespace 'graphla
         unity_sframe_base_ptr sample(float, int) except +
         cpplist[unity_sframe_base_ptr] random_split(float, int) except +
         unity_sframe_base_ptr groupby_aggregate(const vector[string]&, const vector[vector[string]]&, const vector[string]&, const vector[string]&) except +
+        unity_sframe_base_ptr window_aggregate(const vector[string]&, const string&, const string&, const string&, double, double, const string&, bint) except +
         unity_sframe_base_ptr append(unity_sframe_base_ptr) except +
         void materialize() except +
         bint is_materialized() except +
         bint has_size() except +
         string query_plan_string() except +
+        string explain_analyze() except +
         unity_sframe_base_ptr join(unity_sframe_base_ptr, const string, map[string, string]) except +
         unity_sarray_base_ptr pack_columns(const vector[string]&, const vector[string]&, flex_type_enum , const flexible_type&) except +
         unity_sframe_base_ptr stack (const string& , const vector[string]& , const vector[flex_type_enum]&, bint) except +
@@ -133,6 +135,8 @@ cdef class UnitySFrameProxy:
     cpdef random_split(self, float percent, int random_seed)
 
     cpdef groupby_aggregate(self, key_columns, group_columns, group_output_columns, column_ops)
+
+    cpdef window_aggregate(self, key_columns, order_column, value_column, column_op, double range_start, double range_end, output_column, bint is_sorted)
     
     cpdef append(self, UnitySFrameProxy other)
 
@@ -144,6 +148,8 @@ cdef class UnitySFrameProxy:
 
     cpdef query_plan_string(self)
 
+    cpdef explain_analyze(self)
+
     cpdef join(self, UnitySFrameProxy right, how, dict on)
 
     cpdef pack_columns(self, columns, keys, dtype, fill_na)
@@ -255,6 +255,21 @@ cdef class UnitySFrameProxy:
                                                    group_output_columns, column_ops)
         return create_proxy_wrapper_from_existing_proxy(self._cli, proxy)
 
+    cpdef window_aggregate(self, _key_columns, _order_column, _value_column, _column_op,
+                           double range_start, double range_end, _output_column, bint is_sorted):
+        cdef vector[string] key_columns = to_vector_of_strings(_key_columns)
+        cdef string order_column        = str_to_cpp(_order_column)
+        cdef string value_column        = str_to_cpp(_value_column)
+        cdef string column_op           = str_to_cpp(_column_op)
+        cdef string output_column       = str_to_cpp(_output_column)
+
+        cdef unity_sframe_base_ptr proxy
+        with nogil:
+            proxy = self.thisptr.window_aggregate(key_columns, order_column, value_column,
+                                                  column_op, range_start, range_end,
+                                                  output_column, is_sorted)
+        return create_proxy_wrapper_from_existing_proxy(self._cli, proxy)
+
     cpdef append(self, UnitySFrameProxy other):
         cdef unity_sframe_base_ptr proxy
         with nogil:
@@ -273,6 +288,9 @@ cdef class UnitySFrameProxy:
     cpdef query_plan_string(self):
         return cpp_to_str(self.thisptr.query_plan_string())
 
+    cpdef explain_analyze(self):
+        return cpp_to_str(self.thisptr.explain_analyze())
+
     cpdef join(self, UnitySFrameProxy right, _how, dict _on):
         cdef unity_sframe_base_ptr proxy
         cdef map[string,string] on = dict_to_string_string_map(_on)
@@ -3373,10 +3373,14 @@ class SFrame(object):
             header=True, quote_level=csv.QUOTE_NONNUMERIC, double_quote=True,
             escape_char='\\', quote_char='\"', na_rep='',
             file_header='', file_footer='', line_prefix='',
-            _no_prefix_on_first_value=False, **kwargs):
+            _no_prefix_on_first_value=False, sharded=False, num_shards=None,
+            **kwargs):
         """
         Writes an SFrame to a CSV file.
 
+        The rows are formatted in parallel. If the filename ends with ".gz",
+        the file is gzip compressed, also in parallel.
+
         Parameters
         ----------
         filename : string
@@ -3417,6 +3421,16 @@ class SFrame(object):
 
         line_prefix: string, optional
             A string printed at the start of each value line
+
+        sharded: bool, optional
+            If True, writes one complete file per part of the SFrame instead
+            of a single file. The part number is inserted before the extension
+            of the filename: "out.csv" is written as "out_00000.csv",
+            "out_00001.csv", ...
+
+        num_shards: int, optional
+            The number of parts the SFrame is written in. Defaults to the
+            number of CPUs.
         """
         # Pandas argument compatibility
         if "sep" in kwargs:
@@ -3456,13 +3470,17 @@ class SFrame(object):
 
         # undocumented option. Disables line prefix on the first value line
         write_csv_options['_no_prefix_on_first_value'] = _no_prefix_on_first_value
+        write_csv_options['sharded'] = sharded
+        if num_shards is not None:
+            write_csv_options['num_shards'] = num_shards
 
         url = _make_internal_url(filename)
         self.__proxy__.save_as_csv(url, write_csv_options)
 
     def export_json(self,
                     filename,
-                    orient='records'):
+                    orient='records',
+                    sharded=False):
         """
         Writes an SFrame to a JSON file.
 
@@ -3475,6 +3493,10 @@ class SFrame(object):
             If orient="records" the file is saved as a single JSON array.
             If orient="lines", the file is saves as a JSON value per line.
 
+        sharded : bool, optional
+            If True, writes one complete file per part of the SFrame. See
+            export_csv.
+
         Examples
         --------
         The orient parameter describes the expected input format of the JSON
@@ -3532,10 +3554,12 @@ class SFrame(object):
                     header=False, double_quote=False,
                     quote_level=csv.QUOTE_NONE,
                     line_prefix=',',
-                    _no_prefix_on_first_value=True)
+                    _no_prefix_on_first_value=True,
+                    sharded=sharded)
         elif orient == "lines":
             self.pack_columns(dtype=dict).export_csv(
-                    filename, header=False, double_quote=False, quote_level=csv.QUOTE_NONE)
+                    filename, header=False, double_quote=False, quote_level=csv.QUOTE_NONE,
+                    sharded=sharded)
         else:
             raise ValueError("Invalid value for orient parameter (" + str(orient) + ")")
 
@@ -4147,6 +4171,13 @@ class SFrame(object):
         """
         return self.__proxy__.query_plan_string()
 
+    def __explain_analyze__(self):
+        """
+        Materializes the SFrame, returning the query plan followed by the
+        rows, time and blocks read of every operator executed.
+        """
+        return self.__proxy__.explain_analyze()
+
     def __iter__(self):
         """
         Provides an iterator to the rows of the SFrame.
@@ -4640,6 +4671,102 @@ class SFrame(object):
                                                                   group_output_columns,
                                                                   group_ops))
 
+    def window_aggregate(self, key_columns, order_column, operation,
+                         range_start, range_end, output_column_name=None,
+                         is_sorted=False):
+        """
+        Aggregate, for every row, a column over the rows with the same values
+        of the key columns whose order value lies in a range relative to the
+        order value of the row. This is the SQL window aggregate
+
+        ``operation(value) OVER (PARTITION BY key_columns ORDER BY order_column
+        RANGE BETWEEN range_start AND range_end)``
+
+        The windows are computed lazily, like the other SFrame operations.
+
+        Parameters
+        ----------
+        key_columns : string | list[string]
+            Column(s) partitioning the rows. May be empty.
+
+        order_column : string
+            The int, float or datetime column ordering the rows of a
+            partition. Datetimes are compared in seconds.
+
+        operation : aggregator
+            A builtin aggregator of a single column, such as
+            ``aggregate.SUM('value')``. See :mod:`~graphlab.aggregate`.
+
+        range_start : int | float
+            The start of the window relative to the order value of each row,
+            inclusive. Usually negative.
+
+        range_end : int | float
+            The end of the window relative to the order value of each row,
+            inclusive.
+
+        output_column_name : string, optional
+            The name of the aggregate column. Defaults to
+            "Window <operation> of <column>".
+
+        is_sorted : bool, optional
+            If True, the SFrame is already sorted by the key columns, then by
+            the order column, and the windows are computed as the rows are
+            read, without sorting the SFrame first. Rows out of order raise
+            an error when the result is computed.
+
+        Returns
+        -------
+        out : SFrame
+            All the columns of this SFrame, followed by the aggregate, sorted
+            by the key columns, then by the order column. Rows with a missing
+            order value have a missing aggregate.
+
+        See Also
+        --------
+        groupby, sort
+
+        Examples
+        --------
+        The sum of the amounts of each user over the last 10 seconds:
+
+        >>> sf = graphlab.SFrame({'user': [1, 1, 2, 1],
+        ...                       'time': [0, 5, 6, 20],
+        ...                       'amount': [1, 2, 3, 4]})
+        >>> sf.window_aggregate('user', 'time', aggregate.SUM('amount'),
+        ...                     -10, 0, 'recent')
+        +--------+------+------+--------+
+        | amount | time | user | recent |
+        +--------+------+------+--------+
+        |   1    |  0   |  1   |   1    |
+        |   2    |  5   |  1   |   3    |
+        |   4    |  20  |  1   |   4    |
+        |   3    |  6   |  2   |   3    |
+        +--------+------+------+--------+
+        [4 rows x 4 columns]
+        """
+        if isinstance(key_columns, str):
+            key_columns = [key_columns]
+        if not isinstance(key_columns, list):
+            raise TypeError("Key columns must be a string or a list of strings")
+        if not isinstance(order_column, str):
+            raise TypeError("Order column must be a string")
+        if type(operation) is not tuple or len(operation) != 2:
+            raise TypeError("Operation must be a builtin aggregator")
+        (op, column) = operation
+        if len(column) != 1 or not isinstance(column[0], str):
+            raise TypeError("Operation must aggregate a single column")
+        value_column = column[0]
+        if output_column_name is None:
+            output_column_name = ("Window " + op.replace('__builtin__', '').strip('_') +
+                                  " of " + value_column)
+
+        with cython_context():
+            return SFrame(_proxy=self.__proxy__.window_aggregate(
+                key_columns, order_column, value_column, op,
+                float(range_start), float(range_end), output_column_name,
+                bool(is_sorted)))
+
     def join(self, right, on=None, how='inner'):
         """
         Merge two SFrames. Merges the current (left) SFrame with the given
@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <cxxtest/TestSuite.h>
+#include <lambda/columnar_transport.hpp>
+
+using namespace graphlab;
+
+class columnar_transport_test: public CxxTest::TestSuite {
+ public:
+  void test_round_trip() {
+    // an integer column with missing values, a string column and a column
+    // of mixed types
+    auto ints = std::make_shared<std::vector<flexible_type> >();
+    auto strings = std::make_shared<std::vector<flexible_type> >();
+    auto mixed = std::make_shared<std::vector<flexible_type> >();
+    for (size_t i = 0; i < 1000; ++i) {
+      ints->push_back(i % 7 == 0 ? FLEX_UNDEFINED : flexible_type(flex_int(i)));
+      strings->push_back(std::to_string(i % 13));
+      if (i % 2) mixed->push_back(flex_float(i) / 2);
+      else mixed->push_back(flex_vec{double(i), 1.0});
+    }
+    sframe_rows rows;
+    rows.add_decoded_column(ints);
+    rows.add_decoded_column(strings);
+    rows.add_decoded_column(mixed);
+
+    // archives are reused, so write after some existing content
+    oarchive oarc;
+    oarc << std::string("header");
+    lambda::write_columnar(oarc, rows);
+    lambda::write_columnar(oarc, *ints);
+    oarc << flex_int(42);
+
+    iarchive iarc(oarc.buf, oarc.off);
+    std::string header;
+    iarc >> header;
+    TS_ASSERT_EQUALS(header, "header");
+    std::vector<sframe_rows::ptr_to_decoded_column_type> columns;
+    lambda::read_columnar(iarc, columns);
+    std::vector<flexible_type> values;
+    lambda::read_columnar(iarc, values);
+    flex_int trailer;
+    iarc >> trailer;
+    TS_ASSERT_EQUALS(trailer, 42);
+
+    TS_ASSERT_EQUALS(columns.size(), 3);
+    std::vector<std::shared_ptr<std::vector<flexible_type> > > expected{ints, strings, mixed};
+    for (size_t c = 0; c < 3; ++c) {
+      TS_ASSERT_EQUALS(columns[c]->size(), 1000);
+      for (size_t i = 0; i < 1000; ++i) {
+        TS_ASSERT((*columns[c])[i] == (*expected[c])[i] ||
+                  ((*expected[c])[i].get_type() == flex_type_enum::UNDEFINED &&
+                   (*columns[c])[i].get_type() == flex_type_enum::UNDEFINED));
+      }
+    }
+    TS_ASSERT_EQUALS(values.size(), 1000);
+    for (size_t i = 0; i < 1000; ++i) {
+      TS_ASSERT_EQUALS(values[i].get_type(), (*ints)[i].get_type());
+    }
+    free(oarc.buf);
+  }
+};
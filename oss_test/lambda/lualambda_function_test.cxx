@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <cxxtest/TestSuite.h>
+#include <lambda/lualambda_function.hpp>
+#include <sframe/sframe_rows.hpp>
+
+using namespace graphlab;
+
+class lualambda_function_test: public CxxTest::TestSuite {
+ public:
+  void test_is_lua_lambda() {
+    TS_ASSERT(lambda::is_lua_lambda("LUA __lambda__transfer__ = function(x) return x end"));
+    TS_ASSERT(!lambda::is_lua_lambda("some pickled str"));
+    TS_ASSERT_THROWS_ANYTHING(lambda::lualambda_function("some pickled str"));
+  }
+
+  void test_one_to_one() {
+    auto values = std::make_shared<std::vector<flexible_type> >();
+    for (size_t i = 0; i < 100; ++i) {
+      values->push_back(i % 10 == 0 ? FLEX_UNDEFINED : flexible_type(flex_int(i)));
+    }
+    sframe_rows rows;
+    rows.add_decoded_column(values);
+
+    lambda::lualambda_function f("LUA __lambda__transfer__ = function(x) return x * 2 end");
+    f.set_skip_undefined(true);
+    std::vector<flexible_type> out;
+    if (!lambda::lua_lambda_supported()) {
+      TS_ASSERT_THROWS_ANYTHING(f.eval(rows, out));
+      return;
+    }
+    f.eval(rows, out);
+    TS_ASSERT_EQUALS(out.size(), 100);
+    for (size_t i = 0; i < 100; ++i) {
+      if (i % 10 == 0) {
+        TS_ASSERT_EQUALS(out[i].get_type(), flex_type_enum::UNDEFINED);
+      } else {
+        TS_ASSERT_EQUALS((flex_int)out[i], 2 * i);
+      }
+    }
+  }
+
+  void test_many_to_one() {
+    auto a = std::make_shared<std::vector<flexible_type> >();
+    auto b = std::make_shared<std::vector<flexible_type> >();
+    for (size_t i = 0; i < 100; ++i) {
+      a->push_back(flex_int(i));
+      b->push_back(std::to_string(i));
+    }
+    sframe_rows rows;
+    rows.add_decoded_column(a);
+    rows.add_decoded_column(b);
+
+    lambda::lualambda_function f(
+        "LUA __lambda__transfer__ = function(row) return row.b .. '-' .. row.a end");
+    std::vector<flexible_type> out;
+    if (!lambda::lua_lambda_supported()) {
+      TS_ASSERT_THROWS_ANYTHING(f.eval({"a", "b"}, rows, out));
+      return;
+    }
+    f.eval({"a", "b"}, rows, out);
+    TS_ASSERT_EQUALS(out.size(), 100);
+    for (size_t i = 0; i < 100; ++i) {
+      TS_ASSERT_EQUALS(out[i].get<flex_string>(),
+                       std::to_string(i) + "-" + std::to_string(i));
+    }
+  }
+
+  void test_compile_error() {
+    if (!lambda::lua_lambda_supported()) return;
+    lambda::lualambda_function f("LUA __lambda__transfer__ = function(x) return x +");
+    auto values = std::make_shared<std::vector<flexible_type> >(10, flex_int(1));
+    sframe_rows rows;
+    rows.add_decoded_column(values);
+    std::vector<flexible_type> out;
+    TS_ASSERT_THROWS_ANYTHING(f.eval(rows, out));
+  }
+};
@@ -53,6 +53,23 @@ class worker_pool_test: public CxxTest::TestSuite {
     });
   }
 
+  void test_try_get_worker() {
+    auto wk_pool = get_worker_pool(nworkers);
+    std::vector<std::unique_ptr<lambda::worker_process<dummy_worker_proxy>>> workers;
+    for (size_t i = 0; i < nworkers; ++i) {
+      workers.push_back(wk_pool->try_get_worker());
+      TS_ASSERT(workers.back() != nullptr);
+    }
+    // all workers are taken
+    TS_ASSERT(wk_pool->try_get_worker() == nullptr);
+    wk_pool->release_worker(workers.back());
+    auto worker = wk_pool->try_get_worker();
+    TS_ASSERT(worker != nullptr);
+    wk_pool->release_worker(worker);
+    for (size_t i = 0; i + 1 < nworkers; ++i) wk_pool->release_worker(workers[i]);
+    TS_ASSERT_EQUALS(wk_pool->num_available_workers(), nworkers);
+  }
+
   void test_worker_crash_and_restart() {
     auto wk_pool = get_worker_pool(nworkers);
     {
@@ -0,0 +1,140 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <string>
+#include <vector>
+#include <sframe/sframe.hpp>
+#include <sframe/arrow_file.hpp>
+#include <sframe/testing_utils.hpp>
+#include <fileio/temp_files.hpp>
+#include <cxxtest/TestSuite.h>
+
+using namespace graphlab;
+
+class arrow_file_test : public CxxTest::TestSuite {
+ public:
+  static std::vector<std::vector<flexible_type> > make_data(size_t num_rows) {
+    std::vector<std::vector<flexible_type> > data;
+    for (size_t i = 0; i < num_rows; ++i) {
+      data.push_back({i % 7 == 3 ? FLEX_UNDEFINED : flexible_type(flex_int(i) - 5),
+                      i % 5 == 2 ? FLEX_UNDEFINED : flexible_type(i * 0.25),
+                      i % 11 == 4 ? FLEX_UNDEFINED : flexible_type("s" + std::to_string(i)),
+                      flexible_type(std::string(i % 3, 'x'))});
+    }
+    return data;
+  }
+
+  static bool same(const flexible_type& a, const flexible_type& b) {
+    if (a.get_type() == flex_type_enum::UNDEFINED ||
+        b.get_type() == flex_type_enum::UNDEFINED) {
+      return a.get_type() == b.get_type();
+    }
+    return a == b;
+  }
+
+  void test_round_trip() {
+    auto data = make_data(1000);
+    sframe frame = make_testing_sframe(
+        {"int", "float", "string", "short"},
+        {flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+         flex_type_enum::STRING, flex_type_enum::STRING},
+        data);
+    std::string filename = get_temp_name() + ".arrow";
+    write_arrow_file(frame, filename, 300);
+
+    arrow_file_info info = read_arrow_file_info(filename);
+    TS_ASSERT_EQUALS(info.column_names, frame.column_names());
+    TS_ASSERT_EQUALS(info.column_types[0], flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS(info.column_types[1], flex_type_enum::FLOAT);
+    TS_ASSERT_EQUALS(info.column_types[2], flex_type_enum::STRING);
+    TS_ASSERT_EQUALS(info.record_batch_lengths, std::vector<size_t>({300, 300, 300, 100}));
+
+    sframe result = read_arrow_file(filename);
+    TS_ASSERT_EQUALS(result.num_rows(), 1000);
+    TS_ASSERT_EQUALS(result.column_names(), frame.column_names());
+    for (size_t i = 0; i < result.num_columns(); ++i) {
+      TS_ASSERT_EQUALS(result.column_type(i), frame.column_type(i));
+    }
+    auto values = testing_extract_sframe_data(result);
+    for (size_t i = 0; i < data.size(); ++i) {
+      for (size_t j = 0; j < data[i].size(); ++j) {
+        TS_ASSERT(same(values[i][j], data[i][j]));
+      }
+    }
+  }
+
+  void test_projection() {
+    auto data = make_data(100);
+    sframe frame = make_testing_sframe(
+        {"int", "float", "string", "short"},
+        {flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+         flex_type_enum::STRING, flex_type_enum::STRING},
+        data);
+    std::string filename = get_temp_name() + ".arrow";
+    write_arrow_file(frame, filename, 10);
+
+    arrow_read_options options;
+    options.columns = {"string", "int"};
+    options.record_batches = {7, 2};
+    sframe result = read_arrow_file(filename, options);
+    TS_ASSERT_EQUALS(result.num_columns(), 2);
+    TS_ASSERT_EQUALS(result.column_name(0), "string");
+    TS_ASSERT_EQUALS(result.column_name(1), "int");
+    TS_ASSERT_EQUALS(result.num_rows(), 20);
+    auto values = testing_extract_sframe_data(result);
+    for (size_t i = 0; i < 20; ++i) {
+      size_t row = (i < 10 ? 70 : 10) + i;
+      TS_ASSERT(same(values[i][0], data[row][2]));
+      TS_ASSERT(same(values[i][1], data[row][0]));
+    }
+
+    options.columns = {"missing"};
+    TS_ASSERT_THROWS_ANYTHING(read_arrow_file(filename, options));
+    options.columns.clear();
+    options.record_batches = {10};
+    TS_ASSERT_THROWS_ANYTHING(read_arrow_file(filename, options));
+  }
+
+  void test_pyarrow_file() {
+    // written by pyarrow 26 with feather.write_feather(table,
+    // compression="uncompressed", chunksize=3)
+    std::string filename = "data/pyarrow_types.arrow";
+    arrow_file_info info = read_arrow_file_info(filename);
+    TS_ASSERT_EQUALS(info.column_names,
+                     std::vector<std::string>({"id", "small", "flag", "score", "name"}));
+    TS_ASSERT_EQUALS(info.record_batch_lengths, std::vector<size_t>({3, 3, 1}));
+
+    sframe result = read_arrow_file(filename);
+    TS_ASSERT_EQUALS(result.column_type(0), flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS(result.column_type(1), flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS(result.column_type(2), flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS(result.column_type(3), flex_type_enum::FLOAT);
+    TS_ASSERT_EQUALS(result.column_type(4), flex_type_enum::STRING);
+    flexible_type none = FLEX_UNDEFINED;
+    std::vector<std::vector<flexible_type> > expected{
+      {1, 1, 1, 0.5, "a"},
+      {none, 2, 0, none, none},
+      {-3, none, none, -1.25, ""},
+      {4, 200, 1, 3.0, "d\xc3\xa9" "f"},
+      {none, 0, 0, 1e10, "e"},
+      {flex_int(1) << 40, 5, none, none, "ff"},
+      {7, 255, 1, 2.5, none}};
+    auto values = testing_extract_sframe_data(result);
+    TS_ASSERT_EQUALS(values.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      for (size_t j = 0; j < expected[i].size(); ++j) {
+        TS_ASSERT(same(values[i][j], expected[i][j]));
+      }
+    }
+  }
+
+  void test_unsupported_type() {
+    sframe frame = make_testing_sframe({"vec"}, {flex_type_enum::VECTOR},
+                                       {{flex_vec{1, 2}}});
+    TS_ASSERT_THROWS_ANYTHING(write_arrow_file(frame, get_temp_name() + ".arrow"));
+  }
+};
@@ -0,0 +1,136 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <map>
+#include <algorithm>
+#include <sframe/join.hpp>
+#include <sframe/join_impl.hpp>
+#include <sframe/testing_utils.hpp>
+#include <cxxtest/TestSuite.h>
+
+using namespace graphlab;
+using namespace graphlab::join_impl;
+
+class join_test : public CxxTest::TestSuite {
+ public:
+  void test_hash_table_groups() {
+    // rows of (key, value). Keys 0..99, key k appearing k % 3 + 1 times.
+    join_hash_table table({0}, 2);
+    std::map<flex_int, size_t> counts;
+    for (size_t i = 0; i < 100000; ++i) {
+      flex_int key = i % 100;
+      if (counts[key] == size_t(key % 3 + 1)) continue;
+      ++counts[key];
+      table.add_row({key, flex_int(i)});
+    }
+    table.build();
+    TS_ASSERT_EQUALS(table.num_stored_rows(), 199);
+
+    std::vector<std::vector<flexible_type> > rows;
+    for (flex_int key = 0; key < 100; ++key) {
+      // look up with the key in another position
+      size_t group = table.find({flex_int(-1), key}, {1}, key % 2 == 0);
+      TS_ASSERT_DIFFERS(group, join_hash_table::NOT_FOUND);
+      table.get_group_rows(group, rows);
+      TS_ASSERT_EQUALS(rows.size(), size_t(key % 3 + 1));
+      for (const auto& row: rows) {
+        TS_ASSERT_EQUALS(row[0], key);
+        TS_ASSERT_EQUALS(flex_int(row[1]) % 100, key);
+      }
+    }
+    TS_ASSERT_EQUALS(table.find({flex_int(100)}, {0}), join_hash_table::NOT_FOUND);
+
+    // only the groups of odd keys were not matched
+    size_t num_unmatched = 0;
+    table.for_each_unmatched_group([&](size_t group) {
+      table.get_group_rows(group, rows);
+      TS_ASSERT_EQUALS(flex_int(rows[0][0]) % 2, 1);
+      ++num_unmatched;
+    });
+    TS_ASSERT_EQUALS(num_unmatched, 50);
+  }
+
+  void test_empty_hash_table() {
+    join_hash_table table({0}, 1);
+    table.build();
+    TS_ASSERT_EQUALS(table.find({flex_int(0)}, {0}), join_hash_table::NOT_FOUND);
+    size_t num_unmatched = 0;
+    table.for_each_unmatched_group([&](size_t) { ++num_unmatched; });
+    TS_ASSERT_EQUALS(num_unmatched, 0);
+  }
+
+  void run_join_test(const std::string& join_type, size_t max_buffer_size) {
+    // left: (key, lvalue) for keys 0..999 with duplicates of even keys
+    // right: (key, rvalue) for keys 500..1999
+    std::vector<std::vector<size_t> > left_data, right_data;
+    for (size_t i = 0; i < 1000; ++i) {
+      left_data.push_back({i, i * 10});
+      if (i % 2 == 0) left_data.push_back({i, i * 10 + 1});
+    }
+    for (size_t i = 500; i < 2000; ++i) right_data.push_back({i, i * 100});
+    sframe left = make_integer_testing_sframe({"key", "lvalue"}, left_data);
+    sframe right = make_integer_testing_sframe({"key", "rvalue"}, right_data);
+
+    sframe result = graphlab::join(left, right, join_type, {{"key", "key"}},
+                                   max_buffer_size);
+    TS_ASSERT_EQUALS(result.num_columns(), 3);
+    TS_ASSERT_EQUALS(result.column_name(0), "key");
+    TS_ASSERT_EQUALS(result.column_name(1), "lvalue");
+    TS_ASSERT_EQUALS(result.column_name(2), "rvalue");
+
+    auto rows = testing_extract_sframe_data(result);
+    bool keep_left = (join_type == "left" || join_type == "outer");
+    bool keep_right = (join_type == "right" || join_type == "outer");
+    std::vector<std::vector<flexible_type> > expected;
+    for (const auto& l: left_data) {
+      if (l[0] >= 500) {
+        expected.push_back({l[0], l[1], l[0] * 100});
+      } else if (keep_left) {
+        expected.push_back({l[0], l[1], FLEX_UNDEFINED});
+      }
+    }
+    if (keep_right) {
+      for (const auto& r: right_data) {
+        if (r[0] >= 1000) expected.push_back({r[0], FLEX_UNDEFINED, r[1]});
+      }
+    }
+    auto row_lt = [](const std::vector<flexible_type>& a,
+                     const std::vector<flexible_type>& b) {
+      for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].get_type() != b[i].get_type()) return a[i].get_type() < b[i].get_type();
+        if (a[i].get_type() == flex_type_enum::UNDEFINED) continue;
+        if (a[i] < b[i]) return true;
+        if (b[i] < a[i]) return false;
+      }
+      return false;
+    };
+    std::sort(rows.begin(), rows.end(), row_lt);
+    std::sort(expected.begin(), expected.end(), row_lt);
+    TS_ASSERT_EQUALS(rows.size(), expected.size());
+    for (size_t i = 0; i < std::min(rows.size(), expected.size()); ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        TS_ASSERT_EQUALS(rows[i][j].get_type(), expected[i][j].get_type());
+        if (expected[i][j].get_type() != flex_type_enum::UNDEFINED) {
+          TS_ASSERT_EQUALS(rows[i][j], expected[i][j]);
+        }
+      }
+    }
+  }
+
+  void test_join_in_memory() {
+    for (std::string join_type: {"inner", "left", "right", "outer"}) {
+      run_join_test(join_type, SFRAME_JOIN_BUFFER_NUM_CELLS);
+    }
+  }
+
+  void test_join_partitioned() {
+    // a small buffer forces the frames to be partitioned to disk first
+    for (std::string join_type: {"inner", "left", "right", "outer"}) {
+      run_join_test(join_type, 100);
+    }
+  }
+};
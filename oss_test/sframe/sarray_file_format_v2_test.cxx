@@ -14,11 +14,17 @@
 * You should have received a copy of the GNU Affero General Public License
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <random>
 #include <cxxtest/TestSuite.h>
 #include <fileio/temp_files.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
+#include <sframe/sarray_v2_block_statistics.hpp>
+#include <sframe/column_statistics.hpp>
 #include <sframe/sarray_file_format_v2.hpp>
 #include <sframe/sarray_index_file.hpp>
+#include <sframe/sarray.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_config.hpp>
 #include <timer/timer.hpp>
 #include <random/random.hpp>
 
@@ -274,6 +280,522 @@ class sarray_file_format_v2_test: public CxxTest::TestSuite {
     }
   }
 
+  void test_block_statistics(void) {
+    using namespace v2_block_impl;
+    block_statistics stats = compute_block_statistics(
+        {5, FLEX_UNDEFINED, -3, 10, FLEX_UNDEFINED});
+    TS_ASSERT(stats.has_range);
+    TS_ASSERT_EQUALS((flex_int)stats.min_value, -3);
+    TS_ASSERT_EQUALS((flex_int)stats.max_value, 10);
+    TS_ASSERT_EQUALS(stats.num_undefined, 2);
+    TS_ASSERT(!block_may_satisfy(stats, "<", -3));
+    TS_ASSERT(block_may_satisfy(stats, "<=", -3));
+    TS_ASSERT(!block_may_satisfy(stats, ">", 10));
+    TS_ASSERT(block_may_satisfy(stats, ">", 9.5));
+    // undefined values pass ==
+    TS_ASSERT(block_may_satisfy(stats, "==", 100));
+    // mixed types have no range
+    stats = compute_block_statistics({5, "hello"});
+    TS_ASSERT(!stats.has_range);
+    TS_ASSERT(block_may_satisfy(stats, "<", -100));
+    // long strings store truncated bounds
+    std::string long_a = std::string(100, 'a') + "z";
+    std::string long_b = std::string(100, 'b');
+    stats = compute_block_statistics({long_b, "c", long_a});
+    TS_ASSERT(stats.has_range);
+    TS_ASSERT_EQUALS((flex_string)stats.min_value, std::string(MAX_STRING_BOUND_LENGTH, 'a'));
+    TS_ASSERT_EQUALS((flex_string)stats.max_value, "c");
+    stats = compute_block_statistics({long_a, long_b});
+    TS_ASSERT_EQUALS((flex_string)stats.max_value,
+                     std::string(MAX_STRING_BOUND_LENGTH - 1, 'b') + "c");
+    TS_ASSERT(block_may_satisfy(stats, "==", long_a));
+    TS_ASSERT(block_may_satisfy(stats, "==", long_b));
+    TS_ASSERT(!block_may_satisfy(stats, ">=", std::string(MAX_STRING_BOUND_LENGTH, 'c')));
+    TS_ASSERT(!block_may_satisfy(stats, "<", std::string(10, 'a')));
+
+    // write a sorted column over 4 segments 
+    const size_t ROWS_PER_SEGMENT = 100000;
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 4, 1);
+    size_t v = 0;
+    for (size_t i = 0;i < 4; ++i) {
+      for (size_t j = 0;j < ROWS_PER_SEGMENT; ++j) {
+        group_writer.write_segment(0, i, v);
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    index_file_information index = read_index_file(test_file_name + ":0");
+    std::vector<std::pair<size_t, size_t> > ranges;
+    TS_ASSERT(find_candidate_row_ranges(index, 0, v,
+            [](const block_statistics& s) { 
+              return block_may_satisfy(s, "<", 1000); 
+            }, ranges));
+    TS_ASSERT_EQUALS(ranges.size(), 1);
+    TS_ASSERT_EQUALS(ranges[0].first, 0);
+    TS_ASSERT_LESS_THAN_EQUALS(1000, ranges[0].second);
+    TS_ASSERT_LESS_THAN(ranges[0].second, ROWS_PER_SEGMENT);
+
+    TS_ASSERT(find_candidate_row_ranges(index, 50, v - 50,
+            [](const block_statistics& s) { 
+              return block_may_satisfy(s, ">=", 2 * ROWS_PER_SEGMENT); 
+            }, ranges));
+    TS_ASSERT_EQUALS(ranges.size(), 1);
+    TS_ASSERT_LESS_THAN_EQUALS(ranges[0].first, 2 * ROWS_PER_SEGMENT);
+    TS_ASSERT_EQUALS(ranges[0].second, v - 50);
+
+    TS_ASSERT(find_candidate_row_ranges(index, 0, v,
+            [=](const block_statistics& s) { 
+              return block_may_satisfy(s, ">", v); 
+            }, ranges));
+    TS_ASSERT_EQUALS(ranges.size(), 0);
+  }
+
+  void test_column_statistics(void) {
+    // column 0: 0..999 repeated, with every 10th row missing.
+    // column 1: 100 distinct strings
+    const size_t ROWS_PER_SEGMENT = 50000;
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 4, 2);
+    size_t v = 0;
+    for (size_t i = 0;i < 4; ++i) {
+      for (size_t j = 0;j < ROWS_PER_SEGMENT; ++j) {
+        std::vector<flexible_type> row{v % 10 == 0 ? FLEX_UNDEFINED : flexible_type(v % 1000),
+                                       "s" + std::to_string(v % 100)};
+        group_writer.write_segment(i, row);
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    column_statistics stats;
+    TS_ASSERT(stats.from_map(read_index_file(test_file_name + ":0").statistics));
+    TS_ASSERT_EQUALS(stats.num_rows, v);
+    TS_ASSERT_EQUALS(stats.num_undefined, v / 10);
+    TS_ASSERT_DELTA(stats.num_distinct, 900, 50);
+    TS_ASSERT_EQUALS(stats.quantiles.size(), column_statistics_builder::NUM_QUANTILES);
+    TS_ASSERT_DELTA(stats.quantiles.front(), 1, 20);
+    TS_ASSERT_DELTA(stats.quantiles.back(), 999, 20);
+    TS_ASSERT_DELTA(stats.selectivity("<", 500), 0.45, 0.03);
+    TS_ASSERT_DELTA(stats.selectivity(">=", 500), 0.45, 0.03);
+    TS_ASSERT_DELTA(stats.selectivity("==", 5), 0.001, 0.001);
+    TS_ASSERT_EQUALS(stats.selectivity("==", 5000), 0);
+    TS_ASSERT_EQUALS(stats.selectivity("!=", 5000), 1);
+
+    TS_ASSERT(stats.from_map(read_index_file(test_file_name + ":1").statistics));
+    TS_ASSERT_EQUALS(stats.num_undefined, 0);
+    TS_ASSERT_DELTA(stats.num_distinct, 100, 5);
+    TS_ASSERT(stats.quantiles.empty());
+    TS_ASSERT_DELTA(stats.selectivity("==", "s1"), 0.01, 0.001);
+
+    // the statistics are kept when the array is saved
+    sarray<flexible_type> array;
+    array.open_for_read(test_file_name + ":0");
+    std::string saved_file_name = get_temp_name() + ".sidx";
+    array.save(saved_file_name);
+    TS_ASSERT(stats.from_map(read_index_file(saved_file_name).statistics));
+    TS_ASSERT_EQUALS(stats.num_rows, v);
+  }
+
+  void test_string_dictionary_encoding(void) {
+    using namespace v2_block_impl;
+    // 500 distinct strings, with some missing values
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < 4096; ++i) {
+      if (i % 10 == 0) data.push_back(FLEX_UNDEFINED);
+      else data.push_back("category_" + std::to_string(i % 500));
+    }
+    block_info info;
+    oarchive oarc;
+    typed_encode(data, info, oarc);
+    // the strings alone take about 50K
+    TS_ASSERT_LESS_THAN(oarc.off, 20000);
+
+    std::vector<flexible_type> decoded;
+    TS_ASSERT(typed_decode(info, oarc.buf, oarc.off, decoded));
+    TS_ASSERT_EQUALS(decoded.size(), data.size());
+    for (size_t i = 0;i < std::min(data.size(), decoded.size()); ++i) {
+      TS_ASSERT_EQUALS(decoded[i].get_type(), data[i].get_type());
+      if (data[i].get_type() == flex_type_enum::STRING) {
+        TS_ASSERT_EQUALS(decoded[i], data[i]);
+      }
+    }
+    free(oarc.buf);
+  }
+
+  void test_column_dictionary_encoding(void) {
+    using namespace v2_block_impl;
+    column_dictionary dictionary;
+    std::vector<std::vector<flexible_type> > blocks{
+      {"a", "b", "a", FLEX_UNDEFINED},
+      {FLEX_UNDEFINED, "c", "b", "c"},
+      {FLEX_UNDEFINED, FLEX_UNDEFINED}};
+    std::vector<block_info> infos(blocks.size());
+    std::vector<oarchive> oarcs(blocks.size());
+    // the blocks share the dictionary
+    for (size_t b = 0;b < blocks.size(); ++b) {
+      typed_encode(blocks[b], infos[b], oarcs[b], &dictionary, 3);
+    }
+    TS_ASSERT_EQUALS(dictionary.size(), 3);
+    auto shared_dictionary = std::make_shared<const column_dictionary>(dictionary);
+    for (size_t b = 0;b < blocks.size(); ++b) {
+      std::vector<flexible_type> decoded;
+      TS_ASSERT(typed_decode(infos[b], oarcs[b].buf, oarcs[b].off, decoded,
+                             shared_dictionary.get()));
+      typed_column codes;
+      TS_ASSERT(typed_decode_string_codes(infos[b], oarcs[b].buf, oarcs[b].off, 
+                                          shared_dictionary, codes));
+      TS_ASSERT_EQUALS(decoded.size(), blocks[b].size());
+      TS_ASSERT_EQUALS(codes.size(), blocks[b].size());
+      TS_ASSERT_EQUALS((int)codes.type(), (int)flex_type_enum::STRING);
+      for (size_t i = 0;i < blocks[b].size(); ++i) {
+        TS_ASSERT_EQUALS((int)decoded[i].get_type(), (int)blocks[b][i].get_type());
+        TS_ASSERT_EQUALS((int)codes.at(i).get_type(), (int)blocks[b][i].get_type());
+        if (blocks[b][i].get_type() == flex_type_enum::STRING) {
+          TS_ASSERT_EQUALS(decoded[i], blocks[b][i]);
+          TS_ASSERT_EQUALS(codes.at(i), blocks[b][i]);
+          TS_ASSERT_EQUALS(dictionary.value(codes.code_data()[i]), blocks[b][i]);
+        }
+      }
+      free(oarcs[b].buf);
+    }
+
+    // a block which does not fit in the dictionary has a block dictionary
+    std::vector<flexible_type> strings{"a", "d"};
+    block_info info;
+    oarchive oarc;
+    typed_encode(strings, info, oarc, &dictionary, 3);
+    TS_ASSERT_EQUALS(dictionary.size(), 3);
+    typed_column codes;
+    TS_ASSERT(!typed_decode_string_codes(info, oarc.buf, oarc.off, 
+                                         shared_dictionary, codes));
+    std::vector<flexible_type> decoded;
+    TS_ASSERT(typed_decode(info, oarc.buf, oarc.off, decoded));
+    TS_ASSERT_EQUALS(decoded.size(), 2);
+    TS_ASSERT_EQUALS(decoded[1], "d");
+    free(oarc.buf);
+  }
+
+  void test_column_dictionary_reads(void) {
+    std::vector<flexible_type> values;
+    for (size_t i = 0;i < 100000; ++i) {
+      if (i % 9 == 0) values.push_back(FLEX_UNDEFINED);
+      else values.push_back("country_" + std::to_string(i % 200));
+    }
+    // two segments, written by the same writer
+    sarray<flexible_type> array;
+    array.open_for_write(get_temp_name() + ".sidx", 2);
+    array.set_type(flex_type_enum::STRING);
+    std::copy(values.begin(), values.begin() + 50000, array.get_output_iterator(0));
+    std::copy(values.begin() + 50000, values.end(), array.get_output_iterator(1));
+    array.close();
+
+    auto reader = array.get_reader();
+    // reads within a segment are read as codes
+    std::vector<std::pair<size_t, size_t> > ranges{
+      {0, 1000}, {1000, 50000}, {50000, 100000}, {123, 7777}, {99990, 200000}};
+    for (auto range: ranges) {
+      typed_column column;
+      TS_ASSERT(reader->read_typed_rows(range.first, range.second, column));
+      size_t end = std::min<size_t>(range.second, values.size());
+      TS_ASSERT_EQUALS(column.size(), end - range.first);
+      TS_ASSERT_EQUALS((int)column.type(), (int)flex_type_enum::STRING);
+      TS_ASSERT_EQUALS(column.dictionary()->size(), 200);
+      for (size_t i = 0;i < column.size(); ++i) {
+        TS_ASSERT_EQUALS((int)column.at(i).get_type(), 
+                         (int)values[range.first + i].get_type());
+        if (column.is_defined(i)) {
+          TS_ASSERT_EQUALS(column.at(i), values[range.first + i]);
+        }
+      }
+    }
+    // sframe_rows across the segments are read as flexible_type
+    sframe_rows rows;
+    TS_ASSERT_EQUALS(reader->read_rows(49000, 51000, rows), 2000);
+    size_t i = 49000;
+    for (const auto& row: rows) {
+      TS_ASSERT_EQUALS((int)row[0].get_type(), (int)values[i].get_type());
+      if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+        TS_ASSERT_EQUALS(row[0], values[i]);
+      }
+      ++i;
+    }
+    // flexible_type reads decode the codes
+    std::vector<flexible_type> ret;
+    TS_ASSERT_EQUALS(reader->read_rows(0, values.size(), ret), values.size());
+    for (size_t i = 0;i < values.size(); ++i) {
+      TS_ASSERT_EQUALS((int)ret[i].get_type(), (int)values[i].get_type());
+      if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+        TS_ASSERT_EQUALS(ret[i], values[i]);
+      }
+    }
+
+    // without column dictionaries, the strings are not read as codes
+    size_t old_size = sframe_config::SFRAME_COLUMN_DICTIONARY_SIZE;
+    sframe_config::SFRAME_COLUMN_DICTIONARY_SIZE = 0;
+    sarray<flexible_type> plain_array;
+    plain_array.open_for_write(get_temp_name() + ".sidx", 1);
+    plain_array.set_type(flex_type_enum::STRING);
+    std::copy(values.begin(), values.end(), plain_array.get_output_iterator(0));
+    plain_array.close();
+    sframe_config::SFRAME_COLUMN_DICTIONARY_SIZE = old_size;
+    typed_column column;
+    TS_ASSERT(!plain_array.get_reader()->read_typed_rows(0, 1000, column));
+  }
+
+  void test_mmap_reads(void) {
+    using namespace v2_block_impl;
+    // an integer column and a string column in 2 segments
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 2, 2);
+    for (size_t i = 0;i < 2; ++i) {
+      for (size_t j = 0;j < 100000; ++j) {
+        group_writer.write_segment(0, i, flex_int(j * j));
+        group_writer.write_segment(1, i, std::to_string(random::rand()));
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    auto read_all = [&](size_t column) {
+      std::vector<flexible_type> ret;
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":" + std::to_string(column));
+      reader.read_rows(0, 2 * 100000, ret);
+      return ret;
+    };
+    size_t old_use_mmap = SFRAME_USE_MMAP;
+    for (size_t column = 0; column < 2; ++column) {
+      SFRAME_USE_MMAP = 0;
+      std::vector<flexible_type> buffered = read_all(column);
+      SFRAME_USE_MMAP = 1;
+      std::vector<flexible_type> mapped = read_all(column);
+      TS_ASSERT_EQUALS(buffered.size(), 200000);
+      TS_ASSERT_EQUALS(mapped.size(), buffered.size());
+      for (size_t i = 0; i < std::min(mapped.size(), buffered.size()); ++i) {
+        TS_ASSERT_EQUALS(mapped[i], buffered[i]);
+      }
+    }
+
+    // raw block reads through the mapped file
+    block_manager& manager = block_manager::get_instance();
+    index_file_information index = read_index_file(test_file_name + ":1");
+    column_address col = manager.open_column(index.segment_files[0]);
+    for (size_t i = 0; i < manager.num_blocks_in_column(col); ++i) {
+      block_address addr{std::get<0>(col), std::get<1>(col), i};
+      block_info* info = NULL;
+      auto bytes = manager.read_block(addr, &info);
+      TS_ASSERT(bytes != NULL);
+      TS_ASSERT_EQUALS(bytes->size(), info->block_size);
+      std::vector<flexible_type> typed;
+      TS_ASSERT(manager.read_typed_block(addr, typed));
+      TS_ASSERT_EQUALS(typed.size(), info->num_elem);
+    }
+    manager.close_column(col);
+    SFRAME_USE_MMAP = old_use_mmap;
+  }
+
+  void test_mapped_reads_are_not_copied(void) {
+    using namespace v2_block_impl;
+    // random doubles do not compress, so the blocks are stored as is
+    std::string test_file_name = get_temp_name() + ".sidx";
+    std::vector<flexible_type> values;
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> dist(0, 1);
+    for (size_t i = 0;i < 100000; ++i) values.push_back(dist(gen));
+    sarray<flexible_type> array;
+    array.open_for_write(test_file_name, 1);
+    array.set_type(flex_type_enum::FLOAT);
+    std::copy(values.begin(), values.end(), array.get_output_iterator(0));
+    array.close();
+
+    // the number of compressed blocks, which have to be read into a buffer
+    block_manager& manager = block_manager::get_instance();
+    column_address col = manager.open_column(array.get_index_info().segment_files[0]);
+    size_t nblocks = manager.num_blocks_in_column(col);
+    size_t ncompressed = 0;
+    for (size_t i = 0; i < nblocks; ++i) {
+      block_address addr{std::get<0>(col), std::get<1>(col), i};
+      if (manager.get_block_info(addr).flags & LZ4_COMPRESSION) ++ncompressed;
+    }
+    manager.close_column(col);
+    TS_ASSERT_LESS_THAN(ncompressed, nblocks);
+
+    size_t old_use_mmap = SFRAME_USE_MMAP;
+    for (size_t use_mmap : {0, 1}) {
+      SFRAME_USE_MMAP = use_mmap;
+      auto reader = array.get_reader();
+      size_t blocks_copied = block_manager::thread_num_blocks_copied();
+      std::vector<flexible_type> ret;
+      TS_ASSERT_EQUALS(reader->read_rows(0, values.size(), ret), values.size());
+      TS_ASSERT(ret == values);
+      blocks_copied = block_manager::thread_num_blocks_copied() - blocks_copied;
+      // the uncompressed blocks are decoded in place in the mapped file
+      TS_ASSERT_EQUALS(blocks_copied, use_mmap ? ncompressed : nblocks);
+    }
+    SFRAME_USE_MMAP = old_use_mmap;
+  }
+
+  void test_typed_decode_numeric(void) {
+    using namespace v2_block_impl;
+    std::vector<std::vector<flexible_type> > blocks{
+      {1, 2, -3, 4},
+      {1, FLEX_UNDEFINED, 3, FLEX_UNDEFINED},
+      {1.5, 2.25, -3.0},
+      {1.0, 2.0, FLEX_UNDEFINED, 4.0},
+      {FLEX_UNDEFINED, FLEX_UNDEFINED}};
+    for (size_t b = 0;b < blocks.size(); ++b) {
+      const auto& values = blocks[b];
+      block_info info;
+      oarchive oarc;
+      typed_encode(values, info, oarc);
+      flex_type_enum type = b < 2 ? flex_type_enum::INTEGER : flex_type_enum::FLOAT;
+      typed_column column;
+      TS_ASSERT(typed_decode_numeric(info, oarc.buf, oarc.off, type, column));
+      TS_ASSERT_EQUALS((int)column.type(), (int)type);
+      std::vector<flexible_type> decoded;
+      column.to_flexible(decoded);
+      TS_ASSERT_EQUALS(decoded.size(), values.size());
+      for (size_t i = 0;i < values.size(); ++i) {
+        TS_ASSERT_EQUALS((int)decoded[i].get_type(), 
+                         (int)(values[i].get_type() == flex_type_enum::UNDEFINED ? 
+                               flex_type_enum::UNDEFINED : type));
+        if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+          TS_ASSERT_EQUALS(decoded[i], values[i]);
+        }
+      }
+      free(oarc.buf);
+    }
+    // other types are not decoded
+    std::vector<flexible_type> strings{"a", "b"};
+    block_info info;
+    oarchive oarc;
+    typed_encode(strings, info, oarc);
+    typed_column column;
+    TS_ASSERT(!typed_decode_numeric(info, oarc.buf, oarc.off, 
+                                    flex_type_enum::INTEGER, column));
+    free(oarc.buf);
+  }
+
+  void test_typed_reads(void) {
+    std::vector<flexible_type> ints, floats;
+    for (size_t i = 0;i < 100000; ++i) {
+      ints.push_back(i % 7 == 0 ? FLEX_UNDEFINED : flexible_type(i));
+      floats.push_back(i % 5 == 0 ? FLEX_UNDEFINED : flexible_type(i * 0.5));
+    }
+    for (auto type: {flex_type_enum::INTEGER, flex_type_enum::FLOAT}) {
+      const auto& values = type == flex_type_enum::INTEGER ? ints : floats;
+      sarray<flexible_type> array;
+      array.open_for_write(get_temp_name() + ".sidx", 1);
+      array.set_type(type);
+      std::copy(values.begin(), values.end(), array.get_output_iterator(0));
+      array.close();
+
+      auto reader = array.get_reader();
+      // sequential and random reads, across block boundaries
+      std::vector<std::pair<size_t, size_t> > ranges{
+        {0, 1000}, {1000, 50000}, {50000, 100000}, {123, 77777}, 
+        {99990, 200000}, {10, 11}};
+      for (auto range: ranges) {
+        typed_column column;
+        TS_ASSERT(reader->read_typed_rows(range.first, range.second, column));
+        size_t end = std::min<size_t>(range.second, values.size());
+        TS_ASSERT_EQUALS(column.size(), end - range.first);
+        TS_ASSERT_EQUALS((int)column.type(), (int)type);
+        for (size_t i = 0;i < column.size(); ++i) {
+          TS_ASSERT(column.at(i) == values[range.first + i] || 
+                    (!column.is_defined(i) && 
+                     values[range.first + i].get_type() == flex_type_enum::UNDEFINED));
+        }
+      }
+      // sframe_rows are read as typed columns
+      sframe_rows rows;
+      TS_ASSERT_EQUALS(reader->read_rows(500, 1500, rows), 1000);
+      TS_ASSERT(rows.has_typed_column(0));
+      TS_ASSERT_EQUALS(rows.num_rows(), 1000);
+      size_t i = 500;
+      for (const auto& row: rows) {
+        TS_ASSERT_EQUALS((int)row[0].get_type(), (int)values[i].get_type());
+        if (values[i].get_type() != flex_type_enum::UNDEFINED) {
+          TS_ASSERT_EQUALS(row[0], values[i]);
+        }
+        ++i;
+      }
+      // flexible_type reads of the same blocks still work
+      std::vector<flexible_type> ret;
+      TS_ASSERT_EQUALS(reader->read_rows(0, values.size(), ret), values.size());
+      for (size_t i = 0;i < values.size(); ++i) {
+        TS_ASSERT_EQUALS((int)ret[i].get_type(), (int)values[i].get_type());
+      }
+    }
+  }
+
+  void test_prefetched_reads(void) {
+    using namespace v2_block_impl;
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 1, 1);
+    for (size_t j = 0;j < 200000; ++j) {
+      group_writer.write_segment(0, 0, std::to_string(j));
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    // prefetching only applies to files which are not memory mapped
+    size_t old_use_mmap = SFRAME_USE_MMAP;
+    size_t old_buffer_size = sframe_config::SFRAME_PREFETCH_BUFFER_SIZE;
+    SFRAME_USE_MMAP = 0;
+    block_manager& manager = block_manager::get_instance();
+    index_file_information index = read_index_file(test_file_name);
+    column_address col = manager.open_column(index.segment_files[0]);
+    size_t nblocks = manager.num_blocks_in_column(col);
+    TS_ASSERT_LESS_THAN(1, nblocks);
+    // a budget of 0 disables prefetching
+    for (size_t budget : {size_t(0), old_buffer_size}) {
+      sframe_config::SFRAME_PREFETCH_BUFFER_SIZE = budget;
+      for (size_t i = 0; i < nblocks; ++i) {
+        manager.prefetch_block(block_address{std::get<0>(col), std::get<1>(col), i});
+      }
+      // read in reverse, some of the blocks twice
+      size_t next_value = 200000;
+      for (size_t i = nblocks; i > 0; --i) {
+        block_address addr{std::get<0>(col), std::get<1>(col), i - 1};
+        std::vector<flexible_type> first, second;
+        TS_ASSERT(manager.read_typed_block(addr, first));
+        TS_ASSERT(manager.read_typed_block(addr, second));
+        TS_ASSERT_EQUALS(first.size(), second.size());
+        next_value -= first.size();
+        for (size_t j = 0; j < first.size(); ++j) {
+          TS_ASSERT_EQUALS(first[j], std::to_string(next_value + j));
+          TS_ASSERT_EQUALS(second[j], first[j]);
+        }
+      }
+      TS_ASSERT_EQUALS(next_value, 0);
+    }
+    // prefetches which are never read are dropped with the segment
+    manager.prefetch_block(block_address{std::get<0>(col), std::get<1>(col), 0});
+    manager.close_column(col);
+
+    // sequential scans through the reader
+    {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name);
+      std::vector<flexible_type> vals;
+      for (size_t i = 0; i < 200000; i += 1000) {
+        TS_ASSERT_EQUALS(reader.read_rows(i, i + 1000, vals), 1000);
+        TS_ASSERT_EQUALS(vals[0], std::to_string(i));
+        TS_ASSERT_EQUALS(vals[999], std::to_string(i + 999));
+      }
+    }
+    SFRAME_USE_MMAP = old_use_mmap;
+  }
+
   void test_typed_random_access(void) {
     // write a file
     sarray_group_format_writer_v2<flexible_type> group_writer;
@@ -845,6 +845,84 @@ class sframe_test : public CxxTest::TestSuite {
      evaluate(multiline_json());
    }
 
+   void test_structural_index() {
+     // lines split by the vectorized scan, and lines which must fall back to
+     // the state machine, longer than a vector block or not.
+     std::vector<std::string> lines{
+       "", "   ", "a", "a,", ",a", ",,", "a,,b", " a , b ,c ",
+       "1,2.5,hello,-3,+4,.5,5.,1e3,-2.5E-3",
+       "0123456789012345678901234567890123456789,x,0123456789012345678901234567890123456789",
+       "a,\"b,c\",d", "a,[1,2,3],b", "a, {1:2},b", "a,b # comment",
+       "tab\t,\tseparated,\\escaped"};
+     for (char dlm: {',', ';', '\t'}) {
+       csv_line_tokenizer fast, slow;
+       fast.delimiter = slow.delimiter = std::string(1, dlm);
+       slow.use_structural_index = false;
+       fast.init();
+       slow.init();
+       for (std::string line: lines) {
+         if (dlm != ',') std::replace(line.begin(), line.end(), ',', dlm);
+         std::vector<std::string> fast_tokens, slow_tokens;
+         TS_ASSERT_EQUALS(fast.tokenize_line(line.c_str(), line.length(), fast_tokens),
+                          slow.tokenize_line(line.c_str(), line.length(), slow_tokens));
+         TS_ASSERT(fast_tokens == slow_tokens);
+       }
+     }
+
+     // the numeric fast paths agree with the generic parser
+     csv_line_tokenizer tokenizer;
+     tokenizer.init();
+     std::string line = "1, -23 ,+4,2.5,-0.125, 1e3,.5,5.,1.5e-3,123456789012345678901";
+     std::vector<flexible_type> output{
+       flex_int(0), flex_int(0), flex_int(0),
+       flex_float(0), flex_float(0), flex_float(0), flex_float(0),
+       flex_float(0), flex_float(0), flex_float(0)};
+     TS_ASSERT_EQUALS(tokenizer.tokenize_line(&(line[0]), line.length(), output, true),
+                      output.size());
+     TS_ASSERT_EQUALS(output[0], 1);
+     TS_ASSERT_EQUALS(output[1], -23);
+     TS_ASSERT_EQUALS(output[2], 4);
+     TS_ASSERT_EQUALS(output[3], 2.5);
+     TS_ASSERT_EQUALS(output[4], -0.125);
+     TS_ASSERT_EQUALS(output[5], 1000.0);
+     TS_ASSERT_EQUALS(output[6], 0.5);
+     TS_ASSERT_EQUALS(output[7], 5.0);
+     TS_ASSERT_EQUALS(output[8], 1.5e-3);
+     TS_ASSERT_DELTA(output[9].get<flex_float>(), 123456789012345678901.0, 1e6);
+   }
+
+   void test_multiple_files() {
+     // small reads, so that the large file is parsed in several ranges
+     size_t old_read_size = SFRAME_CSV_PARSER_READ_SIZE;
+     SFRAME_CSV_PARSER_READ_SIZE = 1024;
+     std::string dirname = get_temp_name();
+     boost::filesystem::create_directory(dirname);
+     std::vector<size_t> file_lengths{10, 5000, 0, 300, 1};
+     size_t row = 0;
+     for (size_t i = 0; i < file_lengths.size(); ++i) {
+       std::ofstream fout(dirname + "/part" + std::to_string(i) + ".csv");
+       fout << "id,value\n";
+       for (size_t j = 0; j < file_lengths[i]; ++j, ++row) {
+         fout << row << ",\"v" << row << "\"\n";
+       }
+     }
+
+     csv_line_tokenizer tokenizer;
+     tokenizer.init();
+     sframe frame;
+     frame.init_from_csvs(dirname, tokenizer, true, false, false,
+                          {{"id", flex_type_enum::INTEGER}});
+     SFRAME_CSV_PARSER_READ_SIZE = old_read_size;
+
+     std::vector<std::vector<flexible_type> > vals;
+     graphlab::copy(frame, std::inserter(vals, vals.end()));
+     TS_ASSERT_EQUALS(vals.size(), row);
+     for (size_t i = 0; i < vals.size(); ++i) {
+       TS_ASSERT_EQUALS(vals[i][0], flex_int(i));
+       TS_ASSERT_EQUALS(vals[i][1], "v" + std::to_string(i));
+     }
+   }
+
    void test_alternate_line_endings() {
      evaluate(alternate_endline_test());
    }
@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <string>
+#include <vector>
+#include <fstream>
+#include <boost/filesystem.hpp>
+#include <sframe/sframe.hpp>
+#include <sframe/algorithm.hpp>
+#include <sframe/parallel_json_parser.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <fileio/temp_files.hpp>
+#include <cxxtest/TestSuite.h>
+
+using namespace graphlab;
+
+class sframe_json_test : public CxxTest::TestSuite {
+ public:
+  static std::string write_file(const std::string& contents) {
+    std::string filename = get_temp_name() + ".json";
+    std::ofstream fout(filename);
+    fout << contents;
+    return filename;
+  }
+
+  static std::vector<std::vector<flexible_type> > read_all(sframe& frame) {
+    std::vector<std::vector<flexible_type> > vals;
+    graphlab::copy(frame, std::inserter(vals, vals.end()));
+    return vals;
+  }
+
+  void test_inference() {
+    std::string filename = write_file(
+        "{\"id\": 1, \"score\": 2, \"name\": \"a\\\"b\", \"tags\": [1, 2]}\n"
+        "\n"
+        "  {\"score\": 2.5, \"id\": 2, \"extra\": {\"k\": null}, \"flag\": true}\r\n"
+        "{\"id\": 3, \"name\": null, \"score\": null, \"flag\": false}");
+    json_file_handling_options options;
+    sframe frame;
+    TS_ASSERT_EQUALS(parse_json_lines_to_sframe(filename, options, frame), 0);
+    TS_ASSERT_EQUALS(frame.num_rows(), 3);
+    TS_ASSERT_EQUALS(frame.num_columns(), 6);
+    TS_ASSERT_EQUALS(frame.column_name(0), "id");
+    TS_ASSERT_EQUALS(frame.column_type(0), flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS(frame.column_name(1), "score");
+    TS_ASSERT_EQUALS(frame.column_type(1), flex_type_enum::FLOAT);
+    TS_ASSERT_EQUALS(frame.column_name(2), "name");
+    TS_ASSERT_EQUALS(frame.column_type(2), flex_type_enum::STRING);
+    // nested values are kept as text
+    TS_ASSERT_EQUALS(frame.column_name(3), "tags");
+    TS_ASSERT_EQUALS(frame.column_type(3), flex_type_enum::STRING);
+    TS_ASSERT_EQUALS(frame.column_name(4), "extra");
+    TS_ASSERT_EQUALS(frame.column_name(5), "flag");
+    TS_ASSERT_EQUALS(frame.column_type(5), flex_type_enum::INTEGER);
+
+    auto vals = read_all(frame);
+    TS_ASSERT_EQUALS(vals[0][0], 1);
+    TS_ASSERT_EQUALS(vals[0][1], 2.0);
+    TS_ASSERT_EQUALS(vals[0][2], "a\"b");
+    TS_ASSERT_EQUALS(vals[0][3], "[1, 2]");
+    TS_ASSERT(vals[0][5].get_type() == flex_type_enum::UNDEFINED);
+    TS_ASSERT_EQUALS(vals[1][1], 2.5);
+    TS_ASSERT_EQUALS(vals[1][4], "{\"k\": null}");
+    TS_ASSERT_EQUALS(vals[1][5], 1);
+    TS_ASSERT(vals[2][1].get_type() == flex_type_enum::UNDEFINED);
+    TS_ASSERT(vals[2][2].get_type() == flex_type_enum::UNDEFINED);
+    TS_ASSERT_EQUALS(vals[2][5], 0);
+  }
+
+  void test_fields_and_nested() {
+    std::string filename = write_file(
+        "{\"a\": {\"x\": [1, 2]}, \"b\": [1, \"s\"], \"c\": 1, \"v\": [1, 2.5]}\n"
+        "{\"v\": [], \"c\": 2, \"a\": {}, \"ignored\": [{\"]\": \"}\"}]}\n");
+    json_file_handling_options options;
+    options.fields = {"c", "v", "a", "b"};
+    options.column_type_hints["c"] = flex_type_enum::FLOAT;
+    options.parse_nested = true;
+    sframe frame;
+    parse_json_lines_to_sframe(filename, options, frame);
+    TS_ASSERT_EQUALS(frame.num_columns(), 4);
+    TS_ASSERT_EQUALS(frame.column_type(0), flex_type_enum::FLOAT);
+    TS_ASSERT_EQUALS(frame.column_type(1), flex_type_enum::VECTOR);
+    TS_ASSERT_EQUALS(frame.column_type(2), flex_type_enum::DICT);
+    TS_ASSERT_EQUALS(frame.column_type(3), flex_type_enum::LIST);
+
+    auto vals = read_all(frame);
+    TS_ASSERT_EQUALS(vals.size(), 2);
+    TS_ASSERT_EQUALS(vals[0][0], 1.0);
+    TS_ASSERT(vals[0][1] == flexible_type(flex_vec{1, 2.5}));
+    flex_dict a = vals[0][2].get<flex_dict>();
+    TS_ASSERT_EQUALS(a.size(), 1);
+    TS_ASSERT_EQUALS(a[0].first, "x");
+    TS_ASSERT(a[0].second == flexible_type(flex_vec{1, 2}));
+    flex_list b = vals[0][3].get<flex_list>();
+    TS_ASSERT_EQUALS(b.size(), 2);
+    TS_ASSERT_EQUALS(b[1], "s");
+    TS_ASSERT_EQUALS(vals[1][0], 2.0);
+    TS_ASSERT_EQUALS(vals[1][1].size(), 0);
+    TS_ASSERT(vals[1][3].get_type() == flex_type_enum::UNDEFINED);
+  }
+
+  void test_failures() {
+    std::string filename = write_file(
+        "{\"a\": 1}\n"
+        "{\"a\": 2,}\n"
+        "[3]\n"
+        "{\"a\": \"four\"}\n"
+        "{\"a\": 5}\n");
+    json_file_handling_options options;
+    // "four" is not an integer
+    options.column_type_hints["a"] = flex_type_enum::INTEGER;
+    {
+      sframe frame;
+      TS_ASSERT_THROWS_ANYTHING(parse_json_lines_to_sframe(filename, options, frame));
+    }
+    options.continue_on_failure = true;
+    sframe frame;
+    TS_ASSERT_EQUALS(parse_json_lines_to_sframe(filename, options, frame), 3);
+    auto vals = read_all(frame);
+    TS_ASSERT_EQUALS(vals.size(), 2);
+    TS_ASSERT_EQUALS(vals[0][0], 1);
+    TS_ASSERT_EQUALS(vals[1][0], 5);
+  }
+
+  void test_multiple_files() {
+    // small reads, so that the large file is parsed in several ranges
+    size_t old_read_size = SFRAME_CSV_PARSER_READ_SIZE;
+    SFRAME_CSV_PARSER_READ_SIZE = 1024;
+    std::string dirname = get_temp_name();
+    boost::filesystem::create_directory(dirname);
+    std::vector<size_t> file_lengths{10, 5000, 0, 300, 1};
+    size_t row = 0;
+    for (size_t i = 0; i < file_lengths.size(); ++i) {
+      std::ofstream fout(dirname + "/part" + std::to_string(i) + ".json");
+      for (size_t j = 0; j < file_lengths[i]; ++j, ++row) {
+        fout << "{\"id\": " << row << ", \"value\": \"v" << row << "\"}\n";
+      }
+    }
+
+    json_file_handling_options options;
+    sframe frame;
+    parse_json_lines_to_sframe(dirname, options, frame);
+    SFRAME_CSV_PARSER_READ_SIZE = old_read_size;
+
+    auto vals = read_all(frame);
+    TS_ASSERT_EQUALS(vals.size(), row);
+    for (size_t i = 0; i < vals.size(); ++i) {
+      TS_ASSERT_EQUALS(vals[i][0], flex_int(i));
+      TS_ASSERT_EQUALS(vals[i][1], "v" + std::to_string(i));
+    }
+
+    // a row limit reads the first rows
+    options.row_limit = 20;
+    sframe limited;
+    parse_json_lines_to_sframe(dirname, options, limited);
+    TS_ASSERT_EQUALS(limited.num_rows(), 20);
+  }
+};
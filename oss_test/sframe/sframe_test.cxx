@@ -16,6 +16,7 @@
 */
 #include <iostream>
 #include <typeinfo>
+#include <numeric>
 #include <boost/filesystem.hpp>
 #include <sframe/sframe.hpp>
 #include <sframe/algorithm.hpp>
@@ -1425,6 +1426,74 @@ class sframe_test : public CxxTest::TestSuite {
    }
 
 
+   void run_flat_groupby_aggregate_test(size_t NUM_GROUPS,
+                                        size_t NUM_ROWS,
+                                        size_t BUFFER_SIZE) {
+     // all the aggregators used here keep their state in the flat group table
+     sframe input;
+     input.open_for_write({"key","int","float"},
+                          {flex_type_enum::INTEGER, flex_type_enum::INTEGER,
+                          flex_type_enum::FLOAT},
+                          "", 4 /* 4 segments*/);
+     // row i is (i % NUM_GROUPS, i, i / 2.0). Every 7th int is missing.
+     std::map<flex_int, std::vector<double> > ints, floats;
+     std::map<flex_int, size_t> counts;
+     for (size_t i = 0;i < NUM_ROWS; ++i) {
+       auto iter = input.get_output_iterator(i % 4);
+       flex_int key = i % NUM_GROUPS;
+       std::vector<flexible_type> flex{key, flex_int(i), (double)i / 2.0};
+       if (i % 7 == 0) flex[1] = FLEX_UNDEFINED;
+       else ints[key].push_back(i);
+       floats[key].push_back((double)i / 2.0);
+       ++counts[key];
+       (*iter) = flex;
+       ++iter;
+     }
+     input.close();
+     sframe output = graphlab::groupby_aggregate(input,
+                                       {"key"},
+                                       {"count","nncount","sum","min","max","avg","var"},
+                                       {{{}, std::make_shared<groupby_operators::count>()},
+                                       {{"int"}, std::make_shared<groupby_operators::non_null_count>()},
+                                       {{"int"}, std::make_shared<groupby_operators::sum>()},
+                                       {{"int"}, std::make_shared<groupby_operators::min>()},
+                                       {{"float"}, std::make_shared<groupby_operators::max>()},
+                                       {{"float"}, std::make_shared<groupby_operators::average>()},
+                                       {{"float"}, std::make_shared<groupby_operators::variance>()}},
+                                       BUFFER_SIZE);
+     TS_ASSERT_EQUALS(output.num_columns(), 8);
+     TS_ASSERT_EQUALS(output.num_rows(), counts.size());
+
+     std::vector<std::vector<flexible_type> > ret;
+     output.get_reader()->read_rows(0, output.num_rows(), ret);
+     std::set<flex_int> allkeys;
+     for(auto& row : ret) {
+       flex_int key = row[0];
+       allkeys.insert(key);
+       const auto& int_values = ints[key];
+       const auto& float_values = floats[key];
+       double mean = 0, var = 0;
+       for (double v: float_values) mean += v / float_values.size();
+       for (double v: float_values) var += (v - mean) * (v - mean) / float_values.size();
+       TS_ASSERT_EQUALS(flex_int(row[1]), flex_int(counts[key]));
+       TS_ASSERT_EQUALS(flex_int(row[2]), flex_int(int_values.size()));
+       TS_ASSERT_EQUALS(flex_int(row[3]),
+                        flex_int(std::accumulate(int_values.begin(), int_values.end(), 0.0)));
+       if (int_values.empty()) {
+         TS_ASSERT_EQUALS(row[4].get_type(), flex_type_enum::UNDEFINED);
+       } else {
+         TS_ASSERT_EQUALS(flex_int(row[4]),
+                          flex_int(*std::min_element(int_values.begin(), int_values.end())));
+       }
+       TS_ASSERT_EQUALS(double(row[5]),
+                        *std::max_element(float_values.begin(), float_values.end()));
+       TS_ASSERT_DELTA(double(row[6]), mean, 1E-5);
+       TS_ASSERT_DELTA(double(row[7]), var, 1E-3);
+     }
+     TS_ASSERT_EQUALS(allkeys.size(), counts.size());
+   }
+
+
    void test_sframe_groupby_aggregate() {
      //small number of groups
      run_groupby_aggregate_sum_test(100, 100000, 100);
@@ -1441,6 +1510,10 @@ class sframe_test : public CxxTest::TestSuite {
      //very very small buffer
      run_groupby_aggregate_sum_test(100000, 100000, 2);
      run_groupby_aggregate_average_test(100000, 100000, 2);
+     //aggregators with flat states
+     run_flat_groupby_aggregate_test(100, 100000, 1000);
+     run_flat_groupby_aggregate_test(1000, 100000, 10);
+     run_flat_groupby_aggregate_test(100000, 100000, 2);
    
    }
 
@@ -1663,4 +1736,88 @@ class sframe_test : public CxxTest::TestSuite {
        ++i;
      }
    }
+
+   void test_sframe_rows_typed_columns() {
+     std::vector<std::vector<flexible_type> > data{{1,FLEX_UNDEFINED,3},
+                                                   {1.5,2.5,3.5},
+                                                   {1,"a",3.5}};
+     sframe_rows rows;
+     for (auto& col: data) {
+       rows.add_decoded_column(std::make_shared<std::vector<flexible_type>>(col));
+     }
+     typed_column int_column = rows.get_typed_column(0);
+     TS_ASSERT_EQUALS((int)int_column.type(), (int)flex_type_enum::INTEGER);
+     TS_ASSERT(!int_column.all_defined());
+     TS_ASSERT(int_column.is_defined(0));
+     TS_ASSERT(!int_column.is_defined(1));
+     TS_ASSERT_EQUALS(int_column.int_data()[2], 3);
+
+     typed_column float_column = rows.get_typed_column(1);
+     TS_ASSERT_EQUALS((int)float_column.type(), (int)flex_type_enum::FLOAT);
+     TS_ASSERT(float_column.all_defined());
+     TS_ASSERT_EQUALS(float_column.float_data()[1], 2.5);
+
+     typed_column mixed_column = rows.get_typed_column(2);
+     TS_ASSERT(!mixed_column.is_packed());
+
+     // round trip
+     sframe_rows out;
+     out.add_typed_column(int_column);
+     out.add_typed_column(float_column);
+     out.add_typed_column(mixed_column);
+     for (size_t c = 0;c < data.size(); ++c) {
+       for (size_t r = 0;r < data[c].size(); ++r) {
+         TS_ASSERT_EQUALS((int)out[r][c].get_type(), (int)data[c][r].get_type());
+         TS_ASSERT(out[r][c] == data[c][r] || 
+                   data[c][r].get_type() == flex_type_enum::UNDEFINED);
+       }
+     }
+   }
+
+   void test_sframe_rows_lazy_typed_columns() {
+     sframe_rows rows;
+     rows.add_typed_column(typed_column(std::vector<flex_int>{1, 2, 3}));
+     rows.add_decoded_column(std::make_shared<std::vector<flexible_type>>(
+         std::vector<flexible_type>{"a", "b", "c"}));
+     TS_ASSERT_EQUALS(rows.num_rows(), 3);
+     TS_ASSERT_EQUALS(rows.num_columns(), 2);
+     TS_ASSERT(rows.has_typed_column(0));
+     TS_ASSERT(!rows.has_typed_column(1));
+
+     // typed columns are returned without packing them again
+     typed_column first = rows.get_typed_column(0);
+     TS_ASSERT_EQUALS(first.int_data(), rows.get_typed_column(0).int_data());
+
+     // copies share the typed columns
+     sframe_rows copy = rows;
+     TS_ASSERT(copy.has_typed_column(0));
+     TS_ASSERT_EQUALS(copy.get_typed_column(0).int_data(), first.int_data());
+
+     // reading as flexible_type converts, but keeps the typed column
+     const sframe_rows& const_rows = rows;
+     TS_ASSERT_EQUALS(const_rows.cget_columns()[0]->size(), 3);
+     TS_ASSERT_EQUALS(const_rows[1][0], 2);
+     TS_ASSERT_EQUALS(const_rows[2][1], "c");
+     TS_ASSERT(rows.has_typed_column(0));
+
+     // type checks to the packed type keep the typed column
+     rows.type_check_inplace({flex_type_enum::INTEGER, flex_type_enum::STRING});
+     TS_ASSERT(rows.has_typed_column(0));
+     copy.type_check_inplace({flex_type_enum::FLOAT, flex_type_enum::STRING});
+     TS_ASSERT(!copy.has_typed_column(0));
+     TS_ASSERT_EQUALS((int)copy[0][0].get_type(), (int)flex_type_enum::FLOAT);
+
+     // modifying drops the typed columns, and does not affect the copies
+     sframe_rows other = rows;
+     rows.get_columns()[0]->at(0) = 10;
+     TS_ASSERT(!rows.has_typed_column(0));
+     TS_ASSERT_EQUALS(rows.get_typed_column(0).int_data()[0], 10);
+     TS_ASSERT_EQUALS(other.get_typed_column(0).int_data()[0], 1);
+     TS_ASSERT_EQUALS(other[0][0], 1);
+
+     // columns may be replaced by typed columns
+     other.set_typed_column(1, typed_column(std::vector<flex_float>{0.5, 1.5, 2.5}));
+     TS_ASSERT(other.has_typed_column(1));
+     TS_ASSERT_EQUALS(other[1][1], 1.5);
+   }
 };
@@ -7,6 +7,8 @@
  */
 #include <sframe_query_engine/planning/planner.hpp>
 #include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/execution/subplan_executor.hpp>
+#include <sframe_query_engine/execution/query_profile.hpp>
 #include <sframe_query_engine/operators/all_operators.hpp>
 #include <sframe_query_engine/util/aggregates.hpp>
 #include <sframe/sarray.hpp>
@@ -136,6 +138,119 @@ class basic_end_to_end: public CxxTest::TestSuite {
       TS_ASSERT_EQUALS(2*i + 1, all_rows[i]);
     }
   }
+  void test_morsels() {
+    const size_t TEST_LENGTH = 100000;
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(i);
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    graphlab::copy(data.begin(), data.end(), *sa);
+    sa->close();
+
+    size_t old_morsel_num_rows = SFRAME_MORSEL_NUM_ROWS;
+    SFRAME_MORSEL_NUM_ROWS = 1024;
+
+    // a filter keeping only the rows of the first half: the morsels of the
+    // second half produce no output.
+    auto make_filter = [&]() {
+      auto root = op_sarray_source::make_planner_node(sa);
+      auto selector = 
+          op_transform::make_planner_node(
+              root, 
+              [](const sframe_rows::row& a)->flexible_type {
+                return (flex_int)(a[0]) < TEST_LENGTH / 2 && (flex_int)(a[0]) % 3 == 0;
+              },
+              flex_type_enum::INTEGER);
+      return op_logical_filter::make_planner_node(root, selector);
+    };
+
+    materialize_options opts;
+    opts.num_segments = 3;
+    auto res = planner().materialize(make_filter(), opts);
+    TS_ASSERT_EQUALS(res.num_segments(), 3);
+    std::vector<flexible_type> all_rows;
+    res.select_column(0)->get_reader()->read_rows(0, res.size(), all_rows);
+    TS_ASSERT_EQUALS(all_rows.size(), (TEST_LENGTH / 2 + 2) / 3);
+    for (flex_int i = 0;i < all_rows.size(); ++i) {
+      TS_ASSERT_EQUALS(3*i, all_rows[i]);
+    }
+
+    // the callback receives the rows of each segment in order
+    std::vector<std::vector<flexible_type> > segment_rows(3);
+    planner().materialize(make_filter(),
+                          [&](size_t segment_id, const std::shared_ptr<sframe_rows>& rows) {
+                            for (const auto& row: *rows) {
+                              segment_rows[segment_id].push_back(row[0]);
+                            }
+                            return false;
+                          },
+                          3);
+    std::vector<flexible_type> concatenated;
+    for (const auto& rows: segment_rows) {
+      concatenated.insert(concatenated.end(), rows.begin(), rows.end());
+    }
+    TS_ASSERT(concatenated == all_rows);
+
+    // with (almost) no room for buffering, the morsels which are not at
+    // the head of their segment wait for it to be written out.
+    size_t old_max_buffered_bytes = SFRAME_MORSEL_MAX_BUFFERED_BYTES;
+    SFRAME_MORSEL_MAX_BUFFERED_BYTES = 1;
+    res = planner().materialize(make_filter(), opts);
+    std::vector<flexible_type> bounded_rows;
+    res.select_column(0)->get_reader()->read_rows(0, res.size(), bounded_rows);
+    TS_ASSERT(bounded_rows == all_rows);
+    SFRAME_MORSEL_MAX_BUFFERED_BYTES = old_max_buffered_bytes;
+
+    SFRAME_MORSEL_NUM_ROWS = old_morsel_num_rows;
+  }
+
+  void test_profile() {
+    const size_t TEST_LENGTH = 10000;
+    std::vector<flexible_type> data;
+    for (size_t i = 0;i < TEST_LENGTH; ++i) data.push_back(i);
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    graphlab::copy(data.begin(), data.end(), *sa);
+    sa->close();
+
+    auto root = op_sarray_source::make_planner_node(sa);
+    auto selector =
+        op_transform::make_planner_node(
+            root,
+            [](const sframe_rows::row& a)->flexible_type {
+              return (flex_int)(a[0]) % 2 == 0;
+            },
+            flex_type_enum::INTEGER);
+    auto filter = op_logical_filter::make_planner_node(root, selector);
+
+    materialize_options opts;
+    opts.num_segments = 2;
+    opts.profile = std::make_shared<query_profile>();
+    auto res = planner().materialize(filter, opts);
+    TS_ASSERT_EQUALS(res.size(), TEST_LENGTH / 2);
+
+    auto stages = opts.profile->stages();
+    TS_ASSERT_EQUALS(stages.size(), 1);
+    TS_ASSERT_EQUALS(stages[0].rows_out, TEST_LENGTH / 2);
+    TS_ASSERT_EQUALS(stages[0].operators.size(), 3);
+
+    // output first: the filter, then its inputs
+    auto filter_op = opts.profile->get_operator(stages[0].operators[0]);
+    TS_ASSERT_EQUALS(filter_op.name, "logical_filter");
+    TS_ASSERT_EQUALS(filter_op.inputs.size(), 2);
+    TS_ASSERT_EQUALS(filter_op.counters.rows_in, 2 * TEST_LENGTH);
+    TS_ASSERT_EQUALS(filter_op.counters.rows_out, TEST_LENGTH / 2);
+    TS_ASSERT_LESS_THAN_EQUALS(2, filter_op.counters.num_instances);
+
+    auto source_op = opts.profile->get_operator(filter_op.inputs[0]);
+    TS_ASSERT_EQUALS(source_op.counters.rows_in, 0);
+    TS_ASSERT_EQUALS(source_op.counters.rows_out, TEST_LENGTH);
+    TS_ASSERT_LESS_THAN(0, source_op.counters.blocks_read);
+    TS_ASSERT_LESS_THAN(0, source_op.counters.bytes_read);
+
+    TS_ASSERT_DIFFERS(opts.profile->to_string().find("logical_filter"), std::string::npos);
+  }
+
   void test_reduction_aggregate() {
     const size_t TEST_LENGTH = 1000000;
     std::vector<flexible_type> data;
@@ -0,0 +1,356 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <sframe_query_engine/planning/planner.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/planning/optimization_engine.hpp>
+#include <sframe_query_engine/planning/cost_model.hpp>
+#include <sframe_query_engine/operators/all_operators.hpp>
+#include <sframe/groupby_aggregate_operators.hpp>
+#include <sframe/testing_utils.hpp>
+#include <cxxtest/TestSuite.h>
+
+using namespace graphlab;
+using namespace graphlab::query_eval;
+
+class blocking_operators_test : public CxxTest::TestSuite {
+ public:
+
+  /// rows of (key, value) with key = i % 5 and value = i
+  static sframe make_data(size_t n) {
+    std::vector<std::vector<size_t> > data;
+    for (size_t i = 0; i < n; ++i) data.push_back({i % 5, i});
+    return make_integer_testing_sframe({"key", "value"}, data);
+  }
+
+  /// logical_filter(node, node[column] < threshold)
+  static pnode_ptr filter_less_than(pnode_ptr node, size_t column, flex_int threshold) {
+    auto mask = op_transform::make_planner_node(
+        op_project::make_planner_node(node, {column}),
+        [=](const sframe_rows::row& row)->flexible_type { return row[0] < threshold; },
+        flex_type_enum::INTEGER);
+    return op_logical_filter::make_planner_node(node, mask);
+  }
+
+  void test_sort_node() {
+    sframe sf = make_data(100);
+    auto sorted = op_sort::make_planner_node(op_sframe_source::make_planner_node(sf),
+                                             sf.column_names(), {1}, {false});
+    TS_ASSERT_EQUALS(infer_planner_node_length(sorted), 100);
+
+    auto filtered = filter_less_than(sorted, 1, 10);
+
+    // the filter is evaluated before the sort
+    auto optimized = optimization_engine::optimize_planner_graph(filtered, materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type, (int)planner_node_type::SORT_NODE);
+
+    auto result = testing_extract_sframe_data(planner().materialize(filtered));
+    TS_ASSERT_EQUALS(result.size(), 10);
+    for (size_t i = 0; i < result.size(); ++i) {
+      TS_ASSERT_EQUALS(result[i][1], flex_int(9 - i));
+      TS_ASSERT_EQUALS(result[i][0], flex_int((9 - i) % 5));
+    }
+  }
+
+  void test_groupby_node() {
+    sframe sf = make_data(100);
+    std::vector<std::pair<std::vector<std::string>,
+                          std::shared_ptr<group_aggregate_value> > > groups =
+        {{{}, std::make_shared<groupby_operators::count>()},
+         {{"value"}, std::make_shared<groupby_operators::sum>()}};
+    auto grouped = op_groupby_aggregate::make_planner_node(
+        op_sframe_source::make_planner_node(sf), sf.column_names(),
+        {"key"}, {"count", ""}, groups);
+
+    TS_ASSERT_EQUALS(infer_planner_node_type(grouped).size(), 3);
+    TS_ASSERT_EQUALS(infer_planner_node_length(grouped), -1);
+
+    // a filter on the key is pushed below the groupby
+    auto filtered = filter_less_than(grouped, 0, 2);
+    auto optimized = optimization_engine::optimize_planner_graph(filtered, materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type,
+                     (int)planner_node_type::GROUPBY_AGGREGATE_NODE);
+
+    auto result = testing_extract_sframe_data(planner().materialize(filtered));
+    std::sort(result.begin(), result.end());
+    TS_ASSERT_EQUALS(result.size(), 2);
+    for (size_t key = 0; key < 2; ++key) {
+      flex_int sum = 0;
+      for (size_t i = key; i < 100; i += 5) sum += i;
+      TS_ASSERT_EQUALS(result[key][0], flex_int(key));
+      TS_ASSERT_EQUALS(result[key][1], 20);
+      TS_ASSERT_EQUALS(result[key][2], sum);
+    }
+
+    // a filter on an aggregate is not
+    auto agg_filtered = filter_less_than(grouped, 1, 100);
+    optimized = optimization_engine::optimize_planner_graph(agg_filtered, materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type,
+                     (int)planner_node_type::LOGICAL_FILTER_NODE);
+  }
+
+  void test_join_node() {
+    sframe left = make_data(20);
+    sframe right = make_integer_testing_sframe({"key", "value", "other"},
+                                               {{0, 100, 1000}, {1, 101, 1001}, {7, 107, 1007}});
+
+    auto joined = op_join::make_planner_node(op_sframe_source::make_planner_node(left),
+                                             op_sframe_source::make_planner_node(right),
+                                             left.column_names(), right.column_names(),
+                                             "inner", {{"key", "key"}});
+    auto column_names = joined->operator_parameters["column_names"].get<flex_list>();
+    TS_ASSERT_EQUALS(column_names.size(), 4);
+    TS_ASSERT_EQUALS(column_names[0], "key");
+    TS_ASSERT_EQUALS(column_names[1], "value");
+    TS_ASSERT_EQUALS(column_names[2], "value.1");
+    TS_ASSERT_EQUALS(column_names[3], "other");
+
+    // Only the right value column is needed.
+    auto projected = op_project::make_planner_node(joined, {0, 2});
+    auto optimized = optimization_engine::optimize_planner_graph(projected, materialize_options());
+    pnode_ptr join_node = optimized;
+    while (join_node->operator_type != planner_node_type::JOIN_NODE &&
+           join_node->operator_type != planner_node_type::BROADCAST_JOIN_NODE) {
+      join_node = join_node->inputs[0];
+    }
+    TS_ASSERT_EQUALS(infer_planner_node_type(join_node).size(), 2);
+
+    auto result = testing_extract_sframe_data(planner().materialize(projected));
+    std::sort(result.begin(), result.end());
+    TS_ASSERT_EQUALS(result.size(), 8);
+    for (size_t i = 0; i < result.size(); ++i) {
+      TS_ASSERT_EQUALS(result[i][0], flex_int(i / 4));
+      TS_ASSERT_EQUALS(result[i][1], flex_int(100 + i / 4));
+    }
+  }
+
+  void test_broadcast_join() {
+    sframe left = make_data(20);
+    sframe right = make_integer_testing_sframe({"key", "value", "other"},
+                                               {{0, 100, 1000}, {0, 200, 2000}, {7, 107, 1007}});
+    auto left_source = op_sframe_source::make_planner_node(left);
+    auto right_source = op_sframe_source::make_planner_node(right);
+
+    // inner and left joins against the small right side are broadcast
+    for (std::string join_type: {"inner", "left"}) {
+      auto joined = op_join::make_planner_node(left_source, right_source,
+                                               left.column_names(), right.column_names(),
+                                               join_type, {{"key", "key"}});
+      auto optimized = optimization_engine::optimize_planner_graph(joined, materialize_options());
+      TS_ASSERT_EQUALS((int)optimized->operator_type,
+                       (int)planner_node_type::BROADCAST_JOIN_NODE);
+      TS_ASSERT_EQUALS(infer_planner_node_type(optimized).size(), 4);
+
+      auto result = testing_extract_sframe_data(planner().materialize(joined));
+      std::sort(result.begin(), result.end());
+      // 4 rows with key 0, each matching 2 rows of the right side
+      size_t expected_size = (join_type == "inner") ? 8 : 8 + 16;
+      TS_ASSERT_EQUALS(result.size(), expected_size);
+      for (const auto& row: result) {
+        if (row[0] == 0) {
+          TS_ASSERT(row[2] == 100 || row[2] == 200);
+          TS_ASSERT_EQUALS(row[3], flex_int(row[2]) * 10);
+        } else {
+          TS_ASSERT_EQUALS(row[2].get_type(), flex_type_enum::UNDEFINED);
+          TS_ASSERT_EQUALS(row[3].get_type(), flex_type_enum::UNDEFINED);
+        }
+      }
+    }
+
+    // a right join against a small left side keeps the keys of unmatched rows
+    auto right_joined = op_join::make_planner_node(right_source, left_source,
+                                                   right.column_names(), left.column_names(),
+                                                   "right", {{"key", "key"}});
+    auto optimized = optimization_engine::optimize_planner_graph(right_joined, materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type,
+                     (int)planner_node_type::BROADCAST_JOIN_NODE);
+    auto result = testing_extract_sframe_data(planner().materialize(right_joined));
+    TS_ASSERT_EQUALS(result.size(), 8 + 16);
+    for (const auto& row: result) {
+      TS_ASSERT_EQUALS(row[0], flex_int(row[3]) % 5);
+      if (row[0] != 0) TS_ASSERT_EQUALS(row[1].get_type(), flex_type_enum::UNDEFINED);
+    }
+
+    // outer joins are not
+    auto outer = op_join::make_planner_node(left_source, right_source,
+                                            left.column_names(), right.column_names(),
+                                            "outer", {{"key", "key"}});
+    optimized = optimization_engine::optimize_planner_graph(outer, materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type, (int)planner_node_type::JOIN_NODE);
+  }
+
+  void test_join_reorder() {
+    // a: 1000 rows, value unique. b: 10 rows per key. c: 10 values of a.
+    sframe a = make_data(1000);
+    std::vector<std::vector<size_t> > b_data, c_data;
+    for (size_t i = 0; i < 50; ++i) b_data.push_back({i % 5, i});
+    for (size_t i = 0; i < 10; ++i) c_data.push_back({i, i * 10});
+    sframe b = make_integer_testing_sframe({"key", "bval"}, b_data);
+    sframe c = make_integer_testing_sframe({"value", "cval"}, c_data);
+    auto a_source = op_sframe_source::make_planner_node(a);
+    auto b_source = op_sframe_source::make_planner_node(b);
+    auto c_source = op_sframe_source::make_planner_node(c);
+
+    auto ab = op_join::make_planner_node(a_source, b_source,
+                                         a.column_names(), b.column_names(),
+                                         "inner", {{"key", "key"}});
+    auto abc = op_join::make_planner_node(ab, c_source,
+                                          {"key", "value", "bval"}, c.column_names(),
+                                          "inner", {{"value", "value"}});
+    auto ac = op_join::make_planner_node(a_source, c_source,
+                                         a.column_names(), c.column_names(),
+                                         "inner", {{"value", "value"}});
+
+    // the column statistics of the sources drive the estimates
+    cost_model costs;
+    TS_ASSERT(costs.estimate(a_source).exact);
+    TS_ASSERT_EQUALS(costs.estimate_num_rows(a_source), 1000);
+    TS_ASSERT_DELTA(costs.estimate(a_source).columns[0].num_distinct, 5, 1);
+    TS_ASSERT_DELTA(costs.estimate_num_rows(ab), 10000, 1000);
+    TS_ASSERT_DELTA(costs.estimate_num_rows(ac), 10, 2);
+    TS_ASSERT_DELTA(costs.estimate_num_rows(filter_less_than(a_source, 0, 1)),
+                    1000 * cost_model::DEFAULT_SELECTIVITY, 1);
+
+    // c is joined first, and the column order is restored
+    auto optimized = optimization_engine::optimize_planner_graph(abc, materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type, (int)planner_node_type::PROJECT_NODE);
+    auto column_names = abc->operator_parameters["column_names"].get<flex_list>();
+    TS_ASSERT_EQUALS(column_names.size(), 4);
+    TS_ASSERT_EQUALS(column_names[3], "cval");
+
+    auto result = testing_extract_sframe_data(planner().materialize(abc));
+    TS_ASSERT_EQUALS(result.size(), 100);
+    for (const auto& row: result) {
+      TS_ASSERT_EQUALS(row[0], flex_int(row[1]) % 5);
+      TS_ASSERT_EQUALS(flex_int(row[2]) % 5, flex_int(row[0]));
+      TS_ASSERT_EQUALS(row[3], flex_int(row[1]) * 10);
+    }
+  }
+
+  void test_window_aggregate_node() {
+    // rows of (key, time, value), not sorted by time, with repeated times
+    std::vector<std::vector<size_t> > data;
+    for (size_t i = 0; i < 1000; ++i) data.push_back({i % 3, (i * 37) % 400, i});
+    sframe sf = make_integer_testing_sframe({"key", "time", "value"}, data);
+    auto source = op_sframe_source::make_planner_node(sf);
+
+    std::vector<std::shared_ptr<group_aggregate_value> > aggregators =
+        {std::make_shared<groupby_operators::sum>(),
+         std::make_shared<groupby_operators::max>(),
+         std::make_shared<groupby_operators::count_distinct>()};
+    for (auto aggregator: aggregators) {
+      auto window = op_window_aggregate::make_planner_node(
+          source, sf.column_names(), {"key"}, "time", "value", aggregator,
+          -10, 5, "agg");
+      TS_ASSERT_EQUALS(infer_planner_node_type(window).size(), 4);
+      TS_ASSERT_EQUALS(infer_planner_node_length(window), 1000);
+
+      std::vector<std::vector<flexible_type> > expected;
+      for (const auto& row: data) {
+        std::unique_ptr<group_aggregate_value> agg(aggregator->new_instance());
+        for (const auto& other: data) {
+          if (other[0] == row[0] &&
+              flex_int(other[1]) >= flex_int(row[1]) - 10 &&
+              flex_int(other[1]) <= flex_int(row[1]) + 5) {
+            agg->add_element_simple(flex_int(other[2]));
+          }
+        }
+        expected.push_back({row[0], row[1], row[2], agg->emit()});
+      }
+      auto result = testing_extract_sframe_data(planner().materialize(window));
+      TS_ASSERT_EQUALS(result.size(), expected.size());
+      // the output is sorted by key and time
+      for (size_t i = 1; i < result.size(); ++i) {
+        TS_ASSERT(result[i - 1][0] < result[i][0] ||
+                  (result[i - 1][0] == result[i][0] && result[i - 1][1] <= result[i][1]));
+      }
+      std::sort(result.begin(), result.end());
+      std::sort(expected.begin(), expected.end());
+      TS_ASSERT(result == expected);
+    }
+
+    auto window = op_window_aggregate::make_planner_node(
+        source, sf.column_names(), {"key"}, "time", "value",
+        std::make_shared<groupby_operators::count>(), 0, 0, "count");
+
+    // a filter on the partition key is pushed below the window
+    auto filtered = filter_less_than(window, 0, 1);
+    auto optimized = optimization_engine::optimize_planner_graph(filtered, materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type,
+                     (int)planner_node_type::WINDOW_AGGREGATE_NODE);
+    auto result = testing_extract_sframe_data(planner().materialize(filtered));
+    TS_ASSERT_EQUALS(result.size(), 334);
+
+    // a filter on the time is not
+    optimized = optimization_engine::optimize_planner_graph(filter_less_than(window, 1, 10),
+                                                            materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type,
+                     (int)planner_node_type::LOGICAL_FILTER_NODE);
+
+    // the input must be sorted if it is claimed to be
+    auto unsorted = op_window_aggregate::make_planner_node(
+        source, sf.column_names(), {}, "time", "value",
+        std::make_shared<groupby_operators::sum>(), 0, 1, "sum", true);
+    TS_ASSERT_THROWS_ANYTHING(planner().materialize(unsorted));
+  }
+
+  void test_window_aggregate_presorted() {
+    // rows of (key, time, value), sorted by key and time, spanning many
+    // blocks per partition
+    std::vector<std::vector<size_t> > data;
+    for (size_t key = 0; key < 3; ++key) {
+      for (size_t i = 0; i < 5000; ++i) data.push_back({key, i / 2, i});
+    }
+    sframe sf = make_integer_testing_sframe({"key", "time", "value"}, data);
+    auto source = op_sframe_source::make_planner_node(sf);
+
+    auto window = op_window_aggregate::make_planner_node(
+        source, sf.column_names(), {"key"}, "time", "value",
+        std::make_shared<groupby_operators::sum>(), -2, 1, "sum", true);
+    // the source is streamed into the window, without a sort
+    TS_ASSERT(window->inputs[0] == source);
+    TS_ASSERT(!is_blocking_node(window));
+
+    // the window aggregate is used by a transform
+    auto doubled = op_transform::make_planner_node(
+        op_project::make_planner_node(window, {3}),
+        [](const sframe_rows::row& row)->flexible_type { return row[0] * 2; },
+        flex_type_enum::INTEGER);
+    auto result = testing_extract_sframe_data(planner().materialize(window));
+    auto doubled_result = testing_extract_sframe_data(planner().materialize(doubled));
+    TS_ASSERT_EQUALS(result.size(), data.size());
+    TS_ASSERT_EQUALS(doubled_result.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      flex_int expected = 0;
+      for (size_t j = i >= 10 ? i - 10 : 0; j < std::min(i + 10, data.size()); ++j) {
+        if (data[j][0] == data[i][0] &&
+            flex_int(data[j][1]) >= flex_int(data[i][1]) - 2 &&
+            flex_int(data[j][1]) <= flex_int(data[i][1]) + 1) {
+          expected += data[j][2];
+        }
+      }
+      TS_ASSERT_EQUALS(result[i][0], data[i][0]);
+      TS_ASSERT_EQUALS(result[i][2], data[i][2]);
+      TS_ASSERT_EQUALS(result[i][3], expected);
+      TS_ASSERT_EQUALS(doubled_result[i][0], 2 * expected);
+    }
+  }
+
+  void test_invalid_arguments_fail_early() {
+    sframe sf = make_data(10);
+    auto source = op_sframe_source::make_planner_node(sf);
+    TS_ASSERT_THROWS_ANYTHING(op_join::make_planner_node(source, source,
+                                                         sf.column_names(), sf.column_names(),
+                                                         "sideways", {{"key", "key"}}));
+    TS_ASSERT_THROWS_ANYTHING(op_join::make_planner_node(source, source,
+                                                         sf.column_names(), sf.column_names(),
+                                                         "inner", {{"key", "missing"}}));
+    TS_ASSERT_THROWS_ANYTHING(op_window_aggregate::make_planner_node(
+        source, sf.column_names(), {"key"}, "value", "value",
+        std::make_shared<groupby_operators::sum>(), 1, -1, "sum"));
+  }
+};
@@ -10,6 +10,7 @@
 #include <sframe_query_engine/operators/binary_transform.hpp>
 #include <sframe/sarray.hpp>
 #include <sframe/algorithm.hpp>
+#include <cmath>
 #include <cxxtest/TestSuite.h>
 
 #include "check_node.hpp"
@@ -44,13 +45,145 @@ class binary_transform_test: public CxxTest::TestSuite {
     check_node(node, expected);
   }
 
+  void test_numeric_kernels() {
+    std::vector<flexible_type> ints{0,1,FLEX_UNDEFINED,3,-4,5,FLEX_UNDEFINED,7};
+    std::vector<flexible_type> floats{0.5,0.0,FLEX_UNDEFINED,3.0,2.5,FLEX_UNDEFINED,1.0,-7.5};
+    std::vector<flexible_type> divisors{2,0,1,FLEX_UNDEFINED,3,-2,0,7};
+
+    auto with_undefined = [](std::function<flexible_type(const flexible_type&, 
+                                                         const flexible_type&)> f,
+                             bool is_equality_compare) {
+      return [=](const sframe_rows::row& left, const sframe_rows::row& right)->flexible_type {
+        const auto& l = left[0];
+        const auto& r = right[0];
+        if (l.get_type() == flex_type_enum::UNDEFINED ||
+            r.get_type() == flex_type_enum::UNDEFINED) {
+          if (is_equality_compare) return f(flexible_type(l.get_type()), 
+                                            flexible_type(r.get_type()));
+          else return FLEX_UNDEFINED;
+        }
+        return f(l, r);
+      };
+    };
+    struct test_case {
+      std::string op;
+      std::vector<flexible_type>* left;
+      std::vector<flexible_type>* right;
+      flex_type_enum type;
+      binary_transform_type fn;
+    };
+    std::vector<test_case> cases{
+      {"+", &ints, &ints, flex_type_enum::INTEGER, with_undefined(
+          [](const flexible_type& l, const flexible_type& r) { return l + r; }, false)},
+      {"*", &floats, &ints, flex_type_enum::FLOAT, with_undefined(
+          [](const flexible_type& l, const flexible_type& r) { return l * r; }, false)},
+      {"/", &ints, &floats, flex_type_enum::FLOAT, with_undefined(
+          [](const flexible_type& l, const flexible_type& r)->flexible_type {
+            return (flex_float)l / (flex_float)r; }, false)},
+      {"%", &ints, &divisors, flex_type_enum::INTEGER, with_undefined(
+          [](const flexible_type& l, const flexible_type& r)->flexible_type {
+            if ((flex_int)r == 0) return FLEX_UNDEFINED;
+            return l.get<flex_int>() % r.get<flex_int>(); }, false)},
+      {"<=", &ints, &floats, flex_type_enum::INTEGER, with_undefined(
+          [](const flexible_type& l, const flexible_type& r)->flexible_type {
+            return (int)(l <= r); }, false)},
+      {"==", &ints, &floats, flex_type_enum::INTEGER, with_undefined(
+          [](const flexible_type& l, const flexible_type& r)->flexible_type {
+            return (int)(l == r); }, true)},
+      {"|", &floats, &ints, flex_type_enum::INTEGER, with_undefined(
+          [](const flexible_type& l, const flexible_type& r)->flexible_type {
+            return (int)(!l.is_zero() || !r.is_zero()); }, false)}};
+
+    for (auto& c: cases) {
+      auto sa_left = make_sarray(*c.left);
+      auto sa_right = make_sarray(*c.right);
+      std::vector<flexible_type> expected;
+      for (size_t i = 0; i < c.left->size(); ++i) {
+        sframe_rows left_rows, right_rows;
+        left_rows.add_decoded_column(std::make_shared<std::vector<flexible_type>>(
+                1, (*c.left)[i]));
+        right_rows.add_decoded_column(std::make_shared<std::vector<flexible_type>>(
+                1, (*c.right)[i]));
+        expected.push_back(c.fn(left_rows[0], right_rows[0]));
+      }
+      auto node = make_node(op_sarray_source(sa_left), op_sarray_source(sa_right), 
+                            c.fn, c.type, c.op);
+      check_node(node, expected);
+    }
+  }
+
+  void test_scalar_kernels() {
+    using namespace binary_transform_kernels;
+    std::vector<flexible_type> ints{0,1,FLEX_UNDEFINED,3,-4,5,FLEX_UNDEFINED,7};
+    std::vector<flexible_type> floats{0.5,0.0,FLEX_UNDEFINED,3.0,2.5,FLEX_UNDEFINED,1.0,-7.5};
+    std::vector<flexible_type> scalars{2, 0, -1.5, 0.0};
+    auto pack = [](const std::vector<flexible_type>& values) {
+      return typed_column(std::make_shared<std::vector<flexible_type> >(values));
+    };
+
+    // the scalar kernels compute the same values as the column kernels
+    // on a column holding the scalar
+    for (std::string op: {"+", "-", "*", "/", "%", "<", ">", "<=", ">=",
+                          "==", "!=", "&", "|"}) {
+      kernel_op kernel = get_kernel_op(op);
+      for (auto values: {&ints, &floats}) {
+        typed_column column = pack(*values);
+        TS_ASSERT(column.is_packed());
+        for (const auto& scalar: scalars) {
+          typed_column constant = pack(std::vector<flexible_type>(values->size(), scalar));
+          for (bool scalar_on_left: {false, true}) {
+            typed_column expected, result;
+            bool has_kernel = scalar_on_left ?
+                apply_kernel(kernel, constant, column, expected) :
+                apply_kernel(kernel, column, constant, expected);
+            TS_ASSERT_EQUALS(apply_scalar_kernel(kernel, column, scalar,
+                                                 scalar_on_left, result),
+                             has_kernel);
+            if (!has_kernel) continue;
+            TS_ASSERT_EQUALS((int)result.type(), (int)expected.type());
+            std::vector<flexible_type> result_values, expected_values;
+            result.to_flexible(result_values);
+            expected.to_flexible(expected_values);
+            TS_ASSERT_EQUALS(result_values.size(), expected_values.size());
+            for (size_t i = 0; i < expected_values.size(); ++i) {
+              const auto& r = result_values[i];
+              const auto& e = expected_values[i];
+              TS_ASSERT_EQUALS((int)r.get_type(), (int)e.get_type());
+              if (e.get_type() == flex_type_enum::FLOAT && std::isnan(e.get<flex_float>())) {
+                TS_ASSERT(std::isnan(r.get<flex_float>()));
+              } else if (e.get_type() != flex_type_enum::UNDEFINED) {
+                TS_ASSERT_EQUALS(r, e);
+              }
+            }
+          }
+        }
+      }
+    }
+
+    // only numeric scalars have kernels
+    typed_column result;
+    TS_ASSERT(!apply_scalar_kernel(kernel_op::PLUS, pack(ints), flexible_type("a"),
+                                   false, result));
+    TS_ASSERT(!apply_scalar_kernel(kernel_op::EQ, pack(ints), FLEX_UNDEFINED,
+                                   true, result));
+  }
+
  private:
+  std::shared_ptr<sarray<flexible_type>> make_sarray(const std::vector<flexible_type>& data) {
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    graphlab::copy(data.begin(), data.end(), *sa);
+    sa->close();
+    return sa;
+  }
+
   std::shared_ptr<execution_node> make_node(const op_sarray_source& source_left,
                                             const op_sarray_source& source_right,
-                                            binary_transform_type f, flex_type_enum type) {
+                                            binary_transform_type f, flex_type_enum type,
+                                            std::string kernel = "") {
     auto left_node = std::make_shared<execution_node>(std::make_shared<op_sarray_source>(source_left));
     auto right_node = std::make_shared<execution_node>(std::make_shared<op_sarray_source>(source_right));
-    auto node = std::make_shared<execution_node>(std::make_shared<op_binary_transform>(f, type),
+    auto node = std::make_shared<execution_node>(std::make_shared<op_binary_transform>(f, type, kernel),
                                                  std::vector<std::shared_ptr<execution_node>>({left_node, right_node}));
     return node;
   }
@@ -0,0 +1,232 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <sframe_query_engine/operators/all_operators.hpp>
+#include <sframe_query_engine/operators/expression.hpp>
+#include <sframe_query_engine/planning/planner.hpp>
+#include <sframe_query_engine/planning/optimization_engine.hpp>
+#include <sframe_query_engine/planning/materialize_options.hpp>
+#include <sframe/sarray.hpp>
+#include <sframe/algorithm.hpp>
+#include <cxxtest/TestSuite.h>
+
+using namespace graphlab;
+using namespace graphlab::query_eval;
+
+class expression_transform_test: public CxxTest::TestSuite {
+ public:
+  void test_common_subexpressions() {
+    auto x = make_column_expression(0, flex_type_enum::INTEGER);
+    auto y = make_column_expression(1, flex_type_enum::INTEGER);
+    auto sum = make_binary_expression("+", x, y, flex_type_enum::INTEGER);
+    // built separately, but identical to sum
+    auto sum2 = make_binary_expression("+", make_column_expression(0, flex_type_enum::INTEGER),
+                                       y, flex_type_enum::INTEGER);
+    auto square = make_binary_expression("*", sum, sum2, flex_type_enum::INTEGER);
+
+    expression_program program({sum, square, sum2});
+    // x, y, x + y, (x + y) * (x + y)
+    TS_ASSERT_EQUALS(program.num_steps(), 4);
+    TS_ASSERT_EQUALS(program.num_outputs(), 3);
+    TS_ASSERT(program.uses_column(0));
+    TS_ASSERT(program.uses_column(1));
+    TS_ASSERT(!program.uses_column(2));
+
+    // different constants and different types are different expressions
+    auto plus_one = make_binary_expression("+", x, make_constant_expression(1),
+                                           flex_type_enum::INTEGER);
+    auto plus_two = make_binary_expression("+", x, make_constant_expression(2),
+                                           flex_type_enum::INTEGER);
+    auto plus_one_float = make_binary_expression("+", x, make_constant_expression(1.0),
+                                                 flex_type_enum::FLOAT);
+    TS_ASSERT_EQUALS(expression_program({plus_one, plus_two, plus_one_float}).num_steps(), 7);
+
+    // given functions of the same operator and types are different expressions
+    auto fn = [](const flexible_type& l, const flexible_type& r) { return l + r; };
+    auto first = make_binary_expression("custom", x, y, flex_type_enum::INTEGER, fn);
+    auto second = make_binary_expression("custom", x, y, flex_type_enum::INTEGER, fn);
+    TS_ASSERT_EQUALS(expression_program({first, second}).num_steps(), 4);
+    TS_ASSERT_EQUALS(expression_program({first, first}).num_steps(), 3);
+  }
+
+  void test_evaluate() {
+    auto a = std::make_shared<std::vector<flexible_type> >();
+    auto b = std::make_shared<std::vector<flexible_type> >();
+    for (size_t i = 0; i < 100; ++i) {
+      a->push_back(i % 7 == 0 ? FLEX_UNDEFINED : flexible_type(flex_int(i)));
+      b->push_back(i % 5 == 0 ? FLEX_UNDEFINED : flexible_type(flex_float(i) / 2));
+    }
+    auto x = make_column_expression(0, flex_type_enum::INTEGER);
+    auto y = make_column_expression(1, flex_type_enum::FLOAT);
+    auto sum = make_binary_expression("+", x, y, flex_type_enum::FLOAT);
+    auto scaled = make_binary_expression("*", sum, make_constant_expression(2),
+                                         flex_type_enum::FLOAT);
+    auto equal = make_binary_expression("==", x, y, flex_type_enum::INTEGER);
+    auto choice = make_conditional_expression(
+        make_binary_expression(">", x, make_constant_expression(50), flex_type_enum::INTEGER),
+        make_cast_expression(x, flex_type_enum::STRING),
+        make_constant_expression("small"));
+
+    expression_program program({scaled, equal, choice});
+    std::vector<typed_column> out;
+    program.evaluate({typed_column(a), typed_column(b)}, 100, out);
+    TS_ASSERT_EQUALS(out.size(), 3);
+
+    std::vector<flexible_type> scaled_values, equal_values, choice_values;
+    out[0].to_flexible(scaled_values);
+    out[1].to_flexible(equal_values);
+    out[2].to_flexible(choice_values);
+    for (size_t i = 0; i < 100; ++i) {
+      bool adef = (*a)[i].get_type() != flex_type_enum::UNDEFINED;
+      bool bdef = (*b)[i].get_type() != flex_type_enum::UNDEFINED;
+      if (adef && bdef) {
+        TS_ASSERT_EQUALS((flex_float)scaled_values[i], (i + i / 2.0) * 2);
+        TS_ASSERT_EQUALS((flex_int)equal_values[i], 0);
+      } else {
+        TS_ASSERT_EQUALS(scaled_values[i].get_type(), flex_type_enum::UNDEFINED);
+        // comparing for equality compares the missing-ness
+        TS_ASSERT_EQUALS((flex_int)equal_values[i], (flex_int)(adef == bdef));
+      }
+      if (!adef) {
+        TS_ASSERT_EQUALS(choice_values[i].get_type(), flex_type_enum::UNDEFINED);
+      } else if (i > 50) {
+        TS_ASSERT_EQUALS(choice_values[i].get<flex_string>(), std::to_string(i));
+      } else {
+        TS_ASSERT_EQUALS(choice_values[i].get<flex_string>(), "small");
+      }
+    }
+  }
+
+  void test_evaluate_string_codes() {
+    auto dictionary = std::make_shared<column_dictionary>();
+    size_t code;
+    for (std::string s: {"us", "fr", "de"}) dictionary->insert(s, 10, code);
+    std::vector<uint32_t> codes;
+    auto validity = typed_column::make_validity(100);
+    for (size_t i = 0; i < 100; ++i) {
+      codes.push_back(i % 3);
+      if (i % 10 != 0) typed_column::set_defined(validity, i);
+    }
+    typed_column column(std::move(codes), dictionary, std::move(validity));
+
+    auto x = make_column_expression(0, flex_type_enum::STRING);
+    auto is_fr = make_binary_expression("==", x, make_constant_expression("fr"),
+                                        flex_type_enum::INTEGER);
+    auto not_fr = make_binary_expression("!=", make_constant_expression("fr"), x,
+                                         flex_type_enum::INTEGER);
+    auto is_it = make_binary_expression("==", x, make_constant_expression("it"),
+                                        flex_type_enum::INTEGER);
+    expression_program program({is_fr, not_fr, is_it});
+    std::vector<typed_column> out;
+    program.evaluate({column}, 100, out);
+    TS_ASSERT_EQUALS(out.size(), 3);
+    for (size_t i = 0; i < 3; ++i) {
+      TS_ASSERT_EQUALS((int)out[i].type(), (int)flex_type_enum::INTEGER);
+      TS_ASSERT(out[i].all_defined());
+    }
+    for (size_t i = 0; i < 100; ++i) {
+      // a missing string is not equal to any string
+      bool fr = i % 10 != 0 && i % 3 == 1;
+      TS_ASSERT_EQUALS(out[0].int_data()[i], (flex_int)fr);
+      TS_ASSERT_EQUALS(out[1].int_data()[i], (flex_int)!fr);
+      TS_ASSERT_EQUALS(out[2].int_data()[i], 0);
+    }
+  }
+
+  void test_evaluate_scalar_operands() {
+    auto a = std::make_shared<std::vector<flexible_type> >();
+    for (size_t i = 0; i < 100; ++i) {
+      a->push_back(i % 7 == 0 ? FLEX_UNDEFINED : flexible_type(flex_int(i)));
+    }
+    auto x = make_column_expression(0, flex_type_enum::INTEGER);
+    auto ten = make_constant_expression(10);
+    // constants on either side of the operator, and read as a column
+    auto minus = make_binary_expression("-", ten, x, flex_type_enum::INTEGER);
+    auto ratio = make_binary_expression("/", x, make_constant_expression(4.0),
+                                        flex_type_enum::FLOAT);
+    auto less = make_binary_expression("<", ten, x, flex_type_enum::INTEGER);
+
+    expression_program program({minus, ratio, less, ten});
+    std::vector<typed_column> out;
+    program.evaluate({typed_column(a)}, 100, out);
+    TS_ASSERT_EQUALS(out.size(), 4);
+    TS_ASSERT_EQUALS((int)out[0].type(), (int)flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS((int)out[1].type(), (int)flex_type_enum::FLOAT);
+    TS_ASSERT_EQUALS((int)out[2].type(), (int)flex_type_enum::INTEGER);
+    TS_ASSERT_EQUALS(out[3].size(), 100);
+    for (size_t i = 0; i < 100; ++i) {
+      TS_ASSERT_EQUALS(out[3].at(i), 10);
+      if (i % 7 == 0) {
+        TS_ASSERT(!out[0].is_defined(i));
+        TS_ASSERT(!out[1].is_defined(i));
+        TS_ASSERT(!out[2].is_defined(i));
+      } else {
+        TS_ASSERT_EQUALS(out[0].int_data()[i], 10 - (flex_int)i);
+        TS_ASSERT_EQUALS(out[1].float_data()[i], i / 4.0);
+        TS_ASSERT_EQUALS(out[2].int_data()[i], (flex_int)(10 < i));
+      }
+    }
+  }
+
+  void test_fuse_transforms() {
+    std::vector<flexible_type> data;
+    for (size_t i = 0; i < 1000; ++i) {
+      data.push_back(i % 10 == 0 ? FLEX_UNDEFINED : flexible_type(flex_int(i)));
+    }
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write();
+    graphlab::copy(data.begin(), data.end(), *sa);
+    sa->close();
+    auto source = op_sarray_source::make_planner_node(sa);
+
+    // plus_one = source + 1
+    auto plus_one = op_transform::make_planner_node(
+        source,
+        [](const sframe_rows::row& a)->flexible_type {
+          return a[0].get_type() == flex_type_enum::UNDEFINED ? a[0] : a[0] + 1;
+        },
+        flex_type_enum::INTEGER);
+    plus_one->any_operator_parameters["expression"] = any(
+        make_binary_expression("+", make_column_expression(0, flex_type_enum::INTEGER),
+                               make_constant_expression(1), flex_type_enum::INTEGER));
+
+    // result = plus_one * source
+    auto result = op_binary_transform::make_planner_node(
+        plus_one, source,
+        [](const sframe_rows::row& a, const sframe_rows::row& b)->flexible_type {
+          if (a[0].get_type() == flex_type_enum::UNDEFINED ||
+              b[0].get_type() == flex_type_enum::UNDEFINED) return FLEX_UNDEFINED;
+          return a[0] * b[0];
+        },
+        flex_type_enum::INTEGER);
+    result->any_operator_parameters["expression"] = any(
+        make_binary_expression("*", make_column_expression(0, flex_type_enum::INTEGER),
+                               make_column_expression(1, flex_type_enum::INTEGER),
+                               flex_type_enum::INTEGER));
+
+    // both transforms become a single expression transform reading the
+    // source once
+    auto optimized = optimization_engine::optimize_planner_graph(result, materialize_options());
+    TS_ASSERT_EQUALS((int)optimized->operator_type,
+                     (int)planner_node_type::EXPRESSION_TRANSFORM_NODE);
+    TS_ASSERT_EQUALS(optimized->inputs.size(), 1);
+    TS_ASSERT_EQUALS((int)optimized->inputs[0]->operator_type,
+                     (int)planner_node_type::SARRAY_SOURCE_NODE);
+
+    auto res = planner().materialize(result);
+    std::vector<flexible_type> values;
+    res.select_column(0)->get_reader()->read_rows(0, res.size(), values);
+    TS_ASSERT_EQUALS(values.size(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      if (i % 10 == 0) {
+        TS_ASSERT_EQUALS(values[i].get_type(), flex_type_enum::UNDEFINED);
+      } else {
+        TS_ASSERT_EQUALS((flex_int)values[i], (flex_int)((i + 1) * i));
+      }
+    }
+  }
+};
@@ -95,6 +95,39 @@ class logical_filter_test: public CxxTest::TestSuite {
     check_node(node, expected);
   }
 
+  void test_filter_typed_masks() {
+    auto data_sa = get_data_sarray();
+    std::vector<flexible_type> data;
+    data_sa->get_reader()->read_rows(0, data_sa->size(), data);
+
+    // integer mask with missing values, float mask, and a mixed mask
+    std::vector<std::vector<flexible_type> > filters{
+      {1, FLEX_UNDEFINED, 0, 3, FLEX_UNDEFINED, -1},
+      {0.5, 0.0, FLEX_UNDEFINED, 0.0, 2.0, 0.0},
+      {"a", 0, "", 1.0, FLEX_UNDEFINED, 0.0}};
+    // the integer and float masks are read as typed columns
+    std::vector<flex_type_enum> filter_types{
+      flex_type_enum::INTEGER, flex_type_enum::FLOAT, flex_type_enum::UNDEFINED};
+    for (size_t f = 0; f < filters.size(); ++f) {
+      const auto& filter = filters[f];
+      auto filter_sa = std::make_shared<sarray<flexible_type>>();
+      filter_sa->open_for_write();
+      if (filter_types[f] != flex_type_enum::UNDEFINED) {
+        filter_sa->set_type(filter_types[f]);
+      }
+      graphlab::copy(filter.begin(), filter.end(), *filter_sa);
+      filter_sa->close();
+
+      std::vector<flexible_type> expected;
+      for (size_t i =0 ; i < data.size(); ++i) {
+        if (!filter[i].is_zero()) {
+          expected.push_back(data[i]);
+        }
+      }
+      auto node = make_node(op_sarray_source(data_sa), op_sarray_source(filter_sa));
+      check_node(node, expected);
+    }
+  }
 
  private:
   std::shared_ptr<sarray<flexible_type>> get_data_sarray() {
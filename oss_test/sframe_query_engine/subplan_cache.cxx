@@ -0,0 +1,170 @@
+/**
+ * Copyright (C) 2015 Dato, Inc.
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms
+ * of the BSD license. See the LICENSE file for details.
+ */
+#include <sframe_query_engine/planning/planner.hpp>
+#include <sframe_query_engine/planning/planner_node.hpp>
+#include <sframe_query_engine/planning/subplan_cache.hpp>
+#include <sframe_query_engine/operators/all_operators.hpp>
+#include <sframe_query_engine/operators/expression.hpp>
+#include <sframe/testing_utils.hpp>
+#include <cxxtest/TestSuite.h>
+
+using namespace graphlab;
+using namespace graphlab::query_eval;
+
+class subplan_cache_test : public CxxTest::TestSuite {
+ public:
+
+  /// rows of (key, value) with key = i % 5 and value = i
+  static sframe make_data(size_t n) {
+    std::vector<std::vector<size_t> > data;
+    for (size_t i = 0; i < n; ++i) data.push_back({i % 5, i});
+    return make_integer_testing_sframe({"key", "value"}, data);
+  }
+
+  /**
+   * logical_filter(node, node[column] < threshold), where the mask is
+   * described by an expression if with_expression is true.
+   */
+  static pnode_ptr filter_less_than(pnode_ptr node, size_t column,
+                                    flex_int threshold, bool with_expression = true) {
+    auto mask = op_transform::make_planner_node(
+        op_project::make_planner_node(node, {column}),
+        [=](const sframe_rows::row& row)->flexible_type { return row[0] < threshold; },
+        flex_type_enum::INTEGER);
+    if (with_expression) {
+      mask->any_operator_parameters["expression"] = make_binary_expression(
+          "<", make_column_expression(0, flex_type_enum::INTEGER),
+          make_constant_expression(threshold), flex_type_enum::INTEGER);
+    }
+    return op_logical_filter::make_planner_node(node, mask);
+  }
+
+  static std::vector<std::string> segment_files(const sframe& sf) {
+    return sf.select_column(0)->get_index_info().segment_files;
+  }
+
+  void test_structural_key() {
+    sframe sf = make_data(100);
+    uint128_t a = 0, b = 0, c = 0, d = 0;
+    TS_ASSERT(subplan_cache::structural_key(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10), a));
+    TS_ASSERT(subplan_cache::structural_key(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10), b));
+    TS_ASSERT(subplan_cache::structural_key(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 20), c));
+    TS_ASSERT(a == b);
+    TS_ASSERT(a != c);
+    // opaque functions cannot be identified
+    TS_ASSERT(!subplan_cache::structural_key(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10, false), d));
+  }
+
+  void test_reuse_equal_graph() {
+    subplan_cache::get_instance().clear();
+    sframe sf = make_data(100);
+    auto first = planner().materialize(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10));
+    TS_ASSERT_EQUALS(subplan_cache::get_instance().num_entries(), 1);
+    TS_ASSERT_EQUALS(subplan_cache::get_instance().num_bytes(),
+                     subplan_cache::file_size(first));
+    TS_ASSERT(subplan_cache::file_size(first) > 0);
+
+    // the same filter built again reads the cached result
+    auto second = planner().materialize(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10));
+    TS_ASSERT(segment_files(first) == segment_files(second));
+    TS_ASSERT(testing_extract_sframe_data(first) == testing_extract_sframe_data(second));
+
+    // a different filter is computed
+    auto third = planner().materialize(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 20));
+    TS_ASSERT_EQUALS(third.num_rows(), 20);
+    TS_ASSERT_EQUALS(subplan_cache::get_instance().num_entries(), 2);
+  }
+
+  void test_reuse_subplan() {
+    subplan_cache::get_instance().clear();
+    sframe sf = make_data(100);
+    planner().materialize(filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10));
+
+    // a projection of an equal filter reads the cached filter
+    auto projected = op_project::make_planner_node(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10), {1});
+    auto filtered = projected->inputs[0];
+    auto result = testing_extract_sframe_data(planner().materialize(projected));
+    TS_ASSERT_EQUALS((int)filtered->operator_type,
+                     (int)planner_node_type::SFRAME_SOURCE_NODE);
+    TS_ASSERT_EQUALS(result.size(), 10);
+    for (size_t i = 0; i < result.size(); ++i) {
+      TS_ASSERT_EQUALS(result[i][0], flex_int(i));
+    }
+  }
+
+  void test_shared_parent() {
+    subplan_cache::get_instance().clear();
+    sframe sf = make_data(100);
+    // the filtered frame, held like an SArray holds its node, several
+    // columns of which are materialized
+    pnode_handle filtered(filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10));
+    TS_ASSERT(has_external_handles(filtered.get()));
+    auto key = planner().materialize(op_project::make_planner_node(filtered, {0}));
+    TS_ASSERT_EQUALS((int)filtered->operator_type,
+                     (int)planner_node_type::SFRAME_SOURCE_NODE);
+    TS_ASSERT_EQUALS(key.num_rows(), 10);
+
+    auto value = testing_extract_sframe_data(
+        planner().materialize(op_project::make_planner_node(filtered, {1})));
+    TS_ASSERT_EQUALS(value.size(), 10);
+    for (size_t i = 0; i < value.size(); ++i) {
+      TS_ASSERT_EQUALS(value[i][0], flex_int(i));
+    }
+    filtered.reset();
+    TS_ASSERT(!has_external_handles(filtered.get()));
+  }
+
+  void test_unshared_parent() {
+    subplan_cache::get_instance().clear();
+    sframe sf = make_data(100);
+    // a node only referenced while building the graph is not shared
+    pnode_ptr filtered = filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10);
+    pnode_ptr other_reference = filtered;
+    TS_ASSERT(!has_external_handles(filtered.get()));
+    auto key = planner().materialize(op_project::make_planner_node(filtered, {0}));
+    TS_ASSERT_EQUALS((int)filtered->operator_type,
+                     (int)planner_node_type::LOGICAL_FILTER_NODE);
+    TS_ASSERT_EQUALS(key.num_rows(), 10);
+  }
+
+  void test_budget() {
+    subplan_cache::get_instance().clear();
+    size_t old_budget = SFRAME_SUBPLAN_CACHE_SIZE;
+    sframe sf = make_data(100);
+    size_t size_10 = subplan_cache::file_size(planner().materialize(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10)));
+    size_t size_5 = subplan_cache::file_size(planner().materialize(
+        filter_less_than(op_sframe_source::make_planner_node(sf), 1, 5)));
+    TS_ASSERT(size_10 > 0 && size_5 > 0);
+
+    // room for one of the results, but not for both
+    subplan_cache::get_instance().clear();
+    SFRAME_SUBPLAN_CACHE_SIZE = size_10 + size_5 - 1;
+    planner().materialize(filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10));
+    planner().materialize(filter_less_than(op_sframe_source::make_planner_node(sf), 1, 5));
+    // the first result is evicted to make room for the second
+    TS_ASSERT_EQUALS(subplan_cache::get_instance().num_entries(), 1);
+    TS_ASSERT_EQUALS(subplan_cache::get_instance().num_bytes(), size_5);
+
+    // too large to be cached
+    subplan_cache::get_instance().clear();
+    SFRAME_SUBPLAN_CACHE_SIZE = size_10 - 1;
+    planner().materialize(filter_less_than(op_sframe_source::make_planner_node(sf), 1, 10));
+    TS_ASSERT_EQUALS(subplan_cache::get_instance().num_entries(), 0);
+    SFRAME_SUBPLAN_CACHE_SIZE = old_budget;
+    subplan_cache::get_instance().clear();
+  }
+};
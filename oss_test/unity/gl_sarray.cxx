@@ -22,6 +22,7 @@
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <sframe/sarray.hpp>
+#include <sframe/rolling_aggregate.hpp>
 
 using namespace graphlab;
 
@@ -446,6 +447,51 @@ class gl_sarray_test: public CxxTest::TestSuite {
       auto result = a.builtin_rolling_apply(std::string("__builtin__avg__"), -3, 0);
       _assert_sarray_equals(result,{flex_undefined(),
         flex_undefined(),flex_undefined(),1.5,2.5,3.5,4.5,5.5,6.5,7.5});
+
+      // the incrementally maintained windows match aggregating each window
+      std::vector<flexible_type> values;
+      for (size_t i = 0; i < 5000; ++i) {
+        if (i % 7 == 0) values.push_back(FLEX_UNDEFINED);
+        else values.push_back(flex_int((i * 7919) % 1000) - 500);
+      }
+      for (auto dtype: {flex_type_enum::INTEGER, flex_type_enum::FLOAT}) {
+        gl_sarray b(values, dtype);
+        auto typed_values = _to_vec(b);
+        for (std::string fn: {"sum", "min", "max", "avg", "var", "stdv", "nonnull__count"}) {
+          for (size_t min_observations: {size_t(0), size_t(80)}) {
+            std::string name = "__builtin__" + fn + "__";
+            auto out = _to_vec(b.builtin_rolling_apply(name, -100, 10, min_observations));
+            auto agg_op = get_builtin_group_aggregator(name);
+            agg_op->set_input_type(dtype);
+            TS_ASSERT_EQUALS(out.size(), values.size());
+            for (size_t i = 0; i < out.size(); ++i) {
+              std::vector<flexible_type> window;
+              size_t observations = 0;
+              for (ssize_t j = ssize_t(i) - 100; j <= ssize_t(i) + 10; ++j) {
+                if (j < 0 || j >= ssize_t(values.size())) {
+                  window.push_back(FLEX_UNDEFINED);
+                } else {
+                  window.push_back(typed_values[j]);
+                  if (values[j] != FLEX_UNDEFINED) ++observations;
+                }
+              }
+              if (observations < min_observations) {
+                TS_ASSERT_EQUALS(out[i].get_type(), flex_type_enum::UNDEFINED);
+                continue;
+              }
+              auto expected = rolling_aggregate::full_window_aggregate(
+                  agg_op, window.begin(), window.end());
+              TS_ASSERT_EQUALS(out[i].get_type(), expected.get_type());
+              if (expected.get_type() == flex_type_enum::FLOAT) {
+                double tolerance = 1e-6 * std::max(1.0, std::abs(expected.get<flex_float>()));
+                TS_ASSERT_DELTA(out[i].get<flex_float>(), expected.get<flex_float>(), tolerance);
+              } else if (expected.get_type() != flex_type_enum::UNDEFINED) {
+                TS_ASSERT_EQUALS(out[i], expected);
+              }
+            }
+          }
+        }
+      }
     }
    
     void test_sarray() {
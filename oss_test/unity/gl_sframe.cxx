@@ -195,6 +195,13 @@ class gl_sframe_test: public CxxTest::TestSuite {
 
       sf["c"] = sf["b"];
       _assert_sframe_equals(sf3, sf); 
+
+      // keys of different types are rejected when the join is created,
+      // unless one of the frames is empty
+      gl_sframe strings{{"a", {"1", "2"}}, {"d", {1, 2}}};
+      TS_ASSERT_THROWS_ANYTHING(sf.join(strings, {"a"}, "inner"));
+      gl_sframe empty{{"a", std::vector<flexible_type>()}};
+      TS_ASSERT_EQUALS(sf.join(empty, {"a"}, "left").size(), sf.size());
     }
 
     void test_pack_unpack() {
@@ -22,6 +22,7 @@
 
 #include <fileio/temp_files.hpp>
 #include <unity/lib/unity_sarray.hpp>
+#include <sframe_query_engine/operators/expression.hpp>
 using namespace graphlab;
 
 class unity_sarray_lazy_eval_test: public CxxTest::TestSuite {
@@ -198,6 +199,26 @@ class unity_sarray_lazy_eval_test: public CxxTest::TestSuite {
     assert_materialized(t3, false);
   }
 
+  /**
+   * The same builtin operation applied twice is described by the same
+   * expression, so that the optimizer can share it.
+   **/
+  void test_operator_expression_keys() {
+    auto t = construct_sarray(100);
+    auto u = construct_sarray(100);
+
+    TS_ASSERT_EQUALS(expression_key(t->left_scalar_operator(2, "*")),
+                     expression_key(t->left_scalar_operator(2, "*")));
+    TS_ASSERT_EQUALS(expression_key(t->right_scalar_operator(2, "<")),
+                     expression_key(t->right_scalar_operator(2, "<")));
+    TS_ASSERT_EQUALS(expression_key(t->vector_operator(u, "+")),
+                     expression_key(t->vector_operator(u, "+")));
+
+    // ** has no builtin operator, so its expressions are never merged
+    TS_ASSERT_DIFFERS(expression_key(t->left_scalar_operator(2, "**")),
+                      expression_key(t->left_scalar_operator(2, "**")));
+  }
+
   std::shared_ptr<unity_sarray_base> construct_sarray(size_t n) {
     std::vector<flexible_type> vec;
     std::shared_ptr<unity_sarray_base> array(new unity_sarray());
@@ -210,6 +231,12 @@ class unity_sarray_lazy_eval_test: public CxxTest::TestSuite {
     return array;
   }
 
+  std::string expression_key(std::shared_ptr<unity_sarray_base> array_ptr) {
+    auto pnode = std::static_pointer_cast<unity_sarray>(array_ptr)->get_planner_node();
+    return pnode->any_operator_parameters.at("expression")
+        .as<query_eval::expression_ptr>()->key;
+  }
+
   void assert_materialized(std::shared_ptr<unity_sarray_base> array_ptr, bool is_materialized) {
     TS_ASSERT_EQUALS(array_ptr->is_materialized(), is_materialized);
   }
@@ -18,6 +18,7 @@
 #include <iostream>
 #include <algorithm>
 #include <fileio/temp_files.hpp>
+#include <fileio/general_fstream.hpp>
 #include <unity/lib/unity_sframe.hpp>
 #include <sframe/dataframe.hpp>
 #include <sframe/algorithm.hpp>
@@ -699,6 +700,48 @@ class unity_sframe_test: public CxxTest::TestSuite {
     TS_ASSERT_THROWS_ANYTHING(sf->sort(std::vector<std::string>({"b"}), std::vector<int>({0})));
   }
 
+  void test_window_aggregate() {
+    dataframe_t df;
+    df.set_column("user", {1, 2, 1, 1, 2}, flex_type_enum::INTEGER);
+    df.set_column("time", {5, 6, 0, 20, FLEX_UNDEFINED}, flex_type_enum::INTEGER);
+    df.set_column("amount", {2, 3, 1, 4, 5}, flex_type_enum::INTEGER);
+    auto sf = std::make_shared<unity_sframe>();
+    sf->construct_from_dataframe(df);
+
+    auto windowed = sf->window_aggregate({"user"}, "time", "amount", "__builtin__sum__",
+                                         -10, 0, "recent", false);
+    TS_ASSERT_EQUALS(windowed->column_names().back(), "recent");
+    auto result = windowed->_head(10);
+    TS_ASSERT_EQUALS(result.nrows(), 5);
+    std::vector<flexible_type> users{1, 1, 1, 2, 2};
+    std::vector<flexible_type> recent{1, 3, 4, FLEX_UNDEFINED, 3};
+    for (size_t i = 0; i < users.size(); ++i) {
+      TS_ASSERT_EQUALS(result.values["user"][i], users[i]);
+      TS_ASSERT_EQUALS((int)result.values["recent"][i].get_type(), (int)recent[i].get_type());
+      if (recent[i].get_type() != flex_type_enum::UNDEFINED) {
+        TS_ASSERT_EQUALS(result.values["recent"][i], recent[i]);
+      }
+    }
+
+    // the sorted result can be aggregated again without sorting
+    auto twice = std::static_pointer_cast<unity_sframe>(windowed)->window_aggregate(
+        {"user"}, "time", "recent", "__builtin__max__", -100, 100, "max_recent", true);
+    result = twice->_head(10);
+    std::vector<flexible_type> max_recent{4, 4, 4, FLEX_UNDEFINED, 3};
+    for (size_t i = 0; i < users.size(); ++i) {
+      TS_ASSERT_EQUALS((int)result.values["max_recent"][i].get_type(),
+                       (int)max_recent[i].get_type());
+      if (max_recent[i].get_type() != flex_type_enum::UNDEFINED) {
+        TS_ASSERT_EQUALS(result.values["max_recent"][i], max_recent[i]);
+      }
+    }
+
+    TS_ASSERT_THROWS_ANYTHING(sf->window_aggregate({"user"}, "time", "amount", "__builtin__sum__",
+                                                   1, 0, "recent", false));
+    TS_ASSERT_THROWS_ANYTHING(sf->window_aggregate({"user"}, "time", "amount", "__builtin__sum__",
+                                                   -10, 0, "amount", false));
+  }
+
   void test_save_load() {
     dataframe_t testdf = _create_test_dataframe();
     auto sf = std::make_shared<unity_sframe>();
@@ -720,4 +763,49 @@ class unity_sframe_test: public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(sf->size(), sf2->size());
     TS_ASSERT_EQUALS(sf->num_columns(), sf2->num_columns());
   }
+
+  static std::string read_file(const std::string& url) {
+    general_ifstream fin(url);
+    return std::string(std::istreambuf_iterator<char>(fin),
+                       std::istreambuf_iterator<char>());
+  }
+
+  void test_save_as_csv() {
+    dataframe_t testdf = _create_test_dataframe();
+    auto sf = std::make_shared<unity_sframe>();
+    sf->construct_from_dataframe(testdf);
+
+    // the output of the rows written in order
+    std::string lines;
+    for (size_t i = 0; i < 100; ++i) {
+      if (i > 0) lines += ",";
+      lines += std::to_string(i) + "," + std::to_string(i) + ",\"" + std::to_string(i) + "\"\n";
+    }
+    std::string expected = "[\na,b,c\n" + lines + "]\n";
+
+    std::map<std::string, flexible_type> config{
+      {"file_header", "["}, {"file_footer", "]"}, {"line_prefix", ","},
+      {"_no_prefix_on_first_value", 1}, {"num_shards", 7}};
+    std::string prefix = get_temp_name();
+    sf->save_as_csv(prefix + ".csv", config);
+    TS_ASSERT_EQUALS(read_file(prefix + ".csv"), expected);
+
+    // compressed in parallel
+    sf->save_as_csv(prefix + ".csv.gz", config);
+    TS_ASSERT_EQUALS(read_file(prefix + ".csv.gz"), expected);
+
+    // one complete file per shard
+    config["sharded"] = 1;
+    sf->save_as_csv(prefix + ".csv", config);
+    std::string shards;
+    for (size_t i = 0; i < 7; ++i) {
+      std::string shard = read_file(prefix + "_0000" + std::to_string(i) + ".csv");
+      TS_ASSERT_EQUALS(shard.substr(0, 8), "[\na,b,c\n");
+      TS_ASSERT_EQUALS(shard.substr(shard.length() - 2), "]\n");
+      shard = shard.substr(8, shard.length() - 10);
+      if (!shards.empty() && !shard.empty()) shards += ",";
+      shards += shard;
+    }
+    TS_ASSERT_EQUALS(shards, lines);
+  }
 };